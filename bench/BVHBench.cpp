@@ -0,0 +1,135 @@
+// BVH build, refit and query timings at 100k objects, checked against brute force.
+
+#include <chrono>
+#include <random>
+#include <vector>
+#include <cstdio>
+#include <cmath>
+#include <algorithm>
+#include <glm/gtc/matrix_transform.hpp>
+#include "BVH.h"
+#include "FrustumCuller.h"
+
+template <typename F>
+static double timeMs(F&& f) {
+    auto start = std::chrono::steady_clock::now();
+    f();
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+int main() {
+    const size_t OBJECTS = 100000;
+    const float WORLD = 500.0f;
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<float> position(-WORLD, WORLD), size(0.2f, 3.0f), unit(-1.0f, 1.0f);
+
+    std::vector<AABB> bounds(OBJECTS);
+    std::vector<glm::vec3> velocity(OBJECTS);
+    for (size_t i = 0; i < OBJECTS; ++i) {
+        glm::vec3 c(position(rng), position(rng) * 0.1f, position(rng));
+        glm::vec3 e(size(rng), size(rng), size(rng));
+        bounds[i] = {c - e, c + e};
+        velocity[i] = glm::vec3(unit(rng), unit(rng), unit(rng));
+    }
+
+    BVH bvh;
+    double buildMs = timeMs([&] { bvh.build(bounds); });
+    std::printf("objects: %zu  nodes: %zu  SAH cost: %.2f\n", OBJECTS, bvh.nodeCount(), bvh.buildCost());
+    std::printf("build:            %8.3f ms\n", buildMs);
+
+    // Move everything a little, as a frame of simulation would
+    for (size_t i = 0; i < OBJECTS; ++i) {
+        bounds[i].min += velocity[i];
+        bounds[i].max += velocity[i];
+        bvh.update((uint32_t)i, bounds[i]);
+    }
+    double refitMs = timeMs([&] { bvh.refit(); });
+    std::printf("refit:            %8.3f ms  (SAH cost %.2f)\n", refitMs, bvh.cost());
+
+    // Frustum query against flat SIMD culling
+    glm::mat4 projection = glm::perspective(glm::radians(45.0f), 16.0f / 9.0f, 0.1f, 300.0f);
+    glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 20.0f, 0.0f), glm::vec3(100.0f, 0.0f, 100.0f), glm::vec3(0, 1, 0));
+    FrustumCuller culler;
+    culler.setFrustum(projection * view);
+    glm::vec4 planes[6];
+    for (int p = 0; p < 6; ++p) planes[p] = culler.plane(p);
+
+    std::vector<uint32_t> visible;
+    double frustumMs = timeMs([&] { bvh.queryFrustum(planes, visible); });
+    double flatMs = timeMs([&] {
+        culler.clear();
+        for (const AABB& box : bounds) culler.add(box);
+        culler.cull();
+    });
+    size_t flatVisible = culler.stats().tested - culler.stats().culled;
+    std::printf("frustum (BVH):    %8.3f ms  visible %zu\n", frustumMs, visible.size());
+    std::printf("frustum (flat):   %8.3f ms  visible %zu\n", flatMs, flatVisible);
+    if (visible.size() != flatVisible) {
+        std::printf("MISMATCH: BVH and flat culling disagree\n");
+        return 1;
+    }
+
+    // Box queries
+    const int BOX_QUERIES = 10000;
+    std::vector<AABB> queries(BOX_QUERIES);
+    for (AABB& q : queries) {
+        glm::vec3 c(position(rng), 0.0f, position(rng));
+        q = {c - glm::vec3(10.0f), c + glm::vec3(10.0f)};
+    }
+    size_t boxHits = 0;
+    double boxMs = timeMs([&] {
+        std::vector<uint32_t> out;
+        for (const AABB& q : queries) {
+            out.clear();
+            bvh.queryBox(q, out);
+            boxHits += out.size();
+        }
+    });
+    size_t bruteHits = 0;
+    for (int i = 0; i < 100; ++i)
+        for (const AABB& box : bounds) bruteHits += box.overlaps(queries[i]);
+    size_t bvhHits = 0;
+    for (int i = 0; i < 100; ++i) {
+        std::vector<uint32_t> out;
+        bvh.queryBox(queries[i], out);
+        bvhHits += out.size();
+    }
+    std::printf("box x%d:       %8.3f ms  hits %zu\n", BOX_QUERIES, boxMs, boxHits);
+    if (bruteHits != bvhHits) {
+        std::printf("MISMATCH: box query %zu vs brute force %zu\n", bvhHits, bruteHits);
+        return 1;
+    }
+
+    // Rays from above towards the ground
+    const int RAYS = 10000;
+    size_t rayHits = 0;
+    std::vector<glm::vec3> origins(RAYS);
+    for (glm::vec3& o : origins) o = glm::vec3(position(rng), 100.0f, position(rng));
+    double rayMs = timeMs([&] {
+        for (const glm::vec3& o : origins) {
+            BVH::RayHit hit;
+            rayHits += bvh.raycast(o, glm::vec3(0.0f, -1.0f, 0.0f), 1000.0f, hit);
+        }
+    });
+    std::printf("ray x%d:       %8.3f ms  hits %zu\n", RAYS, rayMs, rayHits);
+    for (int i = 0; i < 100; ++i) {
+        // Brute-force nearest entry distance along -Y
+        float nearest = 1e30f;
+        for (const AABB& box : bounds) {
+            const glm::vec3& o = origins[i];
+            if (o.x >= box.min.x && o.x <= box.max.x && o.z >= box.min.z && o.z <= box.max.z && box.min.y <= o.y)
+                nearest = std::min(nearest, std::max(0.0f, o.y - box.max.y));
+        }
+        BVH::RayHit hit;
+        bool found = bvh.raycast(origins[i], glm::vec3(0.0f, -1.0f, 0.0f), 1000.0f, hit);
+        if (found != (nearest < 1e30f) || (found && std::abs(hit.distance - nearest) > 1e-3f)) {
+            std::printf("MISMATCH: ray %d\n", i);
+            return 1;
+        }
+    }
+
+    double rebuildMs = timeMs([&] { bvh.build(bounds); });
+    std::printf("rebuild:          %8.3f ms  (SAH cost %.2f)\n", rebuildMs, bvh.buildCost());
+    return 0;
+}
@@ -0,0 +1,53 @@
+#ifndef BENCH_GEOMETRY_H
+#define BENCH_GEOMETRY_H
+
+// Test meshes shared by the CPU benchmarks, in the engine's interleaved vertex
+// layout: position, normal, uv, tangent, bitangent (14 floats per vertex)
+
+#include <cmath>
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+#include <glm/gtc/constants.hpp>
+
+inline void pushVertex(std::vector<float>& out, const glm::vec3& p, const glm::vec3& n, const glm::vec2& uv,
+                       const glm::vec3& t, const glm::vec3& b) {
+    const float v[14] = {p.x, p.y, p.z, n.x, n.y, n.z, uv.x, uv.y, t.x, t.y, t.z, b.x, b.y, b.z};
+    out.insert(out.end(), v, v + 14);
+}
+
+// Unit cube, 4 vertices per face, counter-clockwise from outside
+inline void cubeGeometry(std::vector<float>& vertices, std::vector<uint32_t>& indices) {
+    const glm::vec3 normals[6] = {{0, 0, 1}, {0, 0, -1}, {1, 0, 0}, {-1, 0, 0}, {0, 1, 0}, {0, -1, 0}};
+    for (const glm::vec3& n : normals) {
+        glm::vec3 t = std::fabs(n.y) > 0.5f ? glm::vec3(1, 0, 0) : glm::cross(glm::vec3(0, 1, 0), n);
+        glm::vec3 b = glm::cross(n, t);
+        uint32_t first = (uint32_t)(vertices.size() / 14);
+        const glm::vec2 corners[4] = {{0, 0}, {1, 0}, {1, 1}, {0, 1}};
+        for (const glm::vec2& c : corners)
+            pushVertex(vertices, 0.5f * n + (c.x - 0.5f) * t + (c.y - 0.5f) * b, n, c, t, b);
+        for (uint32_t i : {0u, 1u, 2u, 2u, 3u, 0u}) indices.push_back(first + i);
+    }
+}
+
+// Same parametrization as buildSphereGeometry() in FG.h, poles and seam included
+inline void sphereGeometry(float radius, int segments, std::vector<float>& vertices, std::vector<uint32_t>& indices) {
+    for (int i = 0; i <= segments; ++i) {
+        float phi = glm::pi<float>() * i / segments;
+        for (int j = 0; j <= segments; ++j) {
+            float theta = glm::two_pi<float>() * j / segments;
+            glm::vec3 n(std::sin(phi) * std::cos(theta), std::cos(phi), std::sin(phi) * std::sin(theta));
+            glm::vec3 t = glm::normalize(glm::vec3(-std::sin(theta), 0.0f, std::cos(theta)));
+            pushVertex(vertices, radius * n, n, glm::vec2((float)j / segments, (float)i / segments), t,
+                       glm::normalize(glm::cross(n, t)));
+        }
+    }
+    for (int i = 0; i < segments; ++i) {
+        for (int j = 0; j < segments; ++j) {
+            uint32_t first = i * (segments + 1) + j, second = first + segments + 1;
+            for (uint32_t k : {first, second, first + 1, second, second + 1, first + 1}) indices.push_back(k);
+        }
+    }
+}
+
+#endif // BENCH_GEOMETRY_H
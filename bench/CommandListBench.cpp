@@ -0,0 +1,92 @@
+// Command list recording at 10k-1M draws: one thread against every pool thread,
+// each draw doing the matrix math of a scene object. The parallel stream must
+// replay exactly as the serial one. "allocs" counts the chunks still allocated
+// over 20 frames after the timed ones; it only stays above 0 while some thread is
+// still reaching a new peak share of the ranges.
+
+#include <chrono>
+#include <vector>
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+#include <glm/gtc/matrix_transform.hpp>
+#include "CommandList.h"
+
+struct DrawData {
+    glm::mat4 model;
+    glm::vec4 normalMatrix[3];
+};
+
+template <typename F>
+static double bestOfMs(int runs, F&& f) {
+    double best = 1e30;
+    for (int i = 0; i < runs; ++i) {
+        auto start = std::chrono::steady_clock::now();
+        f();
+        auto end = std::chrono::steady_clock::now();
+        best = std::min(best, std::chrono::duration<double, std::milli>(end - start).count());
+    }
+    return best;
+}
+
+// What a scene traversal does per object: transform, normal matrix, state, draw
+static void recordRange(CommandList& list, size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+        list.bindProgram((uint32_t)(i / 100000));
+        list.bindMaterial((uint32_t)(i / 64 % 4));
+        float t = (float)i;
+        DrawData data;
+        data.model = glm::translate(glm::mat4(1.0f), glm::vec3(t * 0.01f, t * 0.02f, -t * 0.03f));
+        data.model = glm::rotate(data.model, t * 0.001f, glm::vec3(0.0f, 1.0f, 0.0f));
+        glm::mat3 normal = glm::transpose(glm::inverse(glm::mat3(data.model)));
+        for (int c = 0; c < 3; ++c) data.normalMatrix[c] = glm::vec4(normal[c], 0.0f);
+        list.setDrawData(data);
+        list.draw((uint32_t)(i % 3));
+    }
+}
+
+// Flattened replay: op, id, count and data of every command
+static void flatten(std::vector<unsigned char>& out, const CommandList::Command& command) {
+    out.insert(out.end(), (const unsigned char*)&command, (const unsigned char*)(&command + 1));
+    const unsigned char* data = (const unsigned char*)command.data();
+    out.insert(out.end(), data, data + command.bytes);
+}
+
+int main() {
+    JobPool& pool = JobPool::shared();
+    JobPool single(1);
+    std::printf("threads: %u\n", pool.size());
+    std::printf("%10s %14s %14s %14s %12s %8s\n", "draws", "serial (ms)", "parallel (ms)", "replay (ms)", "commands",
+                "allocs");
+
+    for (size_t count : {10000u, 100000u, 1000000u}) {
+        ParallelRecorder serial(single), parallel(pool);
+        const size_t grain = 1024;
+
+        double serialMs = bestOfMs(5, [&] { serial.record(count, count, recordRange); });
+        double parallelMs = bestOfMs(5, [&] { parallel.record(count, grain, recordRange); });
+
+        // Later frames reuse the chunks
+        size_t allocations = parallel.chunkAllocations();
+        for (int frame = 0; frame < 20; ++frame) parallel.record(count, grain, recordRange);
+        allocations = parallel.chunkAllocations() - allocations;
+
+        std::vector<unsigned char> expected, actual;
+        serial.replay([&](const CommandList::Command& command) { flatten(expected, command); });
+        parallel.replay([&](const CommandList::Command& command) { flatten(actual, command); });
+        if (expected != actual) {
+            std::printf("MISMATCH at %zu draws\n", count);
+            return 1;
+        }
+
+        size_t replayed = 0;
+        double replayMs = bestOfMs(5, [&] {
+            replayed = 0;
+            parallel.replay([&](const CommandList::Command&) { ++replayed; });
+        });
+
+        std::printf("%10zu %14.3f %14.3f %14.3f %12zu %8zu\n", count, serialMs, parallelMs, replayMs, replayed,
+                    allocations);
+    }
+    return 0;
+}
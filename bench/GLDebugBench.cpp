@@ -0,0 +1,106 @@
+// Cost of GL_CHECK against direct calls. glad's entry points are plain function
+// pointers, so they are pointed at stubs here and no GL context is needed.
+// Built twice (see CMakeLists.txt):
+//   GLDebugBench          release: GL_CHECK must expand to exactly the direct
+//                         call (checked at compile time) and never call glGetError
+//   GLDebugBenchChecked   ENGINE_GL_DEBUG: one glGetError per wrapped call, and
+//                         a failing call site is reported once however often it fails
+
+#include <chrono>
+#include <cstdio>
+#include "GLDebug.h"
+
+#define STRINGIFY_(x) #x
+#define STRINGIFY(x) STRINGIFY_(x)
+
+#ifndef ENGINE_GL_DEBUG
+static constexpr bool sameText(const char* a, const char* b) {
+    return *a == *b && (*a == '\0' || sameText(a + 1, b + 1));
+}
+// Both sides are fully macro-expanded, i.e. down to glad_glUniform1i(0, 1)
+static_assert(sameText(STRINGIFY(GL_CHECK(glUniform1i(0, 1))), STRINGIFY(glUniform1i(0, 1))),
+              "GL_CHECK must be the bare call in release builds");
+#endif
+
+static unsigned long long uniformCalls = 0;
+static unsigned long long errorQueries = 0;
+static GLenum pendingError = GL_NO_ERROR;
+
+static void APIENTRY stubUniform1i(GLint, GLint value) { uniformCalls += (unsigned)value; }
+
+static GLenum APIENTRY stubGetError() {
+    ++errorQueries;
+    GLenum error = pendingError;
+    pendingError = GL_NO_ERROR;
+    return error;
+}
+
+static void direct(int calls) {
+    for (int i = 0; i < calls; ++i) glUniform1i(0, 1);
+}
+
+static void wrapped(int calls) {
+    for (int i = 0; i < calls; ++i) GL_CHECK(glUniform1i(0, 1));
+}
+
+static double nsPerCall(void (*loop)(int), int calls) {
+    // Best of several runs; the loops are short enough for the scheduler to matter
+    double best = 1e30;
+    for (int run = 0; run < 5; ++run) {
+        auto start = std::chrono::steady_clock::now();
+        loop(calls);
+        double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        if (ns < best) best = ns;
+    }
+    return best / calls;
+}
+
+int main() {
+    glad_glUniform1i = stubUniform1i;
+    glad_glGetError = stubGetError;
+    const int CALLS = 10000000;
+    bool ok = true;
+
+    double directNs = nsPerCall(direct, CALLS);
+    unsigned long long queriesBefore = errorQueries;
+    double wrappedNs = nsPerCall(wrapped, CALLS);
+    unsigned long long queries = errorQueries - queriesBefore;
+
+    std::printf("%s build\n", GLDebug::ENABLED ? "ENGINE_GL_DEBUG" : "release");
+    std::printf("direct:   %.2f ns per call\n", directNs);
+    std::printf("GL_CHECK: %.2f ns per call (%+.0f%%), %llu glGetError calls\n", wrappedNs,
+                100.0 * (wrappedNs / directNs - 1.0), queries);
+    if (uniformCalls != 10ull * CALLS) {
+        std::printf("MISMATCH: %llu stub calls, expected %llu\n", uniformCalls, 10ull * CALLS);
+        ok = false;
+    }
+
+    if (!GLDebug::ENABLED) {
+        if (queries != 0) {
+            std::printf("MISMATCH: release GL_CHECK queried glGetError\n");
+            ok = false;
+        }
+        return ok ? 0 : 1;
+    }
+
+    if (queries != 5ull * CALLS) {
+        std::printf("MISMATCH: expected one glGetError per wrapped call\n");
+        ok = false;
+    }
+    // The same site failing every frame: reported on the first failure only
+    std::printf("expect one GL_INVALID_VALUE report:\n");
+    for (int frame = 0; frame < 100; ++frame) {
+        pendingError = GL_INVALID_VALUE;
+        bool clean = GLDebug::check("glUniform1i(0, 1)", __FILE__, __LINE__);
+        if (clean) {
+            std::printf("MISMATCH: pending error not reported\n");
+            ok = false;
+            break;
+        }
+    }
+    if (!GLDebug::check("nothing", __FILE__, __LINE__)) {
+        std::printf("MISMATCH: error still pending after check\n");
+        ok = false;
+    }
+    return ok ? 0 : 1;
+}
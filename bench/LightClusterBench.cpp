@@ -0,0 +1,66 @@
+// Clustered light assignment timings at 1k-16k lights, checked against brute force.
+
+#include <chrono>
+#include <random>
+#include <vector>
+#include <cstdio>
+#include <algorithm>
+#include <glm/gtc/matrix_transform.hpp>
+#include "LightClusterer.h"
+
+template <typename F>
+static double timeMs(F&& f) {
+    auto start = std::chrono::steady_clock::now();
+    f();
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+int main() {
+    const float WORLD = 60.0f;
+    glm::mat4 projection = glm::perspective(glm::radians(45.0f), 16.0f / 9.0f, 0.1f, 100.0f);
+    glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 5.0f, 0.0f), glm::vec3(30.0f, 0.0f, 30.0f), glm::vec3(0, 1, 0));
+
+    LightClusterer clusterer;
+    double boundsMs = timeMs([&] { clusterer.setProjection(projection, 0.1f, 100.0f); });
+    std::printf("cluster bounds:   %8.3f ms  (%u clusters)\n", boundsMs, LightClusterer::CLUSTER_COUNT);
+
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<float> position(-WORLD, WORLD), radius(1.0f, 4.0f);
+    for (size_t count : {1000, 4000, 16000}) {
+        std::vector<PointLight> lights(count);
+        for (PointLight& light : lights)
+            light = {glm::vec3(position(rng), position(rng) * 0.05f, position(rng)), radius(rng), glm::vec3(1.0f), 1.0f};
+
+        clusterer.assign(lights, view);
+        double assignMs = timeMs([&] { clusterer.assign(lights, view); });
+        const LightClusterer::Stats& stats = clusterer.stats();
+        std::printf("assign %5zu:     %8.3f ms  visible %u  refs %u  avg %.1f  max %u  overflow %u\n", count,
+                    assignMs, stats.visibleLights, stats.references, stats.averageLightsPerCluster,
+                    stats.maxLightsPerCluster, stats.overflowedClusters);
+
+        // Brute force: every light against every cluster box
+        std::vector<uint32_t> expected;
+        for (unsigned cluster = 0; cluster < LightClusterer::CLUSTER_COUNT; ++cluster) {
+            glm::vec3 lo, hi;
+            clusterer.clusterBounds(cluster, lo, hi);
+            expected.clear();
+            for (size_t i = 0; i < count; ++i) {
+                glm::vec3 c = glm::vec3(view * glm::vec4(lights[i].position, 1.0f));
+                glm::vec3 d = glm::max(lo - c, glm::vec3(0.0f)) + glm::max(c - hi, glm::vec3(0.0f));
+                if (glm::dot(d, d) <= lights[i].radius * lights[i].radius) expected.push_back((uint32_t)i);
+            }
+            if (expected.size() > LightClusterer::MAX_LIGHTS_PER_CLUSTER) continue;
+
+            uint32_t offset = clusterer.grid()[2 * cluster], found = clusterer.grid()[2 * cluster + 1];
+            std::vector<uint32_t> actual(clusterer.indices().begin() + offset,
+                                         clusterer.indices().begin() + offset + found);
+            std::sort(actual.begin(), actual.end());
+            if (actual != expected) {
+                std::printf("MISMATCH: cluster %u has %u lights, brute force %zu\n", cluster, found, expected.size());
+                return 1;
+            }
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,148 @@
+// Lightmap bake of a small static scene (a floor with a cube and a sphere above
+// it under the two key lights of main.cpp): atlas build time, bake
+// time on one thread and on every pool thread, and rays per second. The bake must
+// be identical for any thread count, and the cooked file must read back as written.
+
+#include <cmath>
+#include <chrono>
+#include <vector>
+#include <cstdio>
+#include <algorithm>
+#include <glm/gtc/matrix_transform.hpp>
+#include "LightmapBaker.h"
+#include "BenchGeometry.h"
+
+template <typename F>
+static double timeMs(F&& f) {
+    auto start = std::chrono::steady_clock::now();
+    f();
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+// Floor of cells x cells quads in the XZ plane, facing +Y
+static void floorGrid(float size, int cells, std::vector<float>& vertices, std::vector<uint32_t>& indices) {
+    for (int z = 0; z <= cells; ++z)
+        for (int x = 0; x <= cells; ++x)
+            pushVertex(vertices, glm::vec3((x / (float)cells - 0.5f) * size, 0.0f, (z / (float)cells - 0.5f) * size),
+                       glm::vec3(0, 1, 0), glm::vec2((float)x, (float)z), glm::vec3(1, 0, 0), glm::vec3(0, 0, -1));
+    for (int z = 0; z < cells; ++z) {
+        for (int x = 0; x < cells; ++x) {
+            uint32_t a = z * (cells + 1) + x, b = a + 1, c = a + cells + 1, d = c + 1;
+            for (uint32_t k : {a, c, b, b, c, d}) indices.push_back(k);
+        }
+    }
+}
+
+static LightmapBaker makeScene(const LightmapBaker::Settings& settings) {
+    LightmapBaker baker(settings);
+    std::vector<float> vertices;
+    std::vector<uint32_t> indices;
+    floorGrid(10.0f, 8, vertices, indices);
+    baker.addObject(vertices, indices, glm::mat4(1.0f), glm::vec3(0.6f));
+    vertices.clear();
+    indices.clear();
+    cubeGeometry(vertices, indices);
+    baker.addObject(vertices, indices, glm::translate(glm::mat4(1.0f), glm::vec3(-1.0f, 0.75f, 0.0f)),
+                    glm::vec3(0.7f, 0.5f, 0.3f));
+    vertices.clear();
+    indices.clear();
+    sphereGeometry(0.8f, 64, vertices, indices);
+    baker.addObject(vertices, indices, glm::translate(glm::mat4(1.0f), glm::vec3(1.5f, 1.2f, 0.0f)),
+                    glm::vec3(0.8f));
+    return baker;
+}
+
+int main() {
+    JobPool& pool = JobPool::shared();
+    JobPool single(1);
+    std::printf("threads: %u\n", pool.size());
+
+    std::vector<PointLight> lights;
+    lights.push_back({glm::vec3(-6.2f, 3.0f, 2.0f), 60.0f, glm::vec3(1.0f), 1.0f});
+    lights.push_back({glm::vec3(6.0f, -2.0f, 0.0f), 60.0f, glm::vec3(0.0f, 0.0f, 1.0f), 1.0f});
+    // Low enough that the second key light still reaches the floor's top side
+    lights[1].position.y = 2.0f;
+
+    LightmapBaker::Settings settings;
+    settings.texelsPerUnit = 16.0f;
+    settings.samples = 32;
+    settings.bounces = 2;
+
+    bool ok = true;
+    std::printf("%8s %8s %10s %8s %12s %12s %10s\n", "samples", "bounces", "texels", "charts", "serial (ms)",
+                "parallel (ms)", "Mrays/s");
+    for (int samples : {16, 64}) {
+        settings.samples = samples;
+        LightmapBaker serial = makeScene(settings);
+        LightmapBaker parallel = makeScene(settings);
+        serial.buildAtlas();
+        parallel.buildAtlas();
+        double serialMs = timeMs([&] { serial.bake(lights, single); });
+        double parallelMs = timeMs([&] { parallel.bake(lights, pool); });
+        const LightmapBaker::Stats& stats = parallel.stats();
+        std::printf("%8d %8d %6dx%-4d %8u %12.1f %12.1f %10.2f\n", samples, settings.bounces, parallel.width(),
+                    parallel.height(), stats.charts, serialMs, parallelMs, stats.rays / parallelMs / 1000.0);
+
+        if (serial.irradiance() != parallel.irradiance() || serial.occlusion() != parallel.occlusion()) {
+            std::printf("MISMATCH: bake depends on the thread count\n");
+            ok = false;
+        }
+        for (const glm::vec3& e : parallel.irradiance()) {
+            if (!(e.x >= 0.0f && e.y >= 0.0f && e.z >= 0.0f && e.x < 1e4f && e.y < 1e4f && e.z < 1e4f)) {
+                std::printf("MISMATCH: invalid irradiance\n");
+                ok = false;
+                break;
+            }
+        }
+    }
+
+    // Every unwrapped uv must land in a texel that has a surface behind it
+    settings.samples = 8;
+    LightmapBaker baker = makeScene(settings);
+    baker.buildAtlas();
+    std::printf("atlas: %d x %d, %u charts, %u texels covered, %.1f texels/unit, %.1f ms\n", baker.width(),
+                baker.height(), baker.stats().charts, baker.stats().texels, baker.stats().texelsPerUnit,
+                baker.stats().atlasMs);
+    baker.bake(lights, pool);
+    for (uint32_t object = 0; object < 3; ++object) {
+        const LightmapBaker::Unwrapped& mesh = baker.unwrapped(object);
+        for (size_t i = 0; i < mesh.indices.size(); i += 3) {
+            const float* v[3];
+            for (int k = 0; k < 3; ++k) v[k] = &mesh.vertices[(size_t)mesh.indices[i + k] * LightmapBaker::UNWRAPPED_FLOATS];
+            glm::vec2 centre = (glm::vec2(v[0][14], v[0][15]) + glm::vec2(v[1][14], v[1][15]) +
+                                glm::vec2(v[2][14], v[2][15])) / 3.0f;
+            glm::vec3 a(v[0][0], v[0][1], v[0][2]), b(v[1][0], v[1][1], v[1][2]), c(v[2][0], v[2][1], v[2][2]);
+            if (glm::length(glm::cross(b - a, c - a)) < 1e-8f) continue;
+            int x = (int)(centre.x * baker.width()), y = (int)(centre.y * baker.height());
+            if (x < 0 || y < 0 || x >= baker.width() || y >= baker.height() ||
+                baker.irradiance()[(size_t)y * baker.width() + x] == glm::vec3(0.0f)) {
+                std::printf("MISMATCH: object %u triangle %zu maps to an empty texel\n", object, i / 3);
+                ok = false;
+                break;
+            }
+        }
+    }
+
+    // Cooked file round trip, and the shared exponent's precision
+    LightmapImage cooked = baker.cook();
+    LightmapImage loaded;
+    if (!cooked.write("lightmap_bench.lmap") || !loaded.read("lightmap_bench.lmap") ||
+        loaded.width != cooked.width || loaded.height != cooked.height || loaded.charts != cooked.charts ||
+        loaded.irradiance != cooked.irradiance || loaded.occlusion != cooked.occlusion) {
+        std::printf("MISMATCH: cooked lightmap did not read back\n");
+        ok = false;
+    }
+    std::remove("lightmap_bench.lmap");
+    float worst = 0.0f;
+    for (const glm::vec3& e : baker.irradiance()) {
+        float peak = std::max(e.x, std::max(e.y, e.z));
+        if (peak <= 0.0f) continue;
+        glm::vec3 d = glm::abs(unpackRGB9E5(packRGB9E5(e)) - e);
+        worst = std::max(worst, std::max(d.x, std::max(d.y, d.z)) / peak);
+    }
+    std::printf("RGB9E5 worst error: %.4f of the brightest channel\n", worst);
+    if (worst > 1.0f / 256.0f) ok = false;
+
+    return ok ? 0 : 1;
+}
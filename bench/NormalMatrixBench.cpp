@@ -0,0 +1,81 @@
+// Normal matrix timings at 1M transforms: per-matrix inverse-transpose against the
+// batched cofactor kernel, checked for the same directions.
+
+#include <chrono>
+#include <random>
+#include <vector>
+#include <cstdio>
+#include <cmath>
+#include <glm/gtc/matrix_transform.hpp>
+#include "NormalMatrix.h"
+
+template <typename F>
+static double timeMs(F&& f) {
+    auto start = std::chrono::steady_clock::now();
+    f();
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+// Normal matrices agree up to a positive scale
+static glm::mat3 normalized(const glm::mat3& m) {
+    float norm = std::sqrt(glm::dot(m[0], m[0]) + glm::dot(m[1], m[1]) + glm::dot(m[2], m[2]));
+    return glm::mat3(m[0] / norm, m[1] / norm, m[2] / norm);
+}
+
+int main() {
+    const size_t COUNT = 1000000;
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<float> angle(0.0f, 6.2831853f), scale(0.2f, 3.0f), unit(-1.0f, 1.0f);
+
+    // Half rigid/uniformly scaled (the common case), half non-uniform, some mirrored
+    std::vector<glm::mat4> models(COUNT);
+    for (size_t i = 0; i < COUNT; ++i) {
+        glm::mat4 model = glm::translate(glm::mat4(1.0f), glm::vec3(unit(rng), unit(rng), unit(rng)) * 100.0f);
+        model = glm::rotate(model, angle(rng), glm::normalize(glm::vec3(unit(rng), unit(rng), unit(rng)) + glm::vec3(0.01f)));
+        if (i % 2 == 0) model = glm::scale(model, glm::vec3(scale(rng)));
+        else model = glm::scale(model, glm::vec3(scale(rng), scale(rng), i % 8 == 1 ? -scale(rng) : scale(rng)));
+        models[i] = model;
+    }
+
+    std::vector<glm::mat3> reference(COUNT);
+    double inverseMs = timeMs([&] {
+        for (size_t i = 0; i < COUNT; ++i)
+            reference[i] = glm::transpose(glm::inverse(glm::mat3(models[i])));
+    });
+
+    std::vector<glm::mat3> single(COUNT);
+    double singleMs = timeMs([&] {
+        for (size_t i = 0; i < COUNT; ++i) single[i] = normalMatrix(models[i]);
+    });
+
+    // Same strides as InstanceData: model and normal columns interleaved
+    struct Entry {
+        glm::mat4 model;
+        glm::vec4 normal[3];
+    };
+    std::vector<Entry> entries(COUNT);
+    for (size_t i = 0; i < COUNT; ++i) entries[i].model = models[i];
+    double batchMs = timeMs([&] {
+        computeNormalMatrices(&entries[0].model, &entries[0].normal[0], COUNT, sizeof(Entry));
+    });
+
+    std::printf("inverse-transpose: %8.3f ms\n", inverseMs);
+    std::printf("normalMatrix():    %8.3f ms\n", singleMs);
+    std::printf("batched:           %8.3f ms\n", batchMs);
+
+    for (size_t i = 0; i < COUNT; ++i) {
+        glm::mat3 batch(glm::vec3(entries[i].normal[0]), glm::vec3(entries[i].normal[1]), glm::vec3(entries[i].normal[2]));
+        glm::mat3 expected = normalized(reference[i]);
+        for (const glm::mat3& candidate : {normalized(single[i]), normalized(batch)}) {
+            for (int c = 0; c < 3; ++c) {
+                glm::vec3 d = candidate[c] - expected[c];
+                if (glm::dot(d, d) > 1e-8f) {
+                    std::printf("MISMATCH: transform %zu\n", i);
+                    return 1;
+                }
+            }
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,169 @@
+// Occlusion raster and test timings for a wall of occluders in front of scattered
+// boxes, checked against a brute-force per-pixel depth buffer: a box the reference
+// can see must never be rejected.
+
+#include <cmath>
+#include <chrono>
+#include <random>
+#include <vector>
+#include <cstdio>
+#include <algorithm>
+#include <glm/gtc/matrix_transform.hpp>
+#include "OcclusionCuller.h"
+
+template <typename F>
+static double timeMs(F&& f) {
+    auto start = std::chrono::steady_clock::now();
+    f();
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+static OcclusionCuller::Mesh unitCube() {
+    OcclusionCuller::Mesh mesh;
+    for (int corner = 0; corner < 8; ++corner) {
+        mesh.positions.push_back(corner & 1 ? 0.5f : -0.5f);
+        mesh.positions.push_back(corner & 2 ? 0.5f : -0.5f);
+        mesh.positions.push_back(corner & 4 ? 0.5f : -0.5f);
+    }
+    mesh.indices = {0, 1, 3, 3, 2, 0,  4, 6, 7, 7, 5, 4,  0, 4, 5, 5, 1, 0,
+                    2, 3, 7, 7, 6, 2,  0, 2, 6, 6, 4, 0,  1, 5, 7, 7, 3, 1};
+    return mesh;
+}
+
+// Exact depth at every pixel centre, same conventions as OcclusionCuller
+struct ReferenceDepth {
+    struct Point {
+        double x, y, z;
+    };
+
+    int width, height;
+    std::vector<double> depth;
+
+    ReferenceDepth(int w, int h) : width(w), height(h), depth((size_t)w * h, 1.0) {}
+
+    void add(const glm::mat4& matrix, const OcclusionCuller::Mesh& mesh) {
+        for (size_t t = 0; t < mesh.indices.size(); t += 3) {
+            Point p[3];
+            bool clipped = false;
+            for (int i = 0; i < 3; ++i) {
+                const float* v = &mesh.positions[3 * mesh.indices[t + i]];
+                glm::vec4 c = matrix * glm::vec4(v[0], v[1], v[2], 1.0f);
+                if (c.w <= 0.0f || c.z < -c.w) clipped = true;
+                p[i] = {(c.x / c.w * 0.5 + 0.5) * width, (c.y / c.w * 0.5 + 0.5) * height, c.z / c.w * 0.5 + 0.5};
+            }
+            if (clipped) continue;
+
+            double area = (p[1].x - p[0].x) * (p[2].y - p[0].y) - (p[1].y - p[0].y) * (p[2].x - p[0].x);
+            if (area == 0.0) continue;
+            int x0 = std::max(0, (int)std::floor(std::min({p[0].x, p[1].x, p[2].x})));
+            int x1 = std::min(width - 1, (int)std::floor(std::max({p[0].x, p[1].x, p[2].x})));
+            int y0 = std::max(0, (int)std::floor(std::min({p[0].y, p[1].y, p[2].y})));
+            int y1 = std::min(height - 1, (int)std::floor(std::max({p[0].y, p[1].y, p[2].y})));
+            for (int y = y0; y <= y1; ++y) {
+                for (int x = x0; x <= x1; ++x) {
+                    double px = x + 0.5, py = y + 0.5, w[3];
+                    for (int i = 0; i < 3; ++i) {
+                        const Point& a = p[(i + 1) % 3];
+                        const Point& b = p[(i + 2) % 3];
+                        w[i] = ((b.x - a.x) * (py - a.y) - (b.y - a.y) * (px - a.x)) / area;
+                    }
+                    if (w[0] < 0.0 || w[1] < 0.0 || w[2] < 0.0) continue;
+                    double z = w[0] * p[0].z + w[1] * p[1].z + w[2] * p[2].z;
+                    double& stored = depth[(size_t)y * width + x];
+                    stored = std::min(stored, z);
+                }
+            }
+        }
+    }
+
+    bool occluded(const glm::mat4& viewProjection, const AABB& box) const {
+        double minX = 1e30, minY = 1e30, maxX = -1e30, maxY = -1e30, minDepth = 1e30;
+        for (int corner = 0; corner < 8; ++corner) {
+            glm::vec4 c = viewProjection * glm::vec4(corner & 1 ? box.max.x : box.min.x,
+                                                     corner & 2 ? box.max.y : box.min.y,
+                                                     corner & 4 ? box.max.z : box.min.z, 1.0f);
+            if (c.w <= 0.0f || c.z < -c.w) return false;
+            double x = (c.x / c.w * 0.5 + 0.5) * width, y = (c.y / c.w * 0.5 + 0.5) * height;
+            minX = std::min(minX, x); maxX = std::max(maxX, x);
+            minY = std::min(minY, y); maxY = std::max(maxY, y);
+            minDepth = std::min(minDepth, c.z / c.w * 0.5 + 0.5);
+        }
+        if (maxX < 0.0 || maxY < 0.0 || minX >= width || minY >= height) return false;
+        for (int y = std::max(0, (int)std::floor(minY)); y <= std::min(height - 1, (int)std::floor(maxY)); ++y)
+            for (int x = std::max(0, (int)std::floor(minX)); x <= std::min(width - 1, (int)std::floor(maxX)); ++x)
+                if (minDepth <= depth[(size_t)y * width + x]) return false;
+        return true;
+    }
+};
+
+int main() {
+    OcclusionCuller culler(320, 192);
+    glm::mat4 projection = glm::perspective(glm::radians(45.0f), 320.0f / 192.0f, 0.1f, 100.0f);
+    glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 0.0f, 5.0f), glm::vec3(0.0f), glm::vec3(0, 1, 0));
+    glm::mat4 viewProjection = projection * view;
+    OcclusionCuller::Mesh cube = unitCube();
+
+    // A 16 x 10 wall at z = 0, then spinning cubes in front of it
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    std::vector<glm::mat4> occluders;
+    for (int y = 0; y < 10; ++y)
+        for (int x = 0; x < 16; ++x)
+            occluders.push_back(glm::translate(glm::mat4(1.0f), glm::vec3(x - 7.5f, y - 4.5f, 0.0f)));
+    for (int i = 0; i < 2000; ++i) {
+        glm::mat4 model = glm::translate(glm::mat4(1.0f), glm::vec3(unit(rng) * 12.0f - 6.0f, unit(rng) * 8.0f - 4.0f,
+                                                                    0.5f + unit(rng) * 3.0f));
+        model = glm::rotate(model, unit(rng) * 6.0f, glm::normalize(glm::vec3(unit(rng), unit(rng), 0.1f)));
+        occluders.push_back(glm::scale(model, glm::vec3(0.1f + unit(rng) * 0.3f)));
+    }
+
+    // Occludees scattered from in front of the wall to far behind it
+    std::vector<AABB> boxes(100000);
+    for (AABB& box : boxes) {
+        glm::vec3 center(unit(rng) * 30.0f - 15.0f, unit(rng) * 20.0f - 10.0f, 3.0f - unit(rng) * 60.0f);
+        glm::vec3 extent = glm::vec3(0.05f) + glm::vec3(unit(rng), unit(rng), unit(rng)) * 0.5f;
+        box = {center - extent, center + extent};
+    }
+    std::vector<uint8_t> visible(boxes.size());
+
+    for (size_t count : {160, 660, 2160}) {
+        auto frame = [&] {
+            culler.begin(viewProjection);
+            for (size_t i = 0; i < count; ++i) culler.addOccluder(cube, occluders[i]);
+            culler.rasterize();
+            culler.cull(boxes.data(), boxes.size(), visible.data());
+        };
+        frame();
+        double frameMs = timeMs(frame);
+        const OcclusionCuller::Stats& stats = culler.stats();
+        std::printf("%5zu occluders: raster %7.3f ms  test %7.3f ms  total %7.3f ms  rejected %u/%u\n", count,
+                    stats.rasterMs, stats.testMs, frameMs, stats.rejected, stats.tested);
+
+        ReferenceDepth reference(culler.width(), culler.height());
+        for (size_t i = 0; i < count; ++i) reference.add(viewProjection * occluders[i], cube);
+
+        // The bound must never be closer than the true depth, and nothing visible may be rejected
+        for (int y = 0; y < culler.height(); ++y) {
+            for (int x = 0; x < culler.width(); ++x) {
+                if (culler.depthBound(x, y) + 1e-5 < reference.depth[(size_t)y * culler.width() + x]) {
+                    std::printf("MISMATCH: depth bound %f in front of %f at (%d, %d)\n", culler.depthBound(x, y),
+                                reference.depth[(size_t)y * culler.width() + x], x, y);
+                    return 1;
+                }
+            }
+        }
+        unsigned referenceRejected = 0;
+        for (size_t i = 0; i < boxes.size(); ++i) {
+            bool hidden = reference.occluded(viewProjection, boxes[i]);
+            referenceRejected += hidden;
+            if (!visible[i] && !hidden) {
+                std::printf("MISMATCH: box %zu rejected but visible in the reference\n", i);
+                return 1;
+            }
+        }
+        std::printf("                 reference rejects %u (%.1f%% found)\n", referenceRejected,
+                    referenceRejected ? 100.0 * stats.rejected / referenceRejected : 100.0);
+    }
+    return 0;
+}
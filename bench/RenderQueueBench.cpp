@@ -0,0 +1,85 @@
+// Sort throughput of RenderQueue at 10k-1M draws: serial radix, parallel radix and
+// std::stable_sort on the same keys.
+
+#include <chrono>
+#include <random>
+#include <vector>
+#include <cstdio>
+#include <algorithm>
+#include "RenderQueue.h"
+
+static std::vector<RenderQueue::Item> makeDraws(size_t count, std::mt19937& rng) {
+    // Scene-like distribution: few passes/programs, more materials and meshes
+    std::uniform_int_distribution<unsigned> pass(0, 2), program(0, 31), material(0, 511), mesh(0, 2047);
+    std::uniform_real_distribution<float> depth(0.0f, 1.0f);
+    std::bernoulli_distribution translucent(0.1);
+
+    std::vector<RenderQueue::Item> draws(count);
+    for (size_t i = 0; i < count; ++i) {
+        uint64_t key = RenderQueue::makeKey(pass(rng), translucent(rng), depth(rng),
+                                            program(rng), material(rng), mesh(rng));
+        draws[i] = {key, (uint32_t)i, 0};
+    }
+    return draws;
+}
+
+template <typename F>
+static double bestOfMs(int runs, F&& f) {
+    double best = 1e30;
+    for (int i = 0; i < runs; ++i) {
+        auto start = std::chrono::steady_clock::now();
+        f();
+        auto end = std::chrono::steady_clock::now();
+        best = std::min(best, std::chrono::duration<double, std::milli>(end - start).count());
+    }
+    return best;
+}
+
+int main() {
+    std::mt19937 rng(1234);
+    JobPool& pool = JobPool::shared();
+    std::printf("threads: %u\n", pool.size());
+    std::printf("%10s %14s %14s %14s %12s\n", "draws", "radix (ms)", "parallel (ms)", "std (ms)", "state chg");
+
+    for (size_t count : {10000u, 100000u, 1000000u}) {
+        std::vector<RenderQueue::Item> draws = makeDraws(count, rng);
+
+        RenderQueue serial(pool), parallel(pool);
+        serial.parallelThreshold = (size_t)-1;
+        parallel.parallelThreshold = 0;
+        serial.reserve(count);
+        parallel.reserve(count);
+
+        auto fill = [&](RenderQueue& queue) {
+            queue.clear();
+            for (const RenderQueue::Item& item : draws) queue.submit(item.key, item.payload);
+        };
+
+        double serialMs = bestOfMs(5, [&] { fill(serial); serial.sort(); });
+        double parallelMs = bestOfMs(5, [&] { fill(parallel); parallel.sort(); });
+
+        std::vector<RenderQueue::Item> reference;
+        double stdMs = bestOfMs(5, [&] {
+            reference = draws;
+            std::stable_sort(reference.begin(), reference.end(),
+                             [](const RenderQueue::Item& a, const RenderQueue::Item& b) { return a.key < b.key; });
+        });
+
+        // Both radix paths must match the stable reference exactly
+        for (size_t i = 0; i < count; ++i) {
+            if (serial.sorted()[i].payload != reference[i].payload ||
+                parallel.sorted()[i].payload != reference[i].payload) {
+                std::printf("MISMATCH at %zu draws, index %zu\n", count, i);
+                return 1;
+            }
+        }
+
+        unsigned stateChanges = 0;
+        parallel.execute([&](const RenderQueue::Item&, unsigned changes) {
+            if (changes & (RenderQueue::PROGRAM_CHANGED | RenderQueue::MATERIAL_CHANGED)) ++stateChanges;
+        });
+
+        std::printf("%10zu %14.3f %14.3f %14.3f %12u\n", count, serialMs, parallelMs, stdMs, stateChanges);
+    }
+    return 0;
+}
@@ -0,0 +1,215 @@
+// Software rasterizer throughput on the engine's stress scene (a lattice of
+// textured, normal-mapped cubes and a sphere under orbiting point lights), one
+// thread against every pool thread. Images must match bit for bit across thread
+// counts. A jittered full-screen mesh checks that shared edges leave no gaps and
+// no double hits.
+//
+// For the comparison with Mesa llvmpipe on the same scene, run the engine
+// headless both ways and compare the render times in the JSON:
+//   LIBGL_ALWAYS_SOFTWARE=1 ./Engine --headless 300 --instances 1000 --timing-json llvmpipe.json
+//   ./Engine --headless 300 --instances 1000 --software --timing-json software.json
+
+#include <cmath>
+#include <chrono>
+#include <random>
+#include <vector>
+#include <cstdio>
+#include <algorithm>
+#include <glm/gtc/constants.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include "SoftwareRasterizer.h"
+#include "BenchGeometry.h"
+
+template <typename F>
+static double bestOfMs(int runs, F&& f) {
+    double best = 1e30;
+    for (int i = 0; i < runs; ++i) {
+        auto start = std::chrono::steady_clock::now();
+        f();
+        auto end = std::chrono::steady_clock::now();
+        best = std::min(best, std::chrono::duration<double, std::milli>(end - start).count());
+    }
+    return best;
+}
+
+static SoftwareRasterizer::Mesh cubeMesh() {
+    std::vector<float> vertices;
+    std::vector<uint32_t> indices;
+    cubeGeometry(vertices, indices);
+    return SoftwareRasterizer::Mesh::fromVertices(vertices, indices);
+}
+
+static SoftwareRasterizer::Mesh sphereMesh(float radius, int segments) {
+    std::vector<float> vertices;
+    std::vector<uint32_t> indices;
+    sphereGeometry(radius, segments, vertices, indices);
+    return SoftwareRasterizer::Mesh::fromVertices(vertices, indices);
+}
+
+// Checkerboard albedo and a bumpy tangent-space normal map
+static SoftwareTexture checker(int size, const glm::vec3& a, const glm::vec3& b) {
+    std::vector<unsigned char> texels((size_t)size * size * 4);
+    for (int y = 0; y < size; ++y) {
+        for (int x = 0; x < size; ++x) {
+            glm::vec3 c = ((x / 16 + y / 16) & 1) ? a : b;
+            unsigned char* t = &texels[((size_t)y * size + x) * 4];
+            for (int k = 0; k < 3; ++k) t[k] = (unsigned char)(c[k] * 255);
+            t[3] = 255;
+        }
+    }
+    return SoftwareTexture(size, size, texels.data());
+}
+
+static SoftwareTexture bumps(int size) {
+    std::vector<unsigned char> texels((size_t)size * size * 4);
+    for (int y = 0; y < size; ++y) {
+        for (int x = 0; x < size; ++x) {
+            glm::vec3 n = glm::normalize(glm::vec3(0.4f * std::sin(x * 0.2f), 0.4f * std::cos(y * 0.2f), 1.0f));
+            unsigned char* t = &texels[((size_t)y * size + x) * 4];
+            for (int k = 0; k < 3; ++k) t[k] = (unsigned char)((n[k] * 0.5f + 0.5f) * 255);
+            t[3] = 255;
+        }
+    }
+    return SoftwareTexture(size, size, texels.data());
+}
+
+// Jittered grid over the whole screen, every triangle with its own vertices and
+// a little closer than the one before: each pixel must pass the depth test once
+static bool watertight(JobPool& pool) {
+    const int cells = 37;
+    std::mt19937 rng(3);
+    std::uniform_real_distribution<float> jitter(-0.2f, 0.2f);
+    std::vector<glm::vec2> grid((cells + 1) * (cells + 1));
+    for (int y = 0; y <= cells; ++y) {
+        for (int x = 0; x <= cells; ++x) {
+            bool border = x == 0 || y == 0 || x == cells || y == cells;
+            float fx = x + (border ? 0.0f : jitter(rng)), fy = y + (border ? 0.0f : jitter(rng));
+            grid[y * (cells + 1) + x] = glm::vec2(fx, fy) / (float)cells * 2.0f - 1.0f;
+        }
+    }
+    std::vector<float> vertices;
+    std::vector<uint32_t> indices;
+    float depth = 0.9f;
+    auto triangle = [&](glm::vec2 a, glm::vec2 b, glm::vec2 c) {
+        for (const glm::vec2& p : {a, b, c}) {
+            indices.push_back((uint32_t)(vertices.size() / 14));
+            pushVertex(vertices, glm::vec3(p, depth), glm::vec3(0, 0, 1), glm::vec2(0), glm::vec3(1, 0, 0),
+                       glm::vec3(0, 1, 0));
+        }
+        depth -= 1e-4f;
+    };
+    for (int y = 0; y < cells; ++y) {
+        for (int x = 0; x < cells; ++x) {
+            glm::vec2 p00 = grid[y * (cells + 1) + x], p10 = grid[y * (cells + 1) + x + 1];
+            glm::vec2 p01 = grid[(y + 1) * (cells + 1) + x], p11 = grid[(y + 1) * (cells + 1) + x + 1];
+            // Alternate the diagonal and the winding, both must rasterize the same
+            if ((x + y) & 1) {
+                triangle(p00, p10, p11);
+                triangle(p11, p01, p00);
+            } else {
+                triangle(p00, p01, p10);
+                triangle(p10, p01, p11);
+            }
+        }
+    }
+    SoftwareRasterizer::Mesh mesh = SoftwareRasterizer::Mesh::fromVertices(vertices, indices);
+
+    SoftwareRasterizer raster(333, 217);
+    std::vector<PointLight> noLights;
+    raster.begin(glm::mat4(1.0f), glm::mat4(1.0f), glm::vec3(0.0f), noLights);
+    raster.draw(mesh, glm::mat4(1.0f), SoftwareRasterizer::Material());
+    raster.finish(pool);
+    unsigned pixels = (unsigned)(raster.width() * raster.height());
+    const SoftwareRasterizer::Stats& stats = raster.stats();
+    std::printf("watertight: %u triangles, %u pixels, %u fragments, %u shaded\n", stats.rasterized, pixels,
+                stats.fragments, stats.shaded);
+    return stats.fragments == pixels && stats.shaded == pixels;
+}
+
+int main() {
+    JobPool& pool = JobPool::shared();
+    JobPool single(1);
+    JobPool wide(std::max(4u, pool.size()));
+    std::printf("threads: %u (determinism checked with %u)\n", pool.size(), wide.size());
+    if (!watertight(wide)) {
+        std::printf("MISMATCH: shared edges left gaps or double hits\n");
+        return 1;
+    }
+
+    SoftwareRasterizer::Mesh cube = cubeMesh();
+    SoftwareRasterizer::Mesh sphere = sphereMesh(0.8f, 64);
+    SoftwareTexture stone = checker(512, glm::vec3(0.7f, 0.65f, 0.6f), glm::vec3(0.4f, 0.38f, 0.35f));
+    SoftwareTexture metal = checker(512, glm::vec3(0.8f, 0.8f, 0.85f), glm::vec3(0.3f, 0.3f, 0.35f));
+    SoftwareTexture normals = bumps(512);
+
+    // Key lights and orbiting lights as in main.cpp
+    std::vector<PointLight> lights;
+    lights.push_back({glm::vec3(-6.2f, 3.0f, 2.0f), 60.0f, glm::vec3(1.0f), 1.0f});
+    lights.push_back({glm::vec3(6.0f, -2.0f, 0.0f), 60.0f, glm::vec3(0.0f, 0.0f, 1.0f), 1.0f});
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    for (int i = 0; i < 64; ++i) {
+        float angle = unit(rng) * glm::two_pi<float>(), distance = 2.0f + unit(rng) * 40.0f;
+        lights.push_back({glm::vec3(std::cos(angle) * distance, 0.2f + unit(rng) * 3.0f, std::sin(angle) * distance),
+                          1.5f + unit(rng) * 3.0f, glm::vec3(unit(rng), unit(rng), unit(rng)), 2.0f});
+    }
+
+    std::printf("%10s %8s %6s %12s %12s %10s %10s %10s\n", "size", "cubes", "filter", "serial (ms)", "parallel (ms)",
+                "Mpix/s", "Mtri/s", "fragments");
+    struct Size {
+        int width, height;
+    };
+    for (Size size : {Size{800, 600}, Size{1920, 1080}}) {
+        for (size_t count : {1000u, 20000u}) {
+            for (SoftwareTexture::Filter filter : {SoftwareTexture::BILINEAR, SoftwareTexture::TRILINEAR}) {
+                int side = 1;
+                while ((size_t)side * side * side < count) ++side;
+                std::vector<glm::mat4> models(count);
+                for (size_t i = 0; i < count; ++i) {
+                    glm::vec3 cell((float)(i % side), (float)(i / side % side), (float)(i / ((size_t)side * side)));
+                    glm::mat4 model = glm::translate(glm::mat4(1.0f), (cell - glm::vec3((side - 1) * 0.5f)) * 1.5f);
+                    model = glm::rotate(model, i * 0.01f, glm::vec3(0.0f, 1.0f, 0.0f));
+                    models[i] = glm::scale(model, glm::vec3(0.5f));
+                }
+                glm::vec3 eye(0.0f, side * 0.6f, side * 1.6f + 4.0f);
+                glm::mat4 view = glm::lookAt(eye, glm::vec3(0.0f), glm::vec3(0, 1, 0));
+                glm::mat4 projection =
+                    glm::perspective(glm::radians(45.0f), (float)size.width / size.height, 0.1f, 100.0f);
+
+                SoftwareRasterizer::Material materials[2];
+                materials[0].diffuse = &stone;
+                materials[1].diffuse = &metal;
+                for (SoftwareRasterizer::Material& material : materials) {
+                    material.normalMap = &normals;
+                    material.filter = filter;
+                }
+
+                SoftwareRasterizer raster(size.width, size.height);
+                auto frame = [&](JobPool& threads) {
+                    raster.begin(view, projection, eye, lights);
+                    raster.draw(sphere, glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, side * 0.9f, 0.0f)),
+                                materials[1]);
+                    for (size_t i = 0; i < count; ++i) raster.draw(cube, models[i], materials[i & 1]);
+                    raster.finish(threads);
+                };
+
+                double serialMs = bestOfMs(2, [&] { frame(single); });
+                std::vector<uint32_t> expected = raster.color();
+                double parallelMs = bestOfMs(3, [&] { frame(pool); });
+                frame(wide);
+                if (raster.color() != expected) {
+                    std::printf("MISMATCH: %dx%d image differs between 1 and %u threads\n", size.width, size.height,
+                                wide.size());
+                    return 1;
+                }
+
+                const SoftwareRasterizer::Stats& stats = raster.stats();
+                double pixels = (double)size.width * size.height;
+                std::printf("%5dx%-4d %8zu %6s %12.2f %12.2f %10.1f %10.2f %10u\n", size.width, size.height, count,
+                            filter == SoftwareTexture::BILINEAR ? "bilin" : "trilin", serialMs, parallelMs,
+                            pixels / parallelMs / 1e3, stats.triangles / parallelMs / 1e3, stats.fragments);
+            }
+        }
+    }
+    return 0;
+}
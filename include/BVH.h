@@ -0,0 +1,93 @@
+#ifndef BVH_H
+#define BVH_H
+
+#include <vector>
+#include <cstdint>
+#include <functional>
+#include <glm/glm.hpp>
+#include "Bounds.h"
+
+// Scene-level bounding volume hierarchy over object AABBs.
+// - Built top-down with binned SAH, collapsed to 4-wide nodes whose child bounds
+//   are stored SoA so one SSE op tests all four children.
+// - Moving objects: update() their bounds and refit() bottom-up each frame; the
+//   tree is rebuilt when refitting has degraded its SAH cost past a threshold.
+class BVH {
+public:
+    static const int LEAF_SIZE = 4;
+
+    // 4 children per node, 128 bytes (two cache lines)
+    struct alignas(64) Node {
+        float minX[4], minY[4], minZ[4];
+        float maxX[4], maxY[4], maxZ[4];
+        int32_t child[4]; // Inner child: node index. Leaf: first slot in the object order
+        int32_t count[4]; // 0 = inner child, >0 = leaf object count, -1 = empty slot
+    };
+
+    struct RayHit {
+        uint32_t object = 0;
+        float distance = 0.0f;
+    };
+
+    void build(const std::vector<AABB>& objectBounds);
+
+    // Record new bounds for a moved object; takes effect on refit()
+    void update(uint32_t object, const AABB& bounds) { bounds_[object] = bounds; }
+
+    // Recompute node bounds from the current object bounds, keeping the topology
+    void refit();
+
+    // Refit, or rebuild when the refit tree costs `rebuildThreshold` times its build cost
+    // Returns true if it rebuilt.
+    bool refitOrRebuild();
+
+    // SAH cost relative to the root area; compared against the cost right after build
+    float cost() const { return cost_; }
+    float buildCost() const { return buildCost_; }
+    float rebuildThreshold = 1.5f;
+
+    // Objects whose bounds are not outside any of the planes (inside: dot(n, p) + d >= 0).
+    // Subtrees fully inside the frustum are emitted without further tests.
+    void queryFrustum(const glm::vec4 planes[6], std::vector<uint32_t>& out) const;
+
+    // Objects whose bounds overlap `box`
+    void queryBox(const AABB& box, std::vector<uint32_t>& out) const;
+
+    // Nearest object whose bounds the ray enters within maxDistance
+    bool raycast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, RayHit& hit) const;
+
+    // Exact test of an object the ray reaches: distance of its hit, or negative for a
+    // miss or a hit beyond maxDistance
+    typedef std::function<float(uint32_t object, float maxDistance)> ObjectIntersector;
+
+    // Nearest hit of `intersect` (e.g. triangles as objects), the boxes only cull.
+    // With anyHit the first hit found is returned, for occlusion (shadow) rays.
+    bool raycast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance,
+                 const ObjectIntersector& intersect, RayHit& hit, bool anyHit = false) const;
+
+    size_t objectCount() const { return bounds_.size(); }
+    size_t nodeCount() const { return nodes.size(); }
+    const AABB& objectBounds(uint32_t object) const { return bounds_[object]; }
+
+private:
+    std::vector<Node> nodes;        // Pre-order: children always follow their parent
+    std::vector<uint32_t> order;    // Object IDs in leaf order
+    std::vector<AABB> bounds_;
+    std::vector<glm::vec3> centroids;
+    float cost_ = 0.0f;
+    float buildCost_ = 0.0f;
+
+    int32_t buildNode(uint32_t begin, uint32_t end, int depth);
+    uint32_t splitRange(uint32_t begin, uint32_t end, bool sah);
+    uint32_t medianSplit(uint32_t begin, uint32_t end, int axis);
+    AABB rangeBounds(uint32_t begin, uint32_t end) const;
+    void setSlot(Node& node, int slot, const AABB& box);
+    AABB slotBounds(const Node& node, int slot) const;
+    float computeCost() const;
+    void emitSubtree(int32_t child, int32_t count, std::vector<uint32_t>& out) const;
+    template <typename LeafTest>
+    bool traverse(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, bool anyHit, RayHit& hit,
+                  const LeafTest& leafTest) const;
+};
+
+#endif // BVH_H
@@ -0,0 +1,80 @@
+#ifndef BOUNDS_H
+#define BOUNDS_H
+
+#include <cmath>
+#include <cstddef>
+#include <algorithm>
+#include <glm/glm.hpp>
+
+struct BoundingSphere {
+    glm::vec3 center = glm::vec3(0.0f);
+    float radius = 0.0f;
+};
+
+// Axis-aligned bounding box
+struct AABB {
+    glm::vec3 min = glm::vec3(0.0f);
+    glm::vec3 max = glm::vec3(0.0f);
+
+    glm::vec3 center() const { return (min + max) * 0.5f; }
+    glm::vec3 extents() const { return (max - min) * 0.5f; }
+
+    void expand(const glm::vec3& p) {
+        min = glm::min(min, p);
+        max = glm::max(max, p);
+    }
+
+    void expand(const AABB& other) {
+        min = glm::min(min, other.min);
+        max = glm::max(max, other.max);
+    }
+
+    float surfaceArea() const {
+        glm::vec3 d = max - min;
+        return 2.0f * (d.x * d.y + d.y * d.z + d.z * d.x);
+    }
+
+    bool overlaps(const AABB& other) const {
+        return min.x <= other.max.x && max.x >= other.min.x &&
+               min.y <= other.max.y && max.y >= other.min.y &&
+               min.z <= other.max.z && max.z >= other.min.z;
+    }
+
+    // Bounds of this box after an affine transform (Arvo's method)
+    AABB transformed(const glm::mat4& m) const {
+        glm::vec3 c = glm::vec3(m * glm::vec4(center(), 1.0f));
+        glm::vec3 e = extents();
+        glm::vec3 r(
+            std::fabs(m[0][0]) * e.x + std::fabs(m[1][0]) * e.y + std::fabs(m[2][0]) * e.z,
+            std::fabs(m[0][1]) * e.x + std::fabs(m[1][1]) * e.y + std::fabs(m[2][1]) * e.z,
+            std::fabs(m[0][2]) * e.x + std::fabs(m[1][2]) * e.y + std::fabs(m[2][2]) * e.z);
+        return {c - r, c + r};
+    }
+};
+
+// Bounds of `count` interleaved vertices whose position is the first 3 floats of
+// every `stride` floats. The sphere is centred on the box and fitted to the points.
+inline void computeBounds(const float* data, size_t count, size_t stride, AABB& box, BoundingSphere& sphere) {
+    if (count == 0) {
+        box = AABB();
+        sphere = BoundingSphere();
+        return;
+    }
+
+    box.min = box.max = glm::vec3(data[0], data[1], data[2]);
+    for (size_t i = 1; i < count; ++i) {
+        const float* p = data + i * stride;
+        box.expand(glm::vec3(p[0], p[1], p[2]));
+    }
+
+    sphere.center = box.center();
+    float radiusSq = 0.0f;
+    for (size_t i = 0; i < count; ++i) {
+        const float* p = data + i * stride;
+        glm::vec3 d = glm::vec3(p[0], p[1], p[2]) - sphere.center;
+        radiusSq = std::max(radiusSq, glm::dot(d, d));
+    }
+    sphere.radius = std::sqrt(radiusSq);
+}
+
+#endif // BOUNDS_H
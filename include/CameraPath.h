@@ -0,0 +1,66 @@
+#ifndef CAMERA_PATH_H
+#define CAMERA_PATH_H
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <algorithm>
+
+// Scripted orbital camera for headless runs. One key per line:
+//
+//   time distance yaw pitch      (seconds, units, degrees, degrees)
+//
+// Keys must be in time order; '#' starts a comment. Between keys the orbit is
+// interpolated linearly; before the first and after the last key it holds.
+class CameraPath {
+public:
+    struct Key {
+        float time, distance, yaw, pitch;
+    };
+
+    bool load(const std::string& path) {
+        std::ifstream file(path);
+        if (!file.is_open()) {
+            std::cerr << "Failed to open camera path: " << path << std::endl;
+            return false;
+        }
+        keys.clear();
+        std::string line;
+        for (int number = 1; std::getline(file, line); ++number) {
+            line = line.substr(0, line.find('#'));
+            if (line.find_first_not_of(" \t\r") == std::string::npos) continue;
+            std::istringstream fields(line);
+            Key key;
+            if (!(fields >> key.time >> key.distance >> key.yaw >> key.pitch) ||
+                (!keys.empty() && key.time < keys.back().time)) {
+                std::cerr << path << ":" << number << ": expected 'time distance yaw pitch' in time order" << std::endl;
+                return false;
+            }
+            keys.push_back(key);
+        }
+        if (keys.empty()) std::cerr << "Camera path has no keys: " << path << std::endl;
+        return !keys.empty();
+    }
+
+    bool empty() const { return keys.empty(); }
+
+    Key sample(float time) const {
+        if (keys.empty()) return {time, 10.0f, -90.0f, 0.0f};
+        if (time <= keys.front().time) return keys.front();
+        if (time >= keys.back().time) return keys.back();
+        auto next = std::upper_bound(keys.begin(), keys.end(), time,
+                                     [](float t, const Key& key) { return t < key.time; });
+        const Key& a = *(next - 1);
+        const Key& b = *next;
+        float f = b.time > a.time ? (time - a.time) / (b.time - a.time) : 0.0f;
+        return {time, a.distance + (b.distance - a.distance) * f, a.yaw + (b.yaw - a.yaw) * f,
+                a.pitch + (b.pitch - a.pitch) * f};
+    }
+
+private:
+    std::vector<Key> keys;
+};
+
+#endif // CAMERA_PATH_H
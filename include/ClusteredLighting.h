@@ -0,0 +1,101 @@
+#ifndef CLUSTERED_LIGHTING_H
+#define CLUSTERED_LIGHTING_H
+
+#include <vector>
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include "GLState.h"
+#include "Shader.h"
+#include "LightClusterer.h"
+
+// GPU side of clustered shading: uploads the lights and LightClusterer's cluster
+// lists into buffer textures (core since GL 3.1) read by shaders/common/lights.glsl.
+class ClusteredLighting {
+public:
+    std::vector<PointLight> lights;
+
+    ClusteredLighting() {
+        glGenBuffers(BUFFER_COUNT, buffers);
+        glGenTextures(BUFFER_COUNT, textures);
+        const GLenum formats[BUFFER_COUNT] = {GL_RGBA32F, GL_RG32UI, GL_R32UI};
+        const char* const names[BUFFER_COUNT] = {"light data", "light clusters", "light indices"};
+        GLState& gl = GLState::instance();
+        for (int i = 0; i < BUFFER_COUNT; ++i) {
+            gl.bindBuffer(GL_TEXTURE_BUFFER, buffers[i]);
+            GL_CHECK(glBufferData(GL_TEXTURE_BUFFER, 16, nullptr, GL_STREAM_DRAW));
+            gl.bindTexture(glsl::sampler::lightData + i, GL_TEXTURE_BUFFER, textures[i]);
+            glTexBuffer(GL_TEXTURE_BUFFER, formats[i], buffers[i]);
+            GLDebug::label(GL_BUFFER, buffers[i], names[i]);
+            GLDebug::label(GL_TEXTURE, textures[i], names[i]);
+        }
+    }
+
+    ClusteredLighting(const ClusteredLighting&) = delete;
+    ClusteredLighting& operator=(const ClusteredLighting&) = delete;
+
+    ~ClusteredLighting() {
+        GLState& gl = GLState::instance();
+        for (int i = 0; i < BUFFER_COUNT; ++i) {
+            gl.forgetBuffer(buffers[i]);
+            gl.forgetTexture(textures[i]);
+        }
+        glDeleteTextures(BUFFER_COUNT, textures);
+        glDeleteBuffers(BUFFER_COUNT, buffers);
+    }
+
+    // Assigns `lights` to the clusters of this camera and uploads the result
+    void update(const glm::mat4& view, const glm::mat4& projection, float nearPlane, float farPlane) {
+        clusterer.setProjection(projection, nearPlane, farPlane);
+        clusterer.assign(lights, view);
+
+        // Two texels per light: position + radius, color + intensity
+        lightTexels.resize(lights.size() * 2);
+        for (size_t i = 0; i < lights.size(); ++i) {
+            lightTexels[2 * i] = glm::vec4(lights[i].position, lights[i].radius);
+            lightTexels[2 * i + 1] = glm::vec4(lights[i].color, lights[i].intensity);
+        }
+
+        upload(LIGHTS, lightTexels.data(), lightTexels.size() * sizeof(glm::vec4));
+        upload(GRID, clusterer.grid().data(), clusterer.grid().size() * sizeof(uint32_t));
+        upload(INDICES, clusterer.indices().data(), clusterer.indices().size() * sizeof(uint32_t));
+    }
+
+    // Binds the light buffers and sets the cluster lookup uniforms of a lit program
+    void bind(const Shader& shader, int viewportWidth, int viewportHeight) const {
+        GLState& gl = GLState::instance();
+        for (int i = 0; i < BUFFER_COUNT; ++i)
+            gl.bindTexture(glsl::sampler::lightData + i, GL_TEXTURE_BUFFER, textures[i]);
+
+        shader.use();
+        shader.setVec2(glsl::uniform::clusterTileSize,
+                       glm::vec2((float)viewportWidth / LightClusterer::CLUSTERS_X,
+                                 (float)viewportHeight / LightClusterer::CLUSTERS_Y));
+        shader.setVec2(glsl::uniform::clusterDepthParams,
+                       glm::vec2(clusterer.depthScale(), clusterer.depthBias()));
+    }
+
+    const LightClusterer::Stats& stats() const { return clusterer.stats(); }
+
+private:
+    // Texture units are consecutive: lightData, clusterGrid, clusterIndices
+    enum Buffer { LIGHTS, GRID, INDICES, BUFFER_COUNT };
+    static_assert(glsl::sampler::clusterGrid == glsl::sampler::lightData + GRID &&
+                  glsl::sampler::clusterIndices == glsl::sampler::lightData + INDICES,
+                  "Light buffer samplers must get consecutive units");
+
+    LightClusterer clusterer;
+    GLuint buffers[BUFFER_COUNT];
+    GLuint textures[BUFFER_COUNT];
+    std::vector<glm::vec4> lightTexels;
+    size_t capacity[BUFFER_COUNT] = {};
+
+    // Orphans the old storage; grows the buffer when needed
+    void upload(Buffer buffer, const void* data, size_t bytes) {
+        GLState::instance().bindBuffer(GL_TEXTURE_BUFFER, buffers[buffer]);
+        if (bytes > capacity[buffer]) capacity[buffer] = bytes + bytes / 2;
+        GL_CHECK(glBufferData(GL_TEXTURE_BUFFER, capacity[buffer], nullptr, GL_STREAM_DRAW));
+        if (bytes > 0) glBufferSubData(GL_TEXTURE_BUFFER, 0, bytes, data);
+    }
+};
+
+#endif // CLUSTERED_LIGHTING_H
@@ -0,0 +1,136 @@
+#ifndef COMMAND_LIST_H
+#define COMMAND_LIST_H
+
+#include <mutex>
+#include <memory>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <functional>
+#include "JobPool.h"
+
+// Draw commands recorded without touching the graphics API, so any thread can
+// build them: bind program, bind material, set per-draw data, draw. IDs are the
+// caller's small dense handles (as in RenderQueue), and the per-draw data is
+// copied in as raw bytes. The GL thread replays the list and maps each command to
+// the actual calls.
+//
+// Commands are packed into 64 KB chunks, the list's linear arena. reset() rewinds
+// them without freeing, so once a frame has reached its peak size, recording
+// allocates nothing.
+class CommandList {
+public:
+    static const size_t CHUNK_BYTES = 64 * 1024;
+
+    // Spare chunks shared by several lists, so the memory follows whichever thread
+    // records the most this frame instead of each keeping its own peak
+    class ChunkPool {
+    public:
+        std::unique_ptr<unsigned char[]> acquire();
+        void release(std::unique_ptr<unsigned char[]> chunk);
+        size_t allocations() const { return allocated; }
+
+    private:
+        std::mutex mutex;
+        std::vector<std::unique_ptr<unsigned char[]>> spare;
+        size_t allocated = 0;
+    };
+    static const uint32_t NONE = ~0u;
+
+    enum Op : uint32_t { BIND_PROGRAM, BIND_MATERIAL, SET_DRAW_DATA, DRAW };
+
+    // 16 bytes, followed by `bytes` of draw data padded to 16
+    struct Command {
+        Op op;
+        uint32_t id;      // Program, material or mesh
+        uint32_t count;   // DRAW: instances
+        uint32_t bytes;   // SET_DRAW_DATA: size of data()
+
+        const void* data() const { return this + 1; }
+    };
+
+    // A point in the recording, for replaying part of it
+    struct Position {
+        size_t chunk = 0;
+        size_t offset = 0;
+    };
+
+    // With a pool, reset() hands the chunks back to it
+    explicit CommandList(ChunkPool* pool = nullptr) : pool(pool) {}
+
+    void reset();
+
+    // Binds equal to the last recorded one are dropped; after this the next binds
+    // are recorded regardless, so the commands that follow can be replayed on
+    // their own.
+    void beginSegment() { program = material = NONE; }
+
+    void bindProgram(uint32_t id);
+    void bindMaterial(uint32_t id);
+    void setDrawData(const void* data, uint32_t bytes);
+    template <typename T>
+    void setDrawData(const T& data) { setDrawData(&data, (uint32_t)sizeof(T)); }
+    void draw(uint32_t mesh, uint32_t instances = 1);
+
+    Position position() const { return {current, chunks.empty() ? 0 : chunks[current].used}; }
+
+    // fn(command) for each command in [from, to)
+    void replay(Position from, Position to, const std::function<void(const Command&)>& fn) const;
+    void replay(const std::function<void(const Command&)>& fn) const { replay(Position(), position(), fn); }
+
+    size_t commandCount() const { return commands; }
+    size_t chunkAllocations() const { return allocations; }  // Since construction, without a pool
+
+private:
+    struct Chunk {
+        std::unique_ptr<unsigned char[]> bytes;
+        size_t used = 0;
+    };
+
+    ChunkPool* pool;
+    std::vector<Chunk> chunks;
+    size_t current = 0;
+    size_t commands = 0;
+    size_t allocations = 0;
+    uint32_t program = NONE;
+    uint32_t material = NONE;
+
+    Command* push(Op op, uint32_t id, uint32_t count, uint32_t bytes);
+};
+
+// One CommandList per job pool thread, all drawing chunks from one ChunkPool.
+// record() splits [0, count) into ranges and has the pool fill them in parallel;
+// replay() then walks the ranges in ascending order on the calling thread, which
+// gives the same command stream as recording serially, and drops binds that
+// repeat across range boundaries.
+class ParallelRecorder {
+public:
+    explicit ParallelRecorder(JobPool& pool = JobPool::shared()) : pool(pool), segments(pool.size()) {
+        lists.reserve(pool.size());
+        for (unsigned i = 0; i < pool.size(); ++i) lists.emplace_back(&chunks);
+    }
+
+    // fn(list, begin, end) records items [begin, end) into `list`; it starts with no
+    // program or material bound
+    void record(size_t count, size_t grain, const std::function<void(CommandList&, size_t, size_t)>& fn);
+
+    void replay(const std::function<void(const CommandList::Command&)>& fn) const;
+
+    size_t commandCount() const;
+    size_t chunkAllocations() const { return chunks.allocations(); }
+
+private:
+    struct Segment {
+        size_t begin;
+        unsigned worker;
+        CommandList::Position from, to;
+    };
+
+    JobPool& pool;
+    CommandList::ChunkPool chunks;
+    std::vector<CommandList> lists;                 // Per worker
+    std::vector<std::vector<Segment>> segments;     // Per worker, in recording order
+    std::vector<Segment> ordered;                   // All of them by range
+};
+
+#endif // COMMAND_LIST_H
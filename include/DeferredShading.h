@@ -0,0 +1,105 @@
+#ifndef DEFERRED_SHADING_H
+#define DEFERRED_SHADING_H
+
+#include <glad/glad.h>
+#include "GLState.h"
+#include "Shader.h"
+#include "ClusteredLighting.h"
+#include "FrameGraph.h"
+
+// Deferred path: opaque geometry is drawn once into a G-buffer by the gbuffer_*
+// programs, then one full-screen pass (deferred_vertex/deferred_fragment) lights
+// each pixel from its light cluster. Hidden fragments never reach the lighting code.
+//
+// Layout (shaders/common/gbuffer.glsl):
+//   0      RGBA8   albedo, specular strength
+//   1      RG16F   world normal, octahedral-encoded
+//   depth  D24S8   matches the window's depth buffer so it can be blitted back
+//
+// The G-buffer is transient: its targets belong to the frame graph, which
+// allocates them from its pool and lends their memory to later passes.
+//
+// Frame (FrameGraph passes):
+//   geometry  createGBuffer() in its setup (cleared), draws opaque geometry
+//   lighting  readGBuffer() in its setup, writes the output; lightingPass() shades
+//             and copies depth over for the forward passes after it
+class DeferredShading {
+public:
+    struct GBuffer {
+        FrameGraph::Resource albedo = FrameGraph::INVALID;
+        FrameGraph::Resource normal = FrameGraph::INVALID;
+        FrameGraph::Resource depth = FrameGraph::INVALID;
+    };
+
+    DeferredShading() {
+        glGenFramebuffers(1, &depthSource);
+        glGenVertexArrays(1, &VAO);  // Core profile draws need a VAO, even an empty one
+    }
+
+    DeferredShading(const DeferredShading&) = delete;
+    DeferredShading& operator=(const DeferredShading&) = delete;
+
+    ~DeferredShading() {
+        GLState& gl = GLState::instance();
+        gl.forgetFramebuffer(depthSource);
+        gl.forgetVertexArray(VAO);
+        glDeleteFramebuffers(1, &depthSource);
+        glDeleteVertexArrays(1, &VAO);
+    }
+
+    // In the geometry pass's setup: the G-buffer at the render size, written and cleared
+    static GBuffer createGBuffer(FrameGraph::Builder& builder, int width, int height) {
+        GBuffer gbuffer;
+        FrameGraph::TextureDesc desc;
+        desc.width = width;
+        desc.height = height;
+        desc.format = GL_RGBA8;
+        gbuffer.albedo = builder.write(builder.create("gAlbedoSpecular", desc), FrameGraph::CLEAR);
+        desc.format = GL_RG16F;
+        gbuffer.normal = builder.write(builder.create("gNormal", desc), FrameGraph::CLEAR);
+        desc.format = GL_DEPTH24_STENCIL8;
+        gbuffer.depth = builder.write(builder.create("gDepth", desc), FrameGraph::CLEAR);
+        return gbuffer;
+    }
+
+    static void readGBuffer(FrameGraph::Builder& builder, const GBuffer& gbuffer) {
+        builder.read(gbuffer.albedo);
+        builder.read(gbuffer.normal);
+        builder.read(gbuffer.depth);
+    }
+
+    // Lights the G-buffer into `output` (bound by the graph, same size), then copies
+    // the depth over so the forward passes after it (translucent grid) are still
+    // depth tested
+    void lightingPass(const FrameGraph::Context& context, const GBuffer& gbuffer, const Shader& shader,
+                      const ClusteredLighting& lighting, GLuint output = 0) {
+        GLState& gl = GLState::instance();
+        gl.bindTexture(glsl::sampler::gAlbedoSpecular, GL_TEXTURE_2D, context.texture(gbuffer.albedo));
+        gl.bindTexture(glsl::sampler::gNormal, GL_TEXTURE_2D, context.texture(gbuffer.normal));
+        gl.bindTexture(glsl::sampler::gDepth, GL_TEXTURE_2D, context.texture(gbuffer.depth));
+        lighting.bind(shader, context.width(), context.height());
+
+        gl.setEnabled(GL_DEPTH_TEST, false);
+        gl.bindVertexArray(VAO);
+        gl.drawArrays(GL_TRIANGLES, 0, 3);
+        gl.setEnabled(GL_DEPTH_TEST, true);
+
+        // Reattached every frame: the pool deletes textures it hasn't handed out
+        // for a while (e.g. while forward shading) and a new gDepth can get the
+        // deleted one's name, so comparing names can't tell a stale attachment
+        gl.bindFramebuffer(GL_READ_FRAMEBUFFER, depthSource);
+        glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_TEXTURE_2D,
+                               context.texture(gbuffer.depth), 0);
+        glReadBuffer(GL_NONE);
+        gl.bindFramebuffer(GL_DRAW_FRAMEBUFFER, output);
+        glBlitFramebuffer(0, 0, context.width(), context.height(), 0, 0, context.width(), context.height(),
+                          GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+        gl.bindFramebuffer(GL_FRAMEBUFFER, output);
+    }
+
+private:
+    GLuint depthSource = 0;   // Read framebuffer of the depth copy
+    GLuint VAO = 0;
+};
+
+#endif // DEFERRED_SHADING_H
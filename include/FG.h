@@ -1,15 +1,19 @@
+#ifndef FG_H
+#define FG_H
+
 #include <vector>
 #include <glad/glad.h>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include "Shader.h" // Assume you have a Shader class for managing shaders
-
-struct Cube {
-    GLuint VAO, VBO, EBO;
-    GLuint textureID;      // Diffuse texture ID
-    GLuint normalMapID;    // Normal map texture ID
-
-    std::vector<float> vertices = {
+#include "GLState.h"
+#include "Bounds.h"
+#include "PositionStream.h"
+
+// Interleaved vertex data (14 floats: position, normal, uv, tangent, bitangent) and
+// indices of the primitives, shared with their instanced variants in Instancing.h
+inline const std::vector<float>& cubeVertices() {
+    static const std::vector<float> data = {
         // Positions          // Normals           // Texture Coords  // Tangents         // Bitangents
         // Front face
         -0.5f, -0.5f,  0.5f,  0.0f, 0.0f, 1.0f,  0.0f, 0.0f,  1.0f, 0.0f, 0.0f,  0.0f, 1.0f, 0.0f,
@@ -42,8 +46,11 @@ struct Cube {
          0.5f, -0.5f,  0.5f,  0.0f, -1.0f, 0.0f,  0.0f, 0.0f,  1.0f, 0.0f, 0.0f,  0.0f, 0.0f, 1.0f,
         -0.5f, -0.5f,  0.5f,  0.0f, -1.0f, 0.0f,  1.0f, 0.0f,  1.0f, 0.0f, 0.0f,  0.0f, 0.0f, 1.0f
     };
+    return data;
+}
 
-    std::vector<unsigned int> indices = {
+inline const std::vector<unsigned int>& cubeIndices() {
+    static const std::vector<unsigned int> data = {
         0, 1, 2, 2, 3, 0,  // Front
         4, 5, 6, 6, 7, 4,  // Back
         8, 9,10,10,11, 8,  // Left
@@ -51,24 +58,88 @@ struct Cube {
         16,17,18,18,19,16, // Top
         20,21,22,22,23,20  // Bottom
     };
+    return data;
+}
+
+inline const std::vector<float>& pyramidVertices() {
+    static const std::vector<float> data = {
+        // Positions          // Normals            // Tex Coords // Tangents         // Bitangents
+        // Base
+        -0.5f, -0.5f, -0.5f,  0.0f, -1.0f,  0.0f,  0.0f, 0.0f,   1.0f,  0.0f,  0.0f,   0.0f, -1.0f,  0.0f,
+         0.5f, -0.5f, -0.5f,  0.0f, -1.0f,  0.0f,  1.0f, 0.0f,   1.0f,  0.0f,  0.0f,   0.0f, -1.0f,  0.0f,
+         0.5f, -0.5f,  0.5f,  0.0f, -1.0f,  0.0f,  1.0f, 1.0f,   1.0f,  0.0f,  0.0f,   0.0f, -1.0f,  0.0f,
+        -0.5f, -0.5f,  0.5f,  0.0f, -1.0f,  0.0f,  0.0f, 1.0f,   1.0f,  0.0f,  0.0f,   0.0f, -1.0f,  0.0f,
+
+        // Front face
+         0.0f,  0.5f,  0.0f,  0.0f,  0.707f,  0.707f,  0.5f, 1.0f,   1.0f,  0.0f,  0.0f,   0.0f,  1.0f,  0.0f,
+        -0.5f, -0.5f,  0.5f,  0.0f,  0.707f,  0.707f,  0.0f, 0.0f,   1.0f,  0.0f,  0.0f,   0.0f,  1.0f,  0.0f,
+         0.5f, -0.5f,  0.5f,  0.0f,  0.707f,  0.707f,  1.0f, 0.0f,   1.0f,  0.0f,  0.0f,   0.0f,  1.0f,  0.0f,
+
+        // Right face
+         0.0f,  0.5f,  0.0f,  0.707f,  0.707f,  0.0f,  0.5f, 1.0f,   0.0f,  0.0f,  1.0f,   0.0f,  1.0f,  0.0f,
+         0.5f, -0.5f,  0.5f,  0.707f,  0.707f,  0.0f,  0.0f, 0.0f,   0.0f,  0.0f,  1.0f,   0.0f,  1.0f,  0.0f,
+         0.5f, -0.5f, -0.5f,  0.707f,  0.707f,  0.0f,  1.0f, 0.0f,   0.0f,  0.0f,  1.0f,   0.0f,  1.0f,  0.0f,
+
+        // Back face
+         0.0f,  0.5f,  0.0f,  0.0f,  0.707f, -0.707f,  0.5f, 1.0f,   -1.0f,  0.0f,  0.0f,   0.0f,  1.0f,  0.0f,
+         0.5f, -0.5f, -0.5f,  0.0f,  0.707f, -0.707f,  0.0f, 0.0f,   -1.0f,  0.0f,  0.0f,   0.0f,  1.0f,  0.0f,
+        -0.5f, -0.5f, -0.5f,  0.0f,  0.707f, -0.707f,  1.0f, 0.0f,   -1.0f,  0.0f,  0.0f,   0.0f,  1.0f,  0.0f,
+
+        // Left face
+         0.0f,  0.5f,  0.0f, -0.707f,  0.707f,  0.0f,  0.5f, 1.0f,   0.0f,  0.0f, -1.0f,   0.0f,  1.0f,  0.0f,
+        -0.5f, -0.5f, -0.5f, -0.707f,  0.707f,  0.0f,  0.0f, 0.0f,   0.0f,  0.0f, -1.0f,   0.0f,  1.0f,  0.0f,
+        -0.5f, -0.5f,  0.5f, -0.707f,  0.707f,  0.0f,  1.0f, 0.0f,   0.0f,  0.0f, -1.0f,   0.0f,  1.0f,  0.0f
+    };
+    return data;
+}
+
+inline const std::vector<unsigned int>& pyramidIndices() {
+    static const std::vector<unsigned int> data = {
+        0, 1, 2, 2, 3, 0,  // Base
+        4, 5, 6,           // Front
+        7, 8, 9,           // Right
+        10, 11, 12,        // Back
+        13, 14, 15         // Left
+    };
+    return data;
+}
+
+
+struct Cube {
+    GLuint VAO, VBO, EBO;
+    PositionStream depthStream;  // Positions only, for the depth pre-pass
+    GLuint textureID;      // Diffuse texture ID
+    GLuint normalMapID;    // Normal map texture ID
+    AABB bounds;                   // Object-space bounds
+    BoundingSphere boundingSphere;
+
+    std::vector<float> vertices = cubeVertices();
+
+    std::vector<unsigned int> indices = cubeIndices();
 
     glm::mat4 model = glm::mat4(1.0f); // Identity matrix
 
     // Constructor: Creates VAO, VBO, and EBO
     Cube(GLuint textureID, GLuint normalMapID) : textureID(textureID), normalMapID(normalMapID) {
+        computeBounds(vertices.data(), vertices.size() / 14, 14, bounds, boundingSphere);
+
         glGenVertexArrays(1, &VAO);
         glGenBuffers(1, &VBO);
         glGenBuffers(1, &EBO);
 
-        glBindVertexArray(VAO);
+        GLState& gl = GLState::instance();
+        gl.bindVertexArray(VAO);
 
         // Upload vertex data
-        glBindBuffer(GL_ARRAY_BUFFER, VBO);
-        glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STATIC_DRAW);
+        gl.bindBuffer(GL_ARRAY_BUFFER, VBO);
+        GL_CHECK(glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STATIC_DRAW));
 
         // Upload index data
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
+        gl.bindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+        GL_CHECK(glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(),
+                              GL_STATIC_DRAW));
+        GLDebug::label(GL_BUFFER, VBO, "cube vertices");
+        GLDebug::label(GL_BUFFER, EBO, "cube indices");
 
         // Position attribute (location = 0 in shader)
         glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 14 * sizeof(float), (void*)0);
@@ -90,7 +161,9 @@ struct Cube {
         glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, 14 * sizeof(float), (void*)(11 * sizeof(float)));
         glEnableVertexAttribArray(4);
 
-        glBindVertexArray(0);
+        gl.bindVertexArray(0);
+
+        depthStream.create(vertices.data(), vertices.size() / 14, 14, EBO);
     }
 
     // Translation method (updates the model matrix)
@@ -98,25 +171,35 @@ struct Cube {
         model = glm::translate(model, glm::vec3(x, y, z));
     }
 
-    // Draw method (binds textures and draws the cube)
-    void Draw(Shader& shader) {
+    // Binds the textures and draws the cube with the program the caller bound
+    void Draw() {
+        GLState& gl = GLState::instance();
+
         // Bind diffuse texture
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, textureID);
-        shader.setInt("texture1", 0);
+        gl.bindTexture(glsl::sampler::texture1, GL_TEXTURE_2D, textureID);
 
         // Bind normal map texture
-        glActiveTexture(GL_TEXTURE1);
-        glBindTexture(GL_TEXTURE_2D, normalMapID);
-        shader.setInt("normalMap", 1);
+        gl.bindTexture(glsl::sampler::normalMap, GL_TEXTURE_2D, normalMapID);
 
         // Draw the cube
-        glBindVertexArray(VAO);
-        glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, 0);
+        gl.bindVertexArray(VAO);
+        gl.drawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, 0);
+    }
+
+    // Position-only draw for the depth pre-pass; textures are not needed
+    void DrawDepth() {
+        GLState& gl = GLState::instance();
+        gl.bindVertexArray(depthStream.VAO);
+        gl.drawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, 0);
     }
 
     // Destructor to clean up buffers
     ~Cube() {
+        depthStream.release();
+        GLState& gl = GLState::instance();
+        gl.forgetVertexArray(VAO);
+        gl.forgetBuffer(VBO);
+        gl.forgetBuffer(EBO);
         glDeleteVertexArrays(1, &VAO);
         glDeleteBuffers(1, &VBO);
         glDeleteBuffers(1, &EBO);
@@ -129,63 +212,37 @@ struct Cube {
 
 struct Pyramid {
     GLuint VAO, VBO, EBO;
+    PositionStream depthStream;  // Positions only, for the depth pre-pass
     GLuint textureID;
     GLuint normalMapID;
+    AABB bounds;                   // Object-space bounds
+    BoundingSphere boundingSphere;
     glm::mat4 model = glm::mat4(1.0f); // Identity matrix
 
-    std::vector<float> vertices = {
-    // Positions          // Normals            // Tex Coords // Tangents         // Bitangents
-    // Base
-    -0.5f, -0.5f, -0.5f,  0.0f, -1.0f,  0.0f,  0.0f, 0.0f,   1.0f,  0.0f,  0.0f,   0.0f, -1.0f,  0.0f,  
-     0.5f, -0.5f, -0.5f,  0.0f, -1.0f,  0.0f,  1.0f, 0.0f,   1.0f,  0.0f,  0.0f,   0.0f, -1.0f,  0.0f,  
-     0.5f, -0.5f,  0.5f,  0.0f, -1.0f,  0.0f,  1.0f, 1.0f,   1.0f,  0.0f,  0.0f,   0.0f, -1.0f,  0.0f,  
-    -0.5f, -0.5f,  0.5f,  0.0f, -1.0f,  0.0f,  0.0f, 1.0f,   1.0f,  0.0f,  0.0f,   0.0f, -1.0f,  0.0f,  
-
-    // Front face
-     0.0f,  0.5f,  0.0f,  0.0f,  0.707f,  0.707f,  0.5f, 1.0f,   1.0f,  0.0f,  0.0f,   0.0f,  1.0f,  0.0f,  
-    -0.5f, -0.5f,  0.5f,  0.0f,  0.707f,  0.707f,  0.0f, 0.0f,   1.0f,  0.0f,  0.0f,   0.0f,  1.0f,  0.0f,  
-     0.5f, -0.5f,  0.5f,  0.0f,  0.707f,  0.707f,  1.0f, 0.0f,   1.0f,  0.0f,  0.0f,   0.0f,  1.0f,  0.0f,  
-
-    // Right face
-     0.0f,  0.5f,  0.0f,  0.707f,  0.707f,  0.0f,  0.5f, 1.0f,   0.0f,  0.0f,  1.0f,   0.0f,  1.0f,  0.0f,  
-     0.5f, -0.5f,  0.5f,  0.707f,  0.707f,  0.0f,  0.0f, 0.0f,   0.0f,  0.0f,  1.0f,   0.0f,  1.0f,  0.0f,  
-     0.5f, -0.5f, -0.5f,  0.707f,  0.707f,  0.0f,  1.0f, 0.0f,   0.0f,  0.0f,  1.0f,   0.0f,  1.0f,  0.0f,  
-
-    // Back face
-     0.0f,  0.5f,  0.0f,  0.0f,  0.707f, -0.707f,  0.5f, 1.0f,   -1.0f,  0.0f,  0.0f,   0.0f,  1.0f,  0.0f,  
-     0.5f, -0.5f, -0.5f,  0.0f,  0.707f, -0.707f,  0.0f, 0.0f,   -1.0f,  0.0f,  0.0f,   0.0f,  1.0f,  0.0f,  
-    -0.5f, -0.5f, -0.5f,  0.0f,  0.707f, -0.707f,  1.0f, 0.0f,   -1.0f,  0.0f,  0.0f,   0.0f,  1.0f,  0.0f,  
-
-    // Left face
-     0.0f,  0.5f,  0.0f, -0.707f,  0.707f,  0.0f,  0.5f, 1.0f,   0.0f,  0.0f, -1.0f,   0.0f,  1.0f,  0.0f,  
-    -0.5f, -0.5f, -0.5f, -0.707f,  0.707f,  0.0f,  0.0f, 0.0f,   0.0f,  0.0f, -1.0f,   0.0f,  1.0f,  0.0f,  
-    -0.5f, -0.5f,  0.5f, -0.707f,  0.707f,  0.0f,  1.0f, 0.0f,   0.0f,  0.0f, -1.0f,   0.0f,  1.0f,  0.0f,  
-};
-
-
-    std::vector<unsigned int> indices = {
-        0, 1, 2, 2, 3, 0,  // Base
-        4, 5, 6,           // Front
-        7, 8, 9,           // Right
-        10, 11, 12,        // Back
-        13, 14, 15         // Left
-    };
+    std::vector<float> vertices = pyramidVertices();
+    std::vector<unsigned int> indices = pyramidIndices();
 
     // Constructor: Creates VAO, VBO, and EBO
     Pyramid(GLuint textureID, GLuint normalMapID) : textureID(textureID), normalMapID(normalMapID) {
+        computeBounds(vertices.data(), vertices.size() / 14, 14, bounds, boundingSphere);
+
         glGenVertexArrays(1, &VAO);
         glGenBuffers(1, &VBO);
         glGenBuffers(1, &EBO);
 
-        glBindVertexArray(VAO);
+        GLState& gl = GLState::instance();
+        gl.bindVertexArray(VAO);
 
         // Upload vertex data
-        glBindBuffer(GL_ARRAY_BUFFER, VBO);
-        glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STATIC_DRAW);
+        gl.bindBuffer(GL_ARRAY_BUFFER, VBO);
+        GL_CHECK(glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STATIC_DRAW));
 
         // Upload index data
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
+        gl.bindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+        GL_CHECK(glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(),
+                              GL_STATIC_DRAW));
+        GLDebug::label(GL_BUFFER, VBO, "pyramid vertices");
+        GLDebug::label(GL_BUFFER, EBO, "pyramid indices");
 
         // Position attribute (location = 0 in shader)
         glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 14 * sizeof(float), (void*)0);
@@ -207,7 +264,9 @@ struct Pyramid {
         glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, 14 * sizeof(float), (void*)(11 * sizeof(float)));
         glEnableVertexAttribArray(4);
 
-        glBindVertexArray(0);
+        gl.bindVertexArray(0);
+
+        depthStream.create(vertices.data(), vertices.size() / 14, 14, EBO);
     }
 
     // Translation method (updates the model matrix)
@@ -215,25 +274,35 @@ struct Pyramid {
         model = glm::translate(model, glm::vec3(x, y, z));
     }
 
-    // Draw method (binds textures and draws the pyramid)
-    void Draw(Shader& shader) {
+    // Binds the textures and draws the pyramid with the program the caller bound
+    void Draw() {
+        GLState& gl = GLState::instance();
+
         // Bind diffuse texture
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, textureID);
-        shader.setInt("texture1", 0);
+        gl.bindTexture(glsl::sampler::texture1, GL_TEXTURE_2D, textureID);
 
         // Bind normal map texture
-        glActiveTexture(GL_TEXTURE1);
-        glBindTexture(GL_TEXTURE_2D, normalMapID);
-        shader.setInt("normalMap", 1);
+        gl.bindTexture(glsl::sampler::normalMap, GL_TEXTURE_2D, normalMapID);
 
         // Draw the pyramid
-        glBindVertexArray(VAO);
-        glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, 0);
+        gl.bindVertexArray(VAO);
+        gl.drawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, 0);
+    }
+
+    // Position-only draw for the depth pre-pass; textures are not needed
+    void DrawDepth() {
+        GLState& gl = GLState::instance();
+        gl.bindVertexArray(depthStream.VAO);
+        gl.drawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, 0);
     }
 
     // Destructor to clean up buffers
     ~Pyramid() {
+        depthStream.release();
+        GLState& gl = GLState::instance();
+        gl.forgetVertexArray(VAO);
+        gl.forgetBuffer(VBO);
+        gl.forgetBuffer(EBO);
         glDeleteVertexArrays(1, &VAO);
         glDeleteBuffers(1, &VBO);
         glDeleteBuffers(1, &EBO);
@@ -256,10 +325,75 @@ struct Pyramid {
 #define NUM_LATITUDE_SEGMENTS 64
 #define NUM_LONGITUDE_SEGMENTS 64
 
+// UV sphere of radius `radius` in the interleaved primitive layout
+inline void buildSphereGeometry(float radius, std::vector<float>& vertices, std::vector<GLuint>& indices) {
+    for (int i = 0; i <= NUM_LATITUDE_SEGMENTS; ++i) {
+        float phi = glm::pi<float>() * i / NUM_LATITUDE_SEGMENTS;
+        for (int j = 0; j <= NUM_LONGITUDE_SEGMENTS; ++j) {
+            float theta = glm::two_pi<float>() * j / NUM_LONGITUDE_SEGMENTS;
+
+            float x = sin(phi) * cos(theta);
+            float y = cos(phi);
+            float z = sin(phi) * sin(theta);
+
+            glm::vec3 pos = radius * glm::vec3(x, y, z);
+            glm::vec3 normal = glm::normalize(glm::vec3(x, y, z));
+            float u = (float)j / NUM_LONGITUDE_SEGMENTS;
+            float v = (float)i / NUM_LATITUDE_SEGMENTS;
+
+            // Approximate tangent vector (not mathematically perfect, but sufficient for smooth sphere)
+            glm::vec3 tangent = glm::normalize(glm::vec3(-sin(theta), 0, cos(theta)));
+            glm::vec3 bitangent = glm::normalize(glm::cross(normal, tangent));
+
+            // Position
+            vertices.push_back(pos.x);
+            vertices.push_back(pos.y);
+            vertices.push_back(pos.z);
+
+            // Normal
+            vertices.push_back(normal.x);
+            vertices.push_back(normal.y);
+            vertices.push_back(normal.z);
+
+            // TexCoords
+            vertices.push_back(u);
+            vertices.push_back(v);
+
+            // Tangent
+            vertices.push_back(tangent.x);
+            vertices.push_back(tangent.y);
+            vertices.push_back(tangent.z);
+
+            // Bitangent
+            vertices.push_back(bitangent.x);
+            vertices.push_back(bitangent.y);
+            vertices.push_back(bitangent.z);
+        }
+    }
+
+    for (int i = 0; i < NUM_LATITUDE_SEGMENTS; ++i) {
+        for (int j = 0; j < NUM_LONGITUDE_SEGMENTS; ++j) {
+            int first = i * (NUM_LONGITUDE_SEGMENTS + 1) + j;
+            int second = first + NUM_LONGITUDE_SEGMENTS + 1;
+
+            indices.push_back(first);
+            indices.push_back(second);
+            indices.push_back(first + 1);
+
+            indices.push_back(second);
+            indices.push_back(second + 1);
+            indices.push_back(first + 1);
+        }
+    }
+}
+
 struct Sphere {
     GLuint VAO, VBO, EBO;
+    PositionStream depthStream;  // Positions only, for the depth pre-pass
     GLuint diffuseID, normalMapID;
     float radius;
+    AABB bounds;                   // Object-space bounds
+    BoundingSphere boundingSphere;
     std::vector<GLuint> indices;
 
     Sphere(float r, GLuint diffuse, GLuint normalMap)
@@ -269,77 +403,25 @@ struct Sphere {
 
     void setupSphere() {
         std::vector<float> vertices;
+        buildSphereGeometry(radius, vertices, indices);
 
-        for (int i = 0; i <= NUM_LATITUDE_SEGMENTS; ++i) {
-            float phi = glm::pi<float>() * i / NUM_LATITUDE_SEGMENTS;
-            for (int j = 0; j <= NUM_LONGITUDE_SEGMENTS; ++j) {
-                float theta = glm::two_pi<float>() * j / NUM_LONGITUDE_SEGMENTS;
-
-                float x = sin(phi) * cos(theta);
-                float y = cos(phi);
-                float z = sin(phi) * sin(theta);
-
-                glm::vec3 pos = radius * glm::vec3(x, y, z);
-                glm::vec3 normal = glm::normalize(glm::vec3(x, y, z));
-                float u = (float)j / NUM_LONGITUDE_SEGMENTS;
-                float v = (float)i / NUM_LATITUDE_SEGMENTS;
-
-                // Approximate tangent vector (not mathematically perfect, but sufficient for smooth sphere)
-                glm::vec3 tangent = glm::normalize(glm::vec3(-sin(theta), 0, cos(theta)));
-                glm::vec3 bitangent = glm::normalize(glm::cross(normal, tangent));
-
-                // Position
-                vertices.push_back(pos.x);
-                vertices.push_back(pos.y);
-                vertices.push_back(pos.z);
-
-                // Normal
-                vertices.push_back(normal.x);
-                vertices.push_back(normal.y);
-                vertices.push_back(normal.z);
-
-                // TexCoords
-                vertices.push_back(u);
-                vertices.push_back(v);
-
-                // Tangent
-                vertices.push_back(tangent.x);
-                vertices.push_back(tangent.y);
-                vertices.push_back(tangent.z);
-
-                // Bitangent
-                vertices.push_back(bitangent.x);
-                vertices.push_back(bitangent.y);
-                vertices.push_back(bitangent.z);
-            }
-        }
-
-        for (int i = 0; i < NUM_LATITUDE_SEGMENTS; ++i) {
-            for (int j = 0; j < NUM_LONGITUDE_SEGMENTS; ++j) {
-                int first = i * (NUM_LONGITUDE_SEGMENTS + 1) + j;
-                int second = first + NUM_LONGITUDE_SEGMENTS + 1;
-
-                indices.push_back(first);
-                indices.push_back(second);
-                indices.push_back(first + 1);
-
-                indices.push_back(second);
-                indices.push_back(second + 1);
-                indices.push_back(first + 1);
-            }
-        }
+        computeBounds(vertices.data(), vertices.size() / 14, 14, bounds, boundingSphere);
 
         glGenVertexArrays(1, &VAO);
         glGenBuffers(1, &VBO);
         glGenBuffers(1, &EBO);
 
-        glBindVertexArray(VAO);
+        GLState& gl = GLState::instance();
+        gl.bindVertexArray(VAO);
 
-        glBindBuffer(GL_ARRAY_BUFFER, VBO);
-        glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STATIC_DRAW);
+        gl.bindBuffer(GL_ARRAY_BUFFER, VBO);
+        GL_CHECK(glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STATIC_DRAW));
 
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLuint), indices.data(), GL_STATIC_DRAW);
+        gl.bindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+        GL_CHECK(glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLuint), indices.data(),
+                              GL_STATIC_DRAW));
+        GLDebug::label(GL_BUFFER, VBO, "sphere vertices");
+        GLDebug::label(GL_BUFFER, EBO, "sphere indices");
 
         // Position
         glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 14 * sizeof(float), (void*)0);
@@ -361,24 +443,41 @@ struct Sphere {
         glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, 14 * sizeof(float), (void*)(11 * sizeof(float)));
         glEnableVertexAttribArray(4);
 
-        glBindVertexArray(0);
+        gl.bindVertexArray(0);
+
+        depthStream.create(vertices.data(), vertices.size() / 14, 14, EBO);
     }
 
     void draw(const Shader& shader) {
+        GLState& gl = GLState::instance();
         shader.use();
 
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, diffuseID);
-        shader.setInt("texture1", 0);
+        gl.bindTexture(glsl::sampler::texture1, GL_TEXTURE_2D, diffuseID);
+        gl.bindTexture(glsl::sampler::normalMap, GL_TEXTURE_2D, normalMapID);
+
+        gl.bindVertexArray(VAO);
+        gl.drawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, 0);
+    }
 
-        glActiveTexture(GL_TEXTURE1);
-        glBindTexture(GL_TEXTURE_2D, normalMapID);
-        shader.setInt("normalMap", 1);
+    // Position-only draw for the depth pre-pass
+    void drawDepth() {
+        GLState& gl = GLState::instance();
+        gl.bindVertexArray(depthStream.VAO);
+        gl.drawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, 0);
+    }
 
-        glBindVertexArray(VAO);
-        glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, 0);
-        glBindVertexArray(0);
+    ~Sphere() {
+        depthStream.release();
+        GLState& gl = GLState::instance();
+        gl.forgetVertexArray(VAO);
+        gl.forgetBuffer(VBO);
+        gl.forgetBuffer(EBO);
+        glDeleteVertexArrays(1, &VAO);
+        glDeleteBuffers(1, &VBO);
+        glDeleteBuffers(1, &EBO);
     }
 };
 
 #endif
+
+#endif // FG_H
@@ -0,0 +1,141 @@
+#ifndef FRAME_CAPTURE_H
+#define FRAME_CAPTURE_H
+
+#include <cmath>
+#include <cctype>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <fstream>
+#include <algorithm>
+#include "Profiler.h"
+
+// Output of headless runs: frames as binary PPM, timings as JSON.
+
+// `rgb` holds top-down rows of width * 3 bytes
+inline bool writePPM(const std::string& path, int width, int height, const std::vector<unsigned char>& rgb) {
+    std::ofstream file(path, std::ios::binary);
+    if (!file.is_open()) return false;
+    file << "P6\n" << width << " " << height << "\n255\n";
+    file.write((const char*)rgb.data(), (std::streamsize)width * height * 3);
+    return file.good();
+}
+
+// Reads what writePPM() writes: binary P6 with a maxval of 255, '#' comments allowed
+inline bool readPPM(const std::string& path, int& width, int& height, std::vector<unsigned char>& rgb) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) return false;
+    auto field = [&](std::string& token) {
+        token.clear();
+        char c;
+        while (file.get(c)) {
+            if (c == '#') {
+                while (file.get(c) && c != '\n') {}
+            } else if (!std::isspace((unsigned char)c)) {
+                token += c;
+            } else if (!token.empty()) {
+                return true;   // Consumes the single whitespace after the field
+            }
+        }
+        return !token.empty();
+    };
+    std::string magic, w, h, maxval;
+    if (!field(magic) || magic != "P6" || !field(w) || !field(h) || !field(maxval) || maxval != "255") return false;
+    width = std::atoi(w.c_str());
+    height = std::atoi(h.c_str());
+    if (width <= 0 || height <= 0) return false;
+    rgb.resize((size_t)width * height * 3);
+    file.read((char*)rgb.data(), (std::streamsize)rgb.size());
+    return (bool)file;
+}
+
+// Per-frame CPU and GPU times of a run, written as
+//   { "frames": N, "simulation_ms": {...}, "render_ms": {...}, "gpu_ms": {...},
+//     "scopes": [...], "per_frame": [[index, simulation, render, gpu], ...] }
+// where each {...} holds mean, min, max, p50, p95 and p99, and "scopes" the
+// profiler's averages.
+class FrameTimings {
+public:
+    struct Frame {
+        unsigned index;
+        float simulationMs;
+        float renderMs;
+        float gpuMs;   // Negative when no GPU result arrived that frame (they lag a few frames)
+    };
+
+    struct Summary {
+        double mean = 0.0, min = 0.0, max = 0.0, p50 = 0.0, p95 = 0.0, p99 = 0.0;
+        size_t count = 0;
+    };
+
+    void reserve(size_t count) { frames.reserve(count); }
+    void add(const Frame& frame) { frames.push_back(frame); }
+    const std::vector<Frame>& all() const { return frames; }
+
+    // Negative values are skipped; percentiles are nearest-rank
+    static Summary summarize(std::vector<float> values) {
+        values.erase(std::remove_if(values.begin(), values.end(), [](float v) { return v < 0.0f; }), values.end());
+        Summary summary;
+        summary.count = values.size();
+        if (values.empty()) return summary;
+        std::sort(values.begin(), values.end());
+        double sum = 0.0;
+        for (float v : values) sum += v;
+        auto rank = [&](double p) { return values[std::min(values.size() - 1, (size_t)std::ceil(p * values.size()) - 1)]; };
+        summary.mean = sum / values.size();
+        summary.min = values.front();
+        summary.max = values.back();
+        summary.p50 = rank(0.50);
+        summary.p95 = rank(0.95);
+        summary.p99 = rank(0.99);
+        return summary;
+    }
+
+    Summary summary(float Frame::*field) const {
+        std::vector<float> values;
+        values.reserve(frames.size());
+        for (const Frame& frame : frames) values.push_back(frame.*field);
+        return summarize(values);
+    }
+
+    bool writeJson(const std::string& path, const Profiler& profiler) const {
+        std::ofstream file(path);
+        if (!file.is_open()) return false;
+        char number[64];
+        auto value = [&](double v) {
+            std::snprintf(number, sizeof(number), "%.4f", v);
+            return std::string(number);
+        };
+        auto summaryJson = [&](const Summary& s) {
+            return "{\"mean\": " + value(s.mean) + ", \"min\": " + value(s.min) + ", \"max\": " + value(s.max) +
+                   ", \"p50\": " + value(s.p50) + ", \"p95\": " + value(s.p95) + ", \"p99\": " + value(s.p99) +
+                   ", \"count\": " + std::to_string(s.count) + "}";
+        };
+
+        file << "{\n  \"frames\": " << frames.size() << ",\n";
+        file << "  \"simulation_ms\": " << summaryJson(summary(&Frame::simulationMs)) << ",\n";
+        file << "  \"render_ms\": " << summaryJson(summary(&Frame::renderMs)) << ",\n";
+        file << "  \"gpu_ms\": " << summaryJson(summary(&Frame::gpuMs)) << ",\n";
+        file << "  \"scopes\": [";
+        const std::vector<Profiler::Result>& scopes = profiler.results();
+        for (size_t i = 0; i < scopes.size(); ++i) {
+            file << (i ? ",\n    " : "\n    ") << "{\"path\": \"" << scopes[i].path << "\", \"cpu_ms\": "
+                 << value(scopes[i].cpuMs.mean()) << ", \"gpu_ms\": " << value(scopes[i].gpuMs.mean()) << "}";
+        }
+        file << "\n  ],\n  \"per_frame\": [";
+        for (size_t i = 0; i < frames.size(); ++i) {
+            const Frame& frame = frames[i];
+            file << (i ? ",\n    " : "\n    ") << "[" << frame.index << ", " << value(frame.simulationMs) << ", "
+                 << value(frame.renderMs) << ", " << (frame.gpuMs < 0.0f ? std::string("null") : value(frame.gpuMs))
+                 << "]";
+        }
+        file << "\n  ]\n}\n";
+        return file.good();
+    }
+
+private:
+    std::vector<Frame> frames;
+};
+
+#endif // FRAME_CAPTURE_H
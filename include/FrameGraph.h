@@ -0,0 +1,209 @@
+#ifndef FRAME_GRAPH_H
+#define FRAME_GRAPH_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <functional>
+#include <glad/glad.h>
+
+// Per-frame render graph. Passes declare which virtual render targets they read
+// and write. compile() then:
+//   1. culls   walking back from the passes with side effects (writes to an
+//              imported target such as the window), drops every pass whose
+//              output nothing live reads
+//   2. orders  live passes in declaration order, which is a valid order by
+//              construction: a pass can only read what earlier passes wrote
+//   3. places  every transient target in a physical texture slot. Targets whose
+//              lifetimes (first to last live use) don't overlap and whose
+//              descriptions match share a slot, so a G-buffer that dies before
+//              the post chain starts lends it its memory.
+// execute() takes the slots' textures from a RenderTargetPool, binds a
+// framebuffer with each pass's written targets attached, clears the attachments
+// the pass asked to clear (and only those), and runs the pass.
+//
+// Compiling touches no GL, so the graph can be built and checked on any thread;
+// only execute() needs the context.
+//
+// Frame:
+//   reset()
+//   import(...)                    the window or scene target
+//   addPass(name, setup, execute)  setup declares create/read/write through the Builder
+//   compile()
+//   execute(pool)
+class RenderTargetPool;
+
+class FrameGraph {
+public:
+    typedef uint32_t Resource;
+    static const Resource INVALID = 0xFFFFFFFFu;
+
+    struct TextureDesc {
+        int width = 0, height = 0;
+        GLenum format = GL_RGBA8;   // Sized internal format
+
+        bool operator==(const TextureDesc& other) const {
+            return width == other.width && height == other.height && format == other.format;
+        }
+        bool isDepth() const;
+        size_t bytes() const;
+    };
+
+    // What a write does with the target's previous contents
+    enum Load {
+        LOAD,         // Keep them; the pass also depends on the previous writer
+        CLEAR,        // Clear to zero colour / far depth first
+        DONT_CARE     // The pass covers every pixel
+    };
+
+    class Builder {
+    public:
+        Resource create(const std::string& name, const TextureDesc& desc);
+        Resource read(Resource resource);
+        Resource write(Resource resource, Load load = LOAD);
+        // Never culled, e.g. a pass that only reads back or blits
+        void sideEffect();
+
+    private:
+        friend class FrameGraph;
+        Builder(FrameGraph& graph, uint32_t pass) : graph(graph), pass(pass) {}
+        FrameGraph& graph;
+        uint32_t pass;
+    };
+
+    // Textures of the targets a pass reads; valid inside its execute callback
+    class Context {
+    public:
+        GLuint texture(Resource resource) const;
+        int width() const { return viewportWidth; }
+        int height() const { return viewportHeight; }
+
+    private:
+        friend class FrameGraph;
+        explicit Context(const FrameGraph& graph) : graph(graph) {}
+        const FrameGraph& graph;
+        int viewportWidth = 0, viewportHeight = 0;
+    };
+
+    typedef std::function<void(Builder&)> SetupFn;
+    typedef std::function<void(const Context&)> ExecuteFn;
+
+    struct Stats {
+        unsigned passes = 0;
+        unsigned culled = 0;
+        unsigned transients = 0;      // Live transient targets
+        unsigned textures = 0;        // Physical slots they were placed in
+        size_t requestedBytes = 0;    // Every live transient in its own texture
+        size_t allocatedBytes = 0;    // The slots, i.e. this frame's peak transient memory
+        float compileMs = 0.0f;
+    };
+
+    // Start a new frame's graph; the pool keeps the textures
+    void reset();
+
+    // A target owned outside the graph. `framebuffer` is what passes writing it
+    // render into; such writes are side effects. `texture` (optional) is returned
+    // to readers.
+    Resource import(const std::string& name, const TextureDesc& desc, GLuint framebuffer, GLuint texture = 0);
+
+    void addPass(const std::string& name, const SetupFn& setup, const ExecuteFn& execute);
+
+    // false (with the reason on std::cerr) when a pass reads a target nothing
+    // wrote or writes targets of different sizes
+    bool compile();
+    void execute(RenderTargetPool& pool);
+
+    const Stats& stats() const { return lastStats; }
+
+    // After compile(): the live passes in execution order, and the slot and
+    // lifetime (positions in that order) of a transient; -1 for culled or unused ones
+    const std::vector<uint32_t>& order() const { return executionOrder; }
+    const std::string& passName(uint32_t pass) const { return passes[pass].name; }
+    int slot(Resource resource) const { return resources[resource].slot; }
+    int firstUse(Resource resource) const { return resources[resource].firstUse; }
+    int lastUse(Resource resource) const { return resources[resource].lastUse; }
+    size_t resourceCount() const { return resources.size(); }
+    const std::vector<TextureDesc>& slots() const { return slotDescs; }
+
+private:
+    struct Access {
+        Resource resource;
+        Load load;
+    };
+
+    struct Pass {
+        std::string name;
+        ExecuteFn execute;
+        std::vector<Resource> reads;
+        std::vector<Access> writes;
+        bool sideEffect = false;
+        bool live = false;
+    };
+
+    struct ResourceNode {
+        std::string name;
+        TextureDesc desc;
+        bool imported = false;
+        GLuint framebuffer = 0;
+        GLuint texture = 0;           // Imported, or the slot's texture during execute()
+        int firstUse = -1, lastUse = -1;   // Positions in executionOrder
+        int slot = -1;
+    };
+
+    std::vector<Pass> passes;
+    std::vector<ResourceNode> resources;
+    std::vector<uint32_t> executionOrder;
+    std::vector<TextureDesc> slotDescs;
+    bool compiled = false;
+    Stats lastStats;
+
+    void cull();
+    bool computeLifetimes();
+    void placeSlots();
+};
+
+// The GL side of the graph: textures handed out by description, reused from
+// frame to frame, and framebuffers cached by their attachments. Textures not
+// handed out for RELEASE_AFTER frames (e.g. the old size after a resize) are
+// deleted.
+class RenderTargetPool {
+public:
+    static const unsigned RELEASE_AFTER = 30;
+
+    RenderTargetPool() = default;
+    RenderTargetPool(const RenderTargetPool&) = delete;
+    RenderTargetPool& operator=(const RenderTargetPool&) = delete;
+    ~RenderTargetPool();
+
+    // Frame boundaries; textures are handed out between them
+    void beginFrame();
+    void endFrame();
+
+    GLuint acquire(const FrameGraph::TextureDesc& desc);
+    // Framebuffer with `colors` on COLOR_ATTACHMENT0.. and `depth` (0: none)
+    GLuint framebuffer(const std::vector<GLuint>& colors, GLuint depth, bool depthStencil);
+
+    size_t allocatedBytes() const;   // Everything the pool holds, idle textures included
+
+private:
+    struct Entry {
+        FrameGraph::TextureDesc desc;
+        GLuint texture;
+        unsigned lastFrame;
+        bool taken;
+    };
+
+    struct Target {
+        std::vector<GLuint> colors;
+        GLuint depth;
+        GLuint framebuffer;
+    };
+
+    std::vector<Entry> entries;
+    std::vector<Target> framebuffers;
+    unsigned frame = 0;
+
+    void release(Entry& entry);
+};
+
+#endif // FRAME_GRAPH_H
@@ -0,0 +1,101 @@
+#ifndef FRAME_PIPELINE_H
+#define FRAME_PIPELINE_H
+
+#include <mutex>
+#include <chrono>
+#include <condition_variable>
+
+// Hands frame snapshots from a producer thread (simulation) to a consumer thread
+// (rendering) through SLOTS preallocated slots used in turn. The producer fills
+// frame N+1 while the consumer still draws frame N. A snapshot isn't touched by the
+// producer again until the consumer releases it.
+//
+// The ring is the bounded queue: with every slot queued or being drawn, acquire()
+// blocks, so the simulation is never more than SLOTS - 1 frames ahead of what is on
+// screen. Two slots is plain double buffering (no frame queued ahead); three lets
+// one finished frame wait while the next is simulated.
+template <typename T, unsigned SLOTS = 3>
+class FramePipeline {
+public:
+    static_assert(SLOTS >= 2, "the producer and the consumer each need a slot");
+    static const unsigned SLOT_COUNT = SLOTS;
+
+    struct Stats {
+        unsigned long long frames = 0;   // Released by the consumer
+        double producerWaitMs = 0.0;     // acquire() blocked: rendering is the bottleneck
+        double consumerWaitMs = 0.0;     // next() blocked: simulation is the bottleneck
+    };
+
+    // For setting up the slots (e.g. sizing their vectors) before the threads start
+    T& slot(unsigned index) { return slots[index]; }
+
+    // Producer: the next slot to fill, or nullptr once closed
+    T* acquire() {
+        std::unique_lock<std::mutex> lock(mutex);
+        wait(lock, freed, counters.producerWaitMs, [this] { return closed || acquired - released < SLOTS; });
+        if (closed) return nullptr;
+        return &slots[acquired++ % SLOTS];
+    }
+
+    // Producer: the slot from acquire() is complete
+    void publish() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            ++published;
+        }
+        ready.notify_one();
+    }
+
+    // Consumer: the oldest published snapshot, or nullptr once closed and drained
+    const T* next() {
+        std::unique_lock<std::mutex> lock(mutex);
+        wait(lock, ready, counters.consumerWaitMs, [this] { return closed || published > taken; });
+        if (published == taken) return nullptr;
+        return &slots[taken++ % SLOTS];
+    }
+
+    // Consumer: done with the snapshot from next()
+    void release() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            ++released;
+            ++counters.frames;
+        }
+        freed.notify_one();
+    }
+
+    // Wakes both sides; acquire() fails from now on, next() after the queue drains
+    void close() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            closed = true;
+        }
+        ready.notify_all();
+        freed.notify_all();
+    }
+
+    Stats stats() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return counters;
+    }
+
+private:
+    T slots[SLOTS];
+    std::mutex mutex;
+    std::condition_variable ready;   // Signalled on publish
+    std::condition_variable freed;   // Signalled on release
+    unsigned long long acquired = 0, published = 0, taken = 0, released = 0;
+    bool closed = false;
+    Stats counters;
+
+    template <typename Predicate>
+    static void wait(std::unique_lock<std::mutex>& lock, std::condition_variable& signal, double& waitedMs,
+                     Predicate done) {
+        if (done()) return;
+        auto start = std::chrono::steady_clock::now();
+        signal.wait(lock, done);
+        waitedMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+};
+
+#endif // FRAME_PIPELINE_H
@@ -0,0 +1,54 @@
+#ifndef FRUSTUM_CULLER_H
+#define FRUSTUM_CULLER_H
+
+#include <vector>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include "Bounds.h"
+#include "JobPool.h"
+
+// Tests world-space AABBs against the view frustum in batches of 4 (SSE) or
+// 8 (AVX) boxes. Bounds are kept as structure-of-arrays (centre/extent per axis)
+// so one plane is evaluated for a whole batch per instruction.
+class FrustumCuller {
+public:
+    struct Stats {
+        unsigned int tested = 0;
+        unsigned int culled = 0;
+    };
+
+    // Planes come from the combined clip matrix, i.e. projection * view
+    void setFrustum(const glm::mat4& viewProjection);
+
+    void clear();
+    // Returns the index to query visible() with
+    uint32_t add(const AABB& worldBounds);
+
+    // Tests everything added since clear(); large sets are split over the pool
+    void cull(JobPool& pool = JobPool::shared());
+
+    bool visible(uint32_t index) const { return visibility[index] != 0; }
+    size_t size() const { return count; }
+    const Stats& stats() const { return lastStats; }
+
+    // Plane i is (normal.xyz, d) with the inside where dot(normal, p) + d >= 0
+    const glm::vec4& plane(int i) const { return planes[i]; }
+
+    // Sets below this size are tested on the calling thread
+    size_t parallelThreshold = 8192;
+
+    static const size_t BATCH = 8;
+
+private:
+    glm::vec4 planes[6];
+    size_t count = 0;
+    std::vector<float> centerX, centerY, centerZ;
+    std::vector<float> extentX, extentY, extentZ;
+    std::vector<uint8_t> visibility;
+    Stats lastStats;
+
+    // Tests boxes [begin, end); both are multiples of BATCH
+    void cullRange(size_t begin, size_t end);
+};
+
+#endif // FRUSTUM_CULLER_H
@@ -0,0 +1,82 @@
+#ifndef GL_DEBUG_H
+#define GL_DEBUG_H
+
+#include <cstring>
+#include <glad/glad.h>
+
+// GL error checking and debug output, compiled in only with ENGINE_GL_DEBUG
+// (CMake defines it for Debug builds). Without it GL_CHECK(call) is the bare
+// call, GL_CHECKPOINT is nothing and the functions below are empty inlines, so
+// release builds issue exactly the same GL calls as unwrapped code.
+//
+//   GL_CHECK(glTexImage2D(...));       drains glGetError after the call and
+//                                      reports it with the call text, file and line
+//   GL_CHECKPOINT("frame");            same, for everything since the last check
+//   GLDebug::label(GL_BUFFER, id, "x") names an object in debug output and in
+//                                      capture tools (RenderDoc, apitrace)
+//
+// Each failing call site and each debug message is reported once, with a count
+// of repeats at exit, so an error inside the frame loop doesn't flood the log.
+namespace GLDebug {
+
+// Which debug output messages reach the log. The masks are bit sets over the
+// SOURCE_* and TYPE_* indices; a message passes when its source and type bits
+// are set and it is at least minSeverity.
+struct Filter {
+    enum Source { SOURCE_API, SOURCE_WINDOW_SYSTEM, SOURCE_SHADER_COMPILER, SOURCE_THIRD_PARTY,
+                  SOURCE_APPLICATION, SOURCE_OTHER, SOURCE_COUNT };
+    enum Type { TYPE_ERROR, TYPE_DEPRECATED, TYPE_UNDEFINED, TYPE_PORTABILITY, TYPE_PERFORMANCE,
+                TYPE_MARKER, TYPE_PUSH_GROUP, TYPE_POP_GROUP, TYPE_OTHER, TYPE_COUNT };
+    enum Severity { NOTIFICATION, LOW, MEDIUM, HIGH };
+
+    unsigned sources = (1u << SOURCE_COUNT) - 1;
+    // Group and marker messages only echo the application's own annotations
+    unsigned types = ((1u << TYPE_COUNT) - 1) & ~(1u << TYPE_MARKER | 1u << TYPE_PUSH_GROUP | 1u << TYPE_POP_GROUP);
+    Severity minSeverity = LOW;
+
+    // "high", "medium", "low" or "notification"; false for anything else
+    static bool parseSeverity(const char* text, Severity& severity);
+};
+
+#ifdef ENGINE_GL_DEBUG
+const bool ENABLED = true;
+
+// Registers the debug output callback (synchronous, so the reported stack is
+// the offending call's) and applies the filter. Needs GL 4.3; on older
+// contexts only GL_CHECK reports errors. Call again to change the filter.
+void enable(const Filter& filter = Filter());
+
+// glObjectLabel where debug output is available. identifier is GL_BUFFER,
+// GL_TEXTURE, GL_PROGRAM, GL_FRAMEBUFFER, GL_VERTEX_ARRAY, ...
+void label(GLenum identifier, GLuint name, const char* text);
+
+// Drains glGetError; false (after reporting) when anything was pending
+bool check(const char* what, const char* file, int line);
+
+#define GL_CHECK(call) do { call; GLDebug::check(#call, __FILE__, __LINE__); } while (0)
+#define GL_CHECKPOINT(what) GLDebug::check(what, __FILE__, __LINE__)
+#else
+const bool ENABLED = false;
+
+inline void enable(const Filter& = Filter()) {}
+inline void label(GLenum, GLuint, const char*) {}
+inline bool check(const char*, const char*, int) { return true; }
+
+#define GL_CHECK(call) call
+#define GL_CHECKPOINT(what) ((void)0)
+#endif
+
+inline bool Filter::parseSeverity(const char* text, Severity& severity) {
+    static const char* const names[] = {"notification", "low", "medium", "high"};
+    for (int i = 0; i < 4; ++i) {
+        if (std::strcmp(text, names[i]) == 0) {
+            severity = (Severity)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace GLDebug
+
+#endif // GL_DEBUG_H
@@ -0,0 +1,318 @@
+#ifndef GL_STATE_H
+#define GL_STATE_H
+
+#include <glad/glad.h>
+#include "GLDebug.h"
+
+// Thin cache over the GL binding/enable state. Every call that would not change
+// the driver state is dropped and counted, so redundant binds from the draw code
+// cost a compare instead of a driver call. The calls it does forward are
+// checked for GL errors in debug builds (GLDebug.h).
+class GLState {
+public:
+    static const unsigned int MAX_TEXTURE_UNITS = 32;
+
+    struct Stats {
+        unsigned int issued = 0;   // Calls forwarded to the driver
+        unsigned int filtered = 0; // Calls skipped because the state already matched
+        unsigned int draws = 0;    // Draw calls
+        unsigned int instances = 0; // Instances drawn by those calls
+    };
+
+    static GLState& instance() {
+        static GLState state;
+        return state;
+    }
+
+    void useProgram(GLuint program) {
+        if (!changed(program_, program)) return;
+        GL_CHECK(glUseProgram(program));
+    }
+
+    void bindVertexArray(GLuint vao) {
+        if (!changed(vertexArray_, vao)) return;
+        GL_CHECK(glBindVertexArray(vao));
+        // The element array binding is part of the VAO
+        buffers_[ELEMENT_ARRAY] = UNKNOWN;
+    }
+
+    void activeTexture(GLuint unit) {
+        if (!changed(activeUnit_, unit)) return;
+        GL_CHECK(glActiveTexture(GL_TEXTURE0 + unit));
+    }
+
+    // Binds `texture` to `target` on texture unit `unit`
+    void bindTexture(GLuint unit, GLenum target, GLuint texture) {
+        if (unit >= MAX_TEXTURE_UNITS) {
+            ++frame_.issued;
+            GL_CHECK(glActiveTexture(GL_TEXTURE0 + unit));
+            GL_CHECK(glBindTexture(target, texture));
+            activeUnit_ = unit;
+            return;
+        }
+        TextureBinding& slot = textures_[unit];
+        if (slot.target == target && slot.texture == texture) {
+            ++frame_.filtered;
+            return;
+        }
+        activeTexture(unit);
+        ++frame_.issued;
+        GL_CHECK(glBindTexture(target, texture));
+        slot.target = target;
+        slot.texture = texture;
+    }
+
+    void bindBuffer(GLenum target, GLuint buffer) {
+        int slot = bufferSlot(target);
+        if (slot < 0) {
+            ++frame_.issued;
+            GL_CHECK(glBindBuffer(target, buffer));
+            return;
+        }
+        if (!changed(buffers_[slot], buffer)) return;
+        GL_CHECK(glBindBuffer(target, buffer));
+    }
+
+    // Indexed bind; also replaces the generic binding of `target`
+    void bindBufferBase(GLenum target, GLuint index, GLuint buffer) {
+        ++frame_.issued;
+        GL_CHECK(glBindBufferBase(target, index, buffer));
+        int slot = bufferSlot(target);
+        if (slot >= 0) buffers_[slot] = buffer;
+    }
+
+    // Indexed bind of part of `buffer`, e.g. this frame's slice of a RingBuffer
+    void bindBufferRange(GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size) {
+        ++frame_.issued;
+        GL_CHECK(glBindBufferRange(target, index, buffer, offset, size));
+        int slot = bufferSlot(target);
+        if (slot >= 0) buffers_[slot] = buffer;
+    }
+
+    void bindFramebuffer(GLenum target, GLuint framebuffer) {
+        if (target == GL_FRAMEBUFFER) {
+            if (drawFramebuffer_ == framebuffer && readFramebuffer_ == framebuffer) {
+                ++frame_.filtered;
+                return;
+            }
+            ++frame_.issued;
+            GL_CHECK(glBindFramebuffer(GL_FRAMEBUFFER, framebuffer));
+            drawFramebuffer_ = readFramebuffer_ = framebuffer;
+        } else if (target == GL_DRAW_FRAMEBUFFER) {
+            if (!changed(drawFramebuffer_, framebuffer)) return;
+            GL_CHECK(glBindFramebuffer(target, framebuffer));
+        } else {
+            if (!changed(readFramebuffer_, framebuffer)) return;
+            GL_CHECK(glBindFramebuffer(target, framebuffer));
+        }
+    }
+
+    // glEnable/glDisable for the capabilities tracked below
+    void setEnabled(GLenum cap, bool enabled) {
+        GLuint* flag = capability(cap);
+        GLuint value = enabled ? 1u : 0u;
+        if (flag && !changed(*flag, value)) return;
+        if (!flag) ++frame_.issued;
+        if (enabled) GL_CHECK(glEnable(cap));
+        else GL_CHECK(glDisable(cap));
+    }
+    void enable(GLenum cap) { setEnabled(cap, true); }
+    void disable(GLenum cap) { setEnabled(cap, false); }
+
+    void blendFunc(GLenum src, GLenum dst) {
+        if (blendSrc_ == src && blendDst_ == dst) {
+            ++frame_.filtered;
+            return;
+        }
+        ++frame_.issued;
+        GL_CHECK(glBlendFunc(src, dst));
+        blendSrc_ = src;
+        blendDst_ = dst;
+    }
+
+    void depthFunc(GLenum func) {
+        if (!changed(depthFunc_, func)) return;
+        GL_CHECK(glDepthFunc(func));
+    }
+
+    void depthMask(bool write) {
+        if (!changed(depthMask_, write ? 1u : 0u)) return;
+        GL_CHECK(glDepthMask(write ? GL_TRUE : GL_FALSE));
+    }
+
+    void colorMask(bool write) {
+        if (!changed(colorMask_, write ? 1u : 0u)) return;
+        GLboolean flag = write ? GL_TRUE : GL_FALSE;
+        GL_CHECK(glColorMask(flag, flag, flag, flag));
+    }
+
+    void viewport(GLint x, GLint y, GLsizei width, GLsizei height) {
+        if (viewport_[0] == x && viewport_[1] == y && viewport_[2] == width && viewport_[3] == height) {
+            ++frame_.filtered;
+            return;
+        }
+        ++frame_.issued;
+        GL_CHECK(glViewport(x, y, width, height));
+        viewport_[0] = x;
+        viewport_[1] = y;
+        viewport_[2] = width;
+        viewport_[3] = height;
+    }
+
+    // Draw calls go through here only to be counted; they are never filtered
+    void drawArrays(GLenum mode, GLint first, GLsizei count) {
+        countDraw(1);
+        GL_CHECK(glDrawArrays(mode, first, count));
+    }
+
+    void drawElements(GLenum mode, GLsizei count, GLenum type, const void* indices) {
+        countDraw(1);
+        GL_CHECK(glDrawElements(mode, count, type, indices));
+    }
+
+    void drawElementsInstanced(GLenum mode, GLsizei count, GLenum type, const void* indices, GLsizei instances) {
+        countDraw(instances);
+        GL_CHECK(glDrawElementsInstanced(mode, count, type, indices, instances));
+    }
+
+    void drawElementsBaseVertex(GLenum mode, GLsizei count, GLenum type, const void* indices, GLint baseVertex) {
+        countDraw(1);
+        GL_CHECK(glDrawElementsBaseVertex(mode, count, type, indices, baseVertex));
+    }
+
+    // One call; every command counts as an instance
+    void multiDrawElementsIndirect(GLenum mode, GLenum type, const void* offset, GLsizei drawCount) {
+        countDraw(drawCount);
+        GL_CHECK(glMultiDrawElementsIndirect(mode, type, offset, drawCount, 0));
+    }
+
+    // Deleting a bound object resets its binding to 0 and frees the name for reuse,
+    // so the cache must forget it or a later bind of a recycled name gets filtered.
+    void forgetProgram(GLuint program) {
+        if (program_ == program) program_ = 0;
+    }
+    void forgetVertexArray(GLuint vao) {
+        if (vertexArray_ == vao) {
+            vertexArray_ = 0;
+            buffers_[ELEMENT_ARRAY] = UNKNOWN;
+        }
+    }
+    void forgetBuffer(GLuint buffer) {
+        for (GLuint& bound : buffers_)
+            if (bound == buffer) bound = 0;
+    }
+    void forgetTexture(GLuint texture) {
+        for (TextureBinding& slot : textures_)
+            if (slot.texture == texture) slot.texture = 0;
+    }
+    void forgetFramebuffer(GLuint framebuffer) {
+        if (drawFramebuffer_ == framebuffer) drawFramebuffer_ = 0;
+        if (readFramebuffer_ == framebuffer) readFramebuffer_ = 0;
+    }
+
+    // Forget everything, e.g. after third-party code touched GL directly
+    void invalidate() {
+        program_ = vertexArray_ = activeUnit_ = UNKNOWN;
+        drawFramebuffer_ = readFramebuffer_ = UNKNOWN;
+        for (GLuint& bound : buffers_) bound = UNKNOWN;
+        for (TextureBinding& slot : textures_) slot = {GL_NONE, UNKNOWN};
+        for (GLuint& flag : caps_) flag = UNKNOWN;
+        blendSrc_ = blendDst_ = UNKNOWN;
+        depthFunc_ = depthMask_ = colorMask_ = UNKNOWN;
+        for (GLint& value : viewport_) value = -1;
+    }
+
+    // Close the current frame: its counters become lastFrame() and a new frame starts
+    void endFrame() {
+        last_ = frame_;
+        frame_ = Stats();
+    }
+
+    const Stats& currentFrame() const { return frame_; }
+    const Stats& lastFrame() const { return last_; }
+
+private:
+    static const GLuint UNKNOWN = 0xFFFFFFFFu;
+
+    enum BufferSlot {
+        ARRAY, ELEMENT_ARRAY, UNIFORM, SHADER_STORAGE, DRAW_INDIRECT,
+        TEXTURE, COPY_READ, COPY_WRITE, PIXEL_PACK, PIXEL_UNPACK,
+        BUFFER_SLOT_COUNT
+    };
+
+    enum Capability { DEPTH_TEST, BLEND, CULL_FACE, SCISSOR_TEST, CAPABILITY_COUNT };
+
+    struct TextureBinding {
+        GLenum target;
+        GLuint texture;
+    };
+
+    // Cached values start at the GL defaults of a fresh context
+    GLuint program_ = 0;
+    GLuint vertexArray_ = 0;
+    GLuint activeUnit_ = 0;
+    GLuint drawFramebuffer_ = 0;
+    GLuint readFramebuffer_ = 0;
+    GLuint buffers_[BUFFER_SLOT_COUNT] = {};
+    TextureBinding textures_[MAX_TEXTURE_UNITS] = {};
+    GLuint caps_[CAPABILITY_COUNT] = {};
+    GLuint blendSrc_ = GL_ONE;
+    GLuint blendDst_ = GL_ZERO;
+    GLuint depthFunc_ = GL_LESS;
+    GLuint depthMask_ = 1;
+    GLuint colorMask_ = 1;
+    GLint viewport_[4] = {-1, -1, -1, -1};  // The initial window size isn't known here
+
+    Stats frame_;
+    Stats last_;
+
+    GLState() {
+        for (TextureBinding& slot : textures_) slot = {GL_TEXTURE_2D, 0};
+    }
+    GLState(const GLState&) = delete;
+    GLState& operator=(const GLState&) = delete;
+
+    // Updates `cached` and counts the call; returns false when the call is redundant
+    bool changed(GLuint& cached, GLuint value) {
+        if (cached == value) {
+            ++frame_.filtered;
+            return false;
+        }
+        ++frame_.issued;
+        cached = value;
+        return true;
+    }
+
+    void countDraw(GLsizei instances) {
+        ++frame_.draws;
+        frame_.instances += (unsigned int)instances;
+    }
+
+    static int bufferSlot(GLenum target) {
+        switch (target) {
+            case GL_ARRAY_BUFFER:          return ARRAY;
+            case GL_ELEMENT_ARRAY_BUFFER:  return ELEMENT_ARRAY;
+            case GL_UNIFORM_BUFFER:        return UNIFORM;
+            case GL_SHADER_STORAGE_BUFFER: return SHADER_STORAGE;
+            case GL_DRAW_INDIRECT_BUFFER:  return DRAW_INDIRECT;
+            case GL_TEXTURE_BUFFER:        return TEXTURE;
+            case GL_COPY_READ_BUFFER:      return COPY_READ;
+            case GL_COPY_WRITE_BUFFER:     return COPY_WRITE;
+            case GL_PIXEL_PACK_BUFFER:     return PIXEL_PACK;
+            case GL_PIXEL_UNPACK_BUFFER:   return PIXEL_UNPACK;
+            default:                       return -1;
+        }
+    }
+
+    GLuint* capability(GLenum cap) {
+        switch (cap) {
+            case GL_DEPTH_TEST:   return &caps_[DEPTH_TEST];
+            case GL_BLEND:        return &caps_[BLEND];
+            case GL_CULL_FACE:    return &caps_[CULL_FACE];
+            case GL_SCISSOR_TEST: return &caps_[SCISSOR_TEST];
+            default:              return nullptr;
+        }
+    }
+};
+
+#endif // GL_STATE_H
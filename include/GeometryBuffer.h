@@ -0,0 +1,149 @@
+#ifndef GEOMETRY_BUFFER_H
+#define GEOMETRY_BUFFER_H
+
+#include <vector>
+#include <cstdint>
+#include <iostream>
+#include <glad/glad.h>
+#include "GLState.h"
+#include "Bounds.h"
+#include "PositionStream.h"
+
+// Where one mesh lives inside a GeometryBuffer
+struct MeshRange {
+    GLuint firstIndex;
+    GLuint indexCount;
+    GLint baseVertex;
+    AABB bounds;                   // Object-space bounds
+    BoundingSphere boundingSphere;
+};
+
+// Vertex and index data of many meshes packed into one VBO/EBO pair, in the
+// interleaved layout of FG.h (14 floats per vertex). Meshes sharing the buffer can
+// be drawn without rebinding anything, which is what multi-draw indirect needs.
+// A packed position-only copy backs the depth pre-pass. Add every mesh, then upload() once.
+class GeometryBuffer {
+public:
+    static const size_t FLOATS_PER_VERTEX = 14;
+
+    GeometryBuffer() = default;
+    GeometryBuffer(const GeometryBuffer&) = delete;
+    GeometryBuffer& operator=(const GeometryBuffer&) = delete;
+
+    ~GeometryBuffer() {
+        GLState& gl = GLState::instance();
+        gl.forgetVertexArray(VAO);
+        gl.forgetVertexArray(depthVAO);
+        gl.forgetBuffer(VBO);
+        gl.forgetBuffer(EBO);
+        gl.forgetBuffer(positionVBO);
+        glDeleteVertexArrays(1, &VAO);
+        glDeleteVertexArrays(1, &depthVAO);
+        glDeleteBuffers(1, &VBO);
+        glDeleteBuffers(1, &EBO);
+        glDeleteBuffers(1, &positionVBO);
+    }
+
+    // Appends a mesh; indices are relative to its own vertices. Returns the mesh ID.
+    uint32_t add(const std::vector<float>& meshVertices, const std::vector<unsigned int>& meshIndices) {
+        if (VAO) {
+            std::cerr << "GeometryBuffer: add() after upload() is not supported" << std::endl;
+            return UINT32_MAX;
+        }
+        MeshRange range;
+        range.firstIndex = (GLuint)indices.size();
+        range.indexCount = (GLuint)meshIndices.size();
+        range.baseVertex = (GLint)(vertices.size() / FLOATS_PER_VERTEX);
+        computeBounds(meshVertices.data(), meshVertices.size() / FLOATS_PER_VERTEX, FLOATS_PER_VERTEX,
+                      range.bounds, range.boundingSphere);
+        ranges.push_back(range);
+
+        vertices.insert(vertices.end(), meshVertices.begin(), meshVertices.end());
+        indices.insert(indices.end(), meshIndices.begin(), meshIndices.end());
+        return (uint32_t)ranges.size() - 1;
+    }
+
+    // Creates the GL buffers, a VAO with attributes 0..4 and a position-only one,
+    // then drops the CPU copy
+    void upload() {
+        glGenVertexArrays(1, &VAO);
+        glGenVertexArrays(1, &depthVAO);
+        glGenBuffers(1, &VBO);
+        glGenBuffers(1, &EBO);
+        glGenBuffers(1, &positionVBO);
+
+        GLState& gl = GLState::instance();
+        gl.bindVertexArray(VAO);
+        gl.bindBuffer(GL_ARRAY_BUFFER, VBO);
+        GL_CHECK(glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STATIC_DRAW));
+        gl.bindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+        GL_CHECK(glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(),
+                              GL_STATIC_DRAW));
+        GLDebug::label(GL_BUFFER, VBO, "geometry vertices");
+        GLDebug::label(GL_BUFFER, EBO, "geometry indices");
+        setVertexAttributes();
+
+        std::vector<float> positions = packPositions(vertices.data(), vertices.size() / FLOATS_PER_VERTEX, FLOATS_PER_VERTEX);
+        gl.bindVertexArray(depthVAO);
+        gl.bindBuffer(GL_ARRAY_BUFFER, positionVBO);
+        GL_CHECK(glBufferData(GL_ARRAY_BUFFER, positions.size() * sizeof(float), positions.data(), GL_STATIC_DRAW));
+        GLDebug::label(GL_BUFFER, positionVBO, "geometry positions");
+        setPositionAttributes();
+        gl.bindVertexArray(0);
+
+        vertices = std::vector<float>();
+        indices = std::vector<unsigned int>();
+    }
+
+    // Points attributes 0..4 of the bound VAO at this buffer and binds the EBO to it
+    void setVertexAttributes() const {
+        GLState& gl = GLState::instance();
+        gl.bindBuffer(GL_ARRAY_BUFFER, VBO);
+        gl.bindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+        const GLint sizes[] = {3, 3, 2, 3, 3};
+        size_t offset = 0;
+        for (GLuint location = 0; location < 5; ++location) {
+            glVertexAttribPointer(location, sizes[location], GL_FLOAT, GL_FALSE,
+                                  FLOATS_PER_VERTEX * sizeof(float), (void*)(offset * sizeof(float)));
+            glEnableVertexAttribArray(location);
+            offset += sizes[location];
+        }
+    }
+
+    // Points attribute 0 of the bound VAO at the packed positions and binds the EBO to it
+    void setPositionAttributes() const {
+        GLState& gl = GLState::instance();
+        gl.bindBuffer(GL_ARRAY_BUFFER, positionVBO);
+        gl.bindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
+        glEnableVertexAttribArray(0);
+    }
+
+    // Plain single draw of one mesh, for code paths without indirect drawing
+    void draw(uint32_t mesh) const { drawRange(VAO, mesh); }
+
+    // Same, position stream only
+    void drawDepth(uint32_t mesh) const { drawRange(depthVAO, mesh); }
+
+    const MeshRange& range(uint32_t mesh) const { return ranges[mesh]; }
+    size_t meshCount() const { return ranges.size(); }
+    GLuint vertexArray() const { return VAO; }
+    GLuint depthVertexArray() const { return depthVAO; }
+
+private:
+    GLuint VAO = 0, VBO = 0, EBO = 0;
+    GLuint depthVAO = 0, positionVBO = 0;
+    std::vector<MeshRange> ranges;
+    std::vector<float> vertices;
+    std::vector<unsigned int> indices;
+
+    void drawRange(GLuint vertexArray, uint32_t mesh) const {
+        const MeshRange& r = ranges[mesh];
+        GLState& gl = GLState::instance();
+        gl.bindVertexArray(vertexArray);
+        gl.drawElementsBaseVertex(GL_TRIANGLES, r.indexCount, GL_UNSIGNED_INT,
+                                  (void*)(r.firstIndex * sizeof(unsigned int)), r.baseVertex);
+    }
+};
+
+#endif // GEOMETRY_BUFFER_H
@@ -2,11 +2,17 @@
 #define GRID_H
 
 #include <vector>
+#include <algorithm>
 #include <glm/glm.hpp>
 #include "Shader.h"
+#include "GLState.h"
+#include "Bounds.h"
 
 class Grid {
 public:
+    AABB bounds;                   // Object-space bounds
+    BoundingSphere boundingSphere;
+
     // Enum to specify grid direction (plane)
     enum GridDirection {
         XY_PLANE, // Default: X and Y axes
@@ -14,56 +20,96 @@ public:
         YZ_PLANE  // Y and Z axes
     };
 
+    // How the grid is drawn
+    enum Mode {
+        LINES,       // Line list of the whole grid in a vertex buffer
+        PROCEDURAL   // One camera-local quad, lines computed in grid_fragment.glsl
+    };
+
     // Constructor: Initializes the grid with a given size, step, and direction
-    Grid(float gridSize, float gridStep = 1.0f, GridDirection direction = XY_PLANE)
-        : gridSize(gridSize), gridStep(gridStep), direction(direction) {
+    Grid(float gridSize, float gridStep = 1.0f, GridDirection direction = XY_PLANE, Mode mode = LINES)
+        : gridSize(gridSize), gridStep(gridStep), direction(direction), mode(mode) {
+        GLState& gl = GLState::instance();
+        glGenVertexArrays(1, &VAO);
+
+        if (mode == PROCEDURAL) {
+            // Nothing to upload: the vertex shader places the quad from gl_VertexID
+            glm::vec3 u, v;
+            planeAxes(direction, u, v);
+            float corners[12];
+            for (int i = 0; i < 4; ++i) {
+                glm::vec3 corner = ((i & 1) ? gridSize : -gridSize) * u + ((i >> 1) ? gridSize : -gridSize) * v;
+                corners[3 * i] = corner.x;
+                corners[3 * i + 1] = corner.y;
+                corners[3 * i + 2] = corner.z;
+            }
+            computeBounds(corners, 4, 3, bounds, boundingSphere);
+            vertexCount = 4;
+            return;
+        }
+
         // Generate grid vertices
         std::vector<float> gridVertices = generateGridVertices(gridSize, gridStep, direction);
         vertexCount = gridVertices.size() / 3; // Each vertex has 3 components (x, y, z)
+        computeBounds(gridVertices.data(), vertexCount, 3, bounds, boundingSphere);
 
         // Set up OpenGL buffers
-        glGenVertexArrays(1, &VAO);
         glGenBuffers(1, &VBO);
+        gl.bindVertexArray(VAO);
 
-        glBindVertexArray(VAO);
-
-        glBindBuffer(GL_ARRAY_BUFFER, VBO);
-        glBufferData(GL_ARRAY_BUFFER, gridVertices.size() * sizeof(float), gridVertices.data(), GL_STATIC_DRAW);
+        gl.bindBuffer(GL_ARRAY_BUFFER, VBO);
+        GL_CHECK(glBufferData(GL_ARRAY_BUFFER, gridVertices.size() * sizeof(float), gridVertices.data(),
+                              GL_STATIC_DRAW));
 
         // Position attribute
         glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
         glEnableVertexAttribArray(0);
 
-        glBindVertexArray(0);
+        gl.bindVertexArray(0);
     }
 
     // Destructor: Cleans up OpenGL resources
     ~Grid() {
+        GLState::instance().forgetVertexArray(VAO);
         glDeleteVertexArrays(1, &VAO);
-        glDeleteBuffers(1, &VBO);
+        if (VBO) {
+            GLState::instance().forgetBuffer(VBO);
+            glDeleteBuffers(1, &VBO);
+        }
     }
 
     // Render the grid
-    void Draw(Shader& shader, const glm::mat4& view, const glm::mat4& projection) {
+    // View and projection come from the shared Camera uniform block
+    void Draw(Shader& shader) {
         shader.use();
+        GLState& gl = GLState::instance();
+        gl.bindVertexArray(VAO);
+
+        if (mode == PROCEDURAL) {
+            glm::vec3 u, v;
+            planeAxes(direction, u, v);
+            shader.setVec3(glsl::uniform::gridAxisU, u);
+            shader.setVec3(glsl::uniform::gridAxisV, v);
+            shader.setFloat(glsl::uniform::gridStep, gridStep);
+            shader.setFloat(glsl::uniform::gridExtent, std::min(gridSize, viewDistance));
+            gl.drawArrays(GL_TRIANGLE_STRIP, 0, vertexCount);
+            return;
+        }
 
         // Set model matrix (identity matrix for the grid)
         glm::mat4 model = glm::mat4(1.0f);
-        shader.setMat4("model", glm::value_ptr(model));
+        shader.setMat4(glsl::uniform::model, glm::value_ptr(model));
+        gl.drawArrays(GL_LINES, 0, vertexCount);
+    }
 
-        // Set view and projection matrices
-        shader.setMat4("view", glm::value_ptr(view));
-        shader.setMat4("projection", glm::value_ptr(projection));
+    // Procedural mode: the quad only reaches this far from the camera (the far plane)
+    void setViewDistance(float distance) { viewDistance = distance; }
 
-        // Bind the grid VAO and draw the grid
-        glBindVertexArray(VAO);
-        glDrawArrays(GL_LINES, 0, vertexCount);
-        glBindVertexArray(0);
-    }
+    Mode drawMode() const { return mode; }
 
 private:
     // OpenGL buffers
-    unsigned int VAO, VBO;
+    unsigned int VAO = 0, VBO = 0;
 
     // Number of vertices in the grid
     int vertexCount;
@@ -72,6 +118,16 @@ private:
     float gridSize;
     float gridStep;
     GridDirection direction;
+    Mode mode;
+    float viewDistance = 100.0f;
+
+    static void planeAxes(GridDirection direction, glm::vec3& u, glm::vec3& v) {
+        switch (direction) {
+            case XY_PLANE: u = glm::vec3(1, 0, 0); v = glm::vec3(0, 1, 0); break;
+            case XZ_PLANE: u = glm::vec3(1, 0, 0); v = glm::vec3(0, 0, 1); break;
+            case YZ_PLANE: u = glm::vec3(0, 1, 0); v = glm::vec3(0, 0, 1); break;
+        }
+    }
 
     // Generate grid vertices based on the specified direction
     std::vector<float> generateGridVertices(float gridSize, float gridStep, GridDirection direction) {
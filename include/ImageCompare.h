@@ -0,0 +1,30 @@
+#ifndef IMAGE_COMPARE_H
+#define IMAGE_COMPARE_H
+
+#include <vector>
+#include <cstddef>
+
+// Frame against golden image, for the regression harness (tools/RegressionHarness.cpp).
+// Two measures, since each misses what the other catches:
+//   - per pixel: pixels with any channel off by more than `tolerance` (out of 255).
+//     Catches small, sharp breakage (a missing object, a wrong material).
+//   - SSIM of the luma over 8x8 windows with a stride of 4 (Wang et al. 2004,
+//     C1 = (0.01 * 255)^2, C2 = (0.03 * 255)^2), averaged. Catches changes spread
+//     over the frame (banding, blur, a shifted light) that stay under the tolerance.
+struct ImageDiff {
+    int maxDifference = 0;        // Largest channel difference
+    size_t pixelsOver = 0;        // Pixels beyond the tolerance
+    double fractionOver = 0.0;    // ...as a fraction of all pixels
+    double ssim = 1.0;            // 1 for identical images
+};
+
+// `a` and `b` are width * height RGB pixels, rows top-down. When `heatmap` is given
+// it receives an RGB image of the differences: grey scaled up 4x, red beyond the
+// tolerance.
+ImageDiff compareImages(const unsigned char* a, const unsigned char* b, int width, int height, int tolerance,
+                        std::vector<unsigned char>* heatmap = nullptr);
+
+// Mean SSIM of two single-channel images (0..255)
+double structuralSimilarity(const float* a, const float* b, int width, int height);
+
+#endif // IMAGE_COMPARE_H
@@ -0,0 +1,91 @@
+#ifndef INDIRECT_RENDERER_H
+#define INDIRECT_RENDERER_H
+
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <glad/glad.h>
+#include "GeometryBuffer.h"
+#include "Instancing.h"
+#include "RingBuffer.h"
+
+// Layout fixed by GL for glMultiDrawElementsIndirect
+struct DrawElementsIndirectCommand {
+    GLuint count;
+    GLuint instanceCount;
+    GLuint firstIndex;
+    GLint baseVertex;
+    GLuint baseInstance;
+};
+
+// Multi-draw indirect submission over one GeometryBuffer (GL 4.3+).
+// Each frame the draws are collected into state buckets (small dense IDs chosen by
+// the caller, e.g. program + material), then upload() writes one command per draw
+// and the per-draw data (InstanceData, read from the DrawBlock SSBO by
+// shaders/indirect_vertex.glsl) grouped by bucket. draw(bucket) then renders a whole
+// bucket with a single glMultiDrawElementsIndirect.
+//
+// Commands and per-draw data are streamed through a RingBuffer, one frame per
+// upload(), so filling them never waits on draws still reading earlier frames.
+//
+// The shader finds its draw through a per-instance attribute holding 0, 1, 2, ...
+// offset by the command's baseInstance, which works without gl_DrawID (GL 4.6).
+class IndirectRenderer {
+public:
+    // Callers keep their per-draw loop when this is false
+    static bool supported() { return GLAD_GL_VERSION_4_3 != 0; }
+
+    IndirectRenderer(const GeometryBuffer& geometry, uint32_t maxDraws = 1 << 17);
+    ~IndirectRenderer();
+
+    IndirectRenderer(const IndirectRenderer&) = delete;
+    IndirectRenderer& operator=(const IndirectRenderer&) = delete;
+
+    void clear();
+    void add(uint32_t bucket, uint32_t mesh, const InstanceData& data);
+
+    // Groups the draws by bucket and uploads commands and per-draw data
+    void upload();
+
+    // Every draw added to `bucket` in one call; the program must already be in use
+    void draw(uint32_t bucket) const;
+
+    // Same draws from the position-only stream, for shaders/depth_indirect_vertex.glsl
+    void drawDepth(uint32_t bucket) const;
+
+    size_t drawCount() const { return pending.size(); }
+    uint32_t capacity() const { return maxDraws; }
+
+    // Streaming stalls and overflows; empty when unsupported
+    RingBuffer::Stats streamStats() const { return stream ? stream->stats() : RingBuffer::Stats(); }
+
+private:
+    struct Pending {
+        uint32_t bucket;
+        uint32_t mesh;
+    };
+
+    struct BucketRange {
+        uint32_t first = 0;
+        uint32_t count = 0;
+    };
+
+    const GeometryBuffer& geometry;
+    uint32_t maxDraws;
+    GLuint VAO = 0;
+    GLuint depthVAO = 0;
+    GLuint drawIdBuffer = 0;
+    std::unique_ptr<RingBuffer> stream;
+    RingBuffer::Allocation commandSpace;   // This frame's commands...
+    RingBuffer::Allocation drawDataSpace;  // ...and per-draw data, in `stream`
+
+    std::vector<Pending> pending;
+    std::vector<InstanceData> pendingData;
+    std::vector<DrawElementsIndirectCommand> commands;
+    std::vector<InstanceData> drawData;
+    std::vector<BucketRange> buckets;
+
+    void submit(GLuint vertexArray, uint32_t bucket) const;
+};
+
+#endif // INDIRECT_RENDERER_H
@@ -0,0 +1,200 @@
+#ifndef INSTANCING_H
+#define INSTANCING_H
+
+#include <vector>
+#include <cstddef>
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include "FG.h"
+#include "GLState.h"
+#include "Shader.h"
+#include "Bounds.h"
+#include "PositionStream.h"
+#include "NormalMatrix.h"
+
+// Per-instance vertex attributes, read by shaders/instanced_vertex.glsl at locations 5..12
+struct InstanceData {
+    glm::mat4 model;
+    glm::vec4 normalMatrix[3];   // Columns of normalMatrix(model); w unused
+    float materialLayer;         // Layer of the diffuse/normal texture arrays
+    float _pad[3];
+
+    static InstanceData make(const glm::mat4& model, float materialLayer) {
+        InstanceData instance;
+        instance.model = model;
+        glm::mat3 normal = ::normalMatrix(model);
+        for (int i = 0; i < 3; ++i)
+            instance.normalMatrix[i] = glm::vec4(normal[i], 0.0f);
+        instance.materialLayer = materialLayer;
+        instance._pad[0] = instance._pad[1] = instance._pad[2] = 0.0f;
+        return instance;
+    }
+};
+static_assert(sizeof(InstanceData) == 128, "InstanceData must match the attribute layout");
+
+// Vertex and index buffers of one primitive type, in the interleaved layout of FG.h.
+// Every instanced batch of that type references these buffers instead of its own copy.
+class PrimitiveGeometry {
+public:
+    GLuint VBO, EBO;
+    GLuint positionVBO;            // Positions only, for the depth pre-pass
+    GLsizei indexCount;
+    AABB bounds;                   // Object-space bounds
+    BoundingSphere boundingSphere;
+
+    PrimitiveGeometry(const std::vector<float>& vertices, const std::vector<unsigned int>& indices)
+        : indexCount((GLsizei)indices.size()) {
+        computeBounds(vertices.data(), vertices.size() / 14, 14, bounds, boundingSphere);
+
+        glGenBuffers(1, &VBO);
+        glGenBuffers(1, &EBO);
+        glGenBuffers(1, &positionVBO);
+
+        // The element binding belongs to the VAO; upload through COPY_WRITE so no VAO is touched
+        GLState& gl = GLState::instance();
+        gl.bindBuffer(GL_ARRAY_BUFFER, VBO);
+        GL_CHECK(glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STATIC_DRAW));
+        gl.bindBuffer(GL_COPY_WRITE_BUFFER, EBO);
+        GL_CHECK(glBufferData(GL_COPY_WRITE_BUFFER, indices.size() * sizeof(unsigned int), indices.data(),
+                              GL_STATIC_DRAW));
+
+        std::vector<float> positions = packPositions(vertices.data(), vertices.size() / 14, 14);
+        gl.bindBuffer(GL_ARRAY_BUFFER, positionVBO);
+        GL_CHECK(glBufferData(GL_ARRAY_BUFFER, positions.size() * sizeof(float), positions.data(), GL_STATIC_DRAW));
+    }
+
+    static PrimitiveGeometry cube() { return PrimitiveGeometry(cubeVertices(), cubeIndices()); }
+    static PrimitiveGeometry pyramid() { return PrimitiveGeometry(pyramidVertices(), pyramidIndices()); }
+    static PrimitiveGeometry sphere(float radius) {
+        std::vector<float> vertices;
+        std::vector<unsigned int> indices;
+        buildSphereGeometry(radius, vertices, indices);
+        return PrimitiveGeometry(vertices, indices);
+    }
+
+    PrimitiveGeometry(const PrimitiveGeometry&) = delete;
+    PrimitiveGeometry& operator=(const PrimitiveGeometry&) = delete;
+
+    ~PrimitiveGeometry() {
+        GLState& gl = GLState::instance();
+        gl.forgetBuffer(VBO);
+        gl.forgetBuffer(EBO);
+        gl.forgetBuffer(positionVBO);
+        glDeleteBuffers(1, &VBO);
+        glDeleteBuffers(1, &EBO);
+        glDeleteBuffers(1, &positionVBO);
+    }
+};
+
+// Any number of copies of one primitive, drawn with a single glDrawElementsInstanced.
+// Materials are layers of two texture arrays picked per instance by InstanceData::materialLayer.
+class InstancedPrimitive {
+public:
+    InstancedPrimitive(const PrimitiveGeometry& geometry, GLuint diffuseArray, GLuint normalArray)
+        : geometry(geometry), diffuseArray(diffuseArray), normalArray(normalArray) {
+        glGenVertexArrays(1, &VAO);
+        glGenVertexArrays(1, &depthVAO);
+        glGenBuffers(1, &instanceVBO);
+
+        GLState& gl = GLState::instance();
+        gl.bindVertexArray(VAO);
+
+        // Shared per-vertex stream (locations 0..4, same layout as FG.h)
+        gl.bindBuffer(GL_ARRAY_BUFFER, geometry.VBO);
+        gl.bindBuffer(GL_ELEMENT_ARRAY_BUFFER, geometry.EBO);
+        const GLint sizes[] = {3, 3, 2, 3, 3};
+        size_t offset = 0;
+        for (GLuint location = 0; location < 5; ++location) {
+            glVertexAttribPointer(location, sizes[location], GL_FLOAT, GL_FALSE, 14 * sizeof(float),
+                                  (void*)(offset * sizeof(float)));
+            glEnableVertexAttribArray(location);
+            offset += sizes[location];
+        }
+
+        // Per-instance stream, advanced once per instance
+        gl.bindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+        for (GLuint column = 0; column < 4; ++column)
+            instanceAttribute(5 + column, 4, offsetof(InstanceData, model) + column * sizeof(glm::vec4));
+        for (GLuint column = 0; column < 3; ++column)
+            instanceAttribute(9 + column, 3, offsetof(InstanceData, normalMatrix) + column * sizeof(glm::vec4));
+        instanceAttribute(12, 1, offsetof(InstanceData, materialLayer));
+
+        // Depth pre-pass: packed positions plus the model matrix, nothing else
+        gl.bindVertexArray(depthVAO);
+        gl.bindBuffer(GL_ARRAY_BUFFER, geometry.positionVBO);
+        gl.bindBuffer(GL_ELEMENT_ARRAY_BUFFER, geometry.EBO);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
+        glEnableVertexAttribArray(0);
+        gl.bindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+        for (GLuint column = 0; column < 4; ++column)
+            instanceAttribute(5 + column, 4, offsetof(InstanceData, model) + column * sizeof(glm::vec4));
+
+        gl.bindVertexArray(0);
+    }
+
+    InstancedPrimitive(const InstancedPrimitive&) = delete;
+    InstancedPrimitive& operator=(const InstancedPrimitive&) = delete;
+
+    // Replaces the instance list. The old storage is orphaned rather than overwritten,
+    // so the upload never waits for a draw still reading last frame's instances.
+    void setInstances(const InstanceData* data, size_t count) {
+        GLState::instance().bindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+        if (count > capacity) {
+            capacity = count;
+            GL_CHECK(glBufferData(GL_ARRAY_BUFFER, capacity * sizeof(InstanceData), data, GL_STREAM_DRAW));
+        } else {
+            GL_CHECK(glBufferData(GL_ARRAY_BUFFER, capacity * sizeof(InstanceData), nullptr, GL_STREAM_DRAW));
+            glBufferSubData(GL_ARRAY_BUFFER, 0, count * sizeof(InstanceData), data);
+        }
+        instances = count;
+    }
+
+    void setInstances(const std::vector<InstanceData>& data) { setInstances(data.data(), data.size()); }
+
+    size_t instanceCount() const { return instances; }
+
+    // Draws every instance with one call; the program should be instanced_vertex/instanced_fragment
+    void Draw(Shader& shader) {
+        if (instances == 0) return;
+        GLState& gl = GLState::instance();
+        shader.use();
+        gl.bindTexture(glsl::sampler::diffuseLayers, GL_TEXTURE_2D_ARRAY, diffuseArray);
+        gl.bindTexture(glsl::sampler::normalLayers, GL_TEXTURE_2D_ARRAY, normalArray);
+        gl.bindVertexArray(VAO);
+        gl.drawElementsInstanced(GL_TRIANGLES, geometry.indexCount, GL_UNSIGNED_INT, 0, (GLsizei)instances);
+    }
+
+    // Position-only draw of every instance; the program should be depth_instanced_vertex
+    void DrawDepth(Shader& shader) {
+        if (instances == 0) return;
+        GLState& gl = GLState::instance();
+        shader.use();
+        gl.bindVertexArray(depthVAO);
+        gl.drawElementsInstanced(GL_TRIANGLES, geometry.indexCount, GL_UNSIGNED_INT, 0, (GLsizei)instances);
+    }
+
+    ~InstancedPrimitive() {
+        GLState& gl = GLState::instance();
+        gl.forgetVertexArray(VAO);
+        gl.forgetVertexArray(depthVAO);
+        gl.forgetBuffer(instanceVBO);
+        glDeleteVertexArrays(1, &VAO);
+        glDeleteVertexArrays(1, &depthVAO);
+        glDeleteBuffers(1, &instanceVBO);
+    }
+
+private:
+    const PrimitiveGeometry& geometry;
+    GLuint VAO, depthVAO, instanceVBO;
+    GLuint diffuseArray, normalArray;
+    size_t capacity = 0;
+    size_t instances = 0;
+
+    static void instanceAttribute(GLuint location, GLint size, size_t offset) {
+        glVertexAttribPointer(location, size, GL_FLOAT, GL_FALSE, sizeof(InstanceData), (void*)offset);
+        glEnableVertexAttribArray(location);
+        glVertexAttribDivisor(location, 1);
+    }
+};
+
+#endif // INSTANCING_H
@@ -0,0 +1,115 @@
+#ifndef JOB_POOL_H
+#define JOB_POOL_H
+
+#include <mutex>
+#include <algorithm>
+#include <deque>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <functional>
+#include <condition_variable>
+
+// Fixed set of worker threads for data-parallel CPU work (sorting, culling, ...).
+// The calling thread always takes part, so a pool of size 1 runs everything inline.
+class JobPool {
+public:
+    // `threads` counts the caller; 0 = one per hardware thread
+    explicit JobPool(unsigned threads = 0) {
+        if (threads == 0) threads = std::thread::hardware_concurrency();
+        if (threads == 0) threads = 1;
+        for (unsigned i = 1; i < threads; ++i)
+            workers.emplace_back([this, i] { workerLoop(i); });
+    }
+
+    ~JobPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (std::thread& worker : workers)
+            worker.join();
+    }
+
+    JobPool(const JobPool&) = delete;
+    JobPool& operator=(const JobPool&) = delete;
+
+    // Process-wide pool sized to the machine
+    static JobPool& shared() {
+        static JobPool pool;
+        return pool;
+    }
+
+    // Number of threads work is spread over, including the caller
+    unsigned size() const { return (unsigned)workers.size() + 1; }
+
+    // Calls fn(begin, end, worker) over [0, count) in chunks of at least `grain` items.
+    // `worker` is in [0, size()) and unique among concurrently running chunks, so it
+    // can index per-thread scratch memory. Returns when every chunk has finished.
+    void parallelFor(size_t count, size_t grain,
+                     const std::function<void(size_t begin, size_t end, unsigned worker)>& fn) {
+        if (count == 0) return;
+        if (grain == 0) grain = 1;
+        size_t chunks = (count + grain - 1) / grain;
+        unsigned helpers = (unsigned)std::min<size_t>(workers.size(), chunks - 1);
+        if (helpers == 0) {
+            fn(0, count, 0);
+            return;
+        }
+
+        std::atomic<size_t> next{0};
+        auto runChunks = [&](unsigned worker) {
+            size_t chunk;
+            while ((chunk = next.fetch_add(1)) < chunks) {
+                size_t begin = chunk * grain;
+                size_t end = std::min(count, begin + grain);
+                fn(begin, end, worker);
+            }
+        };
+
+        // Helpers must all exit before this frame's locals go out of scope
+        std::mutex doneMutex;
+        std::condition_variable doneSignal;
+        unsigned pending = helpers;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            for (unsigned i = 0; i < helpers; ++i) {
+                jobs.push_back([&](unsigned worker) {
+                    runChunks(worker);
+                    std::lock_guard<std::mutex> doneLock(doneMutex);
+                    if (--pending == 0) doneSignal.notify_one();
+                });
+            }
+        }
+        wake.notify_all();
+
+        runChunks(0);
+
+        std::unique_lock<std::mutex> doneLock(doneMutex);
+        doneSignal.wait(doneLock, [&] { return pending == 0; });
+    }
+
+private:
+    std::vector<std::thread> workers;
+    std::deque<std::function<void(unsigned)>> jobs;
+    std::mutex mutex;
+    std::condition_variable wake;
+    bool stopping = false;
+
+    void workerLoop(unsigned index) {
+        while (true) {
+            std::function<void(unsigned)> job;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wake.wait(lock, [this] { return stopping || !jobs.empty(); });
+                if (stopping && jobs.empty()) return;
+                job = std::move(jobs.front());
+                jobs.pop_front();
+            }
+            job(index);
+        }
+    }
+};
+
+#endif // JOB_POOL_H
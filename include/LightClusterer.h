@@ -0,0 +1,104 @@
+#ifndef LIGHT_CLUSTERER_H
+#define LIGHT_CLUSTERER_H
+
+#include <vector>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include "JobPool.h"
+
+struct PointLight {
+    glm::vec3 position;
+    float radius;       // Influence ends here
+    glm::vec3 color;
+    float intensity;
+};
+
+// Windowed attenuation, zero from the radius on; same as lightFalloff() in
+// shaders/common/lights.glsl
+inline float lightFalloff(float distance, float radius) {
+    float ratio = distance / radius;
+    float window = glm::clamp(1.0f - ratio * ratio * ratio * ratio, 0.0f, 1.0f);
+    return window * window;
+}
+
+// CPU light assignment for clustered shading. The view frustum is cut into
+// CLUSTERS_X x CLUSTERS_Y screen tiles and CLUSTERS_Z exponential depth slices;
+// every light is listed in each cluster its sphere touches.
+//
+// Cluster bounds are view-space AABBs rebuilt only when the projection changes.
+// assign() spreads the depth slices over the job pool (each slice owns its
+// clusters, so no locking) and tests one light against a whole row of cluster
+// boxes per SIMD instruction, 4 (SSE) or 8 (AVX) at a time.
+//
+// Output, in the layout shaders/common/lights.glsl reads:
+//   grid()     2 uints per cluster: offset into indices(), light count
+//   indices()  light indices, grouped by cluster
+// Cluster index = (slice * CLUSTERS_Y + tileY) * CLUSTERS_X + tileX.
+class LightClusterer {
+public:
+    // Keep in sync with shaders/common/lights.glsl
+    static const unsigned CLUSTERS_X = 16;
+    static const unsigned CLUSTERS_Y = 9;
+    static const unsigned CLUSTERS_Z = 24;
+    static const unsigned TILES_PER_SLICE = CLUSTERS_X * CLUSTERS_Y;
+    static const unsigned CLUSTER_COUNT = TILES_PER_SLICE * CLUSTERS_Z;
+    static const unsigned MAX_LIGHTS_PER_CLUSTER = 256;
+
+    struct Stats {
+        unsigned int lights = 0;
+        unsigned int visibleLights = 0;     // Touching at least one cluster
+        unsigned int references = 0;        // Total cluster/light pairs
+        unsigned int occupiedClusters = 0;
+        unsigned int maxLightsPerCluster = 0;
+        unsigned int overflowedClusters = 0; // Hit MAX_LIGHTS_PER_CLUSTER and dropped lights
+        float averageLightsPerCluster = 0.0f; // Over occupied clusters
+        float assignMs = 0.0f;
+    };
+
+    // Rebuilds the cluster bounds if the projection or depth range changed
+    void setProjection(const glm::mat4& projection, float nearPlane, float farPlane);
+
+    // Assigns `lights` (world space) to clusters for this view
+    void assign(const std::vector<PointLight>& lights, const glm::mat4& view, JobPool& pool = JobPool::shared());
+
+    const std::vector<uint32_t>& grid() const { return clusterGrid; }
+    const std::vector<uint32_t>& indices() const { return lightIndices; }
+    const Stats& stats() const { return lastStats; }
+
+    // slice = floor(log(viewDepth) * depthScale + depthBias)
+    float depthScale() const { return sliceScale; }
+    float depthBias() const { return sliceBias; }
+
+    // Depth slice of a positive view-space depth, clamped to the grid
+    unsigned sliceOf(float viewDepth) const;
+
+    // View-space bounds of one cluster
+    void clusterBounds(unsigned cluster, glm::vec3& min, glm::vec3& max) const;
+
+private:
+    // Tiles per slice rounded up to whole SIMD batches
+    static const unsigned TILE_STRIDE = (TILES_PER_SLICE + 7) / 8 * 8;
+
+    glm::mat4 currentProjection = glm::mat4(0.0f);
+    float nearPlane = 0.0f, farPlane = 0.0f;
+    float sliceScale = 0.0f, sliceBias = 0.0f;
+
+    // Cluster boxes, [slice][TILE_STRIDE], structure-of-arrays
+    std::vector<float> minX, minY, minZ, maxX, maxY, maxZ;
+
+    // Lights in view space, structure-of-arrays
+    std::vector<float> lightX, lightY, lightZ, lightRadius;
+    std::vector<uint16_t> firstSlice, lastSlice;
+
+    // [cluster][MAX_LIGHTS_PER_CLUSTER] scratch lists and their sizes
+    std::vector<uint32_t> scratch;
+    std::vector<uint32_t> scratchCount;
+
+    std::vector<uint32_t> clusterGrid;
+    std::vector<uint32_t> lightIndices;
+    Stats lastStats;
+
+    void assignSlice(unsigned slice);
+};
+
+#endif // LIGHT_CLUSTERER_H
@@ -0,0 +1,128 @@
+#ifndef LIGHTMAP_H
+#define LIGHTMAP_H
+
+#include <vector>
+#include <glad/glad.h>
+#include "GLState.h"
+#include "Shader.h"
+#include "LightmapBaker.h"
+
+// The cooked lightmap on the GPU: irradiance as GL_RGB9_E5 (4 bytes a texel, HDR
+// without a float format) and occlusion as GL_R8. Both are filtered bilinearly;
+// the baker leaves a border of valid texels around every chart for that.
+class Lightmap {
+public:
+    Lightmap() {
+        glGenTextures(1, &irradiance);
+        glGenTextures(1, &occlusion);
+    }
+
+    Lightmap(const Lightmap&) = delete;
+    Lightmap& operator=(const Lightmap&) = delete;
+
+    ~Lightmap() {
+        GLState& gl = GLState::instance();
+        gl.forgetTexture(irradiance);
+        gl.forgetTexture(occlusion);
+        glDeleteTextures(1, &irradiance);
+        glDeleteTextures(1, &occlusion);
+    }
+
+    void upload(const LightmapImage& image) {
+        GLState& gl = GLState::instance();
+        gl.bindTexture(glsl::sampler::lightmap, GL_TEXTURE_2D, irradiance);
+        GLDebug::label(GL_TEXTURE, irradiance, "lightmap irradiance");
+        GL_CHECK(glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB9_E5, image.width, image.height, 0, GL_RGB,
+                              GL_UNSIGNED_INT_5_9_9_9_REV, image.irradiance.data()));
+        setSampling();
+
+        // Rows of bytes are not 4-byte aligned for every width
+        gl.bindTexture(glsl::sampler::lightmapOcclusion, GL_TEXTURE_2D, occlusion);
+        GLDebug::label(GL_TEXTURE, occlusion, "lightmap occlusion");
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        GL_CHECK(glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, image.width, image.height, 0, GL_RED, GL_UNSIGNED_BYTE,
+                              image.occlusion.data()));
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        setSampling();
+    }
+
+    void bind() const {
+        GLState& gl = GLState::instance();
+        gl.bindTexture(glsl::sampler::lightmap, GL_TEXTURE_2D, irradiance);
+        gl.bindTexture(glsl::sampler::lightmapOcclusion, GL_TEXTURE_2D, occlusion);
+    }
+
+private:
+    GLuint irradiance = 0, occlusion = 0;
+
+    static void setSampling() {
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    }
+};
+
+// A static object drawn with lightmap_vertex/lightmap_fragment: its unwrapped
+// geometry (split along chart seams) with the lightmap uv at location 5. The depth
+// pre-pass keeps using the object's own position stream; the positions are the
+// same, so GL_EQUAL still passes.
+struct LightmappedMesh {
+    GLuint VAO, VBO, EBO;
+    GLuint textureID, normalMapID;
+    GLsizei indexCount;
+
+    LightmappedMesh(const LightmapBaker::Unwrapped& mesh, GLuint textureID, GLuint normalMapID)
+        : textureID(textureID), normalMapID(normalMapID), indexCount((GLsizei)mesh.indices.size()) {
+        glGenVertexArrays(1, &VAO);
+        glGenBuffers(1, &VBO);
+        glGenBuffers(1, &EBO);
+
+        GLState& gl = GLState::instance();
+        gl.bindVertexArray(VAO);
+        gl.bindBuffer(GL_ARRAY_BUFFER, VBO);
+        GL_CHECK(glBufferData(GL_ARRAY_BUFFER, mesh.vertices.size() * sizeof(float), mesh.vertices.data(),
+                              GL_STATIC_DRAW));
+        gl.bindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+        GL_CHECK(glBufferData(GL_ELEMENT_ARRAY_BUFFER, mesh.indices.size() * sizeof(uint32_t), mesh.indices.data(),
+                              GL_STATIC_DRAW));
+        GLDebug::label(GL_BUFFER, VBO, "lightmapped vertices");
+        GLDebug::label(GL_BUFFER, EBO, "lightmapped indices");
+
+        // Position, normal, uv, tangent, bitangent, lightmap uv
+        const GLint sizes[6] = {3, 3, 2, 3, 3, 2};
+        const GLsizei stride = LightmapBaker::UNWRAPPED_FLOATS * sizeof(float);
+        size_t offset = 0;
+        for (GLuint location = 0; location < 6; ++location) {
+            glVertexAttribPointer(location, sizes[location], GL_FLOAT, GL_FALSE, stride,
+                                  (void*)(offset * sizeof(float)));
+            glEnableVertexAttribArray(location);
+            offset += sizes[location];
+        }
+        gl.bindVertexArray(0);
+    }
+
+    LightmappedMesh(const LightmappedMesh&) = delete;
+    LightmappedMesh& operator=(const LightmappedMesh&) = delete;
+
+    // With the lightmapped program, which the caller binds
+    void Draw() {
+        GLState& gl = GLState::instance();
+        gl.bindTexture(glsl::sampler::texture1, GL_TEXTURE_2D, textureID);
+        gl.bindTexture(glsl::sampler::normalMap, GL_TEXTURE_2D, normalMapID);
+        gl.bindVertexArray(VAO);
+        gl.drawElements(GL_TRIANGLES, indexCount, GL_UNSIGNED_INT, 0);
+    }
+
+    ~LightmappedMesh() {
+        GLState& gl = GLState::instance();
+        gl.forgetVertexArray(VAO);
+        gl.forgetBuffer(VBO);
+        gl.forgetBuffer(EBO);
+        glDeleteVertexArrays(1, &VAO);
+        glDeleteBuffers(1, &VBO);
+        glDeleteBuffers(1, &EBO);
+    }
+};
+
+#endif // LIGHTMAP_H
@@ -0,0 +1,181 @@
+#ifndef LIGHTMAP_BAKER_H
+#define LIGHTMAP_BAKER_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include "BVH.h"
+#include "JobPool.h"
+#include "LightClusterer.h"
+
+// Cooked lightmap, as LightmapBaker writes it and Lightmap (Lightmap.h) uploads it.
+// File layout, little endian:
+//   "LMAP", uint32 version, uint32 width, uint32 height, uint32 chart count,
+//   width * height uint32 irradiance (GL_RGB9_E5), width * height uint8 occlusion
+// Rows are bottom-up (row 0 is v = 0).
+struct LightmapImage {
+    static const uint32_t VERSION = 1;
+
+    int width = 0, height = 0;
+    uint32_t charts = 0;               // Must match the atlas the runtime unwraps
+    std::vector<uint32_t> irradiance;  // Shared-exponent RGB, see packRGB9E5()
+    std::vector<uint8_t> occlusion;    // 255 = unoccluded
+
+    bool write(const std::string& path) const;
+    bool read(const std::string& path);
+};
+
+// GL_UNSIGNED_INT_5_9_9_9_REV packing: three 9-bit mantissas and a shared 5-bit exponent
+uint32_t packRGB9E5(const glm::vec3& rgb);
+glm::vec3 unpackRGB9E5(uint32_t packed);
+
+// Bakes the lighting of static objects into one atlas on the CPU, so their shading
+// reads a texel instead of looping over lights:
+//   1. atlas   each object's triangles are grown into charts of connected triangles
+//              within `chartAngle` of the first one's normal, projected onto that
+//              plane at `texelsPerUnit` and shelf-packed. Every chart keeps a
+//              1-texel border of valid texels, so bilinear filtering never reads
+//              another chart.
+//   2. texels  every texel of a chart gets a world position and normal: the
+//              triangle under its centre, or the nearest one for border texels
+//   3. trace   per texel, direct light from the static lights with shadow rays,
+//              `samples` cosine-weighted paths of up to `bounces` diffuse bounces
+//              (direct light at every vertex), and ambient occlusion from the
+//              fraction of those rays that hit within `aoDistance`
+// Rays go through the 4-wide SSE BVH (BVH.h) over all triangles; atlas rows are
+// spread over the job pool. Random numbers are seeded per texel, so the result
+// does not depend on the thread count.
+//
+// The irradiance follows shade() in shaders/common/shading.glsl: per light,
+// 0.1 * color ambient (scaled by the occlusion) plus N.L * color, times the
+// falloff; the shaded colour is albedo * irradiance. Specular depends on the view
+// and is not baked.
+class LightmapBaker {
+public:
+    static const int VERTEX_FLOATS = 14;          // FG.h layout
+    static const int UNWRAPPED_FLOATS = 16;       // ...plus the lightmap uv
+
+    struct Settings {
+        float texelsPerUnit = 32.0f;   // Shrunk until the atlas fits maxSize
+        float chartAngle = 30.0f;      // Degrees
+        int maxSize = 2048;
+        int samples = 64;
+        int bounces = 2;
+        float aoDistance = 1.0f;
+        uint32_t seed = 1;
+    };
+
+    struct Stats {
+        unsigned int charts = 0;
+        unsigned int texels = 0;       // Texels covered by charts
+        float texelsPerUnit = 0.0f;    // After fitting
+        uint64_t rays = 0;
+        float atlasMs = 0.0f;
+        float bakeMs = 0.0f;
+    };
+
+    // The object's geometry for the lightmapped draw: vertices split along chart
+    // boundaries, in the FG.h layout with the lightmap uv appended
+    struct Unwrapped {
+        std::vector<float> vertices;
+        std::vector<uint32_t> indices;
+    };
+
+    LightmapBaker() = default;
+    explicit LightmapBaker(const Settings& settings) : settings(settings) {}
+
+    // Static geometry in the FG.h layout, placed by `model`. `albedo` is the mean
+    // diffuse colour indirect light bounces off. Returns the object's index.
+    uint32_t addObject(const std::vector<float>& vertices, const std::vector<uint32_t>& indices,
+                       const glm::mat4& model, const glm::vec3& albedo);
+
+    // Charts, packing and texel positions; deterministic, so the runtime rebuilds it
+    // to get the same uvs the bake used
+    void buildAtlas();
+
+    // Traces the atlas (buildAtlas() first) lit by `lights`
+    void bake(const std::vector<PointLight>& lights, JobPool& pool = JobPool::shared());
+
+    int width() const { return atlasWidth; }
+    int height() const { return atlasHeight; }
+    const Unwrapped& unwrapped(uint32_t object) const { return objects[object].unwrapped; }
+
+    // Linear irradiance and occlusion ([0, 1]) per texel, rows bottom-up
+    const std::vector<glm::vec3>& irradiance() const { return texelIrradiance; }
+    const std::vector<float>& occlusion() const { return texelOcclusion; }
+
+    // The bake in the cooked format
+    LightmapImage cook() const;
+
+    const Stats& stats() const { return lastStats; }
+
+private:
+    struct Object {
+        std::vector<float> vertices;
+        std::vector<uint32_t> indices;
+        glm::mat4 model;
+        glm::vec3 albedo;
+        Unwrapped unwrapped;
+    };
+
+    // World space. Degenerate triangles are kept for the unwrap but not traced.
+    struct Triangle {
+        glm::vec3 p0, edge1, edge2;
+        glm::vec3 normal[3];
+        glm::vec3 faceNormal;
+        uint32_t object;
+        uint32_t firstIndex;      // Of its first index in the object
+    };
+
+    struct Chart {
+        uint32_t object;
+        glm::vec3 axisU, axisV;
+        glm::vec2 offset;         // Atlas texel of the projected origin
+        int x, y, width, height;  // Texel rect, border included
+        std::vector<uint32_t> triangles;
+    };
+
+    // One atlas texel; triangle < 0 when no chart covers it
+    struct Texel {
+        glm::vec3 position;
+        glm::vec3 normal;
+        int32_t triangle = -1;
+    };
+
+    Settings settings;
+    std::vector<Object> objects;
+    std::vector<Triangle> triangles;
+    std::vector<Chart> charts;
+    std::vector<Texel> texels;
+    int atlasWidth = 0, atlasHeight = 0;
+    float scale = 0.0f;               // Texels per unit the atlas was fitted with
+    std::vector<glm::vec3> texelIrradiance;
+    std::vector<float> texelOcclusion;
+
+    // Tracing
+    BVH bvh;
+    std::vector<uint32_t> traced;   // BVH object -> triangle
+    float rayBias = 1e-4f;
+    const std::vector<PointLight>* bakeLights = nullptr;
+
+    Stats lastStats;
+
+    void buildTriangles();
+    void buildCharts();
+    bool packCharts(float texelsPerUnit);
+    void unwrapObjects();
+    void placeTexels();
+    glm::vec2 project(const Chart& chart, const glm::vec3& p) const;
+
+    // Distance to the triangle, negative for a miss or beyond maxDistance
+    float hitDistance(uint32_t triangle, const glm::vec3& origin, const glm::vec3& direction, float maxDistance) const;
+    bool intersect(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, uint32_t& triangle,
+                   float& distance, glm::vec2& barycentric) const;
+    bool occluded(const glm::vec3& origin, const glm::vec3& direction, float distance) const;
+    glm::vec3 directLight(const glm::vec3& position, const glm::vec3& normal, float occlusion,
+                          uint64_t& rays) const;
+    void bakeTexel(size_t index, uint64_t& rays);
+};
+
+#endif // LIGHTMAP_BAKER_H
@@ -5,6 +5,8 @@
 #include <glad/glad.h>
 #include <glm/glm.hpp>
 #include "Shader.h"
+#include "Bounds.h"
+#include "PositionStream.h"
 
 struct Vertex {
     glm::vec3 Position;
@@ -17,9 +19,13 @@ public:
     std::vector<Vertex> vertices;
     std::vector<unsigned int> indices;
     unsigned int VAO;
+    AABB bounds;                   // Object-space bounds
+    BoundingSphere boundingSphere;
+    PositionStream depthStream;    // Positions only, for the depth pre-pass
 
     Mesh(std::vector<Vertex> vertices, std::vector<unsigned int> indices);
     void Draw(const Shader& shader) const;
+    void DrawDepth() const;
 
 private:
     unsigned int VBO, EBO;
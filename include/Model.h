@@ -16,6 +16,7 @@ class Model {
 public:
     Model(const std::string& path);
     void Draw(Shader& shader);
+    void DrawDepth();
 
 private:
     std::vector<Mesh> meshes;
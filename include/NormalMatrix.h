@@ -0,0 +1,27 @@
+#ifndef NORMAL_MATRIX_H
+#define NORMAL_MATRIX_H
+
+#include <cstddef>
+#include <glm/glm.hpp>
+
+// Normal matrices computed on the CPU, once per object or instance, instead of
+// mat3(transpose(inverse(model))) for every vertex.
+//
+// Results are the inverse-transpose of the model's upper 3x3 up to a positive scale;
+// every shader renormalizes after the multiply. That allows two shortcuts:
+//   - rotation times uniform scale (rigid included) is its own normal matrix, so the
+//     upper 3x3 is used as is;
+//   - anything else uses the cofactor matrix (det * inverse-transpose, sign fixed),
+//     so there is no division and no inverse.
+
+// True when the upper 3x3 is a rotation (or reflection) times a uniform scale
+bool isConformal(const glm::mat3& m, float tolerance = 1e-4f);
+
+glm::mat3 normalMatrix(const glm::mat4& model);
+
+// Normal matrices of `count` models, 4 (SSE) or 8 (AVX) per step. Each output is three
+// vec4 columns (w = 0). Both arrays advance by `stride` bytes per element, so a whole
+// InstanceData array is processed in place.
+void computeNormalMatrices(const glm::mat4* models, glm::vec4* normalColumns, size_t count, size_t stride);
+
+#endif // NORMAL_MATRIX_H
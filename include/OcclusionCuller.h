@@ -0,0 +1,127 @@
+#ifndef OCCLUSION_CULLER_H
+#define OCCLUSION_CULLER_H
+
+#include <vector>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include "Bounds.h"
+#include "JobPool.h"
+
+// CPU occlusion culling in the style of masked software occlusion culling
+// (Hasselgren et al.). A few large occluders are rasterized into a small depth
+// buffer, then occludee boxes are tested against it before anything is submitted.
+//
+// The buffer is split into TILE_WIDTH x TILE_HEIGHT pixel tiles. A tile keeps no
+// per-pixel depth, only:
+//   farDepth      every pixel of the tile is at or in front of this
+//   mask          pixels covered by the working layer (bit = row * TILE_WIDTH + column)
+//   workingDepth  those pixels are at or in front of this
+// Triangles merge into the working layer; once it covers the whole tile it becomes
+// the new farDepth. Depth is window depth in [0, 1] (0 = near plane), always an
+// upper bound, so a box is only rejected when it is certainly hidden.
+//
+// Coverage is computed one tile row per SIMD instruction: 8 pixels (AVX) or two
+// halves of 4 (SSE). rasterize() hands tile rows to the job pool; each row owns its
+// tiles and walks the triangles in submission order, so results never depend on
+// the thread count. Nothing here touches GL.
+//
+// Frame:
+//   begin(viewProjection)     clear, set the camera
+//   addOccluder(mesh, model)  large, close, opaque meshes
+//   rasterize()
+//   cull(boxes, visible)      or occluded() for single boxes
+class OcclusionCuller {
+public:
+    static const int TILE_WIDTH = 8;
+    static const int TILE_HEIGHT = 4;
+    static const uint32_t FULL_TILE = 0xFFFFFFFFu;
+
+    // Occluder geometry: packed positions (3 floats per vertex) and triangle indices
+    struct Mesh {
+        std::vector<float> positions;
+        std::vector<uint32_t> indices;
+
+        // From interleaved vertices with the position first, `strideFloats` floats each
+        static Mesh fromVertices(const std::vector<float>& vertices, size_t strideFloats,
+                                 const std::vector<uint32_t>& indices) {
+            Mesh mesh;
+            size_t count = vertices.size() / strideFloats;
+            mesh.positions.resize(count * 3);
+            for (size_t i = 0; i < count; ++i)
+                for (size_t k = 0; k < 3; ++k) mesh.positions[3 * i + k] = vertices[i * strideFloats + k];
+            mesh.indices = indices;
+            return mesh;
+        }
+    };
+
+    struct Stats {
+        unsigned int occluders = 0;
+        unsigned int triangles = 0;         // Submitted by the occluders
+        unsigned int rasterized = 0;        // Survived clipping and setup
+        unsigned int tested = 0;
+        unsigned int rejected = 0;          // Occluded boxes
+        float rasterMs = 0.0f;
+        float testMs = 0.0f;
+    };
+
+    // Width and height are rounded up to whole tiles
+    OcclusionCuller(int width = 320, int height = 192);
+
+    int width() const { return tilesX * TILE_WIDTH; }
+    int height() const { return tilesY * TILE_HEIGHT; }
+
+    // Clears the buffer and the occluder list for a new frame
+    void begin(const glm::mat4& viewProjection);
+
+    // `mesh` must stay alive until rasterize() returns
+    void addOccluder(const Mesh& mesh, const glm::mat4& model);
+
+    void rasterize(JobPool& pool = JobPool::shared());
+
+    // True when the world-space box is certainly hidden by the rasterized occluders.
+    // Boxes crossing the near plane or outside the screen are never occluded here.
+    bool occluded(const AABB& worldBounds) const;
+
+    // visible[i] = !occluded(boxes[i]); large sets are split over the pool
+    void cull(const AABB* boxes, size_t count, uint8_t* visible, JobPool& pool = JobPool::shared());
+
+    // Upper bound of the depth at one pixel, (0, 0) = bottom left
+    float depthBound(int x, int y) const;
+
+    const Stats& stats() const { return lastStats; }
+
+    // Sets below this size are tested on the calling thread
+    size_t parallelThreshold = 4096;
+
+private:
+    // Screen-space setup of one triangle; edges are > 0 inside (counter-clockwise)
+    struct Triangle {
+        float edgeA[3], edgeB[3], edgeC[3];   // edge(x, y) = A x + B y + C
+        float depthA, depthB, depthC;         // Depth plane over the screen
+        float maxDepth;
+        int tileX0, tileX1, tileY0, tileY1;   // Inclusive tile range
+    };
+
+    struct Occluder {
+        const Mesh* mesh;
+        glm::mat4 model;
+    };
+
+    int tilesX = 0, tilesY = 0;
+    glm::mat4 viewProjection = glm::mat4(1.0f);
+    std::vector<Occluder> occluders;
+    std::vector<Triangle> triangles;
+    std::vector<uint8_t> triangleValid;
+
+    // Tiles, row-major, structure-of-arrays
+    std::vector<uint32_t> tileMask;
+    std::vector<float> tileFarDepth, tileWorkingDepth;
+
+    Stats lastStats;
+
+    bool setupTriangle(const glm::vec4& c0, const glm::vec4& c1, const glm::vec4& c2, Triangle& tri) const;
+    void rasterizeTileRow(int tileY);
+    void updateTile(size_t tile, uint32_t coverage, float depth);
+};
+
+#endif // OCCLUSION_CULLER_H
@@ -16,6 +16,7 @@ public:
     glm::mat4 GetViewMatrix() const;
     void ProcessMouseMovement(float xoffset, float yoffset);
     void ProcessMouseScroll(float yoffset);
+    void SetOrbit(float distance, float yaw, float pitch);  // Scripted cameras; clamped like the mouse
 
     glm::vec3 GetCameraPosition() const;
 
@@ -0,0 +1,55 @@
+#ifndef POSITION_STREAM_H
+#define POSITION_STREAM_H
+
+#include <vector>
+#include <cstddef>
+#include <glad/glad.h>
+#include "GLState.h"
+
+// Positions of interleaved vertex data (position first, `strideFloats` floats per
+// vertex), tightly packed: 12 bytes per vertex
+inline std::vector<float> packPositions(const float* vertices, size_t vertexCount, size_t strideFloats) {
+    std::vector<float> positions(vertexCount * 3);
+    for (size_t i = 0; i < vertexCount; ++i) {
+        positions[3 * i + 0] = vertices[i * strideFloats + 0];
+        positions[3 * i + 1] = vertices[i * strideFloats + 1];
+        positions[3 * i + 2] = vertices[i * strideFloats + 2];
+    }
+    return positions;
+}
+
+// Position-only copy of a mesh for depth-only passes, with its own VAO (location 0)
+// sharing the mesh's index buffer. The depth pre-pass then fetches 12 bytes per
+// vertex instead of the full 32-56 byte interleaved vertex.
+//
+// Plain handles like the mesh types that own it: the owner calls release().
+struct PositionStream {
+    GLuint VAO = 0, VBO = 0;
+
+    void create(const float* vertices, size_t vertexCount, size_t strideFloats, GLuint indexBuffer) {
+        std::vector<float> positions = packPositions(vertices, vertexCount, strideFloats);
+
+        glGenVertexArrays(1, &VAO);
+        glGenBuffers(1, &VBO);
+
+        GLState& gl = GLState::instance();
+        gl.bindVertexArray(VAO);
+        gl.bindBuffer(GL_ARRAY_BUFFER, VBO);
+        GL_CHECK(glBufferData(GL_ARRAY_BUFFER, positions.size() * sizeof(float), positions.data(), GL_STATIC_DRAW));
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
+        glEnableVertexAttribArray(0);
+        gl.bindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
+        gl.bindVertexArray(0);
+    }
+
+    void release() {
+        GLState& gl = GLState::instance();
+        gl.forgetVertexArray(VAO);
+        gl.forgetBuffer(VBO);
+        glDeleteVertexArrays(1, &VAO);
+        glDeleteBuffers(1, &VBO);
+        VAO = VBO = 0;
+    }
+};
+
+#endif // POSITION_STREAM_H
@@ -0,0 +1,142 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstdint>
+#include <unordered_map>
+#include <glad/glad.h>
+
+// Frame profiler with named, nestable scopes timed on both sides:
+//   CPU  steady_clock around the scope
+//   GPU  a GL_TIMESTAMP query at each end of the scope (timestamps nest, unlike
+//        GL_TIME_ELAPSED)
+// Queries live in a ring of FRAME_LATENCY frames. A frame's results are read when
+// its slot comes round again, and only if the GPU has already written them, so
+// reading never stalls. A frame whose queries are still pending is dropped.
+//
+// With GL_ARB_pipeline_statistics_query (core in 4.6), top-level scopes also count
+// vertex and fragment shader invocations. Those queries can't nest, which is why
+// only top-level scopes get them.
+//
+// Scopes are identified by their path ("opaque/cube"). A scope entered several
+// times in one frame is summed. Every value is a rolling average over the last
+// HISTORY frames that contained the scope.
+class Profiler {
+public:
+    static const unsigned FRAME_LATENCY = 4;
+    static const unsigned MAX_GPU_SCOPES = 64;   // Per frame; later scopes are CPU-only
+    static const unsigned HISTORY = 64;
+
+    struct RollingAverage {
+        double samples[HISTORY] = {};
+        double sum = 0.0;
+        unsigned count = 0, next = 0;
+
+        void add(double value) {
+            if (count == HISTORY) sum -= samples[next];
+            else ++count;
+            samples[next] = value;
+            sum += value;
+            next = (next + 1) % HISTORY;
+        }
+        double mean() const { return count ? sum / count : 0.0; }
+    };
+
+    struct Result {
+        std::string path;
+        std::string name;
+        unsigned depth = 0;
+        RollingAverage cpuMs, gpuMs;
+        RollingAverage vertexInvocations, fragmentInvocations;
+    };
+
+    struct Stats {
+        unsigned int collectedFrames = 0;  // Frames whose GPU results were read
+        unsigned int droppedFrames = 0;    // GPU results not ready when their slot came round
+        float lastGpuFrameMs = 0.0f;       // First to last timestamp of the latest collected frame
+    };
+
+    // Needs a current GL context
+    Profiler();
+    ~Profiler();
+
+    Profiler(const Profiler&) = delete;
+    Profiler& operator=(const Profiler&) = delete;
+
+    void beginFrame();
+    void endFrame();
+
+    void begin(const char* name);
+    void end();
+
+    // begin() on construction, end() when it goes out of scope
+    class Scope {
+    public:
+        Scope(Profiler& profiler, const char* name) : profiler(profiler) { profiler.begin(name); }
+        ~Scope() { profiler.end(); }
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        Profiler& profiler;
+    };
+
+    bool gpuTimers() const { return timers; }
+    bool pipelineStatistics() const { return statistics; }
+
+    // In first-seen order, so children follow their parent
+    const std::vector<Result>& results() const { return scopes; }
+    const Result* find(const std::string& path) const;
+    const Stats& stats() const { return counters; }
+
+    // "name cpu/gpu ms" for every scope up to `maxDepth`, for the window title
+    std::string summary(unsigned maxDepth = 0) const;
+
+    // One row per scope: path, depth, averages; false if the file can't be written
+    bool exportCsv(const std::string& path) const;
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    static const unsigned NO_QUERY = ~0u;
+
+    // One begin()/end() pair of a frame
+    struct Sample {
+        unsigned scope;
+        unsigned query;    // Timestamp pair, or NO_QUERY past MAX_GPU_SCOPES
+        bool counted;      // Has pipeline statistics queries
+    };
+
+    struct Frame {
+        GLuint timestamps[2 * MAX_GPU_SCOPES];
+        GLuint invocations[2 * MAX_GPU_SCOPES];   // Vertex, fragment per sample
+        std::vector<Sample> samples;
+        bool pending = false;
+    };
+
+    struct Open {
+        unsigned scope;
+        unsigned sample;
+        Clock::time_point start;
+    };
+
+    bool timers = false;
+    bool statistics = false;
+    Frame frames[FRAME_LATENCY];
+    unsigned frameIndex = 0;
+    unsigned gpuScopes = 0;
+
+    std::vector<Result> scopes;
+    std::unordered_map<std::string, unsigned> scopeIndex;
+    std::vector<Open> stack;
+    std::vector<double> cpuThisFrame;   // Per scope, summed over the frame
+    std::vector<uint8_t> seenThisFrame;
+    Stats counters;
+
+    unsigned scopeFor(const char* name);
+    void collect(Frame& frame);
+};
+
+#endif // PROFILER_H
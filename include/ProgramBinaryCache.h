@@ -0,0 +1,112 @@
+#ifndef PROGRAM_BINARY_CACHE_H
+#define PROGRAM_BINARY_CACHE_H
+
+#include <glad/glad.h>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <filesystem>
+
+// On-disk cache of linked program binaries (GL 4.1 / ARB_get_program_binary).
+// Entries are keyed by a hash of the fully preprocessed sources plus the driver
+// identity, so editing a shared include only invalidates the programs that use it.
+class ProgramBinaryCache {
+public:
+    explicit ProgramBinaryCache(const std::string& directory) : directory(directory) {}
+
+    // Needs a current GL context
+    bool supported() {
+        if (!checked) {
+            checked = true;
+            GLint formats = 0;
+            if (GLAD_GL_VERSION_4_1)
+                glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+            available = formats > 0;
+            if (available) {
+                driver = std::string((const char*)glGetString(GL_VENDOR)) + "|" +
+                         (const char*)glGetString(GL_RENDERER) + "|" +
+                         (const char*)glGetString(GL_VERSION);
+                std::filesystem::create_directories(directory);
+            }
+        }
+        return available;
+    }
+
+    std::string key(const std::string& vertexCode, const std::string& fragmentCode) const {
+        uint64_t hash = 14695981039346656037ull;
+        hash = fnv1a(hash, driver);
+        hash = fnv1a(hash, vertexCode);
+        hash = fnv1a(hash, "\x1f");
+        hash = fnv1a(hash, fragmentCode);
+        char name[17];
+        std::snprintf(name, sizeof(name), "%016llx", (unsigned long long)hash);
+        return name;
+    }
+
+    // Loads a cached binary into `program`; false when missing or rejected by the driver
+    bool load(const std::string& key, GLuint program) {
+        if (!supported()) return false;
+
+        std::ifstream file(entryPath(key), std::ios::binary);
+        if (!file.is_open()) return false;
+
+        GLenum format = 0;
+        file.read(reinterpret_cast<char*>(&format), sizeof(format));
+        std::vector<char> binary((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        if (!file.eof() && file.fail()) return false;
+        if (binary.empty()) return false;
+
+        glProgramBinary(program, format, binary.data(), (GLsizei)binary.size());
+        GLint linked = GL_FALSE;
+        glGetProgramiv(program, GL_LINK_STATUS, &linked);
+        if (!linked) {
+            // Stale after a driver update; drop it so it gets rebuilt
+            std::filesystem::remove(entryPath(key));
+            return false;
+        }
+        return true;
+    }
+
+    void store(const std::string& key, GLuint program) {
+        if (!supported()) return;
+
+        GLint length = 0;
+        glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+        if (length <= 0) return;
+
+        std::vector<char> binary(length);
+        GLenum format = 0;
+        glGetProgramBinary(program, length, nullptr, &format, binary.data());
+
+        std::ofstream file(entryPath(key), std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) {
+            std::cerr << "WARNING: Cannot write program binary cache entry " << key << std::endl;
+            return;
+        }
+        file.write(reinterpret_cast<const char*>(&format), sizeof(format));
+        file.write(binary.data(), binary.size());
+    }
+
+private:
+    std::string directory;
+    std::string driver;
+    bool checked = false;
+    bool available = false;
+
+    std::string entryPath(const std::string& key) const {
+        return (std::filesystem::path(directory) / (key + ".bin")).string();
+    }
+
+    static uint64_t fnv1a(uint64_t hash, const std::string& data) {
+        for (unsigned char c : data) {
+            hash ^= c;
+            hash *= 1099511628211ull;
+        }
+        return hash;
+    }
+};
+
+#endif // PROGRAM_BINARY_CACHE_H
@@ -0,0 +1,79 @@
+#ifndef RENDER_QUEUE_H
+#define RENDER_QUEUE_H
+
+#include <cstdint>
+#include <vector>
+#include <functional>
+#include "JobPool.h"
+
+// Per-frame list of draws sorted by a packed 64-bit key, executed in an order that
+// minimizes state changes. Key layout, most significant bits first:
+//
+//   63..60  pass          (4 bits)
+//   59      translucent   (1 bit)   opaque draws come first within a pass
+//   58..35  depth         (24 bits) opaque: coarse front-to-back bucket,
+//                                   translucent: full precision back-to-front
+//   34..23  program       (12 bits)
+//   22..11  material      (12 bits) texture set
+//   10..0   mesh          (11 bits) VAO
+//
+// Program/material/mesh are small dense IDs chosen by the caller, not GL names.
+class RenderQueue {
+public:
+    struct Item {
+        uint64_t key;
+        uint32_t payload; // Caller's handle for the draw
+        uint32_t pad;
+    };
+
+    // Which key fields differ from the previously executed item
+    enum Change : unsigned {
+        PASS_CHANGED = 1 << 0,
+        TRANSLUCENCY_CHANGED = 1 << 1,
+        PROGRAM_CHANGED = 1 << 2,
+        MATERIAL_CHANGED = 1 << 3,
+        MESH_CHANGED = 1 << 4,
+    };
+
+    static const unsigned OPAQUE_DEPTH_BUCKETS = 16;
+
+    // `depth` is the normalized view depth in [0, 1], 0 = near plane
+    static uint64_t makeKey(unsigned pass, bool translucent, float depth,
+                            unsigned program, unsigned material, unsigned mesh);
+
+    static unsigned pass(uint64_t key)     { return (unsigned)(key >> 60) & 0xF; }
+    static bool translucent(uint64_t key)  { return (key >> 59) & 1; }
+    static unsigned program(uint64_t key)  { return (unsigned)(key >> 23) & 0xFFF; }
+    static unsigned material(uint64_t key) { return (unsigned)(key >> 11) & 0xFFF; }
+    static unsigned mesh(uint64_t key)     { return (unsigned)key & 0x7FF; }
+
+    explicit RenderQueue(JobPool& pool = JobPool::shared()) : pool(pool) {}
+
+    void clear() { items.clear(); }
+    void reserve(size_t count) { items.reserve(count); scratch.reserve(count); }
+    void submit(uint64_t key, uint32_t payload) { items.push_back({key, payload, 0}); }
+
+    // Stable LSD radix sort by key; spread over the job pool for large queues
+    void sort();
+
+    // Calls fn(item, changes) for every item in sorted order; `changes` is a mask of
+    // Change bits relative to the previous item (everything for the first one)
+    void execute(const std::function<void(const Item&, unsigned changes)>& fn) const;
+
+    const std::vector<Item>& sorted() const { return items; }
+    size_t size() const { return items.size(); }
+
+    // Below this many items sorting stays on the calling thread
+    size_t parallelThreshold = 16384;
+
+private:
+    JobPool& pool;
+    std::vector<Item> items;
+    std::vector<Item> scratch;
+    std::vector<uint32_t> histograms; // [chunk][256]
+
+    void sortSerial();
+    void sortParallel();
+};
+
+#endif // RENDER_QUEUE_H
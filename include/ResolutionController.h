@@ -0,0 +1,79 @@
+#ifndef RESOLUTION_CONTROLLER_H
+#define RESOLUTION_CONTROLLER_H
+
+#include <cmath>
+#include <algorithm>
+
+// Picks the render scale (fraction of the window size per axis) from measured GPU
+// frame times so the frame stays within targetMs.
+//
+// Over budget, the scale drops at once: pixel cost goes with scale^2, so it jumps
+// straight to sqrt(target / measured) of the current scale. Under budget, it rises
+// one step at a time, and only after raiseFrames frames in a row under
+// headroom * target. The gap between the two thresholds is the hysteresis that
+// keeps it from oscillating.
+//
+// Timer results arrive a few frames late. After every change the next
+// `latencyFrames` measurements still belong to the old size, so they are ignored.
+class ResolutionController {
+public:
+    struct Settings {
+        float targetMs = 16.6f;
+        float minScale = 0.5f;
+        float maxScale = 1.0f;
+        float step = 0.05f;          // Scales are multiples of this
+        float headroom = 0.8f;       // Rise only below this fraction of the target
+        unsigned raiseFrames = 30;
+        unsigned latencyFrames = 5;
+    };
+
+    ResolutionController() : ResolutionController(Settings()) {}
+    explicit ResolutionController(const Settings& settings) : settings(settings), current(settings.maxScale) {}
+
+    // One measured GPU frame time; returns true when the scale changed
+    bool update(float gpuMs) {
+        if (ignore > 0) {
+            --ignore;
+            return false;
+        }
+
+        float next = current;
+        if (gpuMs > settings.targetMs) {
+            underBudget = 0;
+            next = quantizeDown(current * std::sqrt(settings.targetMs / gpuMs));
+        } else if (gpuMs < settings.targetMs * settings.headroom) {
+            if (++underBudget >= settings.raiseFrames) {
+                underBudget = 0;
+                next = current + settings.step;
+            }
+        } else {
+            underBudget = 0;
+        }
+
+        next = std::min(std::max(next, settings.minScale), settings.maxScale);
+        if (std::fabs(next - current) < 1e-4f) return false;
+        current = next;
+        ignore = settings.latencyFrames;
+        return true;
+    }
+
+    float scale() const { return current; }
+
+    // Render size for a window, at least 1x1
+    int scaled(int windowSize) const { return std::max(1, (int)std::lround(windowSize * current)); }
+
+    const Settings& config() const { return settings; }
+
+private:
+    Settings settings;
+    float current;
+    unsigned underBudget = 0;
+    unsigned ignore = 0;
+
+    float quantizeDown(float scale) const {
+        // Rounded down, so the next frame lands under the target rather than near it
+        return std::floor(scale / settings.step + 1e-3f) * settings.step;
+    }
+};
+
+#endif // RESOLUTION_CONTROLLER_H
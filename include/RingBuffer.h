@@ -0,0 +1,84 @@
+#ifndef RING_BUFFER_H
+#define RING_BUFFER_H
+
+#include <vector>
+#include <cstddef>
+#include <glad/glad.h>
+
+// Streaming buffer for data the CPU rewrites every frame (per-draw data, indirect
+// commands, later debug lines or particles). allocate() hands out space for the
+// current frame: a CPU pointer to write through and the offset the GPU reads it at.
+//
+// With GL 4.4 the buffer is one persistent, coherent mapping split into FRAMES
+// sections used in turn. A fence after each frame tells when the GPU is done with
+// its section. When beginFrame() has to wait for that fence, the CPU has got
+// FRAMES frames ahead, and the wait is counted as a stall.
+//
+// Without buffer storage, allocations go to a CPU staging copy and flush() uploads
+// them with glBufferSubData into storage orphaned at beginFrame(), which is what
+// the callers did before.
+class RingBuffer {
+public:
+    static const unsigned FRAMES = 3;
+
+    struct Allocation {
+        void* cpu = nullptr;     // Write `size` bytes here...
+        GLintptr offset = 0;     // ...and read them from buffer() at this offset
+        GLsizeiptr size = 0;
+
+        explicit operator bool() const { return cpu != nullptr; }
+    };
+
+    struct Stats {
+        unsigned int frames = 0;
+        unsigned int stalls = 0;      // beginFrame() waited on the GPU
+        double stallMs = 0.0;         // Total time spent waiting
+        unsigned int overflows = 0;   // allocate() calls that didn't fit in the frame
+        size_t peakBytes = 0;         // Most used by one frame
+    };
+
+    static bool persistentSupported() { return GLAD_GL_VERSION_4_4 != 0; }
+
+    // `frameBytes` per frame. Allocations start on multiples of `alignment`; 0 uses
+    // the uniform / shader storage offset alignment, so any of them can be bound
+    // with glBindBufferRange.
+    explicit RingBuffer(size_t frameBytes, size_t alignment = 0);
+    ~RingBuffer();
+
+    RingBuffer(const RingBuffer&) = delete;
+    RingBuffer& operator=(const RingBuffer&) = delete;
+
+    // Starts the next frame. Fences the previous one, so the draws reading it must
+    // have been issued by now, then waits until the GPU has released the section
+    // about to be reused.
+    void beginFrame();
+
+    // Empty on overflow; the previous allocations of the frame stay valid
+    Allocation allocate(size_t bytes, size_t alignment = 0);
+
+    // Makes what was written so far visible to the GPU; call before the draws that
+    // read it. A no-op for the coherent mapping.
+    void flush();
+
+    GLuint buffer() const { return handle; }
+    bool persistent() const { return mapped != nullptr; }
+    size_t capacity() const { return frameBytes; }
+    const Stats& stats() const { return counters; }
+
+private:
+    GLuint handle = 0;
+    size_t frameBytes;
+    size_t alignment;
+    unsigned char* mapped = nullptr;        // All FRAMES sections when persistent
+    std::vector<unsigned char> staging;     // One frame otherwise
+    GLsync fences[FRAMES] = {};
+    unsigned section = FRAMES - 1;
+    bool started = false;
+    size_t used = 0;
+    size_t flushed = 0;
+    Stats counters;
+
+    void createOrphaned();
+};
+
+#endif // RING_BUFFER_H
@@ -0,0 +1,121 @@
+#ifndef SCENE_TARGET_H
+#define SCENE_TARGET_H
+
+#include <cstdint>
+#include <iostream>
+#include <glad/glad.h>
+#include "GLState.h"
+#include "Shader.h"
+
+// Offscreen colour + depth target the scene is rendered into at the dynamic
+// resolution, then upscaled to the window by present() (deferred_vertex +
+// upscale_fragment).
+//
+// The targets are reallocated when the size changes. ResolutionController only
+// changes the scale in whole steps with hysteresis, so that happens a few times a
+// second at most.
+class SceneTarget {
+public:
+    SceneTarget(int width, int height) {
+        glGenFramebuffers(1, &FBO);
+        glGenTextures(TARGET_COUNT, targets);
+        glGenVertexArrays(1, &VAO);
+        resize(width, height);
+    }
+
+    SceneTarget(const SceneTarget&) = delete;
+    SceneTarget& operator=(const SceneTarget&) = delete;
+
+    ~SceneTarget() {
+        GLState& gl = GLState::instance();
+        gl.forgetFramebuffer(FBO);
+        gl.forgetVertexArray(VAO);
+        for (int i = 0; i < TARGET_COUNT; ++i) gl.forgetTexture(targets[i]);
+        glDeleteFramebuffers(1, &FBO);
+        glDeleteTextures(TARGET_COUNT, targets);
+        glDeleteVertexArrays(1, &VAO);
+    }
+
+    bool resize(int newWidth, int newHeight) {
+        if (newWidth == width && newHeight == height) return complete;
+        width = newWidth;
+        height = newHeight;
+
+        GLState& gl = GLState::instance();
+        gl.bindTexture(glsl::sampler::sceneColor, GL_TEXTURE_2D, targets[COLOR]);
+        GLDebug::label(GL_TEXTURE, targets[COLOR], "scene color");
+        GL_CHECK(glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr));
+        // Bilinear: the upscale samples between texels
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+        gl.bindTexture(glsl::sampler::sceneColor, GL_TEXTURE_2D, targets[DEPTH]);
+        GLDebug::label(GL_TEXTURE, targets[DEPTH], "scene depth");
+        GL_CHECK(glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH24_STENCIL8, width, height, 0, GL_DEPTH_STENCIL,
+                              GL_UNSIGNED_INT_24_8, nullptr));
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        gl.bindTexture(glsl::sampler::sceneColor, GL_TEXTURE_2D, targets[COLOR]);
+
+        gl.bindFramebuffer(GL_FRAMEBUFFER, FBO);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, targets[COLOR], 0);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_TEXTURE_2D, targets[DEPTH], 0);
+
+        complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+        if (!complete)
+            std::cerr << "Scene framebuffer is incomplete" << std::endl;
+        gl.bindFramebuffer(GL_FRAMEBUFFER, 0);
+        return complete;
+    }
+
+    bool ready() const { return complete; }
+    GLuint framebuffer() const { return FBO; }
+    int renderWidth() const { return width; }
+    int renderHeight() const { return height; }
+
+    // Binds the target and its viewport; the scene is drawn next
+    void bind() const {
+        GLState& gl = GLState::instance();
+        gl.bindFramebuffer(GL_FRAMEBUFFER, FBO);
+        gl.viewport(0, 0, width, height);
+    }
+
+    // Replaces the colour with `rgba` (renderWidth x renderHeight, rows bottom-up),
+    // for frames rendered on the CPU
+    void upload(const uint32_t* rgba) const {
+        GLState::instance().bindTexture(glsl::sampler::sceneColor, GL_TEXTURE_2D, targets[COLOR]);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, rgba);
+    }
+
+    // Upscales into `output` (the window's framebuffer) and leaves it bound
+    void present(const Shader& shader, int windowWidth, int windowHeight, float sharpness, GLuint output = 0) const {
+        GLState& gl = GLState::instance();
+        gl.bindFramebuffer(GL_FRAMEBUFFER, output);
+        gl.viewport(0, 0, windowWidth, windowHeight);
+        gl.bindTexture(glsl::sampler::sceneColor, GL_TEXTURE_2D, targets[COLOR]);
+
+        shader.use();
+        shader.setVec2(glsl::uniform::outputSize, glm::vec2((float)windowWidth, (float)windowHeight));
+        shader.setFloat(glsl::uniform::sharpness, sharpness);
+
+        gl.setEnabled(GL_DEPTH_TEST, false);
+        gl.setEnabled(GL_BLEND, false);
+        gl.bindVertexArray(VAO);
+        gl.drawArrays(GL_TRIANGLES, 0, 3);
+        gl.setEnabled(GL_DEPTH_TEST, true);
+    }
+
+private:
+    enum Target { COLOR, DEPTH, TARGET_COUNT };
+
+    GLuint FBO = 0;
+    GLuint VAO = 0;
+    GLuint targets[TARGET_COUNT];
+    int width = 0, height = 0;
+    bool complete = false;
+};
+
+#endif // SCENE_TARGET_H
@@ -1,3 +1,10 @@
+#include <vector>
+#include <cstring>
+#include "GLState.h"
+#ifdef ENGINE_HEADLESS_EGL
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
 
 struct Window {
     SDL_Window* window;
@@ -6,22 +13,42 @@ struct Window {
     int height;
     const char* title;
 
+    // Headless: no window; an EGL context (surfaceless, or a 1x1 pbuffer where that
+    // isn't supported) draws into an offscreen framebuffer of width x height, which
+    // takes the place of the default framebuffer
+    bool headless;
+    // Which debug output messages are logged (debug builds, GL 4.3); set before init()
+    GLDebug::Filter debugFilter;
+    GLuint framebuffer = 0;
+    GLuint offscreenColor = 0, offscreenDepth = 0;
+#ifdef ENGINE_HEADLESS_EGL
+    EGLDisplay eglDisplay = EGL_NO_DISPLAY;
+    EGLContext eglContext = EGL_NO_CONTEXT;
+    EGLSurface eglSurface = EGL_NO_SURFACE;
+#endif
+
     // Constructor to initialize the window parameters
-    Window(int w, int h, const char* t) 
-        : width(w), height(h), title(t), window(nullptr), glContext(nullptr) {}
+    Window(int w, int h, const char* t, bool headless = false)
+        : window(nullptr), glContext(nullptr), width(w), height(h), title(t), headless(headless) {}
 
     // Initialize the window
     bool init() {
+        if (headless) return initHeadless();
+
         // Initialize SDL
         if (SDL_Init(SDL_INIT_VIDEO) < 0) {
             std::cerr << "Failed to initialize SDL! Error: " << SDL_GetError() << std::endl;
             return false;
         }
 
-        // Set OpenGL attributes
-        SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 3);
+        // Set OpenGL attributes; ask for 4.3 (indirect draws, SSBOs) first
+        SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 4);
         SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 3);
         SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE);
+        // Same depth format as the deferred G-buffer, so its depth can be blitted over
+        SDL_GL_SetAttribute(SDL_GL_DEPTH_SIZE, 24);
+        SDL_GL_SetAttribute(SDL_GL_STENCIL_SIZE, 8);
+        if (GLDebug::ENABLED) SDL_GL_SetAttribute(SDL_GL_CONTEXT_FLAGS, SDL_GL_CONTEXT_DEBUG_FLAG);
 
         // Create a window
         window = SDL_CreateWindow(title, SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED, width, height, SDL_WINDOW_OPENGL);
@@ -31,8 +58,13 @@ struct Window {
             return false;
         }
 
-        // Create an OpenGL context
+        // Create an OpenGL context, falling back to 3.3 where 4.3 isn't available
         glContext = SDL_GL_CreateContext(window);
+        if (!glContext) {
+            SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 3);
+            SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 3);
+            glContext = SDL_GL_CreateContext(window);
+        }
         if (!glContext) {
             std::cerr << "Failed to create OpenGL context! Error: " << SDL_GetError() << std::endl;
             SDL_DestroyWindow(window);
@@ -48,9 +80,10 @@ struct Window {
             SDL_Quit();
             return false;
         }
+        GLDebug::enable(debugFilter);
 
         // Enable depth testing
-        glEnable(GL_DEPTH_TEST);
+        GLState::instance().enable(GL_DEPTH_TEST);
 
         // Enable relative mouse mode for smooth camera control
         SDL_SetRelativeMouseMode(SDL_TRUE);
@@ -58,8 +91,154 @@ struct Window {
         return true;
     }
 
+    bool initHeadless() {
+        // Events and timers only: the loop still polls for SDL_QUIT (Ctrl+C) and times frames
+        if (SDL_Init(SDL_INIT_EVENTS | SDL_INIT_TIMER) < 0) {
+            std::cerr << "Failed to initialize SDL! Error: " << SDL_GetError() << std::endl;
+            return false;
+        }
+#ifdef ENGINE_HEADLESS_EGL
+        // Surfaceless platform (Mesa) first: no display server needed at all
+        const char* clientExtensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+        if (clientExtensions && std::strstr(clientExtensions, "EGL_MESA_platform_surfaceless")) {
+            PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay =
+                (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+            if (getPlatformDisplay)
+                eglDisplay = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+        }
+        if (eglDisplay == EGL_NO_DISPLAY) eglDisplay = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+        if (eglDisplay == EGL_NO_DISPLAY || !eglInitialize(eglDisplay, nullptr, nullptr)) {
+            std::cerr << "Failed to initialize EGL! Error: 0x" << std::hex << eglGetError() << std::dec << std::endl;
+            eglDisplay = EGL_NO_DISPLAY;
+            return false;
+        }
+
+        const char* extensions = eglQueryString(eglDisplay, EGL_EXTENSIONS);
+        bool surfaceless = extensions && std::strstr(extensions, "EGL_KHR_surfaceless_context");
+        const EGLint configAttributes[] = {
+            EGL_SURFACE_TYPE, surfaceless ? 0 : EGL_PBUFFER_BIT,
+            EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+            EGL_RED_SIZE, 8, EGL_GREEN_SIZE, 8, EGL_BLUE_SIZE, 8,
+            EGL_NONE};
+        EGLConfig config;
+        EGLint configCount = 0;
+        if (!eglChooseConfig(eglDisplay, configAttributes, &config, 1, &configCount) || configCount == 0 ||
+            !eglBindAPI(EGL_OPENGL_API)) {
+            std::cerr << "No EGL config for desktop OpenGL" << std::endl;
+            return false;
+        }
+
+        // Same versions as the windowed path: 4.3 core, else 3.3 core
+        const EGLint versions[][2] = {{4, 3}, {3, 3}};
+        for (const EGLint* version : versions) {
+            // Debug builds ask for a debug context first; EGL before 1.5 rejects the attribute
+            for (int debug = GLDebug::ENABLED ? 1 : 0; debug >= 0 && eglContext == EGL_NO_CONTEXT; --debug) {
+                const EGLint contextAttributes[] = {
+                    EGL_CONTEXT_MAJOR_VERSION, version[0], EGL_CONTEXT_MINOR_VERSION, version[1],
+                    EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+                    debug ? EGL_CONTEXT_OPENGL_DEBUG : EGL_NONE, EGL_TRUE, EGL_NONE};
+                eglContext = eglCreateContext(eglDisplay, config, EGL_NO_CONTEXT, contextAttributes);
+            }
+            if (eglContext != EGL_NO_CONTEXT) break;
+        }
+        if (eglContext == EGL_NO_CONTEXT) {
+            std::cerr << "Failed to create EGL context! Error: 0x" << std::hex << eglGetError() << std::dec
+                      << std::endl;
+            return false;
+        }
+        if (!surfaceless) {
+            const EGLint pbufferAttributes[] = {EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE};
+            eglSurface = eglCreatePbufferSurface(eglDisplay, config, pbufferAttributes);
+        }
+        if (!eglMakeCurrent(eglDisplay, eglSurface, eglSurface, eglContext)) {
+            std::cerr << "Failed to make the EGL context current! Error: 0x" << std::hex << eglGetError()
+                      << std::dec << std::endl;
+            return false;
+        }
+
+        if (!gladLoadGLLoader((GLADloadproc)eglGetProcAddress)) {
+            std::cerr << "Failed to initialize OpenGL loader!" << std::endl;
+            return false;
+        }
+        GLDebug::enable(debugFilter);
+
+        // Stands in for the window: same formats as the default framebuffer above
+        glGenFramebuffers(1, &framebuffer);
+        glGenRenderbuffers(1, &offscreenColor);
+        glGenRenderbuffers(1, &offscreenDepth);
+        glBindRenderbuffer(GL_RENDERBUFFER, offscreenColor);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+        glBindRenderbuffer(GL_RENDERBUFFER, offscreenDepth);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+        GLState& gl = GLState::instance();
+        gl.bindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, offscreenColor);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, offscreenDepth);
+        GLDebug::label(GL_FRAMEBUFFER, framebuffer, "headless window");
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+            std::cerr << "Headless framebuffer is incomplete" << std::endl;
+            return false;
+        }
+        gl.viewport(0, 0, width, height);
+        gl.enable(GL_DEPTH_TEST);
+        return true;
+#else
+        std::cerr << "Headless mode needs EGL; this build was made without it" << std::endl;
+        return false;
+#endif
+    }
+
+    // Makes the context current on the calling thread, or releases it
+    void makeCurrent(bool current) {
+#ifdef ENGINE_HEADLESS_EGL
+        if (headless) {
+            if (current) eglMakeCurrent(eglDisplay, eglSurface, eglSurface, eglContext);
+            else eglMakeCurrent(eglDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+            return;
+        }
+#endif
+        SDL_GL_MakeCurrent(window, current ? glContext : nullptr);
+    }
+
+    // Headless, a frame stays in `framebuffer` until the next one draws over it
+    void swap() {
+        // Catches errors from calls not wrapped in GL_CHECK, once a frame
+        GL_CHECKPOINT("frame");
+        if (!headless) SDL_GL_SwapWindow(window);
+    }
+
+    void setTitle(const char* text) {
+        if (window) SDL_SetWindowTitle(window, text);
+    }
+
+    // Colour of `framebuffer` as top-down RGB rows
+    void readPixels(std::vector<unsigned char>& rgb) const {
+        rgb.resize((size_t)width * height * 3);
+        std::vector<unsigned char> rows(rgb.size());
+        GLState::instance().bindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
+        glPixelStorei(GL_PACK_ALIGNMENT, 1);
+        glReadPixels(0, 0, width, height, GL_RGB, GL_UNSIGNED_BYTE, rows.data());
+        size_t stride = (size_t)width * 3;
+        for (int y = 0; y < height; ++y)
+            std::copy(&rows[(height - 1 - y) * stride], &rows[(height - y) * stride], &rgb[y * stride]);
+    }
+
     // Destructor to clean up SDL
     ~Window() {
+        if (framebuffer) {
+            GLState::instance().forgetFramebuffer(framebuffer);
+            glDeleteFramebuffers(1, &framebuffer);
+            glDeleteRenderbuffers(1, &offscreenColor);
+            glDeleteRenderbuffers(1, &offscreenDepth);
+        }
+#ifdef ENGINE_HEADLESS_EGL
+        if (eglDisplay != EGL_NO_DISPLAY) {
+            eglMakeCurrent(eglDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+            if (eglContext != EGL_NO_CONTEXT) eglDestroyContext(eglDisplay, eglContext);
+            if (eglSurface != EGL_NO_SURFACE) eglDestroySurface(eglDisplay, eglSurface);
+            eglTerminate(eglDisplay);
+        }
+#endif
         if (glContext) {
             SDL_GL_DeleteContext(glContext);
         }
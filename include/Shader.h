@@ -2,43 +2,126 @@
 #define SHADER_H
 
 #include <string>
+#include <vector>
 #include <iostream>
 #include <fstream>
 #include <sstream>
+#include <array>
+#include <unordered_set>
+#include <algorithm>
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/type_ptr.hpp>
+#include "GLState.h"
+#include "GLDebug.h"
+#include "ShaderPreprocessor.h"
+#include "ProgramBinaryCache.h"
+#include "ShaderReflection.h" // Generated by tools/ShaderReflect.cpp
 
 class Shader {
 public:
     unsigned int ID;
 
     // Constructor
-    Shader(const std::string& vertexPath, const std::string& fragmentPath) {
-        // Read shader source code from files
-        std::string vertexCode = readFile(vertexPath);
-        std::string fragmentCode = readFile(fragmentPath);
+    Shader(const std::string& vertexPath, const std::string& fragmentPath, ProgramBinaryCache* binaryCache = nullptr)
+        : ID(0), vertexPath(vertexPath), fragmentPath(fragmentPath), binaryCache(binaryCache) {
+        reload();
+    }
+
+    Shader(const Shader&) = delete;
+    Shader& operator=(const Shader&) = delete;
+
+    // Rebuild the program from disk. The previous program stays active if the new one fails.
+    bool reload() {
+        ShaderPreprocessor preprocessor;
+        PreprocessedSource vertex = preprocessor.process(vertexPath);
+        PreprocessedSource fragment = preprocessor.process(fragmentPath);
+        if (!vertex.ok || !fragment.ok) return false;
 
-        const char* vertexSource = vertexCode.c_str();
-        const char* fragmentSource = fragmentCode.c_str();
+        unsigned int program = glCreateProgram();
+        bool linked = false;
+
+        std::string cacheKey;
+        if (binaryCache && binaryCache->supported()) {
+            cacheKey = binaryCache->key(vertex.code, fragment.code);
+            linked = binaryCache->load(cacheKey, program);
+        }
 
-        unsigned int vertexShader = compileShader(vertexSource, GL_VERTEX_SHADER);
-        unsigned int fragmentShader = compileShader(fragmentSource, GL_FRAGMENT_SHADER);
+        if (!linked) {
+            unsigned int vertexShader = compileShader(vertex, GL_VERTEX_SHADER);
+            unsigned int fragmentShader = compileShader(fragment, GL_FRAGMENT_SHADER);
+
+            glAttachShader(program, vertexShader);
+            glAttachShader(program, fragmentShader);
+            if (!cacheKey.empty())
+                glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+            glLinkProgram(program);
+            linked = checkCompileErrors(program, "PROGRAM", {});
+
+            glDeleteShader(vertexShader);
+            glDeleteShader(fragmentShader);
+
+            if (linked && !cacheKey.empty())
+                binaryCache->store(cacheKey, program);
+        }
 
-        ID = glCreateProgram();
-        glAttachShader(ID, vertexShader);
-        glAttachShader(ID, fragmentShader);
-        glLinkProgram(ID);
-        checkCompileErrors(ID, "PROGRAM");
+        if (!linked) {
+            glDeleteProgram(program);
+            return false;
+        }
 
-        glDeleteShader(vertexShader);
-        glDeleteShader(fragmentShader);
+        if (ID) {
+            GLState::instance().forgetProgram(ID);
+            glDeleteProgram(ID);
+        }
+        ID = program;
+        if (GLDebug::ENABLED) GLDebug::label(GL_PROGRAM, ID, (vertexPath + " + " + fragmentPath).c_str());
+        missingUniforms.clear();
+        bindReflection();
+
+        // Every file either stage pulled in, for hot reload
+        dependencyFiles = vertex.files;
+        for (const std::string& file : fragment.files)
+            if (std::find(dependencyFiles.begin(), dependencyFiles.end(), file) == dependencyFiles.end())
+                dependencyFiles.push_back(file);
+        return true;
     }
 
+    const std::vector<std::string>& dependencies() const { return dependencyFiles; }
+
     // Activate the shader
-    void use() const { glUseProgram(ID); }
+    void use() const { GLState::instance().useProgram(ID); }
+
+    // Setters by generated uniform ID (glsl::uniform::*); no name lookup per call.
+    // Uniforms the program doesn't use have location -1, which GL ignores.
+    void setMat4(glsl::UniformId id, const float* value) const {
+        glUniformMatrix4fv(locations[id], 1, GL_FALSE, value);
+    }
+
+    void setMat3(glsl::UniformId id, const float* value) const {
+        glUniformMatrix3fv(locations[id], 1, GL_FALSE, value);
+    }
+
+    void setInt(glsl::UniformId id, int value) const {
+        glUniform1i(locations[id], value);
+    }
+
+    void setVec3(glsl::UniformId id, const glm::vec3& value) const {
+        glUniform3fv(locations[id], 1, glm::value_ptr(value));
+    }
+
+    void setVec2(glsl::UniformId id, const glm::vec2& value) const {
+        glUniform2f(locations[id], value.x, value.y);
+    }
+
+    void setFloat(glsl::UniformId id, float value) const {
+        glUniform1f(locations[id], value);
+    }
 
     void setMat4(const std::string& name, const float* value) const {
         GLint location = glGetUniformLocation(ID, name.c_str());
         if (location == -1) {
-            std::cerr << "Error: Uniform '" << name << "' not found in shader!" << std::endl;
+            reportMissing(name);
             return;
         }
         glUniformMatrix4fv(location, 1, GL_FALSE, value);
@@ -48,7 +131,7 @@ public:
     void setInt(const std::string& name, int value) const {
         GLint location = glGetUniformLocation(ID, name.c_str());
         if (location == -1) {
-            std::cerr << "Error: Uniform '" << name << "' not found in shader!" << std::endl;
+            reportMissing(name);
             return;
         }
         glUniform1i(location, value);
@@ -66,32 +149,76 @@ public:
     GLint getUniformLocation(const std::string& name) const {
         GLint location = glGetUniformLocation(ID, name.c_str());
         if (location == -1) {
-            std::cerr << "Error: Uniform '" << name << "' not found in shader!" << std::endl;
+            reportMissing(name);
         }
         return location;
     }
 
     ~Shader() {
+        GLState::instance().forgetProgram(ID);
         glDeleteProgram(ID);
     }
 
 private:
-    unsigned int compileShader(const char* source, GLenum type) {
+    std::string vertexPath;
+    std::string fragmentPath;
+    ProgramBinaryCache* binaryCache;
+    std::vector<std::string> dependencyFiles;
+    std::array<GLint, glsl::uniform::COUNT> locations{};
+    mutable std::unordered_set<std::string> missingUniforms;
+
+    // Once per name and link; these lookups run every frame
+    void reportMissing(const std::string& name) const {
+        if (missingUniforms.insert(name).second)
+            std::cerr << "Error: Uniform '" << name << "' not found in " << vertexPath << " + " << fragmentPath
+                      << std::endl;
+    }
+
+    // Resolve the generated uniform IDs once per link, and assign the fixed
+    // sampler units and uniform/storage block bindings
+    void bindReflection() {
+        for (glsl::UniformId id = 0; id < glsl::uniform::COUNT; ++id)
+            locations[id] = glGetUniformLocation(ID, glsl::uniformNames[id]);
+
+        GLState::instance().useProgram(ID);
+        for (const glsl::SamplerUnit& sampler : glsl::samplerUnits)
+            if (sampler.id < glsl::uniform::COUNT && locations[sampler.id] != -1)
+                glUniform1i(locations[sampler.id], sampler.unit);
+
+        for (const glsl::UniformBlockBinding& block : glsl::uniformBlocks) {
+            if (!block.name) continue;
+            GLuint index = glGetUniformBlockIndex(ID, block.name);
+            if (index != GL_INVALID_INDEX)
+                glUniformBlockBinding(ID, index, block.binding);
+        }
+
+        if (!GLAD_GL_VERSION_4_3) return;
+        for (const glsl::UniformBlockBinding& block : glsl::storageBlocks) {
+            if (!block.name) continue;
+            GLuint index = glGetProgramResourceIndex(ID, GL_SHADER_STORAGE_BLOCK, block.name);
+            if (index != GL_INVALID_INDEX)
+                glShaderStorageBlockBinding(ID, index, block.binding);
+        }
+    }
+
+    unsigned int compileShader(const PreprocessedSource& source, GLenum type) {
+        const char* code = source.code.c_str();
         unsigned int shader = glCreateShader(type);
-        glShaderSource(shader, 1, &source, NULL);
+        glShaderSource(shader, 1, &code, NULL);
         glCompileShader(shader);
-        checkCompileErrors(shader, (type == GL_VERTEX_SHADER ? "VERTEX" : "FRAGMENT"));
+        checkCompileErrors(shader, (type == GL_VERTEX_SHADER ? "VERTEX" : "FRAGMENT"), source.files);
         return shader;
     }
 
-    void checkCompileErrors(unsigned int shader, std::string type) {
+    bool checkCompileErrors(unsigned int shader, std::string type, const std::vector<std::string>& files) {
         int success;
         char infoLog[1024];
         if (type != "PROGRAM") {
             glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
             if (!success) {
                 glGetShaderInfoLog(shader, 1024, NULL, infoLog);
-                std::cerr << "ERROR::SHADER_COMPILATION_ERROR of type: " << type << "\n" << infoLog << "\n";
+                std::cerr << "ERROR::SHADER_COMPILATION_ERROR of type: " << type << "\n"
+                          << ShaderPreprocessor::remapLog(infoLog, files) << "\n";
             }
         } else {
             glGetProgramiv(shader, GL_LINK_STATUS, &success);
@@ -100,18 +227,7 @@ private:
                 std::cerr << "ERROR::PROGRAM_LINKING_ERROR of type: " << type << "\n" << infoLog << "\n";
             }
         }
-    }
-
-    std::string readFile(const std::string& filePath) {
-        std::ifstream file(filePath);
-        if (!file.is_open()) {
-            std::cerr << "ERROR: Failed to open file: " << filePath << std::endl;
-            return "";
-        }
-
-        std::stringstream buffer;
-        buffer << file.rdbuf();
-        return buffer.str();
+        return success;
     }
 
 };
@@ -0,0 +1,98 @@
+#ifndef SHADER_LIBRARY_H
+#define SHADER_LIBRARY_H
+
+#include <map>
+#include <set>
+#include <memory>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <iostream>
+#include <filesystem>
+#include "Shader.h"
+#include "ProgramBinaryCache.h"
+
+// Owns the engine's shader programs and hot-reloads them.
+// Keeps a file -> programs dependency graph built from the includes each program
+// pulled in, so touching a shared header rebuilds exactly the programs using it.
+class ShaderLibrary {
+public:
+    explicit ShaderLibrary(const std::string& binaryCacheDir = "shader_cache")
+        : binaryCache(binaryCacheDir) {}
+
+    Shader& load(const std::string& vertexPath, const std::string& fragmentPath) {
+        shaders.push_back(std::make_unique<Shader>(vertexPath, fragmentPath, &binaryCache));
+        Shader* shader = shaders.back().get();
+        // Track the entry points even if preprocessing failed, so fixing them reloads
+        track(shader, {ShaderPreprocessor::normalize(vertexPath), ShaderPreprocessor::normalize(fragmentPath)});
+        track(shader, shader->dependencies());
+        return *shader;
+    }
+
+    // Poll the tracked files; rebuilds the programs depending on changed ones.
+    // Returns the number of programs rebuilt.
+    int update() {
+        auto now = std::chrono::steady_clock::now();
+        if (now - lastPoll < pollInterval) return 0;
+        lastPoll = now;
+
+        std::set<Shader*> dirty;
+        for (auto& [file, stamp] : timestamps) {
+            std::filesystem::file_time_type current = modificationTime(file);
+            if (current == stamp) continue;
+            stamp = current;
+            for (Shader* shader : dependents[file])
+                dirty.insert(shader);
+        }
+
+        int rebuilt = 0;
+        for (Shader* shader : dirty) {
+            if (!shader->reload()) continue;
+            ++rebuilt;
+            // A reload may have added or removed includes
+            untrack(shader);
+            track(shader, shader->dependencies());
+        }
+        if (rebuilt > 0)
+            std::cout << "Reloaded " << rebuilt << " shader program(s)" << std::endl;
+        return rebuilt;
+    }
+
+    // Programs that would be rebuilt if `file` changed
+    std::vector<Shader*> dependentsOf(const std::string& file) const {
+        auto it = dependents.find(ShaderPreprocessor::normalize(file));
+        if (it == dependents.end()) return {};
+        return std::vector<Shader*>(it->second.begin(), it->second.end());
+    }
+
+    void setPollInterval(std::chrono::milliseconds interval) { pollInterval = interval; }
+
+private:
+    ProgramBinaryCache binaryCache;
+    std::vector<std::unique_ptr<Shader>> shaders;
+    std::map<std::string, std::set<Shader*>> dependents;
+    std::map<std::string, std::filesystem::file_time_type> timestamps;
+    std::chrono::steady_clock::time_point lastPoll;
+    std::chrono::milliseconds pollInterval{250};
+
+    void track(Shader* shader, const std::vector<std::string>& files) {
+        for (const std::string& file : files) {
+            dependents[file].insert(shader);
+            if (!timestamps.count(file))
+                timestamps[file] = modificationTime(file);
+        }
+    }
+
+    void untrack(Shader* shader) {
+        for (auto& [file, users] : dependents)
+            users.erase(shader);
+    }
+
+    static std::filesystem::file_time_type modificationTime(const std::string& file) {
+        std::error_code error;
+        std::filesystem::file_time_type time = std::filesystem::last_write_time(file, error);
+        return error ? std::filesystem::file_time_type::min() : time;
+    }
+};
+
+#endif // SHADER_LIBRARY_H
@@ -0,0 +1,189 @@
+#ifndef SHADER_PREPROCESSOR_H
+#define SHADER_PREPROCESSOR_H
+
+#include <string>
+#include <vector>
+#include <set>
+#include <regex>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <filesystem>
+
+// Result of expanding a GLSL file and everything it includes
+struct PreprocessedSource {
+    std::string code;                // Expanded source, ready for glShaderSource
+    std::vector<std::string> files;  // Every file pulled in; index = GLSL source-string number
+    bool ok = false;
+};
+
+// Expands `#include "file"` directives in GLSL sources.
+// - Includes resolve relative to the including file, then against the include dirs.
+// - `#pragma once` files and classic #ifndef guards are both honoured.
+// - `#line` directives keep compiler messages pointing at the original file and
+//   line; remapLog() turns the source-string numbers back into file names.
+class ShaderPreprocessor {
+public:
+    explicit ShaderPreprocessor(std::vector<std::string> includeDirs = {})
+        : includeDirs(std::move(includeDirs)) {}
+
+    PreprocessedSource process(const std::string& path) const {
+        PreprocessedSource result;
+        std::set<std::string> onceFiles;
+        std::vector<std::string> stack;
+        result.ok = expand(normalize(path), result, onceFiles, stack);
+        return result;
+    }
+
+    // Replaces the source-string number in driver messages ("0:12(5): error", "0(12) : error")
+    // with the file it refers to
+    static std::string remapLog(const std::string& log, const std::vector<std::string>& files) {
+        static const std::regex location(R"(^(ERROR: |WARNING: )?(\d+)([:(]\d+))");
+        std::stringstream in(log);
+        std::string line, out;
+        while (std::getline(in, line)) {
+            std::smatch match;
+            if (std::regex_search(line, match, location)) {
+                size_t index = std::stoul(match[2].str());
+                if (index < files.size())
+                    line = match[1].str() + files[index] + match[3].str() + match.suffix().str();
+            }
+            out += line + "\n";
+        }
+        return out;
+    }
+
+    static std::string normalize(const std::string& path) {
+        return std::filesystem::path(path).lexically_normal().generic_string();
+    }
+
+private:
+    std::vector<std::string> includeDirs;
+
+    bool expand(const std::string& path, PreprocessedSource& result,
+                std::set<std::string>& onceFiles, std::vector<std::string>& stack) const {
+        for (const std::string& open : stack) {
+            if (open == path) {
+                std::cerr << "ERROR: Circular shader include: " << path << std::endl;
+                return false;
+            }
+        }
+
+        std::ifstream file(path);
+        if (!file.is_open()) {
+            std::cerr << "ERROR: Failed to open file: " << path << std::endl;
+            return false;
+        }
+
+        int fileIndex = indexOf(path, result.files);
+        bool topLevel = stack.empty();
+        stack.push_back(path);
+        if (!topLevel)
+            result.code += lineDirective(1, fileIndex);
+
+        std::string line;
+        int lineNumber = 0;
+        bool versionSeen = false;
+        while (std::getline(file, line)) {
+            ++lineNumber;
+            std::string directive = trimLeft(line);
+
+            if (startsWith(directive, "#version")) {
+                if (topLevel && !versionSeen) {
+                    // #version must stay first; everything after it gets remapped
+                    result.code += line + "\n";
+                    result.code += lineDirective(lineNumber + 1, fileIndex);
+                    versionSeen = true;
+                } else {
+                    std::cerr << "WARNING: Ignoring #version in included file " << path << std::endl;
+                    result.code += "\n";
+                }
+                continue;
+            }
+
+            if (startsWith(directive, "#pragma") && directive.find("once") != std::string::npos) {
+                onceFiles.insert(path);
+                result.code += "\n";
+                continue;
+            }
+
+            if (startsWith(directive, "#include")) {
+                std::string target;
+                if (!includeTarget(directive, target)) {
+                    std::cerr << "ERROR: Malformed include in " << path << ":" << lineNumber << std::endl;
+                    stack.pop_back();
+                    return false;
+                }
+
+                std::string resolved = resolve(path, target);
+                if (resolved.empty()) {
+                    std::cerr << "ERROR: Cannot resolve include \"" << target << "\" in "
+                              << path << ":" << lineNumber << std::endl;
+                    stack.pop_back();
+                    return false;
+                }
+
+                if (!onceFiles.count(resolved)) {
+                    if (!expand(resolved, result, onceFiles, stack)) {
+                        stack.pop_back();
+                        return false;
+                    }
+                } else {
+                    // Still a dependency even if its body is skipped
+                    indexOf(resolved, result.files);
+                }
+                result.code += lineDirective(lineNumber + 1, fileIndex);
+                continue;
+            }
+
+            result.code += line + "\n";
+        }
+
+        stack.pop_back();
+        return true;
+    }
+
+    std::string resolve(const std::string& includer, const std::string& target) const {
+        namespace fs = std::filesystem;
+        fs::path local = fs::path(includer).parent_path() / target;
+        if (fs::exists(local)) return normalize(local.string());
+
+        for (const std::string& dir : includeDirs) {
+            fs::path candidate = fs::path(dir) / target;
+            if (fs::exists(candidate)) return normalize(candidate.string());
+        }
+        return "";
+    }
+
+    static bool includeTarget(const std::string& directive, std::string& target) {
+        size_t open = directive.find_first_of("\"<", 8);
+        if (open == std::string::npos) return false;
+        char closing = directive[open] == '"' ? '"' : '>';
+        size_t close = directive.find(closing, open + 1);
+        if (close == std::string::npos) return false;
+        target = directive.substr(open + 1, close - open - 1);
+        return !target.empty();
+    }
+
+    static int indexOf(const std::string& path, std::vector<std::string>& files) {
+        for (size_t i = 0; i < files.size(); ++i)
+            if (files[i] == path) return (int)i;
+        files.push_back(path);
+        return (int)files.size() - 1;
+    }
+
+    static std::string lineDirective(int line, int fileIndex) {
+        return "#line " + std::to_string(line) + " " + std::to_string(fileIndex) + "\n";
+    }
+
+    static std::string trimLeft(const std::string& s) {
+        size_t start = s.find_first_not_of(" \t");
+        return start == std::string::npos ? "" : s.substr(start);
+    }
+
+    static bool startsWith(const std::string& s, const char* prefix) {
+        return s.rfind(prefix, 0) == 0;
+    }
+};
+
+#endif // SHADER_PREPROCESSOR_H
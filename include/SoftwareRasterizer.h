@@ -0,0 +1,209 @@
+#ifndef SOFTWARE_RASTERIZER_H
+#define SOFTWARE_RASTERIZER_H
+
+#include <deque>
+#include <vector>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include "Bounds.h"
+#include "JobPool.h"
+#include "LightClusterer.h"
+
+// RGBA8 texture and its mip chain for the software rasterizer, wrapped like
+// GL_REPEAT. Rows are in GL order: row 0 is v = 0.
+class SoftwareTexture {
+public:
+    enum Filter {
+        BILINEAR,    // GL_LINEAR: level 0 only, as loadTexture() sets up
+        TRILINEAR    // GL_LINEAR_MIPMAP_LINEAR
+    };
+
+    SoftwareTexture() = default;
+
+    // Copies `rgba` (width * height texels) and box-filters the mip chain down to 1x1
+    SoftwareTexture(int width, int height, const unsigned char* rgba);
+
+    bool empty() const { return levels.empty(); }
+    int width() const { return levels.empty() ? 0 : levels[0].width; }
+    int height() const { return levels.empty() ? 0 : levels[0].height; }
+    int levelCount() const { return (int)levels.size(); }
+
+    // Bilinear sample of one level, components in [0, 1]
+    glm::vec4 sampleLevel(const glm::vec2& uv, int level) const;
+
+    // With TRILINEAR, the level of detail comes from the screen-space derivatives
+    // of uv, as GL computes it; BILINEAR ignores them
+    glm::vec4 sample(const glm::vec2& uv, const glm::vec2& dUVdx, const glm::vec2& dUVdy, Filter filter) const;
+
+private:
+    struct Level {
+        int width, height;
+        std::vector<uint32_t> texels;   // RGBA8, R in the low byte
+    };
+    std::vector<Level> levels;
+};
+
+// CPU rendering backend for the lit scene: what vertexShader.glsl +
+// fragmentShader.glsl do on the GPU, without a GL context. For machines without
+// a GPU, and as a deterministic reference image.
+//
+// draw() takes the same inputs as a Draw(shader) call of a scene primitive: the
+// interleaved 14-float vertices of FG.h, the model matrix and the diffuse and
+// normal maps. finish() runs the frame on the job pool:
+//   1. vertices   per draw: clip position, world position, uv and TBN
+//   2. setup      per draw: near/far clipping, edge functions, binning into
+//                 TILE_SIZE x TILE_SIZE tiles (per-worker bins)
+//   3. tiles      one job per tile. The tile's triangles are rasterized in
+//                 submission order into a visibility buffer (depth + triangle),
+//                 4 (SSE) or 8 (AVX) pixels per edge-function evaluation. Then every
+//                 covered pixel is shaded once with perspective-correct attributes.
+// Each tile is owned by one job and its triangles keep submission order, so the
+// image is the same for any thread count.
+//
+// Conventions follow GL: counter-clockwise NDC, window depth in [0, 1] with
+// GL_LESS, pixel centres at +0.5, rows bottom-up and no face culling. Shared edges
+// are evaluated identically from both sides, and a tie-breaking (top-left style)
+// rule gives every pixel on them to exactly one triangle. Only opaque geometry is
+// supported; blending and the grid are left to GL.
+class SoftwareRasterizer {
+public:
+    static const int TILE_SIZE = 32;
+    static const int VERTEX_FLOATS = 14;   // position, normal, uv, tangent, bitangent
+
+    // Geometry in the FG.h layout
+    struct Mesh {
+        std::vector<float> vertices;
+        std::vector<uint32_t> indices;
+        BoundingSphere bounds;   // Object space; lights outside it are skipped per draw
+
+        static Mesh fromVertices(const std::vector<float>& vertices, const std::vector<uint32_t>& indices) {
+            Mesh mesh;
+            mesh.vertices = vertices;
+            mesh.indices = indices;
+            AABB box;
+            computeBounds(vertices.data(), vertices.size() / VERTEX_FLOATS, VERTEX_FLOATS, box, mesh.bounds);
+            return mesh;
+        }
+    };
+
+    struct Material {
+        const SoftwareTexture* diffuse = nullptr;
+        const SoftwareTexture* normalMap = nullptr;   // None: the interpolated vertex normal
+        SoftwareTexture::Filter filter = SoftwareTexture::BILINEAR;
+        float specularStrength = 1.0f;
+    };
+
+    struct Stats {
+        unsigned int draws = 0;
+        unsigned int triangles = 0;       // Submitted
+        unsigned int rasterized = 0;      // After clipping and zero-area rejection
+        unsigned int binned = 0;          // Triangle/tile pairs
+        unsigned int fragments = 0;       // Pixels that passed the depth test
+        unsigned int shaded = 0;          // Pixels shaded (visible at the end)
+        float setupMs = 0.0f;             // Vertices, clipping, binning
+        float rasterMs = 0.0f;            // Tiles: visibility and shading
+    };
+
+    SoftwareRasterizer(int width, int height);
+
+    void resize(int width, int height);
+    int width() const { return frameWidth; }
+    int height() const { return frameHeight; }
+
+    // Starts a frame; `lights` is read by finish(), so it must stay alive until then
+    void begin(const glm::mat4& view, const glm::mat4& projection, const glm::vec3& eye,
+               const std::vector<PointLight>& lights, const glm::vec4& clearColor = glm::vec4(0.0f));
+
+    // `mesh` and the material's textures must stay alive until finish() returns
+    void draw(const Mesh& mesh, const glm::mat4& model, const Material& material);
+
+    void finish(JobPool& pool = JobPool::shared());
+
+    // RGBA8 (R in the low byte) and window depth, rows bottom-up like glReadPixels
+    const std::vector<uint32_t>& color() const { return colorBuffer; }
+    const std::vector<float>& depth() const { return depthBuffer; }
+
+    // Top-down RGB rows, as writePPM() takes them
+    void readRGB(std::vector<unsigned char>& rgb) const;
+
+    const Stats& stats() const { return lastStats; }
+
+private:
+    // Output of the vertex stage
+    struct Vertex {
+        glm::vec4 clip;
+        glm::vec3 world;
+        glm::vec2 uv;
+        glm::vec3 tangent, bitangent, normal;
+    };
+
+    struct Draw {
+        const Mesh* mesh;
+        glm::mat4 model;
+        Material material;
+        size_t firstVertex;          // In `vertices`
+        unsigned lightWorker;        // Light list in lightLists[lightWorker]
+        size_t firstLight, lightCount;
+    };
+
+    // Screen-space setup. Planes are f(x, y) = p.x * x + p.y * y + p.z.
+    struct Triangle {
+        glm::vec3 edge[3];           // > 0 inside; edge i runs from vertex i to i + 1
+        bool owns[3];                // Pixels exactly on edge i belong to this triangle
+        glm::vec3 depth;             // Window depth
+        glm::vec3 perspective[3];    // Barycentric of vertex i over w, linear on screen
+        const Vertex* v[3];
+        uint32_t draw;
+        int x0, y0, x1, y1;          // Inclusive pixel bounds
+    };
+
+    struct BinEntry {
+        uint32_t order;              // Submission order: draw-local triangles follow each other
+        uint32_t triangle;           // In workerTriangles[worker]
+        uint32_t worker;
+    };
+
+    struct WorkerCounters {
+        unsigned rasterized = 0, binned = 0, fragments = 0, shaded = 0;
+    };
+
+    int frameWidth = 0, frameHeight = 0;
+    int tilesX = 0, tilesY = 0;
+
+    glm::mat4 viewProjection = glm::mat4(1.0f);
+    glm::vec3 eyePosition = glm::vec3(0.0f);
+    const std::vector<PointLight>* frameLights = nullptr;
+    glm::vec4 clear = glm::vec4(0.0f);
+
+    std::vector<Draw> draws;
+    std::vector<size_t> firstTriangle;                   // Per draw, for the submission order
+    size_t totalVertices = 0, totalTriangles = 0;
+    std::vector<Vertex> vertices;
+    std::vector<std::vector<uint32_t>> lightLists;       // Per worker
+    std::vector<std::vector<Triangle>> workerTriangles;  // Per worker
+    std::vector<std::deque<Vertex>> clipVertices;        // Per worker; deque so pointers stay valid
+    std::vector<std::vector<BinEntry>> bins;             // [worker * tiles + tile]
+    std::vector<std::vector<BinEntry>> tileEntries;      // Per worker scratch for merging bins
+    std::vector<WorkerCounters> counters;
+
+    std::vector<uint32_t> colorBuffer;
+    std::vector<float> depthBuffer;
+
+    // Visibility buffer, padded to whole tiles (stride tilesX * TILE_SIZE) so SIMD
+    // rows never leave it
+    std::vector<float> tileDepth;
+    std::vector<const Triangle*> visibility;             // Nearest triangle per pixel
+
+    Stats lastStats;
+
+    void prepareWorkers(unsigned workers);
+    void transformDraw(size_t drawIndex, unsigned worker);
+    void setupDraw(size_t drawIndex, unsigned worker);
+    void setupTriangle(const Vertex* a, const Vertex* b, const Vertex* c, uint32_t draw, uint32_t order,
+                       unsigned worker);
+    void rasterizeTile(int tile, unsigned worker);
+    void rasterizeTriangle(const Triangle& tri, int x0, int y0, int x1, int y1, unsigned worker);
+    uint32_t shadePixel(const Triangle& tri, float x, float y) const;
+};
+
+#endif // SOFTWARE_RASTERIZER_H
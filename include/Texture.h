@@ -3,14 +3,19 @@
 
 
 #include <SDL2/SDL.h>
+#include <vector>
+#include <algorithm>
+#include <iostream>
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
+#include "GLState.h"
 
 
 unsigned int loadTexture(const char* path) {
     unsigned int textureID;
     glGenTextures(1, &textureID);
-    glBindTexture(GL_TEXTURE_2D, textureID);
+    GLState::instance().bindTexture(0, GL_TEXTURE_2D, textureID);
+    GLDebug::label(GL_TEXTURE, textureID, path);
     
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
@@ -22,7 +27,7 @@ unsigned int loadTexture(const char* path) {
     unsigned char* data = stbi_load(path, &width, &height, &nrChannels, 0);
     if (data) {
         GLenum format = (nrChannels == 4) ? GL_RGBA : GL_RGB;
-        glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
+        GL_CHECK(glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data));
         glGenerateMipmap(GL_TEXTURE_2D);
     } else {
         std::cout << "Failed to load texture: " << path << std::endl;
@@ -32,6 +37,65 @@ unsigned int loadTexture(const char* path) {
     return textureID;
 }
 
+// Decodes an image to RGBA8 on the CPU, rows flipped like loadTexture() (row 0 is v = 0)
+bool loadImage(const char* path, int& width, int& height, std::vector<unsigned char>& rgba) {
+    int nrChannels;
+    stbi_set_flip_vertically_on_load(true);
+    unsigned char* data = stbi_load(path, &width, &height, &nrChannels, 4);
+    if (!data) {
+        std::cout << "Failed to load image: " << path << std::endl;
+        return false;
+    }
+    rgba.assign(data, data + (size_t)width * height * 4);
+    stbi_image_free(data);
+    return true;
+}
+
+// Loads same-sized images into the layers of a GL_TEXTURE_2D_ARRAY (layer i = paths[i]).
+// Images are expanded to RGBA so RGB and RGBA files can share an array.
+unsigned int loadTextureArray(const std::vector<const char*>& paths) {
+    if (paths.empty()) return 0;
+
+    int width = 0, height = 0;
+    std::vector<unsigned char> texels;
+    stbi_set_flip_vertically_on_load(true);
+    for (size_t layer = 0; layer < paths.size(); ++layer) {
+        int w, h, nrChannels;
+        unsigned char* data = stbi_load(paths[layer], &w, &h, &nrChannels, 4);
+        if (!data) {
+            std::cout << "Failed to load texture: " << paths[layer] << std::endl;
+            return 0;
+        }
+        if (layer == 0) {
+            width = w;
+            height = h;
+            texels.resize((size_t)width * height * 4 * paths.size());
+        } else if (w != width || h != height) {
+            std::cout << "Texture array layer " << paths[layer] << " is " << w << "x" << h
+                      << ", expected " << width << "x" << height << std::endl;
+            stbi_image_free(data);
+            return 0;
+        }
+        std::copy(data, data + (size_t)width * height * 4, texels.begin() + layer * (size_t)width * height * 4);
+        stbi_image_free(data);
+    }
+
+    unsigned int textureID;
+    glGenTextures(1, &textureID);
+    GLState::instance().bindTexture(0, GL_TEXTURE_2D_ARRAY, textureID);
+    GLDebug::label(GL_TEXTURE, textureID, paths[0]);
+
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+    GL_CHECK(glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA8, width, height, (GLsizei)paths.size(), 0,
+                          GL_RGBA, GL_UNSIGNED_BYTE, texels.data()));
+    glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+    return textureID;
+}
+
 
 
 #endif
\ No newline at end of file
@@ -0,0 +1,41 @@
+#ifndef UNIFORM_BUFFER_H
+#define UNIFORM_BUFFER_H
+
+#include <glad/glad.h>
+#include "GLState.h"
+
+// Uniform buffer holding one std140 block (e.g. glsl::CameraBlock), attached to a
+// fixed binding point from glsl::binding
+template <typename T>
+class UniformBuffer {
+public:
+    explicit UniformBuffer(GLuint binding) : binding(binding) {
+        glGenBuffers(1, &UBO);
+        GLState& gl = GLState::instance();
+        gl.bindBuffer(GL_UNIFORM_BUFFER, UBO);
+        GL_CHECK(glBufferData(GL_UNIFORM_BUFFER, sizeof(T), nullptr, GL_DYNAMIC_DRAW));
+        GLDebug::label(GL_BUFFER, UBO, "uniform block");
+        gl.bindBufferBase(GL_UNIFORM_BUFFER, binding, UBO);
+    }
+
+    UniformBuffer(const UniformBuffer&) = delete;
+    UniformBuffer& operator=(const UniformBuffer&) = delete;
+
+    ~UniformBuffer() {
+        GLState::instance().forgetBuffer(UBO);
+        glDeleteBuffers(1, &UBO);
+    }
+
+    void update(const T& data) {
+        GLState::instance().bindBuffer(GL_UNIFORM_BUFFER, UBO);
+        glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(T), &data);
+    }
+
+    GLuint id() const { return UBO; }
+
+private:
+    GLuint UBO;
+    GLuint binding;
+};
+
+#endif // UNIFORM_BUFFER_H
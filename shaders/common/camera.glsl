@@ -0,0 +1,11 @@
+#ifndef CAMERA_GLSL
+#define CAMERA_GLSL
+
+// Shared by every program; filled once per frame from glsl::CameraBlock
+layout(std140) uniform Camera {
+    mat4 view;
+    mat4 projection;
+    vec3 viewPos;
+};
+
+#endif
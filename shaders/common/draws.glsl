@@ -0,0 +1,16 @@
+#ifndef DRAWS_GLSL
+#define DRAWS_GLSL
+
+// Per-draw data of the multi-draw indirect path, same layout as InstanceData in
+// Instancing.h. Indexed by the per-instance draw ID at location 13.
+struct DrawData {
+    mat4 model;
+    vec4 normalMatrix[3];
+    float materialLayer;
+};
+
+layout(std430) readonly buffer DrawBlock {
+    DrawData draws[];
+};
+
+#endif
@@ -0,0 +1,25 @@
+#ifndef GBUFFER_GLSL
+#define GBUFFER_GLSL
+
+// G-buffer layout, must match DeferredShading.h:
+//   0      RGBA8   albedo, specular strength
+//   1      RG16F   world normal, octahedral-encoded
+//   depth  D24S8   world position is rebuilt from it
+
+vec2 signNotZero(vec2 v) {
+    return vec2(v.x >= 0.0 ? 1.0 : -1.0, v.y >= 0.0 ? 1.0 : -1.0);
+}
+
+// Unit vector -> [-1, 1]^2: project onto the octahedron, fold the lower half over
+vec2 encodeNormal(vec3 n) {
+    n /= abs(n.x) + abs(n.y) + abs(n.z);
+    return n.z >= 0.0 ? n.xy : (1.0 - abs(n.yx)) * signNotZero(n.xy);
+}
+
+vec3 decodeNormal(vec2 e) {
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    if (n.z < 0.0) n.xy = (1.0 - abs(n.yx)) * signNotZero(n.xy);
+    return normalize(n);
+}
+
+#endif
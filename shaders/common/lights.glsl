@@ -0,0 +1,53 @@
+#ifndef LIGHTS_GLSL
+#define LIGHTS_GLSL
+
+#include "camera.glsl"
+
+// Clustered point lights, filled every frame by ClusteredLighting.
+// Grid size must match LightClusterer::CLUSTERS_X/Y/Z.
+#define CLUSTERS_X 16
+#define CLUSTERS_Y 9
+#define CLUSTERS_Z 24
+
+uniform samplerBuffer lightData;        // Per light: (position, radius), (color, intensity)
+uniform usamplerBuffer clusterGrid;     // Per cluster: (offset into clusterIndices, count)
+uniform usamplerBuffer clusterIndices;  // Light indices grouped by cluster
+uniform vec2 clusterTileSize;           // Pixels per cluster tile
+uniform vec2 clusterDepthParams;        // slice = log(view depth) * x + y
+
+struct Light {
+    vec3 position;
+    float radius;
+    vec3 color;
+};
+
+// Offset and light count of the cluster containing this fragment
+uvec2 clusterLights(vec3 fragPos) {
+    float depth = -(view * vec4(fragPos, 1.0)).z;
+    int slice = int(log(max(depth, 1e-4)) * clusterDepthParams.x + clusterDepthParams.y);
+    ivec3 cell = ivec3(ivec2(gl_FragCoord.xy / clusterTileSize), slice);
+    cell = clamp(cell, ivec3(0), ivec3(CLUSTERS_X - 1, CLUSTERS_Y - 1, CLUSTERS_Z - 1));
+    int cluster = (cell.z * CLUSTERS_Y + cell.y) * CLUSTERS_X + cell.x;
+    return texelFetch(clusterGrid, cluster).rg;
+}
+
+// Index of the light in the full list (ClusteredLighting::lights)
+int lightIndex(uint listIndex) {
+    return int(texelFetch(clusterIndices, int(listIndex)).r);
+}
+
+Light fetchLight(uint listIndex) {
+    int light = lightIndex(listIndex);
+    vec4 positionRadius = texelFetch(lightData, light * 2);
+    vec4 colorIntensity = texelFetch(lightData, light * 2 + 1);
+    return Light(positionRadius.xyz, positionRadius.w, colorIntensity.rgb * colorIntensity.a);
+}
+
+// Smooth window reaching 0 at the light's radius
+float lightFalloff(float distance, float radius) {
+    float ratio = distance / radius;
+    float window = clamp(1.0 - ratio * ratio * ratio * ratio, 0.0, 1.0);
+    return window * window;
+}
+
+#endif
@@ -0,0 +1,50 @@
+#ifndef SHADING_GLSL
+#define SHADING_GLSL
+
+#include "camera.glsl"
+#include "lights.glsl"
+
+// Phong lighting from the lights of this fragment's cluster, shared by the lit programs
+// and the deferred lighting pass. Lights below `firstLight` are skipped (they are
+// baked into a lightmap); `occlusion` scales the ambient term.
+vec3 shadeLights(vec3 albedo, vec3 norm, vec3 fragPos, float specularStrength, int firstLight, float occlusion) {
+    vec3 viewDir = normalize(viewPos - fragPos);
+    vec3 result = vec3(0.0);
+
+    uvec2 cluster = clusterLights(fragPos);
+    for (uint i = 0u; i < cluster.y; i++) {
+        if (lightIndex(cluster.x + i) < firstLight) continue;
+        Light light = fetchLight(cluster.x + i);
+        vec3 toLight = light.position - fragPos;
+        float distance = length(toLight);
+        vec3 lightColor = light.color * lightFalloff(distance, light.radius);
+
+        // Ambient
+        float ambientStrength = 0.1 * occlusion;
+        vec3 ambient = ambientStrength * lightColor;
+
+        // Diffuse
+        vec3 lightDir = toLight / max(distance, 1e-4);
+        float diff = max(dot(norm, lightDir), 0.0);
+        vec3 diffuse = diff * lightColor;
+
+        // Specular
+        vec3 reflectDir = reflect(-lightDir, norm);
+        float spec = pow(max(dot(viewDir, reflectDir), 0.0), 32);
+        vec3 specular = specularStrength * spec * lightColor;
+
+        // Combine lighting with texture color
+        result += (ambient + diffuse + specular) * albedo;
+    }
+    return result;
+}
+
+vec3 shade(vec3 albedo, vec3 norm, vec3 fragPos, float specularStrength) {
+    return shadeLights(albedo, norm, fragPos, specularStrength, 0, 1.0);
+}
+
+vec3 shade(vec3 albedo, vec3 norm, vec3 fragPos) {
+    return shade(albedo, norm, fragPos, 1.0);
+}
+
+#endif
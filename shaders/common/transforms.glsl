@@ -0,0 +1,9 @@
+#ifndef TRANSFORMS_GLSL
+#define TRANSFORMS_GLSL
+
+#include "camera.glsl"
+
+uniform mat4 model;
+uniform mat3 normalMatrix;  // From normalMatrix() in NormalMatrix.h, up to scale: renormalize
+
+#endif
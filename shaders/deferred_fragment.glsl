@@ -0,0 +1,30 @@
+#version 330 core
+out vec4 FragColor;
+
+uniform sampler2D gAlbedoSpecular;
+uniform sampler2D gNormal;
+uniform sampler2D gDepth;
+
+#include "common/gbuffer.glsl"
+#include "common/shading.glsl"
+
+// World position from the depth buffer (symmetric perspective projection)
+vec3 worldPosition(vec2 uv, float depth) {
+    vec3 ndc = vec3(uv, depth) * 2.0 - 1.0;
+    float viewZ = -projection[3][2] / (ndc.z + projection[2][2]);
+    vec3 viewPosition = vec3(ndc.xy * -viewZ / vec2(projection[0][0], projection[1][1]), viewZ);
+    return transpose(mat3(view)) * (viewPosition - view[3].xyz);
+}
+
+// Full-screen lighting pass: each pixel loops over its cluster's lights only
+void main() {
+    ivec2 pixel = ivec2(gl_FragCoord.xy);
+    float depth = texelFetch(gDepth, pixel, 0).r;
+    if (depth == 1.0) discard;  // Nothing drawn here; keep the clear color
+
+    vec4 albedoSpecular = texelFetch(gAlbedoSpecular, pixel, 0);
+    vec3 norm = decodeNormal(texelFetch(gNormal, pixel, 0).rg);
+    vec3 fragPos = worldPosition(gl_FragCoord.xy / vec2(textureSize(gDepth, 0)), depth);
+
+    FragColor = vec4(shade(albedoSpecular.rgb, norm, fragPos, albedoSpecular.a), 1.0);
+}
@@ -0,0 +1,14 @@
+#version 430 core
+layout (location = 0) in vec3 aPos;
+layout (location = 13) in uint aDrawId;
+
+// Depth pre-pass for indirect_vertex.glsl
+invariant gl_Position;
+
+#include "common/camera.glsl"
+#include "common/draws.glsl"
+
+void main() {
+    vec3 worldPos = vec3(draws[aDrawId].model * vec4(aPos, 1.0));
+    gl_Position = projection * view * vec4(worldPos, 1.0);
+}
@@ -0,0 +1,13 @@
+#version 330 core
+layout (location = 0) in vec3 aPos;
+layout (location = 5) in mat4 aModel;   // 5..8, InstanceData::model
+
+// Depth pre-pass for instanced_vertex.glsl
+invariant gl_Position;
+
+#include "common/camera.glsl"
+
+void main() {
+    vec3 worldPos = vec3(aModel * vec4(aPos, 1.0));
+    gl_Position = projection * view * vec4(worldPos, 1.0);
+}
@@ -0,0 +1,12 @@
+#version 330 core
+layout (location = 0) in vec3 aPos;
+
+// Depth pre-pass for vertexShader.glsl: positions only, same transform
+invariant gl_Position;
+
+#include "common/transforms.glsl"
+
+void main() {
+    vec3 worldPos = vec3(model * vec4(aPos, 1.0));
+    gl_Position = projection * view * vec4(worldPos, 1.0);
+}
@@ -0,0 +1,21 @@
+#version 330 core
+layout (location = 0) out vec4 gAlbedoSpecular;
+layout (location = 1) out vec2 gNormal;
+
+in vec2 TexCoord;
+in mat3 TBN;
+flat in float MaterialLayer;
+
+uniform sampler2DArray diffuseLayers;   // One layer per material
+uniform sampler2DArray normalLayers;
+
+#include "common/gbuffer.glsl"
+
+// Geometry pass twin of instanced_fragment.glsl
+void main() {
+    vec3 uvw = vec3(TexCoord, MaterialLayer);
+    vec3 mappedNormal = normalize(texture(normalLayers, uvw).rgb * 2.0 - 1.0);
+
+    gAlbedoSpecular = vec4(texture(diffuseLayers, uvw).rgb, 1.0);
+    gNormal = encodeNormal(normalize(TBN * mappedNormal));
+}
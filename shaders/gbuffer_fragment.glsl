@@ -0,0 +1,19 @@
+#version 330 core
+layout (location = 0) out vec4 gAlbedoSpecular;
+layout (location = 1) out vec2 gNormal;
+
+in vec2 TexCoord;
+in mat3 TBN;
+
+uniform sampler2D texture1;    // Diffuse Texture
+uniform sampler2D normalMap;   // Normal Map
+
+#include "common/gbuffer.glsl"
+
+// Geometry pass twin of fragmentShader.glsl: same material inputs, no lighting
+void main() {
+    vec3 mappedNormal = normalize(texture(normalMap, TexCoord).rgb * 2.0 - 1.0);
+
+    gAlbedoSpecular = vec4(texture(texture1, TexCoord).rgb, 1.0);
+    gNormal = encodeNormal(normalize(TBN * mappedNormal));
+}
@@ -1,6 +1,40 @@
 #version 330 core
+// Anti-aliased grid lines computed per pixel: a minor level every gridStep and a
+// major level every 10 steps, each about one pixel wide whatever the distance.
+// A level fades out once its cells shrink to a few pixels, where it would only
+// alias, and the whole grid fades with distance from the camera.
+
+#include "common/camera.glsl"
+
+in vec3 worldPos;
+
+uniform vec3 gridAxisU;
+uniform vec3 gridAxisV;
+uniform float gridStep;
+uniform float gridExtent;   // Fully faded at this distance
+
 out vec4 FragColor;
 
+// Coverage of the nearest line of a level with the given cell size
+float gridLevel(vec2 coord, float cell) {
+    vec2 cells = coord / cell;
+    vec2 perPixel = fwidth(cells);
+    vec2 pixels = abs(fract(cells - 0.5) - 0.5) / perPixel;   // Distance to the line in pixels
+    float line = 1.0 - min(min(pixels.x, pixels.y), 1.0);
+
+    // perPixel above ~0.25 means a cell is under four pixels wide
+    float density = max(perPixel.x, perPixel.y);
+    return line * (1.0 - smoothstep(0.1, 0.25, density));
+}
+
 void main() {
-    FragColor = vec4(1.0, 1.0, 1.0, 0.3); // Gray color with 50% transparency
-}
\ No newline at end of file
+    vec2 coord = vec2(dot(worldPos, gridAxisU), dot(worldPos, gridAxisV));
+
+    float minor = gridLevel(coord, gridStep) * 0.3;
+    float major = gridLevel(coord, gridStep * 10.0) * 0.5;
+    float fade = 1.0 - smoothstep(0.5 * gridExtent, gridExtent, length(worldPos - viewPos));
+
+    float alpha = max(minor, major) * fade;
+    if (alpha < 0.002) discard;
+    FragColor = vec4(1.0, 1.0, 1.0, alpha);
+}
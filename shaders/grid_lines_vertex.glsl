@@ -0,0 +1,8 @@
+#version 330 core
+layout (location = 0) in vec3 aPos;
+
+#include "common/transforms.glsl"
+
+void main() {
+    gl_Position = projection * view * model * vec4(aPos, 1.0);
+}
\ No newline at end of file
@@ -1,10 +1,20 @@
 #version 330 core
-layout (location = 0) in vec3 aPos;
+// Procedural grid: one quad on the grid plane, centred under the camera and
+// built from gl_VertexID (drawn as a 4-vertex strip with no vertex buffer)
 
-uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+#include "common/camera.glsl"
+
+uniform vec3 gridAxisU;     // Unit axes spanning the plane, which goes through the origin
+uniform vec3 gridAxisV;
+uniform float gridExtent;   // Half size of the quad; the view distance is enough
+
+out vec3 worldPos;
 
 void main() {
-    gl_Position = projection * view * model * vec4(aPos, 1.0);
-}
\ No newline at end of file
+    vec2 corner = vec2(gl_VertexID & 1, gl_VertexID >> 1) * 2.0 - 1.0;
+    vec3 normal = cross(gridAxisU, gridAxisV);
+    vec3 centre = viewPos - normal * dot(viewPos, normal);
+
+    worldPos = centre + (corner.x * gridAxisU + corner.y * gridAxisV) * gridExtent;
+    gl_Position = projection * view * vec4(worldPos, 1.0);
+}
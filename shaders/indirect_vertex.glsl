@@ -0,0 +1,38 @@
+#version 430 core
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aNormal;
+layout (location = 2) in vec2 aTexCoord;
+layout (location = 3) in vec3 aTangent;
+layout (location = 4) in vec3 aBitangent;
+
+// Index into `draws`; a per-instance stream 0, 1, 2, ... that each indirect
+// command offsets with its baseInstance
+layout (location = 13) in uint aDrawId;
+
+out vec2 TexCoord;
+out vec3 FragPos;
+out vec3 Normal;
+out mat3 TBN;
+flat out float MaterialLayer;
+
+invariant gl_Position;
+
+#include "common/camera.glsl"
+#include "common/draws.glsl"
+
+void main() {
+    DrawData draw = draws[aDrawId];
+    mat3 normalMatrix = mat3(draw.normalMatrix[0].xyz, draw.normalMatrix[1].xyz, draw.normalMatrix[2].xyz);
+
+    FragPos = vec3(draw.model * vec4(aPos, 1.0));
+    Normal = normalize(normalMatrix * aNormal);
+
+    // Surface directions follow the model matrix, not the normal matrix
+    vec3 T = normalize(mat3(draw.model) * aTangent);
+    vec3 B = normalize(mat3(draw.model) * aBitangent);
+    TBN = mat3(T, B, Normal);
+
+    TexCoord = aTexCoord;
+    MaterialLayer = draw.materialLayer;
+    gl_Position = projection * view * vec4(FragPos, 1.0);
+}
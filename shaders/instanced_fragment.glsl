@@ -0,0 +1,20 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec2 TexCoord;
+in vec3 FragPos;
+in mat3 TBN;
+flat in float MaterialLayer;
+
+uniform sampler2DArray diffuseLayers;   // One layer per material
+uniform sampler2DArray normalLayers;
+
+#include "common/shading.glsl"
+
+void main() {
+    vec3 uvw = vec3(TexCoord, MaterialLayer);
+    vec3 mappedNormal = normalize(texture(normalLayers, uvw).rgb * 2.0 - 1.0);
+    vec3 norm = normalize(TBN * mappedNormal);
+
+    FragColor = vec4(shade(texture(diffuseLayers, uvw).rgb, norm, FragPos), 1.0);
+}
@@ -0,0 +1,35 @@
+#version 330 core
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aNormal;
+layout (location = 2) in vec2 aTexCoord;
+layout (location = 3) in vec3 aTangent;
+layout (location = 4) in vec3 aBitangent;
+
+// Per-instance attributes (InstanceData in Instancing.h)
+layout (location = 5) in mat4 aModel;          // 5..8
+layout (location = 9) in mat3 aNormalMatrix;   // 9..11
+layout (location = 12) in float aMaterialLayer;
+
+out vec2 TexCoord;
+out vec3 FragPos;
+out mat3 TBN;
+flat out float MaterialLayer;
+
+invariant gl_Position;
+
+#include "common/camera.glsl"
+
+void main() {
+    FragPos = vec3(aModel * vec4(aPos, 1.0));
+
+    // Tangent and bitangent are surface directions and follow the model matrix;
+    // only the normal needs the inverse transpose under non-uniform scale
+    vec3 T = normalize(mat3(aModel) * aTangent);
+    vec3 B = normalize(mat3(aModel) * aBitangent);
+    vec3 N = normalize(aNormalMatrix * aNormal);
+    TBN = mat3(T, B, N);
+
+    TexCoord = aTexCoord;
+    MaterialLayer = aMaterialLayer;
+    gl_Position = projection * view * vec4(FragPos, 1.0);
+}
@@ -0,0 +1,28 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec2 TexCoord;
+in vec2 LightmapUV;
+in vec3 FragPos;
+in vec3 Normal;
+in mat3 TBN;
+
+uniform sampler2D texture1;            // Diffuse Texture
+uniform sampler2D normalMap;           // Normal Map
+uniform sampler2D lightmap;            // Irradiance of the baked lights (GL_RGB9_E5)
+uniform sampler2D lightmapOcclusion;   // Baked ambient occlusion
+uniform int bakedLights;               // Lights [0, bakedLights) are in the lightmap
+
+#include "common/shading.glsl"
+
+// Static objects: the baked lights are one texture fetch, only the moving lights
+// are shaded per fragment
+void main() {
+    vec3 normalMapValue = texture(normalMap, TexCoord).rgb;
+    vec3 norm = normalize(TBN * normalize(normalMapValue * 2.0 - 1.0));
+    vec3 albedo = texture(texture1, TexCoord).rgb;
+
+    vec3 baked = albedo * texture(lightmap, LightmapUV).rgb;
+    float occlusion = texture(lightmapOcclusion, LightmapUV).r;
+    FragColor = vec4(baked + shadeLights(albedo, norm, FragPos, 1.0, bakedLights, occlusion), 1.0);
+}
@@ -0,0 +1,31 @@
+#version 330 core
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aNormal;
+layout (location = 2) in vec2 aTexCoord;
+layout (location = 3) in vec3 aTangent;
+layout (location = 4) in vec3 aBitangent;
+layout (location = 5) in vec2 aLightmapUV;
+
+out vec2 TexCoord;
+out vec2 LightmapUV;
+out vec3 FragPos;
+out vec3 Normal;
+out mat3 TBN;
+
+invariant gl_Position;
+
+#include "common/transforms.glsl"
+
+// vertexShader.glsl plus the lightmap atlas uv (LightmapBaker::Unwrapped)
+void main() {
+    FragPos = vec3(model * vec4(aPos, 1.0));
+    Normal = normalize(normalMatrix * aNormal);
+
+    vec3 T = normalize(mat3(model) * aTangent);
+    vec3 B = normalize(mat3(model) * aBitangent);
+    TBN = mat3(T, B, Normal);
+
+    TexCoord = aTexCoord;
+    LightmapUV = aLightmapUV;
+    gl_Position = projection * view * vec4(FragPos, 1.0);
+}
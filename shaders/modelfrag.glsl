@@ -5,7 +5,8 @@ in vec3 FragPos;
 in vec3 Normal;
 
 uniform vec3 lightPos = vec3(2.0, 4.0, 2.0);
-uniform vec3 viewPos = vec3(0.0, 0.0, 3.0);
+
+#include "common/camera.glsl"
 
 void main() {
     // Ambient
@@ -6,12 +6,10 @@ layout (location = 2) in vec2 aTexCoords;
 out vec3 FragPos;
 out vec3 Normal;
 
-uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+#include "common/transforms.glsl"
 
 void main() {
     FragPos = vec3(model * vec4(aPos, 1.0));
-    Normal = mat3(transpose(inverse(model))) * aNormal;  
+    Normal = normalize(normalMatrix * aNormal);
     gl_Position = projection * view * vec4(FragPos, 1.0);
 }
\ No newline at end of file
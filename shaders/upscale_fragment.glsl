@@ -0,0 +1,27 @@
+#version 330 core
+out vec4 FragColor;
+
+uniform sampler2D sceneColor;   // Scene rendered at the dynamic resolution
+uniform vec2 outputSize;        // Window size in pixels
+uniform float sharpness;        // 0 = plain bilinear
+
+// Bilinear upscale of the scene target to the window, plus an unsharp mask one
+// source texel wide to win back some of the detail lost to the lower resolution.
+// The result is clamped to the neighbourhood so edges don't ring.
+void main() {
+    vec2 uv = gl_FragCoord.xy / outputSize;
+    vec2 texel = 1.0 / vec2(textureSize(sceneColor, 0));
+
+    vec3 center = texture(sceneColor, uv).rgb;
+    vec3 left = texture(sceneColor, uv - vec2(texel.x, 0.0)).rgb;
+    vec3 right = texture(sceneColor, uv + vec2(texel.x, 0.0)).rgb;
+    vec3 down = texture(sceneColor, uv - vec2(0.0, texel.y)).rgb;
+    vec3 up = texture(sceneColor, uv + vec2(0.0, texel.y)).rgb;
+
+    vec3 blurred = (left + right + down + up) * 0.25;
+    vec3 low = min(center, min(min(left, right), min(down, up)));
+    vec3 high = max(center, max(max(left, right), max(down, up)));
+    vec3 sharpened = center + (center - blurred) * sharpness;
+
+    FragColor = vec4(clamp(sharpened, low, high), 1.0);
+}
@@ -10,19 +10,18 @@ out vec3 FragPos;
 out vec3 Normal;
 out mat3 TBN;
 
-uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+invariant gl_Position;
+
+#include "common/transforms.glsl"
 
 void main() {
     FragPos = vec3(model * vec4(aPos, 1.0));
-    Normal = normalize(mat3(transpose(inverse(model))) * aNormal);
+    Normal = normalize(normalMatrix * aNormal);
     
     // Compute TBN matrix (Tangent, Bitangent, Normal to transform normals to world space)
     vec3 T = normalize(mat3(model) * aTangent);
     vec3 B = normalize(mat3(model) * aBitangent);
-    vec3 N = normalize(mat3(model) * aNormal);
-    TBN = mat3(T, B, N);
+    TBN = mat3(T, B, Normal);
 
     TexCoord = aTexCoord;
     gl_Position = projection * view * vec4(FragPos, 1.0);
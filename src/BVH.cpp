@@ -0,0 +1,467 @@
+#include "BVH.h"
+#include <cmath>
+#include <cfloat>
+#include <algorithm>
+#include <cassert>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define BVH_SSE 1
+#endif
+
+namespace {
+
+const int SAH_BINS = 16;
+const int STACK_SIZE = 256; // Up to 3 deferred siblings per level
+// SAH can peel one object off per level on skewed input. Below this depth the
+// splits are medians, which at least halve every range, so 32 more levels hold
+// any 32-bit object count and the traversal stacks can't overflow.
+const int MAX_SAH_DEPTH = 48;
+const int MAX_DEPTH = MAX_SAH_DEPTH + 32;
+static_assert(3 * MAX_DEPTH + 1 <= STACK_SIZE, "traversal stack too small for the deepest tree");
+const float TRAVERSAL_COST = 1.0f;
+const float INTERSECTION_COST = 1.0f;
+
+AABB emptyBox() {
+    return {glm::vec3(FLT_MAX), glm::vec3(-FLT_MAX)};
+}
+
+float area(const AABB& box) {
+    if (box.min.x > box.max.x) return 0.0f;
+    return box.surfaceArea();
+}
+
+// Slab test against one box; distance of entry (0 if the origin is inside)
+bool rayBox(const glm::vec3& origin, const glm::vec3& invDir, float maxDistance, const AABB& box, float& tEnter) {
+    float tNear = 0.0f, tFar = maxDistance;
+    for (int axis = 0; axis < 3; ++axis) {
+        float t1 = (box.min[axis] - origin[axis]) * invDir[axis];
+        float t2 = (box.max[axis] - origin[axis]) * invDir[axis];
+        tNear = std::max(tNear, std::min(t1, t2));
+        tFar = std::min(tFar, std::max(t1, t2));
+    }
+    tEnter = tNear;
+    return tNear <= tFar;
+}
+
+bool insideFrustum(const glm::vec4 planes[6], const AABB& box) {
+    glm::vec3 c = box.center(), e = box.extents();
+    for (int p = 0; p < 6; ++p) {
+        const glm::vec4& n = planes[p];
+        float d = c.x * n.x + c.y * n.y + c.z * n.z + n.w;
+        float r = e.x * std::fabs(n.x) + e.y * std::fabs(n.y) + e.z * std::fabs(n.z);
+        if (d + r < 0.0f) return false;
+    }
+    return true;
+}
+
+}
+
+void BVH::build(const std::vector<AABB>& objectBounds) {
+    bounds_ = objectBounds;
+    nodes.clear();
+    order.resize(bounds_.size());
+    centroids.resize(bounds_.size());
+    for (uint32_t i = 0; i < bounds_.size(); ++i) {
+        order[i] = i;
+        centroids[i] = bounds_[i].center();
+    }
+
+    if (!bounds_.empty()) {
+        nodes.reserve(bounds_.size() / 2 + 1);
+        buildNode(0, (uint32_t)bounds_.size(), 0);
+    }
+    cost_ = buildCost_ = computeCost();
+}
+
+int32_t BVH::buildNode(uint32_t begin, uint32_t end, int depth) {
+    assert(depth < MAX_DEPTH);
+    bool sah = depth < MAX_SAH_DEPTH;
+    int32_t index = (int32_t)nodes.size();
+    nodes.emplace_back();
+
+    // Split into up to four ranges, always splitting the largest one
+    uint32_t rangeBegin[4] = {begin}, rangeEnd[4] = {end};
+    int rangeCount = 1;
+    while (rangeCount < 4) {
+        int largest = -1;
+        uint32_t largestSize = LEAF_SIZE;
+        for (int i = 0; i < rangeCount; ++i) {
+            if (rangeEnd[i] - rangeBegin[i] > largestSize) {
+                largest = i;
+                largestSize = rangeEnd[i] - rangeBegin[i];
+            }
+        }
+        if (largest < 0) break;
+
+        uint32_t mid = splitRange(rangeBegin[largest], rangeEnd[largest], sah);
+        rangeBegin[rangeCount] = mid;
+        rangeEnd[rangeCount] = rangeEnd[largest];
+        rangeEnd[largest] = mid;
+        ++rangeCount;
+    }
+
+    for (int slot = 0; slot < 4; ++slot) {
+        if (slot >= rangeCount) {
+            setSlot(nodes[index], slot, emptyBox());
+            nodes[index].child[slot] = 0;
+            nodes[index].count[slot] = -1;
+            continue;
+        }
+
+        AABB box = rangeBounds(rangeBegin[slot], rangeEnd[slot]);
+        uint32_t size = rangeEnd[slot] - rangeBegin[slot];
+        int32_t child, count;
+        if (size <= (uint32_t)LEAF_SIZE) {
+            child = (int32_t)rangeBegin[slot];
+            count = (int32_t)size;
+        } else {
+            child = buildNode(rangeBegin[slot], rangeEnd[slot], depth + 1);
+            count = 0;
+        }
+        // buildNode may have reallocated `nodes`
+        setSlot(nodes[index], slot, box);
+        nodes[index].child[slot] = child;
+        nodes[index].count[slot] = count;
+    }
+    return index;
+}
+
+// Binned SAH split (or the median with sah false) along the widest centroid
+// axis; returns the partition point
+uint32_t BVH::splitRange(uint32_t begin, uint32_t end, bool sah) {
+    AABB centroidBox = emptyBox();
+    for (uint32_t i = begin; i < end; ++i)
+        centroidBox.expand(centroids[order[i]]);
+
+    glm::vec3 extent = centroidBox.max - centroidBox.min;
+    int axis = 0;
+    if (extent.y > extent[axis]) axis = 1;
+    if (extent.z > extent[axis]) axis = 2;
+
+    uint32_t middle = begin + (end - begin) / 2;
+    if (extent[axis] <= 1e-12f)
+        return middle; // All centroids coincide; any split is as good
+    if (!sah) return medianSplit(begin, end, axis);
+
+    const float scale = SAH_BINS / extent[axis];
+    const float origin = centroidBox.min[axis];
+    auto binOf = [&](uint32_t object) {
+        int bin = (int)((centroids[object][axis] - origin) * scale);
+        return std::min(bin, SAH_BINS - 1);
+    };
+
+    uint32_t binCount[SAH_BINS] = {};
+    AABB binBox[SAH_BINS];
+    for (AABB& box : binBox) box = emptyBox();
+    for (uint32_t i = begin; i < end; ++i) {
+        int bin = binOf(order[i]);
+        ++binCount[bin];
+        binBox[bin].expand(bounds_[order[i]]);
+    }
+
+    // Sweep from the right for suffix areas, then from the left to evaluate splits
+    float rightArea[SAH_BINS];
+    uint32_t rightCount[SAH_BINS];
+    AABB accum = emptyBox();
+    uint32_t count = 0;
+    for (int bin = SAH_BINS - 1; bin > 0; --bin) {
+        accum.expand(binBox[bin]);
+        count += binCount[bin];
+        rightArea[bin] = area(accum);
+        rightCount[bin] = count;
+    }
+
+    int bestSplit = -1;
+    float bestCost = FLT_MAX;
+    accum = emptyBox();
+    count = 0;
+    for (int bin = 0; bin < SAH_BINS - 1; ++bin) {
+        accum.expand(binBox[bin]);
+        count += binCount[bin];
+        if (count == 0 || rightCount[bin + 1] == 0) continue;
+        float cost = count * area(accum) + rightCount[bin + 1] * rightArea[bin + 1];
+        if (cost < bestCost) {
+            bestCost = cost;
+            bestSplit = bin;
+        }
+    }
+
+    if (bestSplit >= 0) {
+        uint32_t* split = std::partition(order.data() + begin, order.data() + end,
+                                         [&](uint32_t object) { return binOf(object) <= bestSplit; });
+        uint32_t mid = (uint32_t)(split - order.data());
+        if (mid != begin && mid != end) return mid;
+    }
+
+    // Degenerate binning
+    return medianSplit(begin, end, axis);
+}
+
+uint32_t BVH::medianSplit(uint32_t begin, uint32_t end, int axis) {
+    uint32_t middle = begin + (end - begin) / 2;
+    std::nth_element(order.data() + begin, order.data() + middle, order.data() + end,
+                     [&](uint32_t a, uint32_t b) { return centroids[a][axis] < centroids[b][axis]; });
+    return middle;
+}
+
+AABB BVH::rangeBounds(uint32_t begin, uint32_t end) const {
+    AABB box = emptyBox();
+    for (uint32_t i = begin; i < end; ++i)
+        box.expand(bounds_[order[i]]);
+    return box;
+}
+
+void BVH::setSlot(Node& node, int slot, const AABB& box) {
+    node.minX[slot] = box.min.x; node.minY[slot] = box.min.y; node.minZ[slot] = box.min.z;
+    node.maxX[slot] = box.max.x; node.maxY[slot] = box.max.y; node.maxZ[slot] = box.max.z;
+}
+
+AABB BVH::slotBounds(const Node& node, int slot) const {
+    return {glm::vec3(node.minX[slot], node.minY[slot], node.minZ[slot]),
+            glm::vec3(node.maxX[slot], node.maxY[slot], node.maxZ[slot])};
+}
+
+void BVH::refit() {
+    // Reverse pre-order visits children before their parents
+    for (size_t i = nodes.size(); i-- > 0;) {
+        Node& node = nodes[i];
+        for (int slot = 0; slot < 4; ++slot) {
+            if (node.count[slot] < 0) continue;
+            AABB box = emptyBox();
+            if (node.count[slot] > 0) {
+                box = rangeBounds(node.child[slot], node.child[slot] + node.count[slot]);
+            } else {
+                const Node& child = nodes[node.child[slot]];
+                for (int c = 0; c < 4; ++c)
+                    if (child.count[c] >= 0) box.expand(slotBounds(child, c));
+            }
+            setSlot(node, slot, box);
+        }
+    }
+    cost_ = computeCost();
+}
+
+bool BVH::refitOrRebuild() {
+    refit();
+    if (cost_ <= buildCost_ * rebuildThreshold) return false;
+    std::vector<AABB> current = bounds_;
+    build(current);
+    return true;
+}
+
+float BVH::computeCost() const {
+    if (nodes.empty()) return 0.0f;
+
+    AABB root = emptyBox();
+    for (int slot = 0; slot < 4; ++slot)
+        if (nodes[0].count[slot] >= 0) root.expand(slotBounds(nodes[0], slot));
+    float rootArea = area(root);
+    if (rootArea <= 0.0f) return 0.0f;
+
+    float total = TRAVERSAL_COST * rootArea;
+    for (const Node& node : nodes) {
+        for (int slot = 0; slot < 4; ++slot) {
+            if (node.count[slot] < 0) continue;
+            float slotArea = area(slotBounds(node, slot));
+            if (node.count[slot] == 0) total += TRAVERSAL_COST * slotArea;
+            else total += INTERSECTION_COST * node.count[slot] * slotArea;
+        }
+    }
+    return total / rootArea;
+}
+
+void BVH::emitSubtree(int32_t child, int32_t count, std::vector<uint32_t>& out) const {
+    if (count > 0) {
+        out.insert(out.end(), order.begin() + child, order.begin() + child + count);
+        return;
+    }
+    const Node& node = nodes[child];
+    for (int slot = 0; slot < 4; ++slot)
+        if (node.count[slot] >= 0) emitSubtree(node.child[slot], node.count[slot], out);
+}
+
+void BVH::queryFrustum(const glm::vec4 planes[6], std::vector<uint32_t>& out) const {
+    if (nodes.empty()) return;
+
+    int32_t stack[STACK_SIZE];
+    int top = 0;
+    stack[top++] = 0;
+    while (top > 0) {
+        const Node& node = nodes[stack[--top]];
+
+        // Per slot: bit set if outside some plane / inside all planes
+        int outsideMask = 0, insideMask = 0xF;
+#ifdef BVH_SSE
+        __m128 cx = _mm_mul_ps(_mm_add_ps(_mm_load_ps(node.minX), _mm_load_ps(node.maxX)), _mm_set1_ps(0.5f));
+        __m128 cy = _mm_mul_ps(_mm_add_ps(_mm_load_ps(node.minY), _mm_load_ps(node.maxY)), _mm_set1_ps(0.5f));
+        __m128 cz = _mm_mul_ps(_mm_add_ps(_mm_load_ps(node.minZ), _mm_load_ps(node.maxZ)), _mm_set1_ps(0.5f));
+        __m128 ex = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node.maxX), _mm_load_ps(node.minX)), _mm_set1_ps(0.5f));
+        __m128 ey = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node.maxY), _mm_load_ps(node.minY)), _mm_set1_ps(0.5f));
+        __m128 ez = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node.maxZ), _mm_load_ps(node.minZ)), _mm_set1_ps(0.5f));
+        __m128 outside = _mm_setzero_ps();
+        __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+        for (int p = 0; p < 6; ++p) {
+            const glm::vec4& n = planes[p];
+            __m128 d = _mm_add_ps(_mm_add_ps(_mm_mul_ps(cx, _mm_set1_ps(n.x)), _mm_mul_ps(cy, _mm_set1_ps(n.y))),
+                                  _mm_add_ps(_mm_mul_ps(cz, _mm_set1_ps(n.z)), _mm_set1_ps(n.w)));
+            __m128 r = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ex, _mm_set1_ps(std::fabs(n.x))),
+                                             _mm_mul_ps(ey, _mm_set1_ps(std::fabs(n.y)))),
+                                  _mm_mul_ps(ez, _mm_set1_ps(std::fabs(n.z))));
+            outside = _mm_or_ps(outside, _mm_cmplt_ps(_mm_add_ps(d, r), _mm_setzero_ps()));
+            inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_sub_ps(d, r), _mm_setzero_ps()));
+        }
+        outsideMask = _mm_movemask_ps(outside);
+        insideMask = _mm_movemask_ps(inside);
+#else
+        for (int slot = 0; slot < 4; ++slot) {
+            AABB box = slotBounds(node, slot);
+            glm::vec3 c = box.center(), e = box.extents();
+            for (int p = 0; p < 6; ++p) {
+                const glm::vec4& n = planes[p];
+                float d = c.x * n.x + c.y * n.y + c.z * n.z + n.w;
+                float r = e.x * std::fabs(n.x) + e.y * std::fabs(n.y) + e.z * std::fabs(n.z);
+                if (d + r < 0.0f) outsideMask |= 1 << slot;
+                if (d - r < 0.0f) insideMask &= ~(1 << slot);
+            }
+        }
+#endif
+
+        for (int slot = 0; slot < 4; ++slot) {
+            if (node.count[slot] < 0 || (outsideMask >> slot) & 1) continue;
+            if ((insideMask >> slot) & 1) {
+                emitSubtree(node.child[slot], node.count[slot], out);
+            } else if (node.count[slot] == 0) {
+                stack[top++] = node.child[slot];
+            } else {
+                // Leaf straddling a plane: test its objects individually
+                for (int32_t i = 0; i < node.count[slot]; ++i) {
+                    uint32_t object = order[node.child[slot] + i];
+                    if (insideFrustum(planes, bounds_[object])) out.push_back(object);
+                }
+            }
+        }
+    }
+}
+
+void BVH::queryBox(const AABB& box, std::vector<uint32_t>& out) const {
+    if (nodes.empty()) return;
+
+    int32_t stack[STACK_SIZE];
+    int top = 0;
+    stack[top++] = 0;
+    while (top > 0) {
+        const Node& node = nodes[stack[--top]];
+
+        int overlapMask = 0;
+#ifdef BVH_SSE
+        __m128 overlap = _mm_and_ps(
+            _mm_and_ps(_mm_cmple_ps(_mm_load_ps(node.minX), _mm_set1_ps(box.max.x)),
+                       _mm_cmpge_ps(_mm_load_ps(node.maxX), _mm_set1_ps(box.min.x))),
+            _mm_and_ps(
+                _mm_and_ps(_mm_cmple_ps(_mm_load_ps(node.minY), _mm_set1_ps(box.max.y)),
+                           _mm_cmpge_ps(_mm_load_ps(node.maxY), _mm_set1_ps(box.min.y))),
+                _mm_and_ps(_mm_cmple_ps(_mm_load_ps(node.minZ), _mm_set1_ps(box.max.z)),
+                           _mm_cmpge_ps(_mm_load_ps(node.maxZ), _mm_set1_ps(box.min.z)))));
+        overlapMask = _mm_movemask_ps(overlap);
+#else
+        for (int slot = 0; slot < 4; ++slot)
+            if (slotBounds(node, slot).overlaps(box)) overlapMask |= 1 << slot;
+#endif
+
+        for (int slot = 0; slot < 4; ++slot) {
+            if (node.count[slot] < 0 || !((overlapMask >> slot) & 1)) continue;
+            if (node.count[slot] == 0) {
+                stack[top++] = node.child[slot];
+                continue;
+            }
+            for (int32_t i = 0; i < node.count[slot]; ++i) {
+                uint32_t object = order[node.child[slot] + i];
+                if (bounds_[object].overlaps(box)) out.push_back(object);
+            }
+        }
+    }
+}
+
+template <typename LeafTest>
+bool BVH::traverse(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, bool anyHit, RayHit& hit,
+                   const LeafTest& leafTest) const {
+    if (nodes.empty()) return false;
+
+    glm::vec3 invDir(1.0f / direction.x, 1.0f / direction.y, 1.0f / direction.z);
+    float best = maxDistance;
+    bool found = false;
+
+    struct Entry { int32_t node; float distance; };
+    Entry stack[STACK_SIZE];
+    int top = 0;
+    stack[top++] = {0, 0.0f};
+    while (top > 0) {
+        Entry entry = stack[--top];
+        if (entry.distance > best) continue;
+        const Node& node = nodes[entry.node];
+
+        float tEnter[4];
+        int hitMask = 0;
+#ifdef BVH_SSE
+        __m128 ox = _mm_set1_ps(origin.x), oy = _mm_set1_ps(origin.y), oz = _mm_set1_ps(origin.z);
+        __m128 ix = _mm_set1_ps(invDir.x), iy = _mm_set1_ps(invDir.y), iz = _mm_set1_ps(invDir.z);
+        __m128 t1x = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node.minX), ox), ix);
+        __m128 t2x = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node.maxX), ox), ix);
+        __m128 t1y = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node.minY), oy), iy);
+        __m128 t2y = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node.maxY), oy), iy);
+        __m128 t1z = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node.minZ), oz), iz);
+        __m128 t2z = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node.maxZ), oz), iz);
+        __m128 tNear = _mm_max_ps(_mm_max_ps(_mm_min_ps(t1x, t2x), _mm_min_ps(t1y, t2y)),
+                                  _mm_max_ps(_mm_min_ps(t1z, t2z), _mm_setzero_ps()));
+        __m128 tFar = _mm_min_ps(_mm_min_ps(_mm_max_ps(t1x, t2x), _mm_max_ps(t1y, t2y)),
+                                 _mm_min_ps(_mm_max_ps(t1z, t2z), _mm_set1_ps(best)));
+        hitMask = _mm_movemask_ps(_mm_cmple_ps(tNear, tFar));
+        _mm_storeu_ps(tEnter, tNear);
+#else
+        for (int slot = 0; slot < 4; ++slot)
+            if (rayBox(origin, invDir, best, slotBounds(node, slot), tEnter[slot])) hitMask |= 1 << slot;
+#endif
+
+        // Push far children first so the nearest is visited next
+        int slots[4], hits = 0;
+        for (int slot = 0; slot < 4; ++slot)
+            if (node.count[slot] >= 0 && (hitMask >> slot) & 1) slots[hits++] = slot;
+        for (int i = 1; i < hits; ++i)
+            for (int j = i; j > 0 && tEnter[slots[j]] > tEnter[slots[j - 1]]; --j)
+                std::swap(slots[j], slots[j - 1]);
+
+        for (int i = 0; i < hits; ++i) {
+            int slot = slots[i];
+            if (node.count[slot] == 0) {
+                stack[top++] = {node.child[slot], tEnter[slot]};
+                continue;
+            }
+            for (int32_t k = 0; k < node.count[slot]; ++k) {
+                uint32_t object = order[node.child[slot] + k];
+                float t = leafTest(object, best);
+                if (t >= 0.0f && (t < best || !found)) {
+                    best = t;
+                    hit.object = object;
+                    hit.distance = t;
+                    found = true;
+                    if (anyHit) return true;
+                }
+            }
+        }
+    }
+    return found;
+}
+
+bool BVH::raycast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, RayHit& hit) const {
+    glm::vec3 invDir(1.0f / direction.x, 1.0f / direction.y, 1.0f / direction.z);
+    return traverse(origin, direction, maxDistance, false, hit, [&](uint32_t object, float best) {
+        float t;
+        return rayBox(origin, invDir, best, bounds_[object], t) ? t : -1.0f;
+    });
+}
+
+bool BVH::raycast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance,
+                  const ObjectIntersector& intersect, RayHit& hit, bool anyHit) const {
+    return traverse(origin, direction, maxDistance, anyHit, hit, intersect);
+}
@@ -0,0 +1,144 @@
+#include "CommandList.h"
+#include <cstring>
+#include <iostream>
+#include <algorithm>
+
+static size_t padded(size_t bytes) { return (bytes + 15) & ~(size_t)15; }
+
+std::unique_ptr<unsigned char[]> CommandList::ChunkPool::acquire() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!spare.empty()) {
+            std::unique_ptr<unsigned char[]> chunk = std::move(spare.back());
+            spare.pop_back();
+            return chunk;
+        }
+        ++allocated;
+    }
+    return std::unique_ptr<unsigned char[]>(new unsigned char[CHUNK_BYTES]);
+}
+
+void CommandList::ChunkPool::release(std::unique_ptr<unsigned char[]> chunk) {
+    std::lock_guard<std::mutex> lock(mutex);
+    spare.push_back(std::move(chunk));
+}
+
+void CommandList::reset() {
+    if (pool) {
+        for (Chunk& chunk : chunks) pool->release(std::move(chunk.bytes));
+        chunks.clear();
+    }
+    for (Chunk& chunk : chunks) chunk.used = 0;
+    current = 0;
+    commands = 0;
+    beginSegment();
+}
+
+CommandList::Command* CommandList::push(Op op, uint32_t id, uint32_t count, uint32_t bytes) {
+    size_t size = sizeof(Command) + padded(bytes);
+    if (size > CHUNK_BYTES) {
+        std::cerr << "CommandList: " << bytes << " bytes of draw data don't fit in a chunk" << std::endl;
+        return nullptr;
+    }
+    if (chunks.empty() || chunks[current].used + size > CHUNK_BYTES) {
+        // Move on to the next chunk, kept from an earlier frame when there is one
+        if (!chunks.empty()) ++current;
+        if (current == chunks.size()) {
+            chunks.emplace_back();
+            if (pool) {
+                chunks.back().bytes = pool->acquire();
+            } else {
+                chunks.back().bytes.reset(new unsigned char[CHUNK_BYTES]);
+                ++allocations;
+            }
+        }
+        chunks[current].used = 0;
+    }
+
+    Chunk& chunk = chunks[current];
+    Command* command = reinterpret_cast<Command*>(chunk.bytes.get() + chunk.used);
+    command->op = op;
+    command->id = id;
+    command->count = count;
+    command->bytes = bytes;
+    chunk.used += size;
+    ++commands;
+    return command;
+}
+
+void CommandList::bindProgram(uint32_t id) {
+    if (id == program) return;
+    program = id;
+    push(BIND_PROGRAM, id, 0, 0);
+}
+
+void CommandList::bindMaterial(uint32_t id) {
+    if (id == material) return;
+    material = id;
+    push(BIND_MATERIAL, id, 0, 0);
+}
+
+void CommandList::setDrawData(const void* data, uint32_t bytes) {
+    Command* command = push(SET_DRAW_DATA, 0, 0, bytes);
+    if (command) std::memcpy(command + 1, data, bytes);
+}
+
+void CommandList::draw(uint32_t mesh, uint32_t instances) {
+    push(DRAW, mesh, instances, 0);
+}
+
+void CommandList::replay(Position from, Position to, const std::function<void(const Command&)>& fn) const {
+    for (size_t c = from.chunk; c <= to.chunk && c < chunks.size(); ++c) {
+        const unsigned char* bytes = chunks[c].bytes.get();
+        size_t offset = c == from.chunk ? from.offset : 0;
+        size_t end = c == to.chunk ? to.offset : chunks[c].used;
+        while (offset < end) {
+            const Command& command = *reinterpret_cast<const Command*>(bytes + offset);
+            fn(command);
+            offset += sizeof(Command) + padded(command.bytes);
+        }
+    }
+}
+
+void ParallelRecorder::record(size_t count, size_t grain,
+                              const std::function<void(CommandList&, size_t, size_t)>& fn) {
+    for (CommandList& list : lists) list.reset();
+    for (std::vector<Segment>& worker : segments) worker.clear();
+
+    pool.parallelFor(count, grain, [&](size_t begin, size_t end, unsigned worker) {
+        CommandList& list = lists[worker];
+        list.beginSegment();
+        CommandList::Position from = list.position();
+        fn(list, begin, end);
+        segments[worker].push_back({begin, worker, from, list.position()});
+    });
+
+    // Ranges were taken in any order by any worker; put them back in sequence
+    ordered.clear();
+    for (const std::vector<Segment>& worker : segments)
+        ordered.insert(ordered.end(), worker.begin(), worker.end());
+    std::sort(ordered.begin(), ordered.end(),
+              [](const Segment& a, const Segment& b) { return a.begin < b.begin; });
+}
+
+void ParallelRecorder::replay(const std::function<void(const CommandList::Command&)>& fn) const {
+    uint32_t program = CommandList::NONE, material = CommandList::NONE;
+    for (const Segment& segment : ordered) {
+        lists[segment.worker].replay(segment.from, segment.to, [&](const CommandList::Command& command) {
+            if (command.op == CommandList::BIND_PROGRAM) {
+                if (command.id == program) return;
+                program = command.id;
+            } else if (command.op == CommandList::BIND_MATERIAL) {
+                if (command.id == material) return;
+                material = command.id;
+            }
+            fn(command);
+        });
+    }
+}
+
+size_t ParallelRecorder::commandCount() const {
+    size_t total = 0;
+    for (const CommandList& list : lists) total += list.commandCount();
+    return total;
+}
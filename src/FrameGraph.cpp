@@ -0,0 +1,392 @@
+#include "FrameGraph.h"
+#include <chrono>
+#include <iostream>
+#include <algorithm>
+#include "GLState.h"
+
+namespace {
+
+struct FormatInfo {
+    GLenum internalFormat;
+    GLenum format;
+    GLenum type;
+    unsigned bytes;   // Per pixel
+};
+
+const FormatInfo FORMATS[] = {
+    {GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE, 4},
+    {GL_RGB10_A2, GL_RGBA, GL_UNSIGNED_INT_2_10_10_10_REV, 4},
+    {GL_RGBA16F, GL_RGBA, GL_HALF_FLOAT, 8},
+    {GL_RGBA32F, GL_RGBA, GL_FLOAT, 16},
+    {GL_R11F_G11F_B10F, GL_RGB, GL_UNSIGNED_INT_10F_11F_11F_REV, 4},
+    {GL_RG16F, GL_RG, GL_HALF_FLOAT, 4},
+    {GL_RG8, GL_RG, GL_UNSIGNED_BYTE, 2},
+    {GL_R8, GL_RED, GL_UNSIGNED_BYTE, 1},
+    {GL_R16F, GL_RED, GL_HALF_FLOAT, 2},
+    {GL_R32F, GL_RED, GL_FLOAT, 4},
+    {GL_DEPTH24_STENCIL8, GL_DEPTH_STENCIL, GL_UNSIGNED_INT_24_8, 4},
+    {GL_DEPTH_COMPONENT24, GL_DEPTH_COMPONENT, GL_UNSIGNED_INT, 4},
+    {GL_DEPTH_COMPONENT32F, GL_DEPTH_COMPONENT, GL_FLOAT, 4},
+};
+
+const FormatInfo& formatInfo(GLenum internalFormat) {
+    for (const FormatInfo& info : FORMATS)
+        if (info.internalFormat == internalFormat) return info;
+    std::cerr << "FrameGraph: unknown format 0x" << std::hex << internalFormat << std::dec << ", assuming RGBA8"
+              << std::endl;
+    return FORMATS[0];
+}
+
+bool hasStencil(GLenum internalFormat) {
+    return internalFormat == GL_DEPTH24_STENCIL8;
+}
+
+// Textures are bound here to be created, away from every sampler unit
+const GLuint SCRATCH_UNIT = GLState::MAX_TEXTURE_UNITS - 1;
+
+} // namespace
+
+bool FrameGraph::TextureDesc::isDepth() const {
+    return formatInfo(format).format == GL_DEPTH_STENCIL || formatInfo(format).format == GL_DEPTH_COMPONENT;
+}
+
+size_t FrameGraph::TextureDesc::bytes() const {
+    return (size_t)width * height * formatInfo(format).bytes;
+}
+
+FrameGraph::Resource FrameGraph::Builder::create(const std::string& name, const TextureDesc& desc) {
+    ResourceNode node;
+    node.name = name;
+    node.desc = desc;
+    graph.resources.push_back(node);
+    return (Resource)(graph.resources.size() - 1);
+}
+
+FrameGraph::Resource FrameGraph::Builder::read(Resource resource) {
+    graph.passes[pass].reads.push_back(resource);
+    return resource;
+}
+
+FrameGraph::Resource FrameGraph::Builder::write(Resource resource, Load load) {
+    graph.passes[pass].writes.push_back({resource, load});
+    return resource;
+}
+
+void FrameGraph::Builder::sideEffect() {
+    graph.passes[pass].sideEffect = true;
+}
+
+GLuint FrameGraph::Context::texture(Resource resource) const {
+    return graph.resources[resource].texture;
+}
+
+void FrameGraph::reset() {
+    passes.clear();
+    resources.clear();
+    executionOrder.clear();
+    slotDescs.clear();
+    compiled = false;
+}
+
+FrameGraph::Resource FrameGraph::import(const std::string& name, const TextureDesc& desc, GLuint framebuffer,
+                                        GLuint texture) {
+    ResourceNode node;
+    node.name = name;
+    node.desc = desc;
+    node.imported = true;
+    node.framebuffer = framebuffer;
+    node.texture = texture;
+    resources.push_back(node);
+    return (Resource)(resources.size() - 1);
+}
+
+void FrameGraph::addPass(const std::string& name, const SetupFn& setup, const ExecuteFn& execute) {
+    Pass pass;
+    pass.name = name;
+    pass.execute = execute;
+    passes.push_back(pass);
+    Builder builder(*this, (uint32_t)(passes.size() - 1));
+    setup(builder);
+}
+
+bool FrameGraph::compile() {
+    auto start = std::chrono::steady_clock::now();
+    compiled = false;
+    cull();
+    if (!computeLifetimes()) return false;
+    placeSlots();
+    compiled = true;
+    lastStats.compileMs =
+        std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return true;
+}
+
+// Reverse walk: a pass is live when it has a side effect or writes something a
+// later live pass wants. A LOAD write wants the previous contents in turn.
+void FrameGraph::cull() {
+    std::vector<char> wanted(resources.size(), 0);
+    for (size_t i = passes.size(); i-- > 0;) {
+        Pass& pass = passes[i];
+        pass.live = pass.sideEffect;
+        for (const Access& write : pass.writes)
+            if (resources[write.resource].imported || wanted[write.resource]) pass.live = true;
+        if (!pass.live) continue;
+        for (const Access& write : pass.writes) wanted[write.resource] = write.load == LOAD;
+        for (Resource read : pass.reads) wanted[read] = 1;
+    }
+}
+
+bool FrameGraph::computeLifetimes() {
+    executionOrder.clear();
+    for (ResourceNode& resource : resources) {
+        resource.firstUse = resource.lastUse = -1;
+        resource.slot = -1;
+    }
+
+    for (uint32_t i = 0; i < passes.size(); ++i) {
+        const Pass& pass = passes[i];
+        if (!pass.live) continue;
+        int position = (int)executionOrder.size();
+        executionOrder.push_back(i);
+
+        auto use = [&](Resource resource, bool needsContents) {
+            ResourceNode& node = resources[resource];
+            if (!node.imported && node.firstUse < 0 && needsContents) {
+                std::cerr << "FrameGraph: pass '" << pass.name << "' reads '" << node.name
+                          << "' before any pass writes it" << std::endl;
+                return false;
+            }
+            if (node.firstUse < 0) node.firstUse = position;
+            node.lastUse = position;
+            return true;
+        };
+        for (Resource read : pass.reads)
+            if (!use(read, true)) return false;
+
+        bool importedWrite = false;
+        unsigned depthWrites = 0;
+        for (const Access& write : pass.writes) {
+            const ResourceNode& node = resources[write.resource];
+            const ResourceNode& first = resources[pass.writes[0].resource];
+            if (node.desc.width != first.desc.width || node.desc.height != first.desc.height) {
+                std::cerr << "FrameGraph: pass '" << pass.name << "' writes targets of different sizes" << std::endl;
+                return false;
+            }
+            importedWrite = importedWrite || node.imported;
+            if (node.desc.isDepth()) ++depthWrites;
+            if (!use(write.resource, write.load == LOAD)) return false;
+        }
+        // An imported target is a whole framebuffer (colour and depth)
+        if ((importedWrite && pass.writes.size() > 1) || depthWrites > 1) {
+            std::cerr << "FrameGraph: pass '" << pass.name
+                      << "' must write one imported target alone, or at most one depth target" << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+// Greedy interval placement in order of first use: a target takes the free slot
+// of its description that was released last, or a new one
+void FrameGraph::placeSlots() {
+    std::vector<Resource> transients;
+    for (Resource r = 0; r < resources.size(); ++r)
+        if (!resources[r].imported && resources[r].firstUse >= 0) transients.push_back(r);
+    std::stable_sort(transients.begin(), transients.end(),
+                     [&](Resource a, Resource b) { return resources[a].firstUse < resources[b].firstUse; });
+
+    std::vector<int> slotLastUse;
+    slotDescs.clear();
+    lastStats.requestedBytes = 0;
+    for (Resource r : transients) {
+        ResourceNode& node = resources[r];
+        lastStats.requestedBytes += node.desc.bytes();
+        int best = -1;
+        for (size_t s = 0; s < slotDescs.size(); ++s) {
+            if (!(slotDescs[s] == node.desc) || slotLastUse[s] >= node.firstUse) continue;
+            if (best < 0 || slotLastUse[s] > slotLastUse[best]) best = (int)s;
+        }
+        if (best < 0) {
+            best = (int)slotDescs.size();
+            slotDescs.push_back(node.desc);
+            slotLastUse.push_back(-1);
+        }
+        node.slot = best;
+        slotLastUse[best] = node.lastUse;
+    }
+
+    lastStats.passes = (unsigned)passes.size();
+    lastStats.culled = (unsigned)(passes.size() - executionOrder.size());
+    lastStats.transients = (unsigned)transients.size();
+    lastStats.textures = (unsigned)slotDescs.size();
+    lastStats.allocatedBytes = 0;
+    for (const TextureDesc& desc : slotDescs) lastStats.allocatedBytes += desc.bytes();
+}
+
+void FrameGraph::execute(RenderTargetPool& pool) {
+    if (!compiled) return;
+    GLState& gl = GLState::instance();
+
+    pool.beginFrame();
+    std::vector<GLuint> slotTextures(slotDescs.size());
+    for (size_t s = 0; s < slotDescs.size(); ++s) slotTextures[s] = pool.acquire(slotDescs[s]);
+    for (ResourceNode& node : resources)
+        if (node.slot >= 0) node.texture = slotTextures[node.slot];
+
+    Context context(*this);
+    std::vector<GLuint> colors;
+    for (uint32_t index : executionOrder) {
+        const Pass& pass = passes[index];
+        if (!pass.writes.empty()) {
+            const ResourceNode& first = resources[pass.writes[0].resource];
+            context.viewportWidth = first.desc.width;
+            context.viewportHeight = first.desc.height;
+
+            bool clearColor = false, clearDepth = false;
+            if (first.imported) {
+                gl.bindFramebuffer(GL_FRAMEBUFFER, first.framebuffer);
+                clearColor = clearDepth = pass.writes[0].load == CLEAR;
+            } else {
+                colors.clear();
+                GLuint depth = 0;
+                bool stencil = false;
+                for (const Access& write : pass.writes) {
+                    const ResourceNode& node = resources[write.resource];
+                    if (node.desc.isDepth()) {
+                        depth = node.texture;
+                        stencil = hasStencil(node.desc.format);
+                        clearDepth = clearDepth || write.load == CLEAR;
+                    } else {
+                        colors.push_back(node.texture);
+                    }
+                }
+                gl.bindFramebuffer(GL_FRAMEBUFFER, pool.framebuffer(colors, depth, stencil));
+            }
+            gl.viewport(0, 0, context.viewportWidth, context.viewportHeight);
+
+            // Only the attachments that asked for it, and only through their own buffers
+            const GLfloat zero[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+            if (first.imported && clearColor) {
+                gl.colorMask(true);
+                gl.depthMask(true);
+                glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+                glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+            } else if (!first.imported) {
+                GLint colorIndex = 0;
+                for (const Access& write : pass.writes) {
+                    const ResourceNode& node = resources[write.resource];
+                    if (node.desc.isDepth()) continue;
+                    if (write.load == CLEAR) {
+                        gl.colorMask(true);
+                        glClearBufferfv(GL_COLOR, colorIndex, zero);
+                    }
+                    ++colorIndex;
+                }
+                if (clearDepth) {
+                    gl.depthMask(true);
+                    const ResourceNode* depthNode = nullptr;
+                    for (const Access& write : pass.writes)
+                        if (resources[write.resource].desc.isDepth()) depthNode = &resources[write.resource];
+                    if (hasStencil(depthNode->desc.format)) {
+                        glClearBufferfi(GL_DEPTH_STENCIL, 0, 1.0f, 0);
+                    } else {
+                        const GLfloat far = 1.0f;
+                        glClearBufferfv(GL_DEPTH, 0, &far);
+                    }
+                }
+            }
+        }
+        pass.execute(context);
+    }
+    pool.endFrame();
+}
+
+RenderTargetPool::~RenderTargetPool() {
+    for (Entry& entry : entries) release(entry);
+}
+
+void RenderTargetPool::beginFrame() {
+    ++frame;
+    for (Entry& entry : entries) entry.taken = false;
+}
+
+void RenderTargetPool::endFrame() {
+    for (Entry& entry : entries)
+        if (frame - entry.lastFrame > RELEASE_AFTER) release(entry);
+    entries.erase(std::remove_if(entries.begin(), entries.end(), [](const Entry& e) { return e.texture == 0; }),
+                  entries.end());
+}
+
+GLuint RenderTargetPool::acquire(const FrameGraph::TextureDesc& desc) {
+    for (Entry& entry : entries) {
+        if (entry.taken || !(entry.desc == desc)) continue;
+        entry.taken = true;
+        entry.lastFrame = frame;
+        return entry.texture;
+    }
+
+    const FormatInfo& info = formatInfo(desc.format);
+    Entry entry = {desc, 0, frame, true};
+    glGenTextures(1, &entry.texture);
+    GLState& gl = GLState::instance();
+    gl.bindTexture(SCRATCH_UNIT, GL_TEXTURE_2D, entry.texture);
+    GL_CHECK(glTexImage2D(GL_TEXTURE_2D, 0, info.internalFormat, desc.width, desc.height, 0, info.format, info.type,
+                          nullptr));
+    GLDebug::label(GL_TEXTURE, entry.texture, "frame graph target");
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    entries.push_back(entry);
+    return entry.texture;
+}
+
+GLuint RenderTargetPool::framebuffer(const std::vector<GLuint>& colors, GLuint depth, bool depthStencil) {
+    for (const Target& target : framebuffers)
+        if (target.colors == colors && target.depth == depth) return target.framebuffer;
+
+    Target target = {colors, depth, 0};
+    glGenFramebuffers(1, &target.framebuffer);
+    GLState& gl = GLState::instance();
+    gl.bindFramebuffer(GL_FRAMEBUFFER, target.framebuffer);
+    std::vector<GLenum> drawBuffers;
+    for (size_t i = 0; i < colors.size(); ++i) {
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + (GLenum)i, GL_TEXTURE_2D, colors[i], 0);
+        drawBuffers.push_back(GL_COLOR_ATTACHMENT0 + (GLenum)i);
+    }
+    if (depth)
+        glFramebufferTexture2D(GL_FRAMEBUFFER, depthStencil ? GL_DEPTH_STENCIL_ATTACHMENT : GL_DEPTH_ATTACHMENT,
+                               GL_TEXTURE_2D, depth, 0);
+    if (drawBuffers.empty()) glDrawBuffer(GL_NONE);
+    else glDrawBuffers((GLsizei)drawBuffers.size(), drawBuffers.data());
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+        std::cerr << "FrameGraph framebuffer is incomplete" << std::endl;
+    framebuffers.push_back(target);
+    return target.framebuffer;
+}
+
+size_t RenderTargetPool::allocatedBytes() const {
+    size_t bytes = 0;
+    for (const Entry& entry : entries) bytes += entry.desc.bytes();
+    return bytes;
+}
+
+// Also drops the framebuffers it is attached to
+void RenderTargetPool::release(Entry& entry) {
+    if (!entry.texture) return;
+    GLState& gl = GLState::instance();
+    for (Target& target : framebuffers) {
+        bool attached = target.depth == entry.texture ||
+                        std::find(target.colors.begin(), target.colors.end(), entry.texture) != target.colors.end();
+        if (!attached || !target.framebuffer) continue;
+        gl.forgetFramebuffer(target.framebuffer);
+        glDeleteFramebuffers(1, &target.framebuffer);
+        target.framebuffer = 0;
+    }
+    framebuffers.erase(std::remove_if(framebuffers.begin(), framebuffers.end(),
+                                      [](const Target& t) { return t.framebuffer == 0; }),
+                       framebuffers.end());
+    gl.forgetTexture(entry.texture);
+    glDeleteTextures(1, &entry.texture);
+    entry.texture = 0;
+}
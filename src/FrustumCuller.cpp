@@ -0,0 +1,140 @@
+#include "FrustumCuller.h"
+#include <cmath>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
+void FrustumCuller::setFrustum(const glm::mat4& m) {
+    // Gribb/Hartmann: planes are sums/differences of the clip matrix rows
+    glm::vec4 row0(m[0][0], m[1][0], m[2][0], m[3][0]);
+    glm::vec4 row1(m[0][1], m[1][1], m[2][1], m[3][1]);
+    glm::vec4 row2(m[0][2], m[1][2], m[2][2], m[3][2]);
+    glm::vec4 row3(m[0][3], m[1][3], m[2][3], m[3][3]);
+
+    planes[0] = row3 + row0; // Left
+    planes[1] = row3 - row0; // Right
+    planes[2] = row3 + row1; // Bottom
+    planes[3] = row3 - row1; // Top
+    planes[4] = row3 + row2; // Near
+    planes[5] = row3 - row2; // Far
+
+    for (glm::vec4& plane : planes) {
+        float length = std::sqrt(plane.x * plane.x + plane.y * plane.y + plane.z * plane.z);
+        plane = plane / length;
+    }
+}
+
+void FrustumCuller::clear() {
+    count = 0;
+    centerX.clear(); centerY.clear(); centerZ.clear();
+    extentX.clear(); extentY.clear(); extentZ.clear();
+}
+
+uint32_t FrustumCuller::add(const AABB& bounds) {
+    glm::vec3 c = bounds.center();
+    glm::vec3 e = bounds.extents();
+    centerX.push_back(c.x); centerY.push_back(c.y); centerZ.push_back(c.z);
+    extentX.push_back(e.x); extentY.push_back(e.y); extentZ.push_back(e.z);
+    return (uint32_t)count++;
+}
+
+void FrustumCuller::cull(JobPool& pool) {
+    // Pad to whole batches; padding results are never read
+    size_t padded = (count + BATCH - 1) / BATCH * BATCH;
+    for (std::vector<float>* column : {&centerX, &centerY, &centerZ, &extentX, &extentY, &extentZ})
+        column->resize(padded, 0.0f);
+    visibility.resize(padded);
+
+    if (count < parallelThreshold || pool.size() == 1) {
+        cullRange(0, padded);
+    } else {
+        const size_t grain = 4096; // Multiple of BATCH
+        pool.parallelFor(padded, grain, [this](size_t begin, size_t end, unsigned) {
+            cullRange(begin, end);
+        });
+    }
+
+    lastStats.tested = (unsigned int)count;
+    lastStats.culled = 0;
+    for (size_t i = 0; i < count; ++i)
+        lastStats.culled += visibility[i] == 0;
+
+    // Keep the columns at the logical size so add() appends after the last box
+    for (std::vector<float>* column : {&centerX, &centerY, &centerZ, &extentX, &extentY, &extentZ})
+        column->resize(count);
+}
+
+void FrustumCuller::cullRange(size_t begin, size_t end) {
+#if defined(__AVX__)
+    __m256 nx[6], ny[6], nz[6], nw[6], ax[6], ay[6], az[6];
+    for (int p = 0; p < 6; ++p) {
+        nx[p] = _mm256_set1_ps(planes[p].x);
+        ny[p] = _mm256_set1_ps(planes[p].y);
+        nz[p] = _mm256_set1_ps(planes[p].z);
+        nw[p] = _mm256_set1_ps(planes[p].w);
+        ax[p] = _mm256_set1_ps(std::fabs(planes[p].x));
+        ay[p] = _mm256_set1_ps(std::fabs(planes[p].y));
+        az[p] = _mm256_set1_ps(std::fabs(planes[p].z));
+    }
+    const __m256 zero = _mm256_setzero_ps();
+
+    for (size_t i = begin; i < end; i += 8) {
+        __m256 cx = _mm256_loadu_ps(&centerX[i]), cy = _mm256_loadu_ps(&centerY[i]), cz = _mm256_loadu_ps(&centerZ[i]);
+        __m256 ex = _mm256_loadu_ps(&extentX[i]), ey = _mm256_loadu_ps(&extentY[i]), ez = _mm256_loadu_ps(&extentZ[i]);
+        __m256 outside = zero;
+        for (int p = 0; p < 6; ++p) {
+            // Signed distance of the centre plus the box's projected radius
+            __m256 d = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(cx, nx[p]), _mm256_mul_ps(cy, ny[p])),
+                                     _mm256_add_ps(_mm256_mul_ps(cz, nz[p]), nw[p]));
+            __m256 r = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(ex, ax[p]), _mm256_mul_ps(ey, ay[p])),
+                                     _mm256_mul_ps(ez, az[p]));
+            outside = _mm256_or_ps(outside, _mm256_cmp_ps(_mm256_add_ps(d, r), zero, _CMP_LT_OQ));
+        }
+        int mask = _mm256_movemask_ps(outside);
+        for (int k = 0; k < 8; ++k)
+            visibility[i + k] = !((mask >> k) & 1);
+    }
+#elif defined(__SSE2__) || defined(_M_X64)
+    __m128 nx[6], ny[6], nz[6], nw[6], ax[6], ay[6], az[6];
+    for (int p = 0; p < 6; ++p) {
+        nx[p] = _mm_set1_ps(planes[p].x);
+        ny[p] = _mm_set1_ps(planes[p].y);
+        nz[p] = _mm_set1_ps(planes[p].z);
+        nw[p] = _mm_set1_ps(planes[p].w);
+        ax[p] = _mm_set1_ps(std::fabs(planes[p].x));
+        ay[p] = _mm_set1_ps(std::fabs(planes[p].y));
+        az[p] = _mm_set1_ps(std::fabs(planes[p].z));
+    }
+    const __m128 zero = _mm_setzero_ps();
+
+    for (size_t i = begin; i < end; i += 4) {
+        __m128 cx = _mm_loadu_ps(&centerX[i]), cy = _mm_loadu_ps(&centerY[i]), cz = _mm_loadu_ps(&centerZ[i]);
+        __m128 ex = _mm_loadu_ps(&extentX[i]), ey = _mm_loadu_ps(&extentY[i]), ez = _mm_loadu_ps(&extentZ[i]);
+        __m128 outside = zero;
+        for (int p = 0; p < 6; ++p) {
+            __m128 d = _mm_add_ps(_mm_add_ps(_mm_mul_ps(cx, nx[p]), _mm_mul_ps(cy, ny[p])),
+                                  _mm_add_ps(_mm_mul_ps(cz, nz[p]), nw[p]));
+            __m128 r = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ex, ax[p]), _mm_mul_ps(ey, ay[p])),
+                                  _mm_mul_ps(ez, az[p]));
+            outside = _mm_or_ps(outside, _mm_cmplt_ps(_mm_add_ps(d, r), zero));
+        }
+        int mask = _mm_movemask_ps(outside);
+        for (int k = 0; k < 4; ++k)
+            visibility[i + k] = !((mask >> k) & 1);
+    }
+#else
+    for (size_t i = begin; i < end; ++i) {
+        bool inside = true;
+        for (int p = 0; p < 6 && inside; ++p) {
+            const glm::vec4& n = planes[p];
+            float d = centerX[i] * n.x + centerY[i] * n.y + centerZ[i] * n.z + n.w;
+            float r = extentX[i] * std::fabs(n.x) + extentY[i] * std::fabs(n.y) + extentZ[i] * std::fabs(n.z);
+            inside = d + r >= 0.0f;
+        }
+        visibility[i] = inside;
+    }
+#endif
+}
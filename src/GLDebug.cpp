@@ -0,0 +1,144 @@
+#include "GLDebug.h"
+
+#ifdef ENGINE_GL_DEBUG
+#include <cstdint>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace GLDebug {
+namespace {
+
+const GLenum SOURCES[Filter::SOURCE_COUNT] = {
+    GL_DEBUG_SOURCE_API, GL_DEBUG_SOURCE_WINDOW_SYSTEM, GL_DEBUG_SOURCE_SHADER_COMPILER,
+    GL_DEBUG_SOURCE_THIRD_PARTY, GL_DEBUG_SOURCE_APPLICATION, GL_DEBUG_SOURCE_OTHER};
+const char* const SOURCE_NAMES[Filter::SOURCE_COUNT] = {
+    "api", "window system", "shader compiler", "third party", "application", "other"};
+
+const GLenum TYPES[Filter::TYPE_COUNT] = {
+    GL_DEBUG_TYPE_ERROR, GL_DEBUG_TYPE_DEPRECATED_BEHAVIOR, GL_DEBUG_TYPE_UNDEFINED_BEHAVIOR,
+    GL_DEBUG_TYPE_PORTABILITY, GL_DEBUG_TYPE_PERFORMANCE, GL_DEBUG_TYPE_MARKER,
+    GL_DEBUG_TYPE_PUSH_GROUP, GL_DEBUG_TYPE_POP_GROUP, GL_DEBUG_TYPE_OTHER};
+const char* const TYPE_NAMES[Filter::TYPE_COUNT] = {
+    "error", "deprecated", "undefined behavior", "portability", "performance",
+    "marker", "push group", "pop group", "other"};
+
+const GLenum SEVERITIES[] = {
+    GL_DEBUG_SEVERITY_NOTIFICATION, GL_DEBUG_SEVERITY_LOW, GL_DEBUG_SEVERITY_MEDIUM, GL_DEBUG_SEVERITY_HIGH};
+const char* const SEVERITY_NAMES[] = {"notification", "low", "medium", "high"};
+
+template <size_t N>
+int indexOf(const GLenum (&values)[N], GLenum value) {
+    for (size_t i = 0; i < N; ++i)
+        if (values[i] == value) return (int)i;
+    return (int)N - 1;
+}
+
+const char* errorName(GLenum error) {
+    switch (error) {
+    case GL_INVALID_ENUM: return "GL_INVALID_ENUM";
+    case GL_INVALID_VALUE: return "GL_INVALID_VALUE";
+    case GL_INVALID_OPERATION: return "GL_INVALID_OPERATION";
+    case GL_INVALID_FRAMEBUFFER_OPERATION: return "GL_INVALID_FRAMEBUFFER_OPERATION";
+    case GL_OUT_OF_MEMORY: return "GL_OUT_OF_MEMORY";
+    case GL_STACK_UNDERFLOW: return "GL_STACK_UNDERFLOW";
+    case GL_STACK_OVERFLOW: return "GL_STACK_OVERFLOW";
+    default: return "unknown GL error";
+    }
+}
+
+// First report of each key is printed, the rest only counted. Keys are the
+// message id with its source and type, or the call site for glGetError.
+struct Reports {
+    std::mutex mutex;
+    std::unordered_map<std::string, unsigned> repeats;
+    std::unordered_map<uint64_t, unsigned> messageRepeats;
+
+    ~Reports() {
+        unsigned total = 0;
+        for (const auto& site : repeats) total += site.second;
+        for (const auto& message : messageRepeats) total += message.second;
+        if (total)
+            std::cerr << "GL debug: " << total << " repeated report(s) suppressed" << std::endl;
+    }
+};
+
+Reports& reports() {
+    static Reports instance;
+    return instance;
+}
+
+void APIENTRY onMessage(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei,
+                        const GLchar* message, const void*) {
+    int sourceIndex = indexOf(SOURCES, source);
+    int typeIndex = indexOf(TYPES, type);
+    Reports& r = reports();
+    {
+        std::lock_guard<std::mutex> lock(r.mutex);
+        uint64_t key = (uint64_t)id << 8 | (uint64_t)sourceIndex << 4 | (uint64_t)typeIndex;
+        auto found = r.messageRepeats.find(key);
+        if (found != r.messageRepeats.end()) {
+            ++found->second;
+            return;
+        }
+        r.messageRepeats.emplace(key, 0u);
+    }
+    std::cerr << "GL debug [" << SOURCE_NAMES[sourceIndex] << ", " << TYPE_NAMES[typeIndex] << ", "
+              << SEVERITY_NAMES[indexOf(SEVERITIES, severity)] << "] " << id << ": " << message << std::endl;
+}
+
+} // namespace
+
+void enable(const Filter& filter) {
+    if (!GLAD_GL_VERSION_4_3) return;
+
+    GLint flags = 0;
+    glGetIntegerv(GL_CONTEXT_FLAGS, &flags);
+    if (!(flags & GL_CONTEXT_FLAG_DEBUG_BIT))
+        std::cerr << "GL debug: not a debug context, the driver may report little" << std::endl;
+
+    glEnable(GL_DEBUG_OUTPUT);
+    glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+    glDebugMessageCallback(onMessage, nullptr);
+
+    // Everything off, then each allowed source x type x severity back on
+    glDebugMessageControl(GL_DONT_CARE, GL_DONT_CARE, GL_DONT_CARE, 0, nullptr, GL_FALSE);
+    for (int source = 0; source < Filter::SOURCE_COUNT; ++source) {
+        if (!(filter.sources & 1u << source)) continue;
+        for (int type = 0; type < Filter::TYPE_COUNT; ++type) {
+            if (!(filter.types & 1u << type)) continue;
+            for (int severity = filter.minSeverity; severity <= Filter::HIGH; ++severity)
+                glDebugMessageControl(SOURCES[source], TYPES[type], SEVERITIES[severity], 0, nullptr, GL_TRUE);
+        }
+    }
+    // The control calls themselves must not have failed
+    check("glDebugMessageControl", __FILE__, __LINE__);
+}
+
+void label(GLenum identifier, GLuint name, const char* text) {
+    if (!GLAD_GL_VERSION_4_3 || !name) return;
+    glObjectLabel(identifier, name, -1, text);
+}
+
+bool check(const char* what, const char* file, int line) {
+    GLenum error = glGetError();
+    if (error == GL_NO_ERROR) return true;
+
+    Reports& r = reports();
+    std::string site = std::string(file) + ":" + std::to_string(line);
+    bool first;
+    {
+        std::lock_guard<std::mutex> lock(r.mutex);
+        auto inserted = r.repeats.emplace(site, 0u);
+        first = inserted.second;
+        if (!first) ++inserted.first->second;
+    }
+    // Errors are sticky per flag until read; report every pending one
+    for (; error != GL_NO_ERROR; error = glGetError())
+        if (first) std::cerr << site << ": " << errorName(error) << " after " << what << std::endl;
+    return false;
+}
+
+} // namespace GLDebug
+#endif // ENGINE_GL_DEBUG
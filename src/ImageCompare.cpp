@@ -0,0 +1,81 @@
+#include "ImageCompare.h"
+#include <cstdlib>
+#include <algorithm>
+
+namespace {
+
+const int WINDOW = 8;
+const int STRIDE = 4;
+
+// Rec. 601 luma
+void luma(const unsigned char* rgb, size_t pixels, std::vector<float>& out) {
+    out.resize(pixels);
+    for (size_t i = 0; i < pixels; ++i)
+        out[i] = 0.299f * rgb[3 * i] + 0.587f * rgb[3 * i + 1] + 0.114f * rgb[3 * i + 2];
+}
+
+} // namespace
+
+double structuralSimilarity(const float* a, const float* b, int width, int height) {
+    const double C1 = (0.01 * 255.0) * (0.01 * 255.0);
+    const double C2 = (0.03 * 255.0) * (0.03 * 255.0);
+    // Images smaller than a window are one window
+    int windowX = std::min(WINDOW, width), windowY = std::min(WINDOW, height);
+    if (windowX <= 0 || windowY <= 0) return 1.0;
+    double n = (double)windowX * windowY;
+
+    double total = 0.0;
+    size_t windows = 0;
+    for (int y = 0; y + windowY <= height; y += STRIDE) {
+        for (int x = 0; x + windowX <= width; x += STRIDE) {
+            double sumA = 0.0, sumB = 0.0, sumAA = 0.0, sumBB = 0.0, sumAB = 0.0;
+            for (int wy = 0; wy < windowY; ++wy) {
+                const float* rowA = a + (size_t)(y + wy) * width + x;
+                const float* rowB = b + (size_t)(y + wy) * width + x;
+                for (int wx = 0; wx < windowX; ++wx) {
+                    double va = rowA[wx], vb = rowB[wx];
+                    sumA += va;
+                    sumB += vb;
+                    sumAA += va * va;
+                    sumBB += vb * vb;
+                    sumAB += va * vb;
+                }
+            }
+            double meanA = sumA / n, meanB = sumB / n;
+            double varA = std::max(0.0, sumAA / n - meanA * meanA);
+            double varB = std::max(0.0, sumBB / n - meanB * meanB);
+            double covariance = sumAB / n - meanA * meanB;
+            total += ((2.0 * meanA * meanB + C1) * (2.0 * covariance + C2)) /
+                     ((meanA * meanA + meanB * meanB + C1) * (varA + varB + C2));
+            ++windows;
+        }
+    }
+    return windows ? total / windows : 1.0;
+}
+
+ImageDiff compareImages(const unsigned char* a, const unsigned char* b, int width, int height, int tolerance,
+                        std::vector<unsigned char>* heatmap) {
+    ImageDiff diff;
+    size_t pixels = (size_t)width * height;
+    if (heatmap) heatmap->assign(pixels * 3, 0);
+    for (size_t i = 0; i < pixels; ++i) {
+        int worst = 0;
+        for (int c = 0; c < 3; ++c) worst = std::max(worst, std::abs((int)a[3 * i + c] - (int)b[3 * i + c]));
+        diff.maxDifference = std::max(diff.maxDifference, worst);
+        bool over = worst > tolerance;
+        if (over) ++diff.pixelsOver;
+        if (heatmap) {
+            unsigned char grey = (unsigned char)std::min(255, worst * 4);
+            (*heatmap)[3 * i] = over ? 255 : grey;
+            (*heatmap)[3 * i + 1] = over ? 0 : grey;
+            (*heatmap)[3 * i + 2] = over ? 0 : grey;
+        }
+    }
+    diff.fractionOver = pixels ? (double)diff.pixelsOver / pixels : 0.0;
+
+    std::vector<float> lumaA, lumaB;
+    luma(a, pixels, lumaA);
+    luma(b, pixels, lumaB);
+    diff.ssim = structuralSimilarity(lumaA.data(), lumaB.data(), width, height);
+    return diff;
+}
@@ -0,0 +1,123 @@
+#include "IndirectRenderer.h"
+#include <iostream>
+#include <cstring>
+#include <algorithm>
+#include "GLState.h"
+#include "ShaderReflection.h"
+
+IndirectRenderer::IndirectRenderer(const GeometryBuffer& geometry, uint32_t maxDraws)
+    : geometry(geometry), maxDraws(maxDraws) {
+    if (!supported()) return;
+
+    glGenVertexArrays(1, &VAO);
+    glGenVertexArrays(1, &depthVAO);
+    glGenBuffers(1, &drawIdBuffer);
+
+    // Instance i of a command reads drawIds[baseInstance + i]
+    std::vector<GLuint> drawIds(maxDraws);
+    for (uint32_t i = 0; i < maxDraws; ++i) drawIds[i] = i;
+    GLState& gl = GLState::instance();
+    gl.bindBuffer(GL_ARRAY_BUFFER, drawIdBuffer);
+    GL_CHECK(glBufferData(GL_ARRAY_BUFFER, drawIds.size() * sizeof(GLuint), drawIds.data(), GL_STATIC_DRAW));
+    GLDebug::label(GL_BUFFER, drawIdBuffer, "indirect draw ids");
+
+    // Full vertex stream for shading, packed positions for the depth pre-pass
+    for (GLuint vertexArray : {VAO, depthVAO}) {
+        gl.bindVertexArray(vertexArray);
+        if (vertexArray == VAO) geometry.setVertexAttributes();
+        else geometry.setPositionAttributes();
+        gl.bindBuffer(GL_ARRAY_BUFFER, drawIdBuffer);
+        glVertexAttribIPointer(13, 1, GL_UNSIGNED_INT, sizeof(GLuint), (void*)0);
+        glEnableVertexAttribArray(13);
+        glVertexAttribDivisor(13, 1);
+    }
+    gl.bindVertexArray(0);
+
+    // Room for a full frame of both, plus alignment padding between them
+    stream.reset(new RingBuffer(maxDraws * (sizeof(DrawElementsIndirectCommand) + sizeof(InstanceData)) + 1024));
+}
+
+IndirectRenderer::~IndirectRenderer() {
+    GLState& gl = GLState::instance();
+    gl.forgetVertexArray(VAO);
+    gl.forgetVertexArray(depthVAO);
+    gl.forgetBuffer(drawIdBuffer);
+    glDeleteVertexArrays(1, &VAO);
+    glDeleteVertexArrays(1, &depthVAO);
+    glDeleteBuffers(1, &drawIdBuffer);
+}
+
+void IndirectRenderer::clear() {
+    pending.clear();
+    pendingData.clear();
+}
+
+void IndirectRenderer::add(uint32_t bucket, uint32_t mesh, const InstanceData& data) {
+    if (pending.size() >= maxDraws) {
+        std::cerr << "IndirectRenderer: more than " << maxDraws << " draws, dropping the rest" << std::endl;
+        return;
+    }
+    pending.push_back({bucket, mesh});
+    pendingData.push_back(data);
+}
+
+void IndirectRenderer::upload() {
+    // Counting sort by bucket; draws keep their submission order inside a bucket
+    uint32_t bucketCount = 0;
+    for (const Pending& draw : pending)
+        bucketCount = std::max(bucketCount, draw.bucket + 1);
+    buckets.assign(bucketCount, BucketRange());
+    for (const Pending& draw : pending)
+        ++buckets[draw.bucket].count;
+    uint32_t running = 0;
+    for (BucketRange& bucket : buckets) {
+        bucket.first = running;
+        running += bucket.count;
+    }
+
+    commands.resize(pending.size());
+    drawData.resize(pending.size());
+    std::vector<uint32_t> cursor(bucketCount);
+    for (uint32_t b = 0; b < bucketCount; ++b) cursor[b] = buckets[b].first;
+    for (size_t i = 0; i < pending.size(); ++i) {
+        uint32_t slot = cursor[pending[i].bucket]++;
+        const MeshRange& range = geometry.range(pending[i].mesh);
+        commands[slot] = {range.indexCount, 1, range.firstIndex, range.baseVertex, slot};
+        drawData[slot] = pendingData[i];
+    }
+
+    commandSpace = drawDataSpace = RingBuffer::Allocation();
+    if (!supported() || commands.empty()) return;
+
+    stream->beginFrame();
+    commandSpace = stream->allocate(commands.size() * sizeof(DrawElementsIndirectCommand));
+    drawDataSpace = stream->allocate(drawData.size() * sizeof(InstanceData));
+    if (!commandSpace || !drawDataSpace) {
+        commandSpace = drawDataSpace = RingBuffer::Allocation();
+        return;
+    }
+    std::memcpy(commandSpace.cpu, commands.data(), commands.size() * sizeof(DrawElementsIndirectCommand));
+    std::memcpy(drawDataSpace.cpu, drawData.data(), drawData.size() * sizeof(InstanceData));
+    stream->flush();
+}
+
+void IndirectRenderer::draw(uint32_t bucket) const {
+    submit(VAO, bucket);
+}
+
+void IndirectRenderer::drawDepth(uint32_t bucket) const {
+    submit(depthVAO, bucket);
+}
+
+void IndirectRenderer::submit(GLuint vertexArray, uint32_t bucket) const {
+    if (!commandSpace || bucket >= buckets.size() || buckets[bucket].count == 0) return;
+
+    GLState& gl = GLState::instance();
+    gl.bindVertexArray(vertexArray);
+    gl.bindBuffer(GL_DRAW_INDIRECT_BUFFER, stream->buffer());
+    gl.bindBufferRange(GL_SHADER_STORAGE_BUFFER, glsl::storage::DrawBlock, stream->buffer(), drawDataSpace.offset,
+                       drawDataSpace.size);
+    gl.multiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT,
+                                 (void*)(commandSpace.offset + buckets[bucket].first * sizeof(DrawElementsIndirectCommand)),
+                                 (GLsizei)buckets[bucket].count);
+}
@@ -0,0 +1,195 @@
+#include "LightClusterer.h"
+#include <cmath>
+#include <chrono>
+#include <algorithm>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
+void LightClusterer::setProjection(const glm::mat4& projection, float nearZ, float farZ) {
+    if (projection == currentProjection && nearZ == nearPlane && farZ == farPlane) return;
+    currentProjection = projection;
+    nearPlane = nearZ;
+    farPlane = farZ;
+
+    // Exponential slices keep clusters roughly cube-shaped in view space
+    float logRange = std::log(farPlane / nearPlane);
+    sliceScale = CLUSTERS_Z / logRange;
+    sliceBias = -(float)CLUSTERS_Z * std::log(nearPlane) / logRange;
+
+    // Padding lanes get a box no sphere can reach
+    const size_t size = (size_t)CLUSTERS_Z * TILE_STRIDE;
+    for (std::vector<float>* column : {&minX, &minY, &minZ, &maxX, &maxY, &maxZ})
+        column->assign(size, 1e30f);
+
+    // View-space direction through each tile corner, scaled to depth 1
+    glm::mat4 inverse = glm::inverse(projection);
+    std::vector<glm::vec3> corners((CLUSTERS_X + 1) * (CLUSTERS_Y + 1));
+    for (unsigned y = 0; y <= CLUSTERS_Y; ++y) {
+        for (unsigned x = 0; x <= CLUSTERS_X; ++x) {
+            glm::vec4 ndc(-1.0f + 2.0f * x / CLUSTERS_X, -1.0f + 2.0f * y / CLUSTERS_Y, -1.0f, 1.0f);
+            glm::vec4 p = inverse * ndc;
+            glm::vec3 point = glm::vec3(p) / p.w;
+            corners[y * (CLUSTERS_X + 1) + x] = point / -point.z;
+        }
+    }
+
+    for (unsigned slice = 0; slice < CLUSTERS_Z; ++slice) {
+        float depthNear = nearPlane * std::pow(farPlane / nearPlane, (float)slice / CLUSTERS_Z);
+        float depthFar = nearPlane * std::pow(farPlane / nearPlane, (float)(slice + 1) / CLUSTERS_Z);
+        for (unsigned y = 0; y < CLUSTERS_Y; ++y) {
+            for (unsigned x = 0; x < CLUSTERS_X; ++x) {
+                glm::vec3 lo(1e30f), hi(-1e30f);
+                for (unsigned corner = 0; corner < 4; ++corner) {
+                    const glm::vec3& dir = corners[(y + corner / 2) * (CLUSTERS_X + 1) + x + corner % 2];
+                    for (float depth : {depthNear, depthFar}) {
+                        lo = glm::min(lo, dir * depth);
+                        hi = glm::max(hi, dir * depth);
+                    }
+                }
+                size_t i = (size_t)slice * TILE_STRIDE + y * CLUSTERS_X + x;
+                minX[i] = lo.x; minY[i] = lo.y; minZ[i] = lo.z;
+                maxX[i] = hi.x; maxY[i] = hi.y; maxZ[i] = hi.z;
+            }
+        }
+    }
+}
+
+unsigned LightClusterer::sliceOf(float viewDepth) const {
+    float slice = std::floor(std::log(std::max(viewDepth, nearPlane)) * sliceScale + sliceBias);
+    return (unsigned)std::min(std::max(slice, 0.0f), (float)(CLUSTERS_Z - 1));
+}
+
+void LightClusterer::clusterBounds(unsigned cluster, glm::vec3& min, glm::vec3& max) const {
+    size_t i = (size_t)(cluster / TILES_PER_SLICE) * TILE_STRIDE + cluster % TILES_PER_SLICE;
+    min = glm::vec3(minX[i], minY[i], minZ[i]);
+    max = glm::vec3(maxX[i], maxY[i], maxZ[i]);
+}
+
+void LightClusterer::assign(const std::vector<PointLight>& lights, const glm::mat4& view, JobPool& pool) {
+    auto start = std::chrono::steady_clock::now();
+
+    // Lights to view space, and the depth slices each one can touch
+    const size_t count = lights.size();
+    for (std::vector<float>* column : {&lightX, &lightY, &lightZ, &lightRadius})
+        column->resize(count);
+    firstSlice.resize(count);
+    lastSlice.resize(count);
+    for (size_t i = 0; i < count; ++i) {
+        glm::vec4 p = view * glm::vec4(lights[i].position, 1.0f);
+        float r = lights[i].radius;
+        lightX[i] = p.x;
+        lightY[i] = p.y;
+        lightZ[i] = p.z;
+        lightRadius[i] = r;
+
+        float depth = -p.z;
+        if (r <= 0.0f || depth + r < nearPlane || depth - r > farPlane) {
+            firstSlice[i] = 1;
+            lastSlice[i] = 0;
+            continue;
+        }
+        firstSlice[i] = (uint16_t)sliceOf(depth - r);
+        lastSlice[i] = (uint16_t)sliceOf(std::min(depth + r, farPlane));
+    }
+
+    scratch.resize((size_t)CLUSTER_COUNT * MAX_LIGHTS_PER_CLUSTER);
+    scratchCount.assign(CLUSTER_COUNT, 0);
+    pool.parallelFor(CLUSTERS_Z, 1, [this](size_t begin, size_t end, unsigned) {
+        for (size_t slice = begin; slice < end; ++slice)
+            assignSlice((unsigned)slice);
+    });
+
+    // Compact the fixed-size scratch lists into offset/count + one index list
+    Stats stats;
+    stats.lights = (unsigned int)count;
+    clusterGrid.resize(2 * (size_t)CLUSTER_COUNT);
+    lightIndices.clear();
+    for (unsigned cluster = 0; cluster < CLUSTER_COUNT; ++cluster) {
+        uint32_t found = scratchCount[cluster];
+        uint32_t stored = std::min<uint32_t>(found, MAX_LIGHTS_PER_CLUSTER);
+        const uint32_t* list = &scratch[(size_t)cluster * MAX_LIGHTS_PER_CLUSTER];
+        clusterGrid[2 * cluster] = (uint32_t)lightIndices.size();
+        clusterGrid[2 * cluster + 1] = stored;
+        lightIndices.insert(lightIndices.end(), list, list + stored);
+
+        stats.references += stored;
+        stats.occupiedClusters += stored > 0;
+        stats.overflowedClusters += found > stored;
+        stats.maxLightsPerCluster = std::max(stats.maxLightsPerCluster, found);
+    }
+    if (stats.occupiedClusters > 0)
+        stats.averageLightsPerCluster = (float)stats.references / stats.occupiedClusters;
+
+    std::vector<uint8_t> seen(count, 0);
+    for (uint32_t light : lightIndices) seen[light] = 1;
+    for (uint8_t s : seen) stats.visibleLights += s;
+
+    auto end = std::chrono::steady_clock::now();
+    stats.assignMs = std::chrono::duration<float, std::milli>(end - start).count();
+    lastStats = stats;
+}
+
+void LightClusterer::assignSlice(unsigned slice) {
+    const size_t base = (size_t)slice * TILE_STRIDE;
+    const float* bx0 = &minX[base]; const float* by0 = &minY[base]; const float* bz0 = &minZ[base];
+    const float* bx1 = &maxX[base]; const float* by1 = &maxY[base]; const float* bz1 = &maxZ[base];
+    uint32_t* counts = &scratchCount[(size_t)slice * TILES_PER_SLICE];
+    uint32_t* lists = &scratch[(size_t)slice * TILES_PER_SLICE * MAX_LIGHTS_PER_CLUSTER];
+
+    auto append = [&](unsigned tile, uint32_t light) {
+        uint32_t n = counts[tile]++;
+        if (n < MAX_LIGHTS_PER_CLUSTER)
+            lists[(size_t)tile * MAX_LIGHTS_PER_CLUSTER + n] = light;
+    };
+
+    const size_t count = lightX.size();
+    for (size_t light = 0; light < count; ++light) {
+        if (slice < firstSlice[light] || slice > lastSlice[light]) continue;
+        const float cx = lightX[light], cy = lightY[light], cz = lightZ[light];
+        const float radiusSq = lightRadius[light] * lightRadius[light];
+
+        // Sphere/box overlap: squared distance from the centre to the box
+#if defined(__AVX__)
+        const __m256 x = _mm256_set1_ps(cx), y = _mm256_set1_ps(cy), z = _mm256_set1_ps(cz);
+        const __m256 r2 = _mm256_set1_ps(radiusSq), zero = _mm256_setzero_ps();
+        for (unsigned t = 0; t < TILE_STRIDE; t += 8) {
+            __m256 dx = _mm256_add_ps(_mm256_max_ps(_mm256_sub_ps(_mm256_loadu_ps(bx0 + t), x), zero),
+                                      _mm256_max_ps(_mm256_sub_ps(x, _mm256_loadu_ps(bx1 + t)), zero));
+            __m256 dy = _mm256_add_ps(_mm256_max_ps(_mm256_sub_ps(_mm256_loadu_ps(by0 + t), y), zero),
+                                      _mm256_max_ps(_mm256_sub_ps(y, _mm256_loadu_ps(by1 + t)), zero));
+            __m256 dz = _mm256_add_ps(_mm256_max_ps(_mm256_sub_ps(_mm256_loadu_ps(bz0 + t), z), zero),
+                                      _mm256_max_ps(_mm256_sub_ps(z, _mm256_loadu_ps(bz1 + t)), zero));
+            __m256 d2 = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy)), _mm256_mul_ps(dz, dz));
+            int mask = _mm256_movemask_ps(_mm256_cmp_ps(d2, r2, _CMP_LE_OQ));
+            for (int k = 0; k < 8; ++k)
+                if (((mask >> k) & 1) && t + k < TILES_PER_SLICE) append(t + k, (uint32_t)light);
+        }
+#elif defined(__SSE2__) || defined(_M_X64)
+        const __m128 x = _mm_set1_ps(cx), y = _mm_set1_ps(cy), z = _mm_set1_ps(cz);
+        const __m128 r2 = _mm_set1_ps(radiusSq), zero = _mm_setzero_ps();
+        for (unsigned t = 0; t < TILE_STRIDE; t += 4) {
+            __m128 dx = _mm_add_ps(_mm_max_ps(_mm_sub_ps(_mm_loadu_ps(bx0 + t), x), zero),
+                                   _mm_max_ps(_mm_sub_ps(x, _mm_loadu_ps(bx1 + t)), zero));
+            __m128 dy = _mm_add_ps(_mm_max_ps(_mm_sub_ps(_mm_loadu_ps(by0 + t), y), zero),
+                                   _mm_max_ps(_mm_sub_ps(y, _mm_loadu_ps(by1 + t)), zero));
+            __m128 dz = _mm_add_ps(_mm_max_ps(_mm_sub_ps(_mm_loadu_ps(bz0 + t), z), zero),
+                                   _mm_max_ps(_mm_sub_ps(z, _mm_loadu_ps(bz1 + t)), zero));
+            __m128 d2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+            int mask = _mm_movemask_ps(_mm_cmple_ps(d2, r2));
+            for (int k = 0; k < 4; ++k)
+                if (((mask >> k) & 1) && t + k < TILES_PER_SLICE) append(t + k, (uint32_t)light);
+        }
+#else
+        for (unsigned t = 0; t < TILES_PER_SLICE; ++t) {
+            float dx = std::max(bx0[t] - cx, 0.0f) + std::max(cx - bx1[t], 0.0f);
+            float dy = std::max(by0[t] - cy, 0.0f) + std::max(cy - by1[t], 0.0f);
+            float dz = std::max(bz0[t] - cz, 0.0f) + std::max(cz - bz1[t], 0.0f);
+            if (dx * dx + dy * dy + dz * dz <= radiusSq) append(t, (uint32_t)light);
+        }
+#endif
+    }
+}
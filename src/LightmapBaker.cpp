@@ -0,0 +1,602 @@
+#include "LightmapBaker.h"
+#include <map>
+#include <cmath>
+#include <cfloat>
+#include <chrono>
+#include <fstream>
+#include <numeric>
+#include <algorithm>
+#include "NormalMatrix.h"
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+float millisecondsSince(Clock::time_point start) {
+    return std::chrono::duration<float, std::milli>(Clock::now() - start).count();
+}
+
+// Per-texel random sequence: a hashed seed, then xorshift
+uint32_t hash(uint32_t x) {
+    x ^= x >> 16;
+    x *= 0x7feb352dU;
+    x ^= x >> 15;
+    x *= 0x846ca68bU;
+    x ^= x >> 16;
+    return x ? x : 1u;
+}
+
+struct Random {
+    uint32_t state;
+
+    float next() {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return (state >> 8) * (1.0f / 16777216.0f);
+    }
+};
+
+// Cosine-weighted direction around `normal` (its pdf cancels the N.L of a diffuse bounce)
+glm::vec3 cosineSample(const glm::vec3& normal, Random& random) {
+    float phi = 6.28318531f * random.next();
+    float r2 = random.next();
+    float r = std::sqrt(r2);
+    // Orthonormal basis without branches on the axis (Duff et al.)
+    float sign = std::copysign(1.0f, normal.z);
+    float a = -1.0f / (sign + normal.z);
+    float b = normal.x * normal.y * a;
+    glm::vec3 tangent(1.0f + sign * normal.x * normal.x * a, sign * b, -sign * normal.x);
+    glm::vec3 bitangent(b, sign + normal.y * normal.y * a, -normal.y);
+    return tangent * (r * std::cos(phi)) + bitangent * (r * std::sin(phi)) + normal * std::sqrt(1.0f - r2);
+}
+
+// Chart adjacency: triangles meet when an edge has the same (quantized) endpoints
+struct EdgeKey {
+    int32_t a[3], b[3];
+
+    bool operator<(const EdgeKey& other) const {
+        for (int i = 0; i < 3; ++i)
+            if (a[i] != other.a[i]) return a[i] < other.a[i];
+        for (int i = 0; i < 3; ++i)
+            if (b[i] != other.b[i]) return b[i] < other.b[i];
+        return false;
+    }
+};
+
+EdgeKey edgeKey(const glm::vec3& p, const glm::vec3& q) {
+    int32_t a[3], b[3];
+    for (int i = 0; i < 3; ++i) {
+        a[i] = (int32_t)std::lround(p[i] * 1e4f);
+        b[i] = (int32_t)std::lround(q[i] * 1e4f);
+    }
+    EdgeKey key;
+    bool swap = std::lexicographical_compare(b, b + 3, a, a + 3);
+    std::copy(swap ? b : a, (swap ? b : a) + 3, key.a);
+    std::copy(swap ? a : b, (swap ? a : b) + 3, key.b);
+    return key;
+}
+
+// Barycentrics of `p` in the 2D triangle (a, b, c); weights of b and c
+bool barycentric2D(const glm::vec2& a, const glm::vec2& b, const glm::vec2& c, const glm::vec2& p,
+                   glm::vec2& weights) {
+    float area = (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+    if (std::fabs(area) < 1e-12f) return false;
+    weights.x = ((p.x - a.x) * (c.y - a.y) - (p.y - a.y) * (c.x - a.x)) / area;
+    weights.y = ((b.x - a.x) * (p.y - a.y) - (b.y - a.y) * (p.x - a.x)) / area;
+    return true;
+}
+
+void writeU32(std::ofstream& file, uint32_t value) {
+    file.write((const char*)&value, sizeof(value));
+}
+
+uint32_t readU32(std::ifstream& file) {
+    uint32_t value = 0;
+    file.read((char*)&value, sizeof(value));
+    return value;
+}
+
+} // namespace
+
+uint32_t packRGB9E5(const glm::vec3& rgb) {
+    // EXT_texture_shared_exponent: N = 9 mantissa bits, exponent bias B = 15
+    const float maxValue = 511.0f / 512.0f * 65536.0f;
+    glm::vec3 c = glm::clamp(rgb, 0.0f, maxValue);
+    float maxComponent = std::max(c.x, std::max(c.y, c.z));
+    if (maxComponent <= 0.0f) return 0;
+    int exponent = std::max(-16, (int)std::floor(std::log2(maxComponent))) + 16;
+    float denominator = std::ldexp(1.0f, exponent - 24);
+    if ((int)std::floor(maxComponent / denominator + 0.5f) == 512) {
+        denominator *= 2.0f;
+        ++exponent;
+    }
+    uint32_t r = (uint32_t)std::floor(c.x / denominator + 0.5f);
+    uint32_t g = (uint32_t)std::floor(c.y / denominator + 0.5f);
+    uint32_t b = (uint32_t)std::floor(c.z / denominator + 0.5f);
+    return r | g << 9 | b << 18 | (uint32_t)exponent << 27;
+}
+
+glm::vec3 unpackRGB9E5(uint32_t packed) {
+    float scale = std::ldexp(1.0f, (int)(packed >> 27) - 24);
+    return glm::vec3((float)(packed & 0x1FF), (float)(packed >> 9 & 0x1FF), (float)(packed >> 18 & 0x1FF)) * scale;
+}
+
+bool LightmapImage::write(const std::string& path) const {
+    std::ofstream file(path, std::ios::binary);
+    if (!file.is_open()) return false;
+    file.write("LMAP", 4);
+    writeU32(file, VERSION);
+    writeU32(file, (uint32_t)width);
+    writeU32(file, (uint32_t)height);
+    writeU32(file, charts);
+    file.write((const char*)irradiance.data(), (std::streamsize)(irradiance.size() * sizeof(uint32_t)));
+    file.write((const char*)occlusion.data(), (std::streamsize)occlusion.size());
+    return file.good();
+}
+
+bool LightmapImage::read(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) return false;
+    char magic[4] = {};
+    file.read(magic, 4);
+    if (std::string(magic, 4) != "LMAP" || readU32(file) != VERSION) return false;
+    width = (int)readU32(file);
+    height = (int)readU32(file);
+    charts = readU32(file);
+    if (!file || width <= 0 || height <= 0 || width > 16384 || height > 16384) return false;
+    size_t count = (size_t)width * height;
+    irradiance.resize(count);
+    occlusion.resize(count);
+    file.read((char*)irradiance.data(), (std::streamsize)(count * sizeof(uint32_t)));
+    file.read((char*)occlusion.data(), (std::streamsize)count);
+    return (bool)file;
+}
+
+uint32_t LightmapBaker::addObject(const std::vector<float>& vertices, const std::vector<uint32_t>& indices,
+                                  const glm::mat4& model, const glm::vec3& albedo) {
+    objects.push_back({vertices, indices, model, albedo, Unwrapped()});
+    return (uint32_t)(objects.size() - 1);
+}
+
+void LightmapBaker::buildAtlas() {
+    Clock::time_point start = Clock::now();
+    buildTriangles();
+    buildCharts();
+    // Shrink the density until the shelves fit
+    float texelsPerUnit = settings.texelsPerUnit;
+    while (!packCharts(texelsPerUnit) && texelsPerUnit > 1e-3f) texelsPerUnit *= 0.8f;
+    unwrapObjects();
+    placeTexels();
+
+    lastStats.charts = (unsigned)charts.size();
+    lastStats.texelsPerUnit = scale;
+    lastStats.texels = 0;
+    for (const Texel& texel : texels)
+        if (texel.triangle >= 0) ++lastStats.texels;
+    lastStats.atlasMs = millisecondsSince(start);
+}
+
+void LightmapBaker::buildTriangles() {
+    triangles.clear();
+    for (uint32_t object = 0; object < objects.size(); ++object) {
+        const Object& o = objects[object];
+        glm::mat3 normals = normalMatrix(o.model);
+        for (uint32_t first = 0; first + 2 < o.indices.size(); first += 3) {
+            glm::vec3 p[3], n[3];
+            for (int k = 0; k < 3; ++k) {
+                const float* v = &o.vertices[(size_t)o.indices[first + k] * VERTEX_FLOATS];
+                p[k] = glm::vec3(o.model * glm::vec4(v[0], v[1], v[2], 1.0f));
+                n[k] = normals * glm::vec3(v[3], v[4], v[5]);
+                float length = glm::length(n[k]);
+                n[k] = length > 0.0f ? n[k] / length : glm::vec3(0.0f, 1.0f, 0.0f);
+            }
+            Triangle tri;
+            tri.p0 = p[0];
+            tri.edge1 = p[1] - p[0];
+            tri.edge2 = p[2] - p[0];
+            glm::vec3 cross = glm::cross(tri.edge1, tri.edge2);
+            float length = glm::length(cross);
+            tri.faceNormal = length > 1e-12f ? cross / length : glm::vec3(0.0f);
+            for (int k = 0; k < 3; ++k) tri.normal[k] = n[k];
+            tri.object = object;
+            tri.firstIndex = first;
+            triangles.push_back(tri);
+        }
+    }
+}
+
+void LightmapBaker::buildCharts() {
+    charts.clear();
+
+    // Edges of every triangle, sorted so shared edges are neighbours
+    struct Edge {
+        EdgeKey key;
+        uint32_t triangle;
+    };
+    std::vector<Edge> edges;
+    edges.reserve(triangles.size() * 3);
+    for (uint32_t t = 0; t < triangles.size(); ++t) {
+        const Triangle& tri = triangles[t];
+        if (tri.faceNormal == glm::vec3(0.0f)) continue;
+        glm::vec3 p[3] = {tri.p0, tri.p0 + tri.edge1, tri.p0 + tri.edge2};
+        for (int k = 0; k < 3; ++k) edges.push_back({edgeKey(p[k], p[(k + 1) % 3]), t});
+    }
+    std::sort(edges.begin(), edges.end(), [](const Edge& a, const Edge& b) {
+        if (a.key < b.key) return true;
+        if (b.key < a.key) return false;
+        return a.triangle < b.triangle;
+    });
+    std::vector<std::vector<uint32_t>> neighbours(triangles.size());
+    for (size_t i = 0; i < edges.size();) {
+        size_t end = i + 1;
+        while (end < edges.size() && !(edges[i].key < edges[end].key)) ++end;
+        for (size_t a = i; a < end; ++a)
+            for (size_t b = i; b < end; ++b)
+                if (a != b && triangles[edges[a].triangle].object == triangles[edges[b].triangle].object)
+                    neighbours[edges[a].triangle].push_back(edges[b].triangle);
+        i = end;
+    }
+
+    // Grow charts from the first unassigned triangle, breadth first
+    float minDot = std::cos(glm::radians(settings.chartAngle));
+    std::vector<int32_t> chartOf(triangles.size(), -1);
+    std::vector<uint32_t> queue;
+    for (uint32_t seed = 0; seed < triangles.size(); ++seed) {
+        const Triangle& first = triangles[seed];
+        if (chartOf[seed] >= 0 || first.faceNormal == glm::vec3(0.0f)) continue;
+        Chart chart;
+        chart.object = first.object;
+        // u along the longest edge of the seed, in its plane
+        glm::vec3 edge3 = first.edge2 - first.edge1;
+        glm::vec3 longest = first.edge1;
+        if (glm::dot(first.edge2, first.edge2) > glm::dot(longest, longest)) longest = first.edge2;
+        if (glm::dot(edge3, edge3) > glm::dot(longest, longest)) longest = edge3;
+        chart.axisU = glm::normalize(longest - first.faceNormal * glm::dot(longest, first.faceNormal));
+        chart.axisV = glm::cross(first.faceNormal, chart.axisU);
+
+        int32_t index = (int32_t)charts.size();
+        queue.assign(1, seed);
+        chartOf[seed] = index;
+        for (size_t head = 0; head < queue.size(); ++head) {
+            uint32_t t = queue[head];
+            chart.triangles.push_back(t);
+            for (uint32_t n : neighbours[t]) {
+                if (chartOf[n] >= 0 || glm::dot(triangles[n].faceNormal, first.faceNormal) < minDot) continue;
+                chartOf[n] = index;
+                queue.push_back(n);
+            }
+        }
+        std::sort(chart.triangles.begin(), chart.triangles.end());
+        charts.push_back(std::move(chart));
+    }
+}
+
+glm::vec2 LightmapBaker::project(const Chart& chart, const glm::vec3& p) const {
+    return glm::vec2(glm::dot(p, chart.axisU), glm::dot(p, chart.axisV)) * scale + chart.offset;
+}
+
+bool LightmapBaker::packCharts(float texelsPerUnit) {
+    scale = texelsPerUnit;
+    int widest = 0;
+    double area = 0.0;
+    for (Chart& chart : charts) {
+        chart.offset = glm::vec2(0.0f);
+        glm::vec2 low(FLT_MAX), high(-FLT_MAX);
+        for (uint32_t t : chart.triangles) {
+            const Triangle& tri = triangles[t];
+            for (const glm::vec3& p : {tri.p0, tri.p0 + tri.edge1, tri.p0 + tri.edge2}) {
+                glm::vec2 q = project(chart, p);
+                low = glm::min(low, q);
+                high = glm::max(high, q);
+            }
+        }
+        // Geometry starts one texel in; the border texels around it stay in the rect
+        chart.offset = glm::vec2(1.0f) - low;
+        chart.width = (int)std::ceil(high.x - low.x) + 2;
+        chart.height = (int)std::ceil(high.y - low.y) + 2;
+        widest = std::max(widest, chart.width);
+        area += (double)chart.width * chart.height;
+    }
+
+    atlasWidth = std::max(std::max(4, widest), ((int)std::ceil(std::sqrt(area) * 1.1) + 3) / 4 * 4);
+    if (atlasWidth > settings.maxSize) return false;
+
+    // Shelves, tallest charts first
+    std::vector<uint32_t> order(charts.size());
+    std::iota(order.begin(), order.end(), 0u);
+    std::stable_sort(order.begin(), order.end(),
+                     [&](uint32_t a, uint32_t b) { return charts[a].height > charts[b].height; });
+    int x = 0, y = 0, shelfHeight = 0;
+    for (uint32_t c : order) {
+        Chart& chart = charts[c];
+        if (x + chart.width > atlasWidth) {
+            x = 0;
+            y += shelfHeight;
+            shelfHeight = 0;
+        }
+        chart.x = x;
+        chart.y = y;
+        chart.offset += glm::vec2((float)x, (float)y);
+        x += chart.width;
+        shelfHeight = std::max(shelfHeight, chart.height);
+    }
+    atlasHeight = std::max(1, (y + shelfHeight + 3) / 4 * 4);
+    return atlasHeight <= settings.maxSize;
+}
+
+void LightmapBaker::unwrapObjects() {
+    std::vector<int32_t> chartOf(triangles.size(), -1);
+    for (size_t c = 0; c < charts.size(); ++c)
+        for (uint32_t t : charts[c].triangles) chartOf[t] = (int32_t)c;
+
+    glm::vec2 atlasSize((float)atlasWidth, (float)atlasHeight);
+    size_t t = 0;
+    for (Object& object : objects) {
+        Unwrapped& out = object.unwrapped;
+        out.vertices.clear();
+        out.indices.clear();
+        // A vertex is split once per chart that uses it
+        std::map<std::pair<int32_t, uint32_t>, uint32_t> remap;
+        for (uint32_t first = 0; first + 2 < object.indices.size(); first += 3, ++t) {
+            const Triangle& tri = triangles[t];
+            glm::vec3 p[3] = {tri.p0, tri.p0 + tri.edge1, tri.p0 + tri.edge2};
+            for (int k = 0; k < 3; ++k) {
+                uint32_t vertex = object.indices[first + k];
+                std::pair<int32_t, uint32_t> key(chartOf[t], vertex);
+                auto found = remap.find(key);
+                if (found == remap.end()) {
+                    // Degenerate triangles cover no pixel; their uv does not matter
+                    glm::vec2 uv = chartOf[t] >= 0 ? project(charts[chartOf[t]], p[k]) / atlasSize : glm::vec2(0.0f);
+                    const float* v = &object.vertices[(size_t)vertex * VERTEX_FLOATS];
+                    out.vertices.insert(out.vertices.end(), v, v + VERTEX_FLOATS);
+                    out.vertices.push_back(uv.x);
+                    out.vertices.push_back(uv.y);
+                    found = remap.emplace(key, (uint32_t)(out.vertices.size() / UNWRAPPED_FLOATS - 1)).first;
+                }
+                out.indices.push_back(found->second);
+            }
+        }
+    }
+}
+
+void LightmapBaker::placeTexels() {
+    texels.assign((size_t)atlasWidth * atlasHeight, Texel());
+
+    // Position and normal at the barycentric (w1, w2) of a triangle
+    auto setTexel = [&](Texel& texel, uint32_t t, glm::vec2 w) {
+        const Triangle& tri = triangles[t];
+        texel.triangle = (int32_t)t;
+        texel.position = tri.p0 + tri.edge1 * w.x + tri.edge2 * w.y;
+        glm::vec3 normal = tri.normal[0] * (1.0f - w.x - w.y) + tri.normal[1] * w.x + tri.normal[2] * w.y;
+        float length = glm::length(normal);
+        texel.normal = length > 1e-6f ? normal / length : tri.faceNormal;
+    };
+    // Closest point in the triangle, approximately: clamped barycentrics
+    auto clampWeights = [](glm::vec2 w) {
+        glm::vec3 full(1.0f - w.x - w.y, w.x, w.y);
+        full = glm::max(full, glm::vec3(0.0f));
+        full /= full.x + full.y + full.z;
+        return glm::vec2(full.y, full.z);
+    };
+
+    std::vector<glm::vec2> corners;
+    std::vector<std::pair<size_t, uint32_t>> adopted;
+    for (const Chart& chart : charts) {
+        // Texel centres inside a triangle
+        bool anyCovered = false;
+        for (uint32_t t : chart.triangles) {
+            const Triangle& tri = triangles[t];
+            glm::vec2 a = project(chart, tri.p0), b = project(chart, tri.p0 + tri.edge1),
+                      c = project(chart, tri.p0 + tri.edge2);
+            glm::vec2 low = glm::min(a, glm::min(b, c)), high = glm::max(a, glm::max(b, c));
+            int x0 = std::max(chart.x, (int)std::floor(low.x)), x1 = std::min(chart.x + chart.width - 1, (int)high.x);
+            int y0 = std::max(chart.y, (int)std::floor(low.y)), y1 = std::min(chart.y + chart.height - 1, (int)high.y);
+            for (int y = y0; y <= y1; ++y) {
+                for (int x = x0; x <= x1; ++x) {
+                    Texel& texel = texels[(size_t)y * atlasWidth + x];
+                    glm::vec2 w;
+                    if (texel.triangle >= 0 || !barycentric2D(a, b, c, glm::vec2(x + 0.5f, y + 0.5f), w)) continue;
+                    if (w.x < -1e-5f || w.y < -1e-5f || w.x + w.y > 1.0f + 1e-5f) continue;
+                    setTexel(texel, t, w);
+                    anyCovered = true;
+                }
+            }
+        }
+
+        // Border and uncovered texels take the triangle of a covered neighbour,
+        // one ring per pass; a chart too thin to cover any centre uses its first
+        auto adopt = [&](size_t index, int x, int y, uint32_t t) {
+            const Triangle& tri = triangles[t];
+            glm::vec2 w;
+            if (!barycentric2D(project(chart, tri.p0), project(chart, tri.p0 + tri.edge1),
+                               project(chart, tri.p0 + tri.edge2), glm::vec2(x + 0.5f, y + 0.5f), w))
+                w = glm::vec2(1.0f / 3.0f);
+            adopted.push_back({index, t});
+            corners.push_back(clampWeights(w));
+        };
+        bool changed = true;
+        while (changed) {
+            changed = false;
+            adopted.clear();
+            corners.clear();
+            for (int y = chart.y; y < chart.y + chart.height; ++y) {
+                for (int x = chart.x; x < chart.x + chart.width; ++x) {
+                    size_t index = (size_t)y * atlasWidth + x;
+                    if (texels[index].triangle >= 0) continue;
+                    if (!anyCovered) {
+                        adopt(index, x, y, chart.triangles[0]);
+                        continue;
+                    }
+                    int32_t neighbour = -1;
+                    for (int dy = -1; dy <= 1 && neighbour < 0; ++dy) {
+                        for (int dx = -1; dx <= 1 && neighbour < 0; ++dx) {
+                            int nx = x + dx, ny = y + dy;
+                            if (nx < chart.x || ny < chart.y || nx >= chart.x + chart.width || ny >= chart.y + chart.height)
+                                continue;
+                            neighbour = texels[(size_t)ny * atlasWidth + nx].triangle;
+                        }
+                    }
+                    if (neighbour >= 0) adopt(index, x, y, (uint32_t)neighbour);
+                }
+            }
+            for (size_t i = 0; i < adopted.size(); ++i) setTexel(texels[adopted[i].first], adopted[i].second, corners[i]);
+            changed = !adopted.empty();
+        }
+    }
+}
+
+// Moller-Trumbore, both faces
+float LightmapBaker::hitDistance(uint32_t triangle, const glm::vec3& origin, const glm::vec3& direction,
+                                 float maxDistance) const {
+    const Triangle& tri = triangles[triangle];
+    glm::vec3 p = glm::cross(direction, tri.edge2);
+    float det = glm::dot(tri.edge1, p);
+    if (std::fabs(det) < 1e-12f) return -1.0f;
+    float invDet = 1.0f / det;
+    glm::vec3 s = origin - tri.p0;
+    float u = glm::dot(s, p) * invDet;
+    if (u < 0.0f || u > 1.0f) return -1.0f;
+    glm::vec3 q = glm::cross(s, tri.edge1);
+    float v = glm::dot(direction, q) * invDet;
+    if (v < 0.0f || u + v > 1.0f) return -1.0f;
+    float t = glm::dot(tri.edge2, q) * invDet;
+    return t > 0.0f && t <= maxDistance ? t : -1.0f;
+}
+
+bool LightmapBaker::intersect(const glm::vec3& origin, const glm::vec3& direction, float maxDistance,
+                              uint32_t& triangle, float& distance, glm::vec2& barycentric) const {
+    auto test = [&](uint32_t object, float best) { return hitDistance(traced[object], origin, direction, best); };
+    BVH::RayHit hit;
+    if (!bvh.raycast(origin, direction, maxDistance, test, hit)) return false;
+
+    const Triangle& tri = triangles[traced[hit.object]];
+    triangle = traced[hit.object];
+    distance = hit.distance;
+    glm::vec3 p = glm::cross(direction, tri.edge2);
+    float invDet = 1.0f / glm::dot(tri.edge1, p);
+    glm::vec3 s = origin - tri.p0;
+    barycentric = glm::vec2(glm::dot(s, p) * invDet, glm::dot(direction, glm::cross(s, tri.edge1)) * invDet);
+    return true;
+}
+
+bool LightmapBaker::occluded(const glm::vec3& origin, const glm::vec3& direction, float distance) const {
+    auto test = [&](uint32_t object, float best) { return hitDistance(traced[object], origin, direction, best); };
+    BVH::RayHit hit;
+    return bvh.raycast(origin, direction, distance, test, hit, true);
+}
+
+glm::vec3 LightmapBaker::directLight(const glm::vec3& position, const glm::vec3& normal, float occlusion,
+                                     uint64_t& rays) const {
+    glm::vec3 result(0.0f);
+    for (const PointLight& light : *bakeLights) {
+        glm::vec3 toLight = light.position - position;
+        float distance = glm::length(toLight);
+        if (distance >= light.radius) continue;
+        glm::vec3 lightColor = light.color * light.intensity * lightFalloff(distance, light.radius);
+        result += 0.1f * occlusion * lightColor;
+
+        glm::vec3 lightDir = toLight / std::max(distance, 1e-4f);
+        float diff = glm::dot(normal, lightDir);
+        if (diff <= 0.0f) continue;
+        ++rays;
+        if (!occluded(position, lightDir, distance - rayBias)) result += diff * lightColor;
+    }
+    return result;
+}
+
+void LightmapBaker::bakeTexel(size_t index, uint64_t& rays) {
+    const Texel& texel = texels[index];
+    if (texel.triangle < 0) return;
+
+    Random random = {hash((uint32_t)index * 0x9E3779B9u ^ hash(settings.seed))};
+    glm::vec3 normal = texel.normal;
+    // Offset off the surface along the geometric normal, on the shading normal's side
+    glm::vec3 face = triangles[texel.triangle].faceNormal;
+    if (glm::dot(face, normal) < 0.0f) face = -face;
+    glm::vec3 origin = texel.position + face * rayBias;
+
+    unsigned occludedRays = 0;
+    glm::vec3 indirect(0.0f);
+    for (int sample = 0; sample < settings.samples; ++sample) {
+        glm::vec3 from = origin, direction = cosineSample(normal, random);
+        glm::vec3 throughput(1.0f);
+        for (int bounce = 0; bounce <= settings.bounces; ++bounce) {
+            uint32_t t;
+            float distance;
+            glm::vec2 w;
+            ++rays;
+            if (!intersect(from, direction, FLT_MAX, t, distance, w)) break;
+            if (bounce == 0 && distance < settings.aoDistance) ++occludedRays;
+            if (bounce == settings.bounces) break;
+
+            // Diffuse bounce: light reaching the hit point, reflected with its albedo
+            const Triangle& tri = triangles[t];
+            glm::vec3 hitNormal =
+                glm::normalize(tri.normal[0] * (1.0f - w.x - w.y) + tri.normal[1] * w.x + tri.normal[2] * w.y);
+            glm::vec3 hitFace = tri.faceNormal;
+            if (glm::dot(hitFace, direction) > 0.0f) hitFace = -hitFace;
+            if (glm::dot(hitNormal, hitFace) < 0.0f) hitNormal = -hitNormal;
+            glm::vec3 hitPosition = from + direction * distance + hitFace * rayBias;
+            throughput *= objects[tri.object].albedo;
+            indirect += throughput * directLight(hitPosition, hitNormal, 1.0f, rays);
+            from = hitPosition;
+            direction = cosineSample(hitNormal, random);
+        }
+    }
+
+    float occlusion = settings.samples > 0 ? 1.0f - (float)occludedRays / settings.samples : 1.0f;
+    texelOcclusion[index] = occlusion;
+    texelIrradiance[index] =
+        directLight(origin, normal, occlusion, rays) + (settings.samples > 0 ? indirect / (float)settings.samples
+                                                                               : glm::vec3(0.0f));
+}
+
+void LightmapBaker::bake(const std::vector<PointLight>& lights, JobPool& pool) {
+    Clock::time_point start = Clock::now();
+    bakeLights = &lights;
+
+    // Only triangles with an area are traced
+    std::vector<AABB> bounds;
+    traced.clear();
+    AABB scene = {glm::vec3(FLT_MAX), glm::vec3(-FLT_MAX)};
+    for (uint32_t t = 0; t < triangles.size(); ++t) {
+        const Triangle& tri = triangles[t];
+        if (tri.faceNormal == glm::vec3(0.0f)) continue;
+        AABB box = {tri.p0, tri.p0};
+        box.expand(tri.p0 + tri.edge1);
+        box.expand(tri.p0 + tri.edge2);
+        bounds.push_back(box);
+        scene.expand(box);
+        traced.push_back(t);
+    }
+    bvh.build(bounds);
+    rayBias = traced.empty() ? 1e-4f : std::max(1e-5f, glm::length(scene.max - scene.min) * 1e-5f);
+
+    texelIrradiance.assign(texels.size(), glm::vec3(0.0f));
+    texelOcclusion.assign(texels.size(), 1.0f);
+    std::vector<uint64_t> rays(pool.size(), 0);
+    // One row per job: rows differ a lot in cost, the pool hands them out as threads free up
+    pool.parallelFor((size_t)atlasHeight, 1, [&](size_t begin, size_t end, unsigned worker) {
+        for (size_t y = begin; y < end; ++y)
+            for (int x = 0; x < atlasWidth; ++x) bakeTexel(y * atlasWidth + x, rays[worker]);
+    });
+
+    lastStats.rays = 0;
+    for (uint64_t count : rays) lastStats.rays += count;
+    lastStats.bakeMs = millisecondsSince(start);
+}
+
+LightmapImage LightmapBaker::cook() const {
+    LightmapImage image;
+    image.width = atlasWidth;
+    image.height = atlasHeight;
+    image.charts = (uint32_t)charts.size();
+    image.irradiance.resize(texelIrradiance.size());
+    image.occlusion.resize(texelOcclusion.size());
+    for (size_t i = 0; i < texelIrradiance.size(); ++i) {
+        image.irradiance[i] = packRGB9E5(texelIrradiance[i]);
+        image.occlusion[i] = (uint8_t)(glm::clamp(texelOcclusion[i], 0.0f, 1.0f) * 255.0f + 0.5f);
+    }
+    return image;
+}
@@ -1,5 +1,6 @@
 #include "Mesh.h"
 #include <glad/glad.h>
+#include "GLState.h"
 
 Mesh::Mesh(std::vector<Vertex> vertices, std::vector<unsigned int> indices)
     : vertices(vertices), indices(indices) {
@@ -7,17 +8,23 @@ Mesh::Mesh(std::vector<Vertex> vertices, std::vector<unsigned int> indices)
 }
 
 void Mesh::setupMesh() {
+    computeBounds(reinterpret_cast<const float*>(vertices.data()), vertices.size(), sizeof(Vertex) / sizeof(float), bounds, boundingSphere);
+
     glGenVertexArrays(1, &VAO);
     glGenBuffers(1, &VBO);
     glGenBuffers(1, &EBO);
 
-    glBindVertexArray(VAO);
+    GLState& gl = GLState::instance();
+    gl.bindVertexArray(VAO);
 
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), vertices.data(), GL_STATIC_DRAW);
+    gl.bindBuffer(GL_ARRAY_BUFFER, VBO);
+    GL_CHECK(glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), vertices.data(), GL_STATIC_DRAW));
 
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
+    gl.bindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+    GL_CHECK(glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(),
+                          GL_STATIC_DRAW));
+    GLDebug::label(GL_BUFFER, VBO, "mesh vertices");
+    GLDebug::label(GL_BUFFER, EBO, "mesh indices");
 
     // Position attribute
     glEnableVertexAttribArray(0);
@@ -31,11 +38,19 @@ void Mesh::setupMesh() {
     glEnableVertexAttribArray(2);
     glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, TexCoords));
 
-    glBindVertexArray(0);
+    gl.bindVertexArray(0);
+
+    depthStream.create(reinterpret_cast<const float*>(vertices.data()), vertices.size(), sizeof(Vertex) / sizeof(float), EBO);
 }
 
 void Mesh::Draw(const Shader& shader) const {
-    glBindVertexArray(VAO);
-    glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, 0);
-    glBindVertexArray(0);
+    GLState& gl = GLState::instance();
+    gl.bindVertexArray(VAO);
+    gl.drawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, 0);
+}
+
+void Mesh::DrawDepth() const {
+    GLState& gl = GLState::instance();
+    gl.bindVertexArray(depthStream.VAO);
+    gl.drawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, 0);
 }
\ No newline at end of file
@@ -9,6 +9,11 @@ void Model::Draw(Shader& shader) {
         mesh.Draw(shader);
 }
 
+void Model::DrawDepth() {
+    for (auto& mesh : meshes)
+        mesh.DrawDepth();
+}
+
 void Model::loadModel(const std::string& path) {
     Assimp::Importer importer;
     const aiScene* scene = importer.ReadFile(path,
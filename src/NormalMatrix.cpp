@@ -0,0 +1,140 @@
+#include "NormalMatrix.h"
+#include <cmath>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
+// Upper 3x3 as 9 floats, column-major: m[column * 3 + row]
+static void cofactors(const float m[9], float cof[9]) {
+    cof[0] = m[4] * m[8] - m[5] * m[7];  // cross(column 1, column 2)
+    cof[1] = m[5] * m[6] - m[3] * m[8];
+    cof[2] = m[3] * m[7] - m[4] * m[6];
+    cof[3] = m[7] * m[2] - m[8] * m[1];  // cross(column 2, column 0)
+    cof[4] = m[8] * m[0] - m[6] * m[2];
+    cof[5] = m[6] * m[1] - m[7] * m[0];
+    cof[6] = m[1] * m[5] - m[2] * m[4];  // cross(column 0, column 1)
+    cof[7] = m[2] * m[3] - m[0] * m[5];
+    cof[8] = m[0] * m[4] - m[1] * m[3];
+}
+
+bool isConformal(const glm::mat3& m, float tolerance) {
+    float l0 = glm::dot(m[0], m[0]);
+    float limit = tolerance * l0;
+    return std::fabs(glm::dot(m[0], m[1])) <= limit && std::fabs(glm::dot(m[0], m[2])) <= limit &&
+           std::fabs(glm::dot(m[1], m[2])) <= limit &&
+           std::fabs(glm::dot(m[1], m[1]) - l0) <= limit && std::fabs(glm::dot(m[2], m[2]) - l0) <= limit;
+}
+
+glm::mat3 normalMatrix(const glm::mat4& model) {
+    glm::mat3 upper(model);
+    if (isConformal(upper)) return upper;
+
+    float m[9], cof[9];
+    for (int i = 0; i < 9; ++i) m[i] = upper[i / 3][i % 3];
+    cofactors(m, cof);
+    float det = m[0] * cof[0] + m[1] * cof[1] + m[2] * cof[2];
+    float sign = det < 0.0f ? -1.0f : 1.0f;
+    return glm::mat3(glm::vec3(cof[0], cof[1], cof[2]) * sign,
+                     glm::vec3(cof[3], cof[4], cof[5]) * sign,
+                     glm::vec3(cof[6], cof[7], cof[8]) * sign);
+}
+
+void computeNormalMatrices(const glm::mat4* models, glm::vec4* normalColumns, size_t count, size_t stride) {
+    const char* in = reinterpret_cast<const char*>(models);
+    char* out = reinterpret_cast<char*>(normalColumns);
+
+#if defined(__AVX__) || defined(__SSE2__) || defined(_M_X64)
+#if defined(__AVX__)
+    typedef __m256 Lanes;
+    const size_t WIDTH = 8;
+    auto load = [](const float* p) { return _mm256_loadu_ps(p); };
+    auto store = [](float* p, Lanes v) { _mm256_storeu_ps(p, v); };
+    auto splat = [](float f) { return _mm256_set1_ps(f); };
+    auto mul = [](Lanes a, Lanes b) { return _mm256_mul_ps(a, b); };
+    auto add = [](Lanes a, Lanes b) { return _mm256_add_ps(a, b); };
+    auto sub = [](Lanes a, Lanes b) { return _mm256_sub_ps(a, b); };
+    auto andMask = [](Lanes a, Lanes b) { return _mm256_and_ps(a, b); };
+    auto xorMask = [](Lanes a, Lanes b) { return _mm256_xor_ps(a, b); };
+    auto lessEqual = [](Lanes a, Lanes b) { return _mm256_cmp_ps(a, b, _CMP_LE_OQ); };
+    auto select = [](Lanes mask, Lanes a, Lanes b) { return _mm256_blendv_ps(b, a, mask); };
+#else
+    typedef __m128 Lanes;
+    const size_t WIDTH = 4;
+    auto load = [](const float* p) { return _mm_loadu_ps(p); };
+    auto store = [](float* p, Lanes v) { _mm_storeu_ps(p, v); };
+    auto splat = [](float f) { return _mm_set1_ps(f); };
+    auto mul = [](Lanes a, Lanes b) { return _mm_mul_ps(a, b); };
+    auto add = [](Lanes a, Lanes b) { return _mm_add_ps(a, b); };
+    auto sub = [](Lanes a, Lanes b) { return _mm_sub_ps(a, b); };
+    auto andMask = [](Lanes a, Lanes b) { return _mm_and_ps(a, b); };
+    auto xorMask = [](Lanes a, Lanes b) { return _mm_xor_ps(a, b); };
+    auto lessEqual = [](Lanes a, Lanes b) { return _mm_cmple_ps(a, b); };
+    auto select = [](Lanes mask, Lanes a, Lanes b) { return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b)); };
+#endif
+    const Lanes signBit = splat(-0.0f);
+
+    // Whole batches: transpose WIDTH matrices into structure-of-arrays, then every
+    // lane computes its cofactors and the conformal test at once
+    size_t i = 0;
+    alignas(32) float soa[9][8];
+    alignas(32) float result[9][8];
+    for (; i + WIDTH <= count; i += WIDTH) {
+        for (size_t lane = 0; lane < WIDTH; ++lane) {
+            const glm::mat4& model = *reinterpret_cast<const glm::mat4*>(in + (i + lane) * stride);
+            for (int e = 0; e < 9; ++e) soa[e][lane] = model[e / 3][e % 3];
+        }
+
+        Lanes m[9];
+        for (int e = 0; e < 9; ++e) m[e] = load(soa[e]);
+
+        Lanes cof[9];
+        cof[0] = sub(mul(m[4], m[8]), mul(m[5], m[7]));
+        cof[1] = sub(mul(m[5], m[6]), mul(m[3], m[8]));
+        cof[2] = sub(mul(m[3], m[7]), mul(m[4], m[6]));
+        cof[3] = sub(mul(m[7], m[2]), mul(m[8], m[1]));
+        cof[4] = sub(mul(m[8], m[0]), mul(m[6], m[2]));
+        cof[5] = sub(mul(m[6], m[1]), mul(m[7], m[0]));
+        cof[6] = sub(mul(m[1], m[5]), mul(m[2], m[4]));
+        cof[7] = sub(mul(m[2], m[3]), mul(m[0], m[5]));
+        cof[8] = sub(mul(m[0], m[4]), mul(m[1], m[3]));
+
+        // Negative determinant (mirroring): flip the sign so normals keep facing out
+        Lanes det = add(add(mul(m[0], cof[0]), mul(m[1], cof[1])), mul(m[2], cof[2]));
+        Lanes flip = andMask(det, signBit);
+
+        // Conformal lanes keep their own 3x3, as in normalMatrix()
+        auto dot = [&](int a, int b) {
+            return add(add(mul(m[a], m[b]), mul(m[a + 1], m[b + 1])), mul(m[a + 2], m[b + 2]));
+        };
+        auto absolute = [&](Lanes a) { return xorMask(a, andMask(a, signBit)); };
+        Lanes l0 = dot(0, 0);
+        Lanes limit = mul(splat(1e-4f), l0);
+        Lanes conformal = andMask(andMask(lessEqual(absolute(dot(0, 3)), limit), lessEqual(absolute(dot(0, 6)), limit)),
+                                  andMask(lessEqual(absolute(dot(3, 6)), limit),
+                                          andMask(lessEqual(absolute(sub(dot(3, 3), l0)), limit),
+                                                  lessEqual(absolute(sub(dot(6, 6), l0)), limit))));
+
+        for (int e = 0; e < 9; ++e)
+            store(result[e], select(conformal, m[e], xorMask(cof[e], flip)));
+
+        for (size_t lane = 0; lane < WIDTH; ++lane) {
+            glm::vec4* columns = reinterpret_cast<glm::vec4*>(out + (i + lane) * stride);
+            for (int c = 0; c < 3; ++c)
+                columns[c] = glm::vec4(result[c * 3][lane], result[c * 3 + 1][lane], result[c * 3 + 2][lane], 0.0f);
+        }
+    }
+#else
+    size_t i = 0;
+#endif
+
+    // Remainder (or everything without SIMD)
+    for (; i < count; ++i) {
+        const glm::mat4& model = *reinterpret_cast<const glm::mat4*>(in + i * stride);
+        glm::vec4* columns = reinterpret_cast<glm::vec4*>(out + i * stride);
+        glm::mat3 normal = normalMatrix(model);
+        for (int c = 0; c < 3; ++c) columns[c] = glm::vec4(normal[c], 0.0f);
+    }
+}
@@ -0,0 +1,298 @@
+#include "OcclusionCuller.h"
+#include <cmath>
+#include <chrono>
+#include <utility>
+#include <algorithm>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
+OcclusionCuller::OcclusionCuller(int width, int height) {
+    tilesX = std::max(1, (width + TILE_WIDTH - 1) / TILE_WIDTH);
+    tilesY = std::max(1, (height + TILE_HEIGHT - 1) / TILE_HEIGHT);
+    size_t tiles = (size_t)tilesX * tilesY;
+    tileMask.assign(tiles, 0);
+    tileFarDepth.assign(tiles, 1.0f);
+    tileWorkingDepth.assign(tiles, 0.0f);
+}
+
+void OcclusionCuller::begin(const glm::mat4& matrix) {
+    viewProjection = matrix;
+    occluders.clear();
+    std::fill(tileMask.begin(), tileMask.end(), 0u);
+    std::fill(tileFarDepth.begin(), tileFarDepth.end(), 1.0f);
+    std::fill(tileWorkingDepth.begin(), tileWorkingDepth.end(), 0.0f);
+    lastStats = Stats();
+}
+
+void OcclusionCuller::addOccluder(const Mesh& mesh, const glm::mat4& model) {
+    occluders.push_back({&mesh, model});
+    lastStats.occluders++;
+    lastStats.triangles += (unsigned)(mesh.indices.size() / 3);
+}
+
+bool OcclusionCuller::setupTriangle(const glm::vec4& c0, const glm::vec4& c1, const glm::vec4& c2, Triangle& tri) const {
+    // No clipping: triangles reaching behind the near plane are dropped, which only
+    // costs occlusion, never correctness
+    const glm::vec4* clip[3] = {&c0, &c1, &c2};
+    glm::vec3 p[3];
+    for (int i = 0; i < 3; ++i) {
+        const glm::vec4& c = *clip[i];
+        if (c.w <= 0.0f || c.z < -c.w) return false;
+        float invW = 1.0f / c.w;
+        p[i] = glm::vec3((c.x * invW * 0.5f + 0.5f) * width(), (c.y * invW * 0.5f + 0.5f) * height(),
+                         c.z * invW * 0.5f + 0.5f);
+    }
+
+    float area = (p[1].x - p[0].x) * (p[2].y - p[0].y) - (p[1].y - p[0].y) * (p[2].x - p[0].x);
+    if (std::fabs(area) < 1e-6f) return false;
+    if (area < 0.0f) {
+        // Both windings occlude; flip clockwise ones so every edge is positive inside
+        std::swap(p[1], p[2]);
+        area = -area;
+    }
+
+    float minX = std::min(p[0].x, std::min(p[1].x, p[2].x)), maxX = std::max(p[0].x, std::max(p[1].x, p[2].x));
+    float minY = std::min(p[0].y, std::min(p[1].y, p[2].y)), maxY = std::max(p[0].y, std::max(p[1].y, p[2].y));
+    float minDepth = std::min(p[0].z, std::min(p[1].z, p[2].z));
+    if (maxX < 0.0f || maxY < 0.0f || minX >= width() || minY >= height() || minDepth >= 1.0f) return false;
+
+    int x0 = std::max(0, (int)std::floor(minX)), x1 = std::min(width() - 1, (int)std::floor(maxX));
+    int y0 = std::max(0, (int)std::floor(minY)), y1 = std::min(height() - 1, (int)std::floor(maxY));
+    tri.tileX0 = x0 / TILE_WIDTH;
+    tri.tileX1 = x1 / TILE_WIDTH;
+    tri.tileY0 = y0 / TILE_HEIGHT;
+    tri.tileY1 = y1 / TILE_HEIGHT;
+
+    for (int i = 0; i < 3; ++i) {
+        const glm::vec3& a = p[i];
+        const glm::vec3& b = p[(i + 1) % 3];
+        tri.edgeA[i] = a.y - b.y;
+        tri.edgeB[i] = b.x - a.x;
+        tri.edgeC[i] = -(tri.edgeA[i] * a.x + tri.edgeB[i] * a.y);
+    }
+
+    float dx1 = p[1].x - p[0].x, dy1 = p[1].y - p[0].y, dz1 = p[1].z - p[0].z;
+    float dx2 = p[2].x - p[0].x, dy2 = p[2].y - p[0].y, dz2 = p[2].z - p[0].z;
+    tri.depthA = (dz1 * dy2 - dz2 * dy1) / area;
+    tri.depthB = (dz2 * dx1 - dz1 * dx2) / area;
+    tri.depthC = p[0].z - tri.depthA * p[0].x - tri.depthB * p[0].y;
+    tri.maxDepth = std::max(p[0].z, std::max(p[1].z, p[2].z));
+    return true;
+}
+
+// Pixels of the tile at (x0, y0) whose centres are inside all three edges,
+// bit = row * TILE_WIDTH + column
+static uint32_t tileCoverage(const float edgeA[3], const float edgeB[3], const float edgeC[3], float x0, float y0) {
+    uint32_t coverage = 0;
+#if defined(__AVX__)
+    const __m256 columns = _mm256_setr_ps(0.5f, 1.5f, 2.5f, 3.5f, 4.5f, 5.5f, 6.5f, 7.5f);
+    const __m256 zero = _mm256_setzero_ps();
+    __m256 x = _mm256_add_ps(_mm256_set1_ps(x0), columns);
+    __m256 edgeX[3];
+    for (int i = 0; i < 3; ++i) edgeX[i] = _mm256_mul_ps(_mm256_set1_ps(edgeA[i]), x);
+    for (int row = 0; row < OcclusionCuller::TILE_HEIGHT; ++row) {
+        // Each row evaluated directly, like the scalar path, so shared edges leave no gaps
+        float y = y0 + row + 0.5f;
+        __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+        for (int i = 0; i < 3; ++i) {
+            __m256 edge = _mm256_add_ps(edgeX[i], _mm256_set1_ps(edgeB[i] * y + edgeC[i]));
+            inside = _mm256_and_ps(inside, _mm256_cmp_ps(edge, zero, _CMP_GE_OQ));
+        }
+        coverage |= (uint32_t)_mm256_movemask_ps(inside) << (row * OcclusionCuller::TILE_WIDTH);
+    }
+#elif defined(__SSE2__) || defined(_M_X64)
+    // One tile row as two halves of 4 pixels
+    const __m128 zero = _mm_setzero_ps();
+    __m128 xLow = _mm_add_ps(_mm_set1_ps(x0), _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f));
+    __m128 xHigh = _mm_add_ps(_mm_set1_ps(x0), _mm_setr_ps(4.5f, 5.5f, 6.5f, 7.5f));
+    __m128 lowX[3], highX[3];
+    for (int i = 0; i < 3; ++i) {
+        __m128 a = _mm_set1_ps(edgeA[i]);
+        lowX[i] = _mm_mul_ps(a, xLow);
+        highX[i] = _mm_mul_ps(a, xHigh);
+    }
+    for (int row = 0; row < OcclusionCuller::TILE_HEIGHT; ++row) {
+        float y = y0 + row + 0.5f;
+        __m128 insideLow = _mm_castsi128_ps(_mm_set1_epi32(-1)), insideHigh = insideLow;
+        for (int i = 0; i < 3; ++i) {
+            __m128 rowStart = _mm_set1_ps(edgeB[i] * y + edgeC[i]);
+            insideLow = _mm_and_ps(insideLow, _mm_cmpge_ps(_mm_add_ps(lowX[i], rowStart), zero));
+            insideHigh = _mm_and_ps(insideHigh, _mm_cmpge_ps(_mm_add_ps(highX[i], rowStart), zero));
+        }
+        uint32_t bits = (uint32_t)_mm_movemask_ps(insideLow) | (uint32_t)_mm_movemask_ps(insideHigh) << 4;
+        coverage |= bits << (row * OcclusionCuller::TILE_WIDTH);
+    }
+#else
+    for (int row = 0; row < OcclusionCuller::TILE_HEIGHT; ++row) {
+        float y = y0 + row + 0.5f;
+        for (int column = 0; column < OcclusionCuller::TILE_WIDTH; ++column) {
+            float x = x0 + column + 0.5f;
+            bool inside = true;
+            for (int i = 0; i < 3; ++i)
+                inside = inside && edgeA[i] * x + (edgeB[i] * y + edgeC[i]) >= 0.0f;
+            if (inside) coverage |= 1u << (row * OcclusionCuller::TILE_WIDTH + column);
+        }
+    }
+#endif
+    return coverage;
+}
+
+void OcclusionCuller::updateTile(size_t tile, uint32_t coverage, float depth) {
+    float& farDepth = tileFarDepth[tile];
+    if (depth >= farDepth) return;  // Behind what the tile already guarantees
+
+    uint32_t& mask = tileMask[tile];
+    float& workingDepth = tileWorkingDepth[tile];
+
+    // Much closer than the working layer: start a new layer rather than merge, which
+    // would bound these pixels by the working depth
+    if (mask != 0 && workingDepth - depth > farDepth - workingDepth) {
+        mask = 0;
+        workingDepth = 0.0f;
+    }
+    mask |= coverage;
+    workingDepth = std::max(workingDepth, depth);
+
+    // A full working layer is a tighter bound for the whole tile
+    if (mask == FULL_TILE) {
+        farDepth = workingDepth;
+        mask = 0;
+        workingDepth = 0.0f;
+    }
+}
+
+void OcclusionCuller::rasterizeTileRow(int tileY) {
+    float y0 = (float)(tileY * TILE_HEIGHT);
+    for (size_t i = 0; i < triangles.size(); ++i) {
+        if (!triangleValid[i]) continue;
+        const Triangle& tri = triangles[i];
+        if (tileY < tri.tileY0 || tileY > tri.tileY1) continue;
+
+        for (int tileX = tri.tileX0; tileX <= tri.tileX1; ++tileX) {
+            float x0 = (float)(tileX * TILE_WIDTH);
+            uint32_t coverage = tileCoverage(tri.edgeA, tri.edgeB, tri.edgeC, x0, y0);
+            if (coverage == 0) continue;
+
+            // Farthest point of the depth plane over the tile, capped by the farthest vertex
+            float depth = tri.depthA * x0 + tri.depthB * y0 + tri.depthC +
+                          std::max(0.0f, tri.depthA * TILE_WIDTH) + std::max(0.0f, tri.depthB * TILE_HEIGHT);
+            updateTile((size_t)tileY * tilesX + tileX, coverage, std::min(depth, tri.maxDepth));
+        }
+    }
+}
+
+void OcclusionCuller::rasterize(JobPool& pool) {
+    auto start = std::chrono::steady_clock::now();
+
+    std::vector<size_t> firstTriangle(occluders.size() + 1, 0);
+    for (size_t i = 0; i < occluders.size(); ++i)
+        firstTriangle[i + 1] = firstTriangle[i] + occluders[i].mesh->indices.size() / 3;
+    triangles.resize(firstTriangle.back());
+    triangleValid.resize(firstTriangle.back());
+
+    // Transform and set up every triangle, a few occluders per job
+    pool.parallelFor(occluders.size(), 16, [&](size_t begin, size_t end, unsigned) {
+        std::vector<glm::vec4> clip;
+        for (size_t o = begin; o < end; ++o) {
+            const Mesh& mesh = *occluders[o].mesh;
+            glm::mat4 matrix = viewProjection * occluders[o].model;
+            size_t vertexCount = mesh.positions.size() / 3;
+            clip.resize(vertexCount);
+            for (size_t v = 0; v < vertexCount; ++v) {
+                const float* p = &mesh.positions[3 * v];
+                clip[v] = matrix * glm::vec4(p[0], p[1], p[2], 1.0f);
+            }
+
+            size_t first = firstTriangle[o];
+            for (size_t t = 0; t + 2 < mesh.indices.size(); t += 3) {
+                const uint32_t* index = &mesh.indices[t];
+                triangleValid[first + t / 3] =
+                    setupTriangle(clip[index[0]], clip[index[1]], clip[index[2]], triangles[first + t / 3]);
+            }
+        }
+    });
+
+    unsigned rasterized = 0;
+    for (uint8_t valid : triangleValid) rasterized += valid;
+    lastStats.rasterized = rasterized;
+
+    // Each tile row is owned by one job
+    pool.parallelFor(tilesY, 1, [&](size_t begin, size_t end, unsigned) {
+        for (size_t row = begin; row < end; ++row) rasterizeTileRow((int)row);
+    });
+
+    auto end = std::chrono::steady_clock::now();
+    lastStats.rasterMs = std::chrono::duration<float, std::milli>(end - start).count();
+}
+
+bool OcclusionCuller::occluded(const AABB& box) const {
+    // Screen rectangle and nearest depth of the 8 corners
+    float minX = 1e30f, minY = 1e30f, maxX = -1e30f, maxY = -1e30f, minDepth = 1e30f;
+    for (int corner = 0; corner < 8; ++corner) {
+        glm::vec4 c = viewProjection * glm::vec4(corner & 1 ? box.max.x : box.min.x,
+                                                 corner & 2 ? box.max.y : box.min.y,
+                                                 corner & 4 ? box.max.z : box.min.z, 1.0f);
+        if (c.w <= 0.0f || c.z < -c.w) return false;
+        float invW = 1.0f / c.w;
+        float x = (c.x * invW * 0.5f + 0.5f) * width();
+        float y = (c.y * invW * 0.5f + 0.5f) * height();
+        minX = std::min(minX, x);
+        maxX = std::max(maxX, x);
+        minY = std::min(minY, y);
+        maxY = std::max(maxY, y);
+        minDepth = std::min(minDepth, c.z * invW * 0.5f + 0.5f);
+    }
+
+    // Every pixel the rectangle touches, not just the covered centres
+    if (maxX < 0.0f || maxY < 0.0f || minX >= width() || minY >= height()) return false;
+    int x0 = std::max(0, (int)std::floor(minX)), x1 = std::min(width() - 1, (int)std::floor(maxX));
+    int y0 = std::max(0, (int)std::floor(minY)), y1 = std::min(height() - 1, (int)std::floor(maxY));
+
+    for (int tileY = y0 / TILE_HEIGHT; tileY <= y1 / TILE_HEIGHT; ++tileY) {
+        int row0 = std::max(y0 - tileY * TILE_HEIGHT, 0), row1 = std::min(y1 - tileY * TILE_HEIGHT, TILE_HEIGHT - 1);
+        uint32_t rows = (uint32_t)((((uint64_t)1 << ((row1 - row0 + 1) * TILE_WIDTH)) - 1) << (row0 * TILE_WIDTH));
+
+        for (int tileX = x0 / TILE_WIDTH; tileX <= x1 / TILE_WIDTH; ++tileX) {
+            int column0 = std::max(x0 - tileX * TILE_WIDTH, 0);
+            int column1 = std::min(x1 - tileX * TILE_WIDTH, TILE_WIDTH - 1);
+            uint32_t columns = ((1u << (column1 + 1)) - 1) & ~((1u << column0) - 1);
+            uint32_t pixels = rows & (columns * 0x01010101u);
+
+            // Pixels all inside the working layer are bounded by its depth
+            size_t tile = (size_t)tileY * tilesX + tileX;
+            float bound = (pixels & ~tileMask[tile]) == 0 ? tileWorkingDepth[tile] : tileFarDepth[tile];
+            if (minDepth <= bound) return false;
+        }
+    }
+    return true;
+}
+
+void OcclusionCuller::cull(const AABB* boxes, size_t count, uint8_t* visible, JobPool& pool) {
+    auto start = std::chrono::steady_clock::now();
+
+    auto test = [&](size_t begin, size_t end, unsigned) {
+        for (size_t i = begin; i < end; ++i) visible[i] = !occluded(boxes[i]);
+    };
+    if (count < parallelThreshold)
+        test(0, count, 0);
+    else
+        pool.parallelFor(count, 1024, test);
+
+    unsigned rejected = 0;
+    for (size_t i = 0; i < count; ++i) rejected += visible[i] == 0;
+
+    auto end = std::chrono::steady_clock::now();
+    lastStats.tested += (unsigned)count;
+    lastStats.rejected += rejected;
+    lastStats.testMs += std::chrono::duration<float, std::milli>(end - start).count();
+}
+
+float OcclusionCuller::depthBound(int x, int y) const {
+    size_t tile = (size_t)(y / TILE_HEIGHT) * tilesX + x / TILE_WIDTH;
+    uint32_t bit = 1u << ((y % TILE_HEIGHT) * TILE_WIDTH + x % TILE_WIDTH);
+    return (tileMask[tile] & bit) ? tileWorkingDepth[tile] : tileFarDepth[tile];
+}
@@ -37,6 +37,12 @@ void OrbitalCamera::ProcessMouseScroll(float yoffset) {
     if (Distance > MaxDistance) Distance = MaxDistance;
 }
 
+void OrbitalCamera::SetOrbit(float distance, float yaw, float pitch) {
+    Distance = glm::clamp(distance, MinDistance, MaxDistance);
+    Yaw = yaw;
+    Pitch = glm::clamp(pitch, -89.0f, 89.0f);
+}
+
 glm::vec3 OrbitalCamera::GetCameraPosition() const {
     return CalculatePosition();
 }
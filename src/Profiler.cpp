@@ -0,0 +1,208 @@
+#include "Profiler.h"
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <algorithm>
+
+// GL_ARB_pipeline_statistics_query; not in the loader, which stops at 4.5
+#ifndef GL_VERTEX_SHADER_INVOCATIONS_ARB
+#define GL_VERTEX_SHADER_INVOCATIONS_ARB 0x82F0
+#endif
+#ifndef GL_FRAGMENT_SHADER_INVOCATIONS_ARB
+#define GL_FRAGMENT_SHADER_INVOCATIONS_ARB 0x82F4
+#endif
+
+static bool hasExtension(const char* name) {
+    GLint count = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+    for (GLint i = 0; i < count; ++i) {
+        const char* extension = (const char*)glGetStringi(GL_EXTENSIONS, i);
+        if (extension && std::strcmp(extension, name) == 0) return true;
+    }
+    return false;
+}
+
+Profiler::Profiler() {
+    // Timer queries are core since 3.3
+    timers = GLAD_GL_VERSION_3_3 != 0;
+    statistics = timers && hasExtension("GL_ARB_pipeline_statistics_query");
+    if (!timers) return;
+    for (Frame& frame : frames) {
+        glGenQueries(2 * MAX_GPU_SCOPES, frame.timestamps);
+        if (statistics) glGenQueries(2 * MAX_GPU_SCOPES, frame.invocations);
+    }
+}
+
+Profiler::~Profiler() {
+    if (!timers) return;
+    for (Frame& frame : frames) {
+        glDeleteQueries(2 * MAX_GPU_SCOPES, frame.timestamps);
+        if (statistics) glDeleteQueries(2 * MAX_GPU_SCOPES, frame.invocations);
+    }
+}
+
+void Profiler::beginFrame() {
+    // This slot was last used FRAME_LATENCY frames ago; its results are usually in
+    Frame& frame = frames[frameIndex % FRAME_LATENCY];
+    if (frame.pending) collect(frame);
+    frame.samples.clear();
+    frame.pending = false;
+    gpuScopes = 0;
+
+    cpuThisFrame.assign(scopes.size(), 0.0);
+    seenThisFrame.assign(scopes.size(), 0);
+}
+
+void Profiler::endFrame() {
+    // Scopes left open are closed so the next frame starts at the top level
+    while (!stack.empty()) end();
+
+    for (size_t i = 0; i < cpuThisFrame.size(); ++i)
+        if (seenThisFrame[i]) scopes[i].cpuMs.add(cpuThisFrame[i]);
+
+    Frame& frame = frames[frameIndex % FRAME_LATENCY];
+    frame.pending = !frame.samples.empty() && timers;
+    ++frameIndex;
+}
+
+unsigned Profiler::scopeFor(const char* name) {
+    std::string path = stack.empty() ? std::string(name) : scopes[stack.back().scope].path + "/" + name;
+    auto found = scopeIndex.find(path);
+    if (found != scopeIndex.end()) return found->second;
+
+    unsigned index = (unsigned)scopes.size();
+    Result result;
+    result.path = path;
+    result.name = name;
+    result.depth = (unsigned)stack.size();
+    scopes.push_back(result);
+    scopeIndex[path] = index;
+    cpuThisFrame.push_back(0.0);
+    seenThisFrame.push_back(0);
+    return index;
+}
+
+void Profiler::begin(const char* name) {
+    unsigned scope = scopeFor(name);
+    Frame& frame = frames[frameIndex % FRAME_LATENCY];
+
+    unsigned sample = (unsigned)frame.samples.size();
+    bool gpu = timers && gpuScopes < MAX_GPU_SCOPES;
+    bool counted = gpu && statistics && stack.empty();
+    frame.samples.push_back({scope, gpu ? gpuScopes : NO_QUERY, counted});
+    if (gpu) {
+        glQueryCounter(frame.timestamps[2 * gpuScopes], GL_TIMESTAMP);
+        if (counted) {
+            glBeginQuery(GL_VERTEX_SHADER_INVOCATIONS_ARB, frame.invocations[2 * gpuScopes]);
+            glBeginQuery(GL_FRAGMENT_SHADER_INVOCATIONS_ARB, frame.invocations[2 * gpuScopes + 1]);
+        }
+        ++gpuScopes;
+    }
+
+    stack.push_back({scope, sample, Clock::now()});
+}
+
+void Profiler::end() {
+    if (stack.empty()) return;
+    Open open = stack.back();
+    stack.pop_back();
+
+    double ms = std::chrono::duration<double, std::milli>(Clock::now() - open.start).count();
+    cpuThisFrame[open.scope] += ms;
+    seenThisFrame[open.scope] = 1;
+
+    Frame& frame = frames[frameIndex % FRAME_LATENCY];
+    const Sample& sample = frame.samples[open.sample];
+    if (sample.query == NO_QUERY) return;
+    // Statistics end first, so the end timestamp is the last query of the scope
+    if (sample.counted) {
+        glEndQuery(GL_VERTEX_SHADER_INVOCATIONS_ARB);
+        glEndQuery(GL_FRAGMENT_SHADER_INVOCATIONS_ARB);
+    }
+    glQueryCounter(frame.timestamps[2 * sample.query + 1], GL_TIMESTAMP);
+}
+
+void Profiler::collect(Frame& frame) {
+    // Never wait: if any end timestamp or statistics result isn't written yet, drop the frame
+    bool any = false;
+    for (const Sample& sample : frame.samples) {
+        if (sample.query == NO_QUERY) continue;
+        any = true;
+        GLuint available = 0;
+        glGetQueryObjectuiv(frame.timestamps[2 * sample.query + 1], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (available && sample.counted) {
+            GLuint vertexAvailable = 0;
+            glGetQueryObjectuiv(frame.invocations[2 * sample.query], GL_QUERY_RESULT_AVAILABLE, &vertexAvailable);
+            glGetQueryObjectuiv(frame.invocations[2 * sample.query + 1], GL_QUERY_RESULT_AVAILABLE, &available);
+            available = available && vertexAvailable;
+        }
+        if (!available) {
+            counters.droppedFrames++;
+            return;
+        }
+    }
+    if (!any) return;
+
+    std::vector<double> gpuMs(scopes.size(), 0.0), vertices(scopes.size(), 0.0), fragments(scopes.size(), 0.0);
+    std::vector<uint8_t> seen(scopes.size(), 0), counted(scopes.size(), 0);
+    GLuint64 frameStart = ~(GLuint64)0, frameEnd = 0;
+    for (const Sample& sample : frame.samples) {
+        if (sample.query == NO_QUERY) continue;
+        unsigned query = sample.query;
+        GLuint64 start = 0, end = 0;
+        glGetQueryObjectui64v(frame.timestamps[2 * query], GL_QUERY_RESULT, &start);
+        glGetQueryObjectui64v(frame.timestamps[2 * query + 1], GL_QUERY_RESULT, &end);
+        gpuMs[sample.scope] += (end - start) / 1e6;
+        seen[sample.scope] = 1;
+        frameStart = std::min(frameStart, start);
+        frameEnd = std::max(frameEnd, end);
+
+        if (sample.counted) {
+            GLuint64 vertexCount = 0, fragmentCount = 0;
+            glGetQueryObjectui64v(frame.invocations[2 * query], GL_QUERY_RESULT, &vertexCount);
+            glGetQueryObjectui64v(frame.invocations[2 * query + 1], GL_QUERY_RESULT, &fragmentCount);
+            vertices[sample.scope] += (double)vertexCount;
+            fragments[sample.scope] += (double)fragmentCount;
+            counted[sample.scope] = 1;
+        }
+    }
+
+    counters.collectedFrames++;
+    counters.lastGpuFrameMs = (float)((frameEnd - frameStart) / 1e6);
+    for (size_t i = 0; i < scopes.size(); ++i) {
+        if (seen[i]) scopes[i].gpuMs.add(gpuMs[i]);
+        if (counted[i]) {
+            scopes[i].vertexInvocations.add(vertices[i]);
+            scopes[i].fragmentInvocations.add(fragments[i]);
+        }
+    }
+}
+
+const Profiler::Result* Profiler::find(const std::string& path) const {
+    auto found = scopeIndex.find(path);
+    return found == scopeIndex.end() ? nullptr : &scopes[found->second];
+}
+
+std::string Profiler::summary(unsigned maxDepth) const {
+    std::string text;
+    char entry[128];
+    for (const Result& scope : scopes) {
+        if (scope.depth > maxDepth) continue;
+        std::snprintf(entry, sizeof(entry), "%s%s %.2f/%.2f", text.empty() ? "" : ", ", scope.name.c_str(),
+                      scope.cpuMs.mean(), scope.gpuMs.mean());
+        text += entry;
+    }
+    return text.empty() ? text : text + " ms (cpu/gpu)";
+}
+
+bool Profiler::exportCsv(const std::string& path) const {
+    std::ofstream file(path);
+    if (!file.is_open()) return false;
+
+    file << "scope,depth,cpu_ms,gpu_ms,vertex_invocations,fragment_invocations\n";
+    for (const Result& scope : scopes) {
+        file << scope.path << ',' << scope.depth << ',' << scope.cpuMs.mean() << ',' << scope.gpuMs.mean() << ','
+             << scope.vertexInvocations.mean() << ',' << scope.fragmentInvocations.mean() << '\n';
+    }
+    return file.good();
+}
@@ -0,0 +1,138 @@
+#include "RenderQueue.h"
+#include <algorithm>
+
+uint64_t RenderQueue::makeKey(unsigned pass, bool translucent, float depth,
+                              unsigned program, unsigned material, unsigned mesh) {
+    depth = std::min(std::max(depth, 0.0f), 1.0f);
+    const uint64_t depthMax = (1u << 24) - 1;
+
+    uint64_t depthBits;
+    if (translucent) {
+        // Far to near
+        depthBits = depthMax - (uint64_t)(depth * depthMax);
+    } else {
+        // Coarse near-to-far buckets so state grouping still dominates
+        uint64_t bucket = std::min<uint64_t>((uint64_t)(depth * OPAQUE_DEPTH_BUCKETS), OPAQUE_DEPTH_BUCKETS - 1);
+        depthBits = bucket << 20;
+    }
+
+    return ((uint64_t)(pass & 0xF) << 60) |
+           ((uint64_t)(translucent ? 1 : 0) << 59) |
+           (depthBits << 35) |
+           ((uint64_t)(program & 0xFFF) << 23) |
+           ((uint64_t)(material & 0xFFF) << 11) |
+           (uint64_t)(mesh & 0x7FF);
+}
+
+void RenderQueue::sort() {
+    if (items.size() < 2) return;
+    scratch.resize(items.size());
+    if (items.size() < parallelThreshold || pool.size() == 1)
+        sortSerial();
+    else
+        sortParallel();
+}
+
+void RenderQueue::sortSerial() {
+    // All eight digit histograms in one read
+    uint32_t counts[8][256] = {};
+    for (const Item& item : items)
+        for (int digit = 0; digit < 8; ++digit)
+            ++counts[digit][(item.key >> (digit * 8)) & 0xFF];
+
+    const size_t n = items.size();
+    for (int digit = 0; digit < 8; ++digit) {
+        // Every key has the same byte here; the pass would be a copy
+        if (counts[digit][(items[0].key >> (digit * 8)) & 0xFF] == n) continue;
+
+        uint32_t offsets[256];
+        uint32_t running = 0;
+        for (int d = 0; d < 256; ++d) {
+            offsets[d] = running;
+            running += counts[digit][d];
+        }
+
+        const int shift = digit * 8;
+        for (const Item& item : items)
+            scratch[offsets[(item.key >> shift) & 0xFF]++] = item;
+        items.swap(scratch);
+    }
+}
+
+void RenderQueue::sortParallel() {
+    const size_t n = items.size();
+    const unsigned chunks = pool.size();
+    const size_t chunkSize = (n + chunks - 1) / chunks;
+    histograms.assign((size_t)chunks * 256, 0);
+
+    // Which digits actually vary: OR of (key ^ first key) over all items
+    std::vector<uint64_t> varying(chunks, 0);
+    const uint64_t first = items[0].key;
+    pool.parallelFor(chunks, 1, [&](size_t begin, size_t end, unsigned) {
+        for (size_t chunk = begin; chunk < end; ++chunk) {
+            uint64_t bits = 0;
+            size_t lo = chunk * chunkSize, hi = std::min(n, lo + chunkSize);
+            for (size_t i = lo; i < hi; ++i) bits |= items[i].key ^ first;
+            varying[chunk] = bits;
+        }
+    });
+    uint64_t differing = 0;
+    for (uint64_t bits : varying) differing |= bits;
+
+    for (int digit = 0; digit < 8; ++digit) {
+        const int shift = digit * 8;
+        if (((differing >> shift) & 0xFF) == 0) continue;
+
+        // Per-chunk histograms
+        pool.parallelFor(chunks, 1, [&](size_t begin, size_t end, unsigned) {
+            for (size_t chunk = begin; chunk < end; ++chunk) {
+                uint32_t* counts = &histograms[chunk * 256];
+                std::fill(counts, counts + 256, 0);
+                size_t lo = chunk * chunkSize, hi = std::min(n, lo + chunkSize);
+                for (size_t i = lo; i < hi; ++i)
+                    ++counts[(items[i].key >> shift) & 0xFF];
+            }
+        });
+
+        // Exclusive prefix over (digit, chunk) keeps the sort stable
+        uint32_t running = 0;
+        for (int d = 0; d < 256; ++d) {
+            for (unsigned chunk = 0; chunk < chunks; ++chunk) {
+                uint32_t& count = histograms[(size_t)chunk * 256 + d];
+                uint32_t c = count;
+                count = running;
+                running += c;
+            }
+        }
+
+        pool.parallelFor(chunks, 1, [&](size_t begin, size_t end, unsigned) {
+            for (size_t chunk = begin; chunk < end; ++chunk) {
+                uint32_t* offsets = &histograms[chunk * 256];
+                size_t lo = chunk * chunkSize, hi = std::min(n, lo + chunkSize);
+                for (size_t i = lo; i < hi; ++i)
+                    scratch[offsets[(items[i].key >> shift) & 0xFF]++] = items[i];
+            }
+        });
+        items.swap(scratch);
+    }
+}
+
+void RenderQueue::execute(const std::function<void(const Item&, unsigned changes)>& fn) const {
+    uint64_t previous = 0;
+    bool firstItem = true;
+    for (const Item& item : items) {
+        unsigned changes = 0;
+        if (firstItem) {
+            changes = PASS_CHANGED | TRANSLUCENCY_CHANGED | PROGRAM_CHANGED | MATERIAL_CHANGED | MESH_CHANGED;
+            firstItem = false;
+        } else {
+            if (pass(item.key) != pass(previous)) changes |= PASS_CHANGED;
+            if (translucent(item.key) != translucent(previous)) changes |= TRANSLUCENCY_CHANGED;
+            if (program(item.key) != program(previous)) changes |= PROGRAM_CHANGED;
+            if (material(item.key) != material(previous)) changes |= MATERIAL_CHANGED;
+            if (mesh(item.key) != mesh(previous)) changes |= MESH_CHANGED;
+        }
+        fn(item, changes);
+        previous = item.key;
+    }
+}
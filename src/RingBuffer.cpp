@@ -0,0 +1,119 @@
+#include "RingBuffer.h"
+#include <chrono>
+#include <iostream>
+#include <algorithm>
+#include "GLState.h"
+
+static size_t alignUp(size_t value, size_t alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+RingBuffer::RingBuffer(size_t frameBytes, size_t alignment) : alignment(alignment) {
+    if (this->alignment == 0) {
+        GLint uniform = 0, storage = 0;
+        glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &uniform);
+        if (GLAD_GL_VERSION_4_3) glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &storage);
+        this->alignment = (size_t)std::max({uniform, storage, 16});
+    }
+    // Every section starts aligned
+    this->frameBytes = alignUp(std::max<size_t>(frameBytes, 1), this->alignment);
+
+    glGenBuffers(1, &handle);
+    GLState& gl = GLState::instance();
+    gl.bindBuffer(GL_COPY_WRITE_BUFFER, handle);
+
+    if (persistentSupported()) {
+        GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        GLsizeiptr total = (GLsizeiptr)(FRAMES * this->frameBytes);
+        GL_CHECK(glBufferStorage(GL_COPY_WRITE_BUFFER, total, nullptr, flags));
+        mapped = (unsigned char*)glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, total, flags);
+        GLDebug::label(GL_BUFFER, handle, "ring buffer (persistent)");
+        if (mapped) return;
+
+        // Storage is immutable, so the fallback needs a new buffer
+        std::cerr << "RingBuffer: persistent mapping failed, using orphaned uploads" << std::endl;
+        gl.forgetBuffer(handle);
+        glDeleteBuffers(1, &handle);
+        glGenBuffers(1, &handle);
+        gl.bindBuffer(GL_COPY_WRITE_BUFFER, handle);
+    }
+    createOrphaned();
+}
+
+void RingBuffer::createOrphaned() {
+    staging.resize(frameBytes);
+    GL_CHECK(glBufferData(GL_COPY_WRITE_BUFFER, (GLsizeiptr)frameBytes, nullptr, GL_STREAM_DRAW));
+    GLDebug::label(GL_BUFFER, handle, "ring buffer");
+}
+
+RingBuffer::~RingBuffer() {
+    for (GLsync& fence : fences)
+        if (fence) glDeleteSync(fence);
+    GLState& gl = GLState::instance();
+    if (mapped) {
+        gl.bindBuffer(GL_COPY_WRITE_BUFFER, handle);
+        glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+    }
+    gl.forgetBuffer(handle);
+    glDeleteBuffers(1, &handle);
+}
+
+void RingBuffer::beginFrame() {
+    if (started) {
+        flush();
+        if (mapped) fences[section] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        counters.peakBytes = std::max(counters.peakBytes, used);
+    }
+    started = true;
+    section = (section + 1) % FRAMES;
+    used = flushed = 0;
+    counters.frames++;
+
+    if (!mapped) {
+        // Orphan: draws still reading last frame keep the old storage
+        GLState::instance().bindBuffer(GL_COPY_WRITE_BUFFER, handle);
+        GL_CHECK(glBufferData(GL_COPY_WRITE_BUFFER, (GLsizeiptr)frameBytes, nullptr, GL_STREAM_DRAW));
+        return;
+    }
+
+    GLsync& fence = fences[section];
+    if (!fence) return;
+    GLenum status = glClientWaitSync(fence, 0, 0);
+    if (status == GL_TIMEOUT_EXPIRED) {
+        // The GPU is still reading this section from FRAMES frames ago
+        counters.stalls++;
+        auto start = std::chrono::steady_clock::now();
+        do {
+            status = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);  // 1 ms
+        } while (status == GL_TIMEOUT_EXPIRED);
+        counters.stallMs +=
+            std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+    glDeleteSync(fence);
+    fence = nullptr;
+}
+
+RingBuffer::Allocation RingBuffer::allocate(size_t bytes, size_t alignment) {
+    Allocation allocation;
+    size_t start = alignUp(used, std::max(alignment, this->alignment));
+    if (!started || start + bytes > frameBytes) {
+        if (counters.overflows++ == 0)
+            std::cerr << "RingBuffer: " << bytes << " bytes don't fit in the " << frameBytes
+                      << " byte frame" << (started ? "" : " (no beginFrame)") << std::endl;
+        return allocation;
+    }
+
+    size_t base = mapped ? section * frameBytes : 0;
+    allocation.cpu = mapped ? mapped + base + start : staging.data() + start;
+    allocation.offset = (GLintptr)(base + start);
+    allocation.size = (GLsizeiptr)bytes;
+    used = start + bytes;
+    return allocation;
+}
+
+void RingBuffer::flush() {
+    if (mapped || used <= flushed) return;
+    GLState::instance().bindBuffer(GL_COPY_WRITE_BUFFER, handle);
+    glBufferSubData(GL_COPY_WRITE_BUFFER, (GLintptr)flushed, (GLsizeiptr)(used - flushed), staging.data() + flushed);
+    flushed = used;
+}
@@ -0,0 +1,616 @@
+#include "SoftwareRasterizer.h"
+#include <cmath>
+#include <chrono>
+#include <utility>
+#include <algorithm>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
+// Lanes of pixels along a row: the same raster loop runs on AVX, SSE or scalars
+namespace {
+#if defined(__AVX__)
+const int LANES = 8;
+typedef __m256 Lanes;
+typedef __m256 Mask;
+inline Lanes splat(float v) { return _mm256_set1_ps(v); }
+inline Lanes laneCentres() { return _mm256_setr_ps(0.5f, 1.5f, 2.5f, 3.5f, 4.5f, 5.5f, 6.5f, 7.5f); }
+inline Lanes add(Lanes a, Lanes b) { return _mm256_add_ps(a, b); }
+inline Lanes mul(Lanes a, Lanes b) { return _mm256_mul_ps(a, b); }
+inline Lanes load(const float* p) { return _mm256_loadu_ps(p); }
+inline void store(float* p, Lanes v) { _mm256_storeu_ps(p, v); }
+inline Mask less(Lanes a, Lanes b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+inline Mask greater(Lanes a, Lanes b) { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+inline Mask greaterEqual(Lanes a, Lanes b) { return _mm256_cmp_ps(a, b, _CMP_GE_OQ); }
+inline Mask both(Mask a, Mask b) { return _mm256_and_ps(a, b); }
+inline Lanes select(Mask m, Lanes a, Lanes b) { return _mm256_blendv_ps(b, a, m); }
+inline int bits(Mask m) { return _mm256_movemask_ps(m); }
+#elif defined(__SSE2__) || defined(_M_X64)
+const int LANES = 4;
+typedef __m128 Lanes;
+typedef __m128 Mask;
+inline Lanes splat(float v) { return _mm_set1_ps(v); }
+inline Lanes laneCentres() { return _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f); }
+inline Lanes add(Lanes a, Lanes b) { return _mm_add_ps(a, b); }
+inline Lanes mul(Lanes a, Lanes b) { return _mm_mul_ps(a, b); }
+inline Lanes load(const float* p) { return _mm_loadu_ps(p); }
+inline void store(float* p, Lanes v) { _mm_storeu_ps(p, v); }
+inline Mask less(Lanes a, Lanes b) { return _mm_cmplt_ps(a, b); }
+inline Mask greater(Lanes a, Lanes b) { return _mm_cmpgt_ps(a, b); }
+inline Mask greaterEqual(Lanes a, Lanes b) { return _mm_cmpge_ps(a, b); }
+inline Mask both(Mask a, Mask b) { return _mm_and_ps(a, b); }
+inline Lanes select(Mask m, Lanes a, Lanes b) { return _mm_or_ps(_mm_and_ps(m, a), _mm_andnot_ps(m, b)); }
+inline int bits(Mask m) { return _mm_movemask_ps(m); }
+#else
+const int LANES = 1;
+typedef float Lanes;
+typedef bool Mask;
+inline Lanes splat(float v) { return v; }
+inline Lanes laneCentres() { return 0.5f; }
+inline Lanes add(Lanes a, Lanes b) { return a + b; }
+inline Lanes mul(Lanes a, Lanes b) { return a * b; }
+inline Lanes load(const float* p) { return *p; }
+inline void store(float* p, Lanes v) { *p = v; }
+inline Mask less(Lanes a, Lanes b) { return a < b; }
+inline Mask greater(Lanes a, Lanes b) { return a > b; }
+inline Mask greaterEqual(Lanes a, Lanes b) { return a >= b; }
+inline Mask both(Mask a, Mask b) { return a && b; }
+inline Lanes select(Mask m, Lanes a, Lanes b) { return m ? a : b; }
+inline int bits(Mask m) { return m ? 1 : 0; }
+#endif
+
+typedef std::chrono::steady_clock Clock;
+
+inline glm::vec4 unpack(uint32_t texel) {
+    return glm::vec4((float)(texel & 0xFF), (float)(texel >> 8 & 0xFF), (float)(texel >> 16 & 0xFF),
+                     (float)(texel >> 24)) * (1.0f / 255.0f);
+}
+
+// Unsigned normalized conversion, as GL writes an RGBA8 target
+inline uint32_t pack(const glm::vec4& color) {
+    glm::vec4 c = glm::clamp(color, 0.0f, 1.0f) * 255.0f + 0.5f;
+    return (uint32_t)c.x | (uint32_t)c.y << 8 | (uint32_t)c.z << 16 | (uint32_t)c.w << 24;
+}
+
+inline int wrap(int i, int size) {
+    return i < 0 ? i + size : i >= size ? i - size : i;
+}
+} // namespace
+
+SoftwareTexture::SoftwareTexture(int width, int height, const unsigned char* rgba) {
+    Level base = {width, height, std::vector<uint32_t>((size_t)width * height)};
+    for (size_t i = 0; i < base.texels.size(); ++i) {
+        const unsigned char* t = rgba + 4 * i;
+        base.texels[i] = (uint32_t)t[0] | (uint32_t)t[1] << 8 | (uint32_t)t[2] << 16 | (uint32_t)t[3] << 24;
+    }
+    levels.push_back(std::move(base));
+
+    // 2x2 box filter, like glGenerateMipmap; odd edges repeat their last texel
+    while (levels.back().width > 1 || levels.back().height > 1) {
+        const Level& source = levels.back();
+        Level next = {std::max(1, source.width / 2), std::max(1, source.height / 2), {}};
+        next.texels.resize((size_t)next.width * next.height);
+        for (int y = 0; y < next.height; ++y) {
+            int y0 = std::min(2 * y, source.height - 1), y1 = std::min(2 * y + 1, source.height - 1);
+            for (int x = 0; x < next.width; ++x) {
+                int x0 = std::min(2 * x, source.width - 1), x1 = std::min(2 * x + 1, source.width - 1);
+                uint32_t t[4] = {source.texels[(size_t)y0 * source.width + x0],
+                                 source.texels[(size_t)y0 * source.width + x1],
+                                 source.texels[(size_t)y1 * source.width + x0],
+                                 source.texels[(size_t)y1 * source.width + x1]};
+                uint32_t packed = 0;
+                for (int shift = 0; shift < 32; shift += 8) {
+                    uint32_t sum = 2;
+                    for (uint32_t texel : t) sum += texel >> shift & 0xFF;
+                    packed |= (sum / 4) << shift;
+                }
+                next.texels[(size_t)y * next.width + x] = packed;
+            }
+        }
+        levels.push_back(std::move(next));
+    }
+}
+
+glm::vec4 SoftwareTexture::sampleLevel(const glm::vec2& uv, int level) const {
+    const Level& l = levels[level];
+    // Repeat first so the texel coordinates stay small
+    float u = (uv.x - std::floor(uv.x)) * l.width - 0.5f;
+    float v = (uv.y - std::floor(uv.y)) * l.height - 0.5f;
+    float fx = std::floor(u), fy = std::floor(v);
+    float tx = u - fx, ty = v - fy;
+    int x0 = wrap((int)fx, l.width), x1 = wrap((int)fx + 1, l.width);
+    int y0 = wrap((int)fy, l.height), y1 = wrap((int)fy + 1, l.height);
+    const uint32_t* row0 = &l.texels[(size_t)y0 * l.width];
+    const uint32_t* row1 = &l.texels[(size_t)y1 * l.width];
+    glm::vec4 bottom = glm::mix(unpack(row0[x0]), unpack(row0[x1]), tx);
+    glm::vec4 top = glm::mix(unpack(row1[x0]), unpack(row1[x1]), tx);
+    return glm::mix(bottom, top, ty);
+}
+
+glm::vec4 SoftwareTexture::sample(const glm::vec2& uv, const glm::vec2& dUVdx, const glm::vec2& dUVdy,
+                                  Filter filter) const {
+    if (filter == BILINEAR || levels.size() == 1) return sampleLevel(uv, 0);
+
+    // rho = the longer footprint axis in texels; lod <= 0 is magnification
+    glm::vec2 size((float)width(), (float)height());
+    float rho = std::max(glm::length(dUVdx * size), glm::length(dUVdy * size));
+    float lod = rho > 0.0f ? std::log2(rho) : 0.0f;
+    if (lod <= 0.0f) return sampleLevel(uv, 0);
+    float maxLevel = (float)(levels.size() - 1);
+    if (lod >= maxLevel) return sampleLevel(uv, (int)maxLevel);
+    int level = (int)lod;
+    return glm::mix(sampleLevel(uv, level), sampleLevel(uv, level + 1), lod - level);
+}
+
+SoftwareRasterizer::SoftwareRasterizer(int width, int height) {
+    resize(width, height);
+}
+
+void SoftwareRasterizer::resize(int width, int height) {
+    width = std::max(1, width);
+    height = std::max(1, height);
+    if (width == frameWidth && height == frameHeight) return;
+    frameWidth = width;
+    frameHeight = height;
+    tilesX = (width + TILE_SIZE - 1) / TILE_SIZE;
+    tilesY = (height + TILE_SIZE - 1) / TILE_SIZE;
+    size_t padded = (size_t)tilesX * TILE_SIZE * tilesY * TILE_SIZE;
+    tileDepth.assign(padded, 1.0f);
+    visibility.assign(padded, nullptr);
+    colorBuffer.assign((size_t)width * height, 0);
+    depthBuffer.assign((size_t)width * height, 1.0f);
+    bins.clear();
+}
+
+void SoftwareRasterizer::begin(const glm::mat4& view, const glm::mat4& projection, const glm::vec3& eye,
+                               const std::vector<PointLight>& lights, const glm::vec4& clearColor) {
+    viewProjection = projection * view;
+    eyePosition = eye;
+    frameLights = &lights;
+    clear = clearColor;
+    draws.clear();
+    firstTriangle.clear();
+    totalVertices = totalTriangles = 0;
+    lastStats = Stats();
+}
+
+void SoftwareRasterizer::draw(const Mesh& mesh, const glm::mat4& model, const Material& material) {
+    Draw d;
+    d.mesh = &mesh;
+    d.model = model;
+    d.material = material;
+    d.firstVertex = totalVertices;
+    d.lightWorker = 0;
+    d.firstLight = d.lightCount = 0;
+    draws.push_back(d);
+    firstTriangle.push_back(totalTriangles);
+    totalVertices += mesh.vertices.size() / VERTEX_FLOATS;
+    totalTriangles += mesh.indices.size() / 3;
+    lastStats.draws++;
+    lastStats.triangles += (unsigned)(mesh.indices.size() / 3);
+}
+
+void SoftwareRasterizer::prepareWorkers(unsigned workers) {
+    size_t tiles = (size_t)tilesX * tilesY;
+    lightLists.resize(workers);
+    workerTriangles.resize(workers);
+    clipVertices.resize(workers);
+    tileEntries.resize(workers);
+    counters.assign(workers, WorkerCounters());
+    if (bins.size() != workers * tiles) {
+        bins.clear();
+        bins.resize(workers * tiles);
+    }
+    for (unsigned w = 0; w < workers; ++w) {
+        lightLists[w].clear();
+        workerTriangles[w].clear();
+        clipVertices[w].clear();
+    }
+    for (std::vector<BinEntry>& bin : bins) bin.clear();
+}
+
+void SoftwareRasterizer::finish(JobPool& pool) {
+    unsigned workers = pool.size();
+    prepareWorkers(workers);
+    vertices.resize(totalVertices);
+
+    // Stages 1 and 2 per draw: a draw's triangles only use its own vertices. The
+    // per-worker triangle lists don't move once this returns.
+    auto start = Clock::now();
+    size_t grain = std::max<size_t>(1, draws.size() / (workers * 8));
+    pool.parallelFor(draws.size(), grain, [&](size_t begin, size_t end, unsigned worker) {
+        for (size_t d = begin; d < end; ++d) {
+            transformDraw(d, worker);
+            setupDraw(d, worker);
+        }
+    });
+    auto setupEnd = Clock::now();
+
+    pool.parallelFor((size_t)tilesX * tilesY, 1, [&](size_t begin, size_t end, unsigned worker) {
+        for (size_t tile = begin; tile < end; ++tile) rasterizeTile((int)tile, worker);
+    });
+    auto rasterEnd = Clock::now();
+
+    for (const WorkerCounters& c : counters) {
+        lastStats.rasterized += c.rasterized;
+        lastStats.binned += c.binned;
+        lastStats.fragments += c.fragments;
+        lastStats.shaded += c.shaded;
+    }
+    lastStats.setupMs = std::chrono::duration<float, std::milli>(setupEnd - start).count();
+    lastStats.rasterMs = std::chrono::duration<float, std::milli>(rasterEnd - setupEnd).count();
+}
+
+// vertexShader.glsl: world position, clip position and a TBN from mat3(model)
+void SoftwareRasterizer::transformDraw(size_t drawIndex, unsigned worker) {
+    Draw& d = draws[drawIndex];
+    const std::vector<float>& source = d.mesh->vertices;
+    size_t count = source.size() / VERTEX_FLOATS;
+    glm::mat3 basis(d.model);
+    for (size_t i = 0; i < count; ++i) {
+        const float* in = &source[i * VERTEX_FLOATS];
+        Vertex& out = vertices[d.firstVertex + i];
+        glm::vec4 world = d.model * glm::vec4(in[0], in[1], in[2], 1.0f);
+        out.world = glm::vec3(world);
+        out.clip = viewProjection * world;
+        out.normal = glm::normalize(basis * glm::vec3(in[3], in[4], in[5]));
+        out.uv = glm::vec2(in[6], in[7]);
+        out.tangent = glm::normalize(basis * glm::vec3(in[8], in[9], in[10]));
+        out.bitangent = glm::normalize(basis * glm::vec3(in[11], in[12], in[13]));
+    }
+
+    // Lights whose sphere reaches the draw's bounds; the rest contribute exactly 0
+    // in shade(), since their falloff is 0
+    glm::vec3 center = glm::vec3(d.model * glm::vec4(d.mesh->bounds.center, 1.0f));
+    float scale = std::max(glm::length(basis[0]), std::max(glm::length(basis[1]), glm::length(basis[2])));
+    float radius = d.mesh->bounds.radius * scale;
+    std::vector<uint32_t>& list = lightLists[worker];
+    d.lightWorker = worker;
+    d.firstLight = list.size();
+    const std::vector<PointLight>& lights = *frameLights;
+    for (size_t i = 0; i < lights.size(); ++i) {
+        float reach = radius + lights[i].radius;
+        glm::vec3 offset = lights[i].position - center;
+        if (glm::dot(offset, offset) < reach * reach) list.push_back((uint32_t)i);
+    }
+    d.lightCount = list.size() - d.firstLight;
+}
+
+void SoftwareRasterizer::setupDraw(size_t drawIndex, unsigned worker) {
+    const Draw& d = draws[drawIndex];
+    const std::vector<uint32_t>& indices = d.mesh->indices;
+    const Vertex* base = &vertices[d.firstVertex];
+    std::deque<Vertex>& clipped = clipVertices[worker];
+
+    for (size_t t = 0; t + 2 < indices.size(); t += 3) {
+        const Vertex* v[3] = {base + indices[t], base + indices[t + 1], base + indices[t + 2]};
+        uint32_t order = (uint32_t)(firstTriangle[drawIndex] + t / 3);
+
+        // Whole triangle outside one frustum plane
+        int outside[6] = {};
+        for (const Vertex* vertex : v) {
+            const glm::vec4& c = vertex->clip;
+            outside[0] += c.x < -c.w;
+            outside[1] += c.x > c.w;
+            outside[2] += c.y < -c.w;
+            outside[3] += c.y > c.w;
+            outside[4] += c.z < -c.w;
+            outside[5] += c.z > c.w;
+        }
+        if (std::find(outside, outside + 6, 3) != outside + 6) continue;
+        if (outside[4] == 0 && outside[5] == 0) {
+            setupTriangle(v[0], v[1], v[2], (uint32_t)drawIndex, order, worker);
+            continue;
+        }
+
+        // Sutherland-Hodgman against the near (z >= -w) and far (z <= w) planes;
+        // x and y are left to the screen bounds. At most 5 vertices come out.
+        Vertex polygon[2][8];
+        int count = 3;
+        for (int i = 0; i < 3; ++i) polygon[0][i] = *v[i];
+        for (int plane = 0; plane < 2; ++plane) {
+            const Vertex* in = polygon[plane];
+            Vertex* out = polygon[plane ^ 1];
+            float sign = plane == 0 ? 1.0f : -1.0f;
+            int kept = 0;
+            for (int i = 0; i < count; ++i) {
+                const Vertex& a = in[i];
+                const Vertex& b = in[(i + 1) % count];
+                float da = a.clip.w + sign * a.clip.z, db = b.clip.w + sign * b.clip.z;
+                if (da >= 0.0f) out[kept++] = a;
+                if ((da >= 0.0f) != (db >= 0.0f)) {
+                    float f = da / (da - db);
+                    Vertex& m = out[kept++];
+                    m.clip = glm::mix(a.clip, b.clip, f);
+                    m.world = glm::mix(a.world, b.world, f);
+                    m.uv = glm::mix(a.uv, b.uv, f);
+                    m.tangent = glm::mix(a.tangent, b.tangent, f);
+                    m.bitangent = glm::mix(a.bitangent, b.bitangent, f);
+                    m.normal = glm::mix(a.normal, b.normal, f);
+                }
+            }
+            count = kept;
+            if (count < 3) break;
+        }
+        if (count < 3) continue;
+
+        // Both passes ran, so the result is back in polygon[0]; fan it out
+        size_t first = clipped.size();
+        for (int i = 0; i < count; ++i) clipped.push_back(polygon[0][i]);
+        for (int i = 1; i + 1 < count; ++i)
+            setupTriangle(&clipped[first], &clipped[first + i], &clipped[first + i + 1], (uint32_t)drawIndex, order,
+                          worker);
+    }
+}
+
+void SoftwareRasterizer::setupTriangle(const Vertex* a, const Vertex* b, const Vertex* c, uint32_t draw,
+                                       uint32_t order, unsigned worker) {
+    const Vertex* v[3] = {a, b, c};
+    glm::vec3 p[3];
+    float invW[3];
+    for (int i = 0; i < 3; ++i) {
+        const glm::vec4& clip = v[i]->clip;
+        if (clip.w <= 1e-20f) return;
+        invW[i] = 1.0f / clip.w;
+        // Snapped to 1/256 pixel, so vertices shared by neighbours land on the same point
+        float x = (clip.x * invW[i] * 0.5f + 0.5f) * frameWidth;
+        float y = (clip.y * invW[i] * 0.5f + 0.5f) * frameHeight;
+        p[i] = glm::vec3(std::floor(x * 256.0f + 0.5f) * (1.0f / 256.0f),
+                         std::floor(y * 256.0f + 0.5f) * (1.0f / 256.0f), clip.z * invW[i] * 0.5f + 0.5f);
+    }
+
+    float area = (p[1].x - p[0].x) * (p[2].y - p[0].y) - (p[1].y - p[0].y) * (p[2].x - p[0].x);
+    if (area == 0.0f) return;
+
+    Triangle tri;
+    float minX = std::min(p[0].x, std::min(p[1].x, p[2].x)), maxX = std::max(p[0].x, std::max(p[1].x, p[2].x));
+    float minY = std::min(p[0].y, std::min(p[1].y, p[2].y)), maxY = std::max(p[0].y, std::max(p[1].y, p[2].y));
+    tri.x0 = std::max(0, (int)std::floor(minX));
+    tri.x1 = std::min(frameWidth - 1, (int)std::floor(maxX));
+    tri.y0 = std::max(0, (int)std::floor(minY));
+    tri.y1 = std::min(frameHeight - 1, (int)std::floor(maxY));
+    if (tri.x0 > tri.x1 || tri.y0 > tri.y1) return;
+
+    // Each edge is built from its endpoints in a fixed order, then negated as a
+    // whole. A neighbour sharing the edge computes the exact negation, so a pixel
+    // centre is inside exactly one of them, or on the edge of both.
+    for (int i = 0; i < 3; ++i) {
+        glm::vec3 from = p[i], to = p[(i + 1) % 3];
+        bool swapped = to.y < from.y || (to.y == from.y && to.x < from.x);
+        if (swapped) std::swap(from, to);
+        float A = from.y - to.y, B = to.x - from.x;
+        glm::vec3 edge(A, B, -(A * from.x + B * from.y));
+        if (swapped != (area < 0.0f)) edge = -edge;
+        tri.edge[i] = edge;
+        // Ties go to the triangle on the +x side (or +y for horizontal edges), the
+        // top-left rule with y up; the neighbour gets the opposite answer
+        tri.owns[i] = edge.x > 0.0f || (edge.x == 0.0f && edge.y > 0.0f);
+    }
+
+    float dx1 = p[1].x - p[0].x, dy1 = p[1].y - p[0].y, dz1 = p[1].z - p[0].z;
+    float dx2 = p[2].x - p[0].x, dy2 = p[2].y - p[0].y, dz2 = p[2].z - p[0].z;
+    float depthA = (dz1 * dy2 - dz2 * dy1) / area;
+    float depthB = (dz2 * dx1 - dz1 * dx2) / area;
+    tri.depth = glm::vec3(depthA, depthB, p[0].z - depthA * p[0].x - depthB * p[0].y);
+
+    // Vertex k's barycentric is the edge opposite it over the doubled area
+    float invArea = 1.0f / std::fabs(area);
+    for (int k = 0; k < 3; ++k) tri.perspective[k] = tri.edge[(k + 1) % 3] * (invW[k] * invArea);
+    for (int k = 0; k < 3; ++k) tri.v[k] = v[k];
+    tri.draw = draw;
+
+    std::vector<Triangle>& triangles = workerTriangles[worker];
+    uint32_t index = (uint32_t)triangles.size();
+    triangles.push_back(tri);
+    counters[worker].rasterized++;
+
+    // Bin into the tiles of the bounds that some part of the triangle can reach:
+    // a tile is skipped when one edge is negative at all of its pixel centres
+    size_t tiles = (size_t)tilesX * tilesY;
+    for (int ty = tri.y0 / TILE_SIZE; ty <= tri.y1 / TILE_SIZE; ++ty) {
+        float cy0 = std::max(tri.y0, ty * TILE_SIZE) + 0.5f;
+        float cy1 = std::min(tri.y1, ty * TILE_SIZE + TILE_SIZE - 1) + 0.5f;
+        for (int tx = tri.x0 / TILE_SIZE; tx <= tri.x1 / TILE_SIZE; ++tx) {
+            float cx0 = std::max(tri.x0, tx * TILE_SIZE) + 0.5f;
+            float cx1 = std::min(tri.x1, tx * TILE_SIZE + TILE_SIZE - 1) + 0.5f;
+            bool reached = true;
+            for (int i = 0; i < 3 && reached; ++i) {
+                const glm::vec3& e = tri.edge[i];
+                reached = e.x * (e.x > 0.0f ? cx1 : cx0) + e.y * (e.y > 0.0f ? cy1 : cy0) + e.z >= 0.0f;
+            }
+            if (!reached) continue;
+            bins[worker * tiles + (size_t)ty * tilesX + tx].push_back({order, index, worker});
+            counters[worker].binned++;
+        }
+    }
+}
+
+void SoftwareRasterizer::rasterizeTile(int tile, unsigned worker) {
+    size_t tiles = (size_t)tilesX * tilesY;
+    int tileX = tile % tilesX * TILE_SIZE, tileY = tile / tilesX * TILE_SIZE;
+    size_t stride = (size_t)tilesX * TILE_SIZE;
+
+    for (int y = tileY; y < tileY + TILE_SIZE; ++y) {
+        std::fill_n(&tileDepth[y * stride + tileX], TILE_SIZE, 1.0f);
+        std::fill_n(&visibility[y * stride + tileX], TILE_SIZE, nullptr);
+    }
+
+    // Every worker's triangles for this tile, back in submission order
+    std::vector<BinEntry>& entries = tileEntries[worker];
+    entries.clear();
+    for (size_t w = 0; w < workerTriangles.size(); ++w) {
+        const std::vector<BinEntry>& bin = bins[w * tiles + tile];
+        entries.insert(entries.end(), bin.begin(), bin.end());
+    }
+    std::sort(entries.begin(), entries.end(), [](const BinEntry& a, const BinEntry& b) {
+        return a.order != b.order ? a.order < b.order : a.triangle < b.triangle;
+    });
+
+    int x1 = std::min(tileX + TILE_SIZE, frameWidth) - 1, y1 = std::min(tileY + TILE_SIZE, frameHeight) - 1;
+    for (const BinEntry& entry : entries) {
+        const Triangle& tri = workerTriangles[entry.worker][entry.triangle];
+        rasterizeTriangle(tri, std::max(tileX, tri.x0), std::max(tileY, tri.y0), std::min(x1, tri.x1),
+                          std::min(y1, tri.y1), worker);
+    }
+
+    // Shade the survivors, once per pixel
+    uint32_t clearColor = pack(clear);
+    unsigned shaded = 0;
+    for (int y = tileY; y <= y1; ++y) {
+        for (int x = tileX; x <= x1; ++x) {
+            size_t padded = y * stride + x, out = (size_t)y * frameWidth + x;
+            const Triangle* tri = visibility[padded];
+            if (!tri) {
+                colorBuffer[out] = clearColor;
+                depthBuffer[out] = 1.0f;
+                continue;
+            }
+            colorBuffer[out] = shadePixel(*tri, x + 0.5f, y + 0.5f);
+            depthBuffer[out] = tileDepth[padded];
+            ++shaded;
+        }
+    }
+    counters[worker].shaded += shaded;
+}
+
+void SoftwareRasterizer::rasterizeTriangle(const Triangle& tri, int x0, int y0, int x1, int y1, unsigned worker) {
+    if (x0 > x1 || y0 > y1) return;
+    size_t stride = (size_t)tilesX * TILE_SIZE;
+    // Rows start on a lane boundary of the tile; the padding keeps the last group in bounds
+    int xStart = x0 - (x0 % LANES);
+    const Lanes zero = splat(0.0f);
+    const Lanes limit = splat((float)(x1 + 1));
+    const Lanes centres = laneCentres();
+    const Lanes depthX = splat(tri.depth.x);
+    Lanes edgeX[3];
+    for (int i = 0; i < 3; ++i) edgeX[i] = splat(tri.edge[i].x);
+    unsigned fragments = 0;
+
+    for (int y = y0; y <= y1; ++y) {
+        float fy = y + 0.5f;
+        Lanes rowEdge[3];
+        for (int i = 0; i < 3; ++i) rowEdge[i] = splat(tri.edge[i].y * fy + tri.edge[i].z);
+        Lanes rowDepth = splat(tri.depth.y * fy + tri.depth.z);
+        float* depthRow = &tileDepth[y * stride];
+        const Triangle** idRow = &visibility[y * stride];
+
+        for (int x = xStart; x <= x1; x += LANES) {
+            Lanes px = add(splat((float)x), centres);
+            Mask inside = less(px, limit);
+            for (int i = 0; i < 3; ++i) {
+                Lanes e = add(mul(edgeX[i], px), rowEdge[i]);
+                inside = both(inside, tri.owns[i] ? greaterEqual(e, zero) : greater(e, zero));
+            }
+            if (!bits(inside)) continue;
+
+            Lanes z = add(mul(depthX, px), rowDepth);
+            Lanes stored = load(depthRow + x);
+            Mask pass = both(inside, less(z, stored));
+            int covered = bits(pass);
+            if (!covered) continue;
+            store(depthRow + x, select(pass, z, stored));
+            for (int lane = 0; lane < LANES; ++lane) {
+                if (!(covered >> lane & 1)) continue;
+                idRow[x + lane] = &tri;
+                ++fragments;
+            }
+        }
+    }
+    counters[worker].fragments += fragments;
+}
+
+// fragmentShader.glsl + shade() from shaders/common/shading.glsl
+uint32_t SoftwareRasterizer::shadePixel(const Triangle& tri, float x, float y) const {
+    float weight[3], sum = 0.0f;
+    for (int k = 0; k < 3; ++k) {
+        weight[k] = tri.perspective[k].x * x + tri.perspective[k].y * y + tri.perspective[k].z;
+        sum += weight[k];
+    }
+    float invSum = 1.0f / sum;
+    for (int k = 0; k < 3; ++k) weight[k] *= invSum;
+    const Vertex& a = *tri.v[0];
+    const Vertex& b = *tri.v[1];
+    const Vertex& c = *tri.v[2];
+    glm::vec3 fragPos = a.world * weight[0] + b.world * weight[1] + c.world * weight[2];
+    glm::vec2 uv = a.uv * weight[0] + b.uv * weight[1] + c.uv * weight[2];
+    glm::vec3 T = a.tangent * weight[0] + b.tangent * weight[1] + c.tangent * weight[2];
+    glm::vec3 B = a.bitangent * weight[0] + b.bitangent * weight[1] + c.bitangent * weight[2];
+    glm::vec3 N = a.normal * weight[0] + b.normal * weight[1] + c.normal * weight[2];
+
+    // Screen-space uv derivatives for mip selection, exact for the triangle:
+    // uv = U / W with U and W linear on screen
+    const Draw& d = draws[tri.draw];
+    const Material& material = d.material;
+    glm::vec2 dUVdx(0.0f), dUVdy(0.0f);
+    if (material.filter == SoftwareTexture::TRILINEAR) {
+        glm::vec2 dUdx(0.0f), dUdy(0.0f);
+        float dWdx = 0.0f, dWdy = 0.0f;
+        const glm::vec2 uvs[3] = {a.uv, b.uv, c.uv};
+        for (int k = 0; k < 3; ++k) {
+            dUdx += uvs[k] * tri.perspective[k].x;
+            dUdy += uvs[k] * tri.perspective[k].y;
+            dWdx += tri.perspective[k].x;
+            dWdy += tri.perspective[k].y;
+        }
+        dUVdx = (dUdx - uv * dWdx) * invSum;
+        dUVdy = (dUdy - uv * dWdy) * invSum;
+    }
+
+    glm::vec3 albedo(1.0f);
+    if (material.diffuse) albedo = glm::vec3(material.diffuse->sample(uv, dUVdx, dUVdy, material.filter));
+    glm::vec3 norm;
+    if (material.normalMap) {
+        glm::vec3 mapped =
+            glm::normalize(glm::vec3(material.normalMap->sample(uv, dUVdx, dUVdy, material.filter)) * 2.0f - 1.0f);
+        norm = glm::normalize(T * mapped.x + B * mapped.y + N * mapped.z);
+    } else {
+        norm = glm::normalize(N);
+    }
+
+    glm::vec3 viewDir = glm::normalize(eyePosition - fragPos);
+    glm::vec3 result(0.0f);
+    const std::vector<PointLight>& lights = *frameLights;
+    const uint32_t* list = lightLists[d.lightWorker].data() + d.firstLight;
+    for (size_t i = 0; i < d.lightCount; ++i) {
+        const PointLight& light = lights[list[i]];
+        glm::vec3 toLight = light.position - fragPos;
+        float distance = glm::length(toLight);
+        float falloff = lightFalloff(distance, light.radius);
+        if (falloff <= 0.0f) continue;
+        glm::vec3 lightColor = light.color * light.intensity * falloff;
+
+        glm::vec3 ambient = 0.1f * lightColor;
+
+        glm::vec3 lightDir = toLight / std::max(distance, 1e-4f);
+        float diff = std::max(glm::dot(norm, lightDir), 0.0f);
+        glm::vec3 diffuse = diff * lightColor;
+
+        glm::vec3 reflectDir = glm::reflect(-lightDir, norm);
+        float spec = std::max(glm::dot(viewDir, reflectDir), 0.0f);
+        spec *= spec;    // pow(spec, 32)
+        spec *= spec;
+        spec *= spec;
+        spec *= spec;
+        spec *= spec;
+        glm::vec3 specular = material.specularStrength * spec * lightColor;
+
+        result += (ambient + diffuse + specular) * albedo;
+    }
+    return pack(glm::vec4(result, 1.0f));
+}
+
+void SoftwareRasterizer::readRGB(std::vector<unsigned char>& rgb) const {
+    rgb.resize((size_t)frameWidth * frameHeight * 3);
+    for (int y = 0; y < frameHeight; ++y) {
+        const uint32_t* row = &colorBuffer[(size_t)(frameHeight - 1 - y) * frameWidth];
+        unsigned char* out = &rgb[(size_t)y * frameWidth * 3];
+        for (int x = 0; x < frameWidth; ++x) {
+            out[3 * x] = (unsigned char)(row[x] & 0xFF);
+            out[3 * x + 1] = (unsigned char)(row[x] >> 8 & 0xFF);
+            out[3 * x + 2] = (unsigned char)(row[x] >> 16 & 0xFF);
+        }
+    }
+}
@@ -4,9 +4,41 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 #include <iostream>
+#include <cstring>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <algorithm>
 #include "Setup.h"
+#include "GLDebug.h"
 #include "Shader.h"
+#include "ShaderLibrary.h"
+#include "UniformBuffer.h"
+#include "RenderQueue.h"
+#include "FrustumCuller.h"
+#include "OcclusionCuller.h"
+#include "SoftwareRasterizer.h"
+#include "LightmapBaker.h"
+#include "Lightmap.h"
+#include "BVH.h"
 #include "FG.h"
+#include "Instancing.h"
+#include "GeometryBuffer.h"
+#include "IndirectRenderer.h"
+#include "CommandList.h"
+#include "ClusteredLighting.h"
+#include "NormalMatrix.h"
+#include "DeferredShading.h"
+#include "FrameGraph.h"
+#include "SceneTarget.h"
+#include "ResolutionController.h"
+#include "JobPool.h"
+#include "FramePipeline.h"
+#include "FrameCapture.h"
+#include "CameraPath.h"
+#include "Profiler.h"
 #include "Texture.h"
 #include "Grid.h"
 #include "Orbital.h" // Include the OrbitalCamera header file
@@ -14,21 +46,255 @@
 // Global camera
 OrbitalCamera camera(glm::vec3(0.0f), 10.0f, -90.0f, 0.0f);
 
-int main() {
-    Window win(800, 600, "Main");
+// Render queue payloads and dense key IDs
+enum DrawId { DRAW_CUBE, DRAW_PYRAMID, DRAW_SPHERE, DRAW_GRID };
+enum ProgramId { PROGRAM_LIT, PROGRAM_GRID, PROGRAM_LIGHTMAPPED };
+enum MaterialId { MATERIAL_NONE, MATERIAL_WOOD, MATERIAL_STONE, MATERIAL_METAL };
+
+// Command line:
+//   --instances N   stress scene of N objects; cubes drawn with one instanced call
+//   --naive         ...or one glDrawElements per cube, for comparison
+//   --command-lists with --naive, record those draws on the job pool and replay them
+//   --indirect      ...or cubes, pyramids and spheres in one multi-draw indirect call
+//   --no-indirect   draw the scene with the per-object loop even on GL 4.3+
+//   --lights N      N extra point lights orbiting the scene (clustered shading)
+//   --deferred      start with deferred shading; Tab switches forward/deferred at runtime
+//   --prepass       start with the depth pre-pass on; P toggles it at runtime
+//   --occlusion     start with CPU occlusion culling on; O toggles it at runtime
+//   --profile FILE  write the CPU/GPU scope timings to FILE (CSV) on exit
+//   --dynamic-resolution MS   render offscreen at a scale that keeps the GPU frame under MS
+//   --scale-range MIN MAX     bounds of that scale (default 0.5 1.0)
+//   --grid-lines    draw the grid as a line list instead of the procedural quad
+//   --single-thread simulate and render in turn on one thread instead of pipelining them
+//   --headless N    no window: render N frames offscreen through EGL at a fixed 60 Hz step, then exit
+//   --camera-path FILE        drive the orbital camera from FILE (see CameraPath.h)
+//   --dump-frames DIR         with --headless, write every frame to DIR/frame_NNNNN.ppm
+//   --dump-every N            ...only frames 0, N, 2N, ... (the readback stalls the GPU)
+//   --timing-json FILE        write per-frame CPU/GPU timings and their percentiles to FILE on exit
+//   --software      rasterize and shade the opaque scene on the CPU (SoftwareRasterizer), then present it through GL
+//   --bake-lightmap FILE      bake the key lights into a lightmap of the static objects, write FILE and use it
+//   --lightmap FILE           use a lightmap baked by --bake-lightmap; the objects stop animating
+//   --gl-debug SEVERITY       least severe GL debug output logged in Debug builds: high, medium, low (default)
+//                             or notification
+enum StressPath { STRESS_INSTANCED, STRESS_NAIVE, STRESS_INDIRECT };
+
+struct LaunchOptions {
+    size_t instances = 0;
+    StressPath stressPath = STRESS_INSTANCED;
+    bool indirect = true;
+    size_t lights = 0;
+    bool deferred = false;
+    bool depthPrepass = false;
+    bool occlusion = false;
+    std::string profileCsv;
+    bool dynamicResolution = false;
+    float targetFrameMs = 16.6f;
+    float minScale = 0.5f, maxScale = 1.0f;
+    bool gridLines = false;
+    bool commandLists = false;
+    bool singleThread = false;
+    unsigned headlessFrames = 0;   // 0: windowed
+    std::string cameraPath;
+    std::string dumpFramesDir;
+    unsigned dumpEvery = 1;
+    std::string timingJson;
+    bool software = false;
+    std::string lightmap;
+    bool bakeLightmap = false;
+    // Least severe GL debug output message logged (debug builds)
+    GLDebug::Filter::Severity glDebugSeverity = GLDebug::Filter::LOW;
+};
+
+// Everything the render stage reads from the simulation for one frame. The
+// simulation fills one while the render thread draws another (FramePipeline).
+struct FrameSnapshot {
+    unsigned index = 0;
+    float time = 0.0f;                        // Seconds; drives the animation
+    glm::mat4 view, projection;
+    glm::vec3 eye;
+    glm::mat4 cubeModel, pyramidModel, sphereModel;
+    glm::mat3 cubeNormal, pyramidNormal, sphereNormal;
+    std::vector<InstanceData> stressInstances;
+    std::vector<glm::vec3> lightPositions;    // Orbiting lights, after the key lights
+    bool deferred = false;
+    bool depthPrepass = false;
+    bool occlusionCulling = false;
+    float simulationMs = 0.0f;
+};
+
+// Programs of one opaque pass: forward shading, G-buffer writes or depth only
+struct LitPrograms {
+    Shader* scene;
+    Shader* instanced;
+    Shader* indirect;       // Scene materials (2D textures per bucket)
+    Shader* indirectArray;  // Stress materials (texture array layers)
+};
+
+// Transforms of the lit objects at time t. Lightmapped runs keep them at t = 0,
+// where the bake placed them.
+static void objectModels(float t, glm::mat4& cube, glm::mat4& pyramid, glm::mat4& sphere) {
+    cube = glm::mat4(1.0f);
+    cube = glm::rotate(cube, t, glm::vec3(0.0f, 0.0f, 1.0f));
+    cube = glm::scale(cube, glm::vec3(0.5f, 0.5f, 0.5f));
+    cube = glm::translate(cube, glm::vec3(1.0f, 0.5f, 0.0f));
+
+    pyramid = glm::mat4(1.0f);
+    pyramid = glm::rotate(pyramid, t, glm::vec3(0.0f, 1.0f, 0.0f));
+    pyramid = glm::translate(pyramid, glm::vec3(-1.0f, 0.5f, 0.0f));
+
+    sphere = glm::mat4(1.0f);
+    sphere = glm::rotate(sphere, t, glm::vec3(1.0f, 1.0f, 1.0f));
+    sphere = glm::translate(sphere, glm::vec3(3.0f, 0.5f, 0.0f));
+}
+
+static LaunchOptions parseLaunchOptions(int argc, char** argv) {
+    LaunchOptions options;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--instances") == 0 && i + 1 < argc)
+            options.instances = std::strtoul(argv[++i], nullptr, 10);
+        else if (std::strcmp(argv[i], "--naive") == 0)
+            options.stressPath = STRESS_NAIVE;
+        else if (std::strcmp(argv[i], "--command-lists") == 0)
+            options.commandLists = true;
+        else if (std::strcmp(argv[i], "--single-thread") == 0)
+            options.singleThread = true;
+        else if (std::strcmp(argv[i], "--indirect") == 0)
+            options.stressPath = STRESS_INDIRECT;
+        else if (std::strcmp(argv[i], "--no-indirect") == 0)
+            options.indirect = false;
+        else if (std::strcmp(argv[i], "--lights") == 0 && i + 1 < argc)
+            options.lights = std::strtoul(argv[++i], nullptr, 10);
+        else if (std::strcmp(argv[i], "--deferred") == 0)
+            options.deferred = true;
+        else if (std::strcmp(argv[i], "--prepass") == 0)
+            options.depthPrepass = true;
+        else if (std::strcmp(argv[i], "--occlusion") == 0)
+            options.occlusion = true;
+        else if (std::strcmp(argv[i], "--profile") == 0 && i + 1 < argc)
+            options.profileCsv = argv[++i];
+        else if (std::strcmp(argv[i], "--dynamic-resolution") == 0 && i + 1 < argc) {
+            options.dynamicResolution = true;
+            options.targetFrameMs = std::strtof(argv[++i], nullptr);
+        } else if (std::strcmp(argv[i], "--scale-range") == 0 && i + 2 < argc) {
+            options.minScale = std::strtof(argv[++i], nullptr);
+            options.maxScale = std::strtof(argv[++i], nullptr);
+        } else if (std::strcmp(argv[i], "--grid-lines") == 0)
+            options.gridLines = true;
+        else if (std::strcmp(argv[i], "--headless") == 0 && i + 1 < argc)
+            options.headlessFrames = (unsigned)std::strtoul(argv[++i], nullptr, 10);
+        else if (std::strcmp(argv[i], "--camera-path") == 0 && i + 1 < argc)
+            options.cameraPath = argv[++i];
+        else if (std::strcmp(argv[i], "--dump-frames") == 0 && i + 1 < argc)
+            options.dumpFramesDir = argv[++i];
+        else if (std::strcmp(argv[i], "--dump-every") == 0 && i + 1 < argc)
+            options.dumpEvery = std::max(1u, (unsigned)std::strtoul(argv[++i], nullptr, 10));
+        else if (std::strcmp(argv[i], "--timing-json") == 0 && i + 1 < argc)
+            options.timingJson = argv[++i];
+        else if (std::strcmp(argv[i], "--software") == 0)
+            options.software = true;
+        else if (std::strcmp(argv[i], "--bake-lightmap") == 0 && i + 1 < argc) {
+            options.lightmap = argv[++i];
+            options.bakeLightmap = true;
+        } else if (std::strcmp(argv[i], "--lightmap") == 0 && i + 1 < argc)
+            options.lightmap = argv[++i];
+        else if (std::strcmp(argv[i], "--gl-debug") == 0 && i + 1 < argc) {
+            if (!GLDebug::Filter::parseSeverity(argv[++i], options.glDebugSeverity))
+                std::cerr << "--gl-debug takes high, medium, low or notification" << std::endl;
+        }
+    }
+    return options;
+}
+
+int main(int argc, char** argv) {
+    LaunchOptions options = parseLaunchOptions(argc, argv);
+
+    bool headless = options.headlessFrames > 0;
+    Window win(800, 600, "Main", headless);
+    win.debugFilter.minSeverity = options.glDebugSeverity;
     if (!win.init()) return -1;
 
-    // Shaders
-    Shader myShader("shaders/vertexShader.glsl", "shaders/fragmentShader.glsl");
-    Shader gridShader("shaders/grid_vertex.glsl", "shaders/grid_fragment.glsl");
+    CameraPath cameraPath;
+    if (!options.cameraPath.empty() && !cameraPath.load(options.cameraPath)) return -1;
+
+    // Shaders (hot-reloaded when a source or one of its includes changes)
+    ShaderLibrary shaders;
+    Shader& myShader = shaders.load("shaders/vertexShader.glsl", "shaders/fragmentShader.glsl");
+    // The procedural grid unless --grid-lines asks for the line list
+    Shader& gridShader = options.gridLines
+        ? shaders.load("shaders/grid_lines_vertex.glsl", "shaders/grid_lines_fragment.glsl")
+        : shaders.load("shaders/grid_vertex.glsl", "shaders/grid_fragment.glsl");
+    Shader& instancedShader = shaders.load("shaders/instanced_vertex.glsl", "shaders/instanced_fragment.glsl");
+    Shader& lightmapShader = shaders.load("shaders/lightmap_vertex.glsl", "shaders/lightmap_fragment.glsl");
+
+    // Multi-draw indirect needs GL 4.3; otherwise everything takes the per-object loop
+    bool indirect = IndirectRenderer::supported();
+    if (!indirect && (options.indirect || options.stressPath == STRESS_INDIRECT))
+        std::cout << "GL 4.3 not available, using per-object draws" << std::endl;
+    if (!indirect && options.stressPath == STRESS_INDIRECT)
+        options.stressPath = STRESS_INSTANCED;
+    LitPrograms forward = {&myShader, &instancedShader, nullptr, nullptr};
+    if (indirect) {
+        forward.indirect = &shaders.load("shaders/indirect_vertex.glsl", "shaders/fragmentShader.glsl");
+        forward.indirectArray = &shaders.load("shaders/indirect_vertex.glsl", "shaders/instanced_fragment.glsl");
+    }
+    bool sceneIndirect = indirect && options.indirect && !options.software;
+
+    // Deferred twins of the lit programs: same vertex shaders, G-buffer fragment shaders
+    LitPrograms deferred = {
+        &shaders.load("shaders/vertexShader.glsl", "shaders/gbuffer_fragment.glsl"),
+        &shaders.load("shaders/instanced_vertex.glsl", "shaders/gbuffer_array_fragment.glsl"), nullptr, nullptr};
+    if (indirect) {
+        deferred.indirect = &shaders.load("shaders/indirect_vertex.glsl", "shaders/gbuffer_fragment.glsl");
+        deferred.indirectArray = &shaders.load("shaders/indirect_vertex.glsl", "shaders/gbuffer_array_fragment.glsl");
+    }
+    // Depth pre-pass programs: position-only streams, empty fragment shader. The
+    // shading pass then tests GL_EQUAL against that depth, so both passes declare
+    // gl_Position invariant: without it the compiler may fold the transform
+    // differently per program and the depths differ in the last bit.
+    LitPrograms depthOnly = {
+        &shaders.load("shaders/depth_vertex.glsl", "shaders/depth_fragment.glsl"),
+        &shaders.load("shaders/depth_instanced_vertex.glsl", "shaders/depth_fragment.glsl"), nullptr, nullptr};
+    if (indirect) {
+        depthOnly.indirect = &shaders.load("shaders/depth_indirect_vertex.glsl", "shaders/depth_fragment.glsl");
+        depthOnly.indirectArray = depthOnly.indirect;
+    }
+    bool depthPrepass = options.depthPrepass;
+
+    Shader& deferredLightingShader = shaders.load("shaders/deferred_vertex.glsl", "shaders/deferred_fragment.glsl");
+    DeferredShading deferredShading;
+    bool useDeferred = options.deferred;
+
+    // The GPU passes of a frame are rebuilt as a graph every frame; render targets
+    // that live inside the frame (the G-buffer) come from the pool
+    FrameGraph frameGraph;
+    RenderTargetPool renderTargets;
+
+    // Camera block shared by every program
+    UniformBuffer<glsl::CameraBlock> cameraBuffer(glsl::binding::Camera);
+
+    // Per-pass CPU and GPU timings; GPU results arrive a few frames late
+    Profiler profiler;
+    const char* drawNames[] = {"cube", "pyramid", "sphere", "grid"};
+
+    // Dynamic resolution: the scene is drawn offscreen at a scale driven by the
+    // measured GPU frame time, then upscaled and sharpened into the window
+    ResolutionController::Settings resolutionSettings;
+    resolutionSettings.targetMs = options.targetFrameMs;
+    resolutionSettings.minScale = std::min(options.minScale, options.maxScale);
+    resolutionSettings.maxScale = options.maxScale;
+    resolutionSettings.latencyFrames = Profiler::FRAME_LATENCY + 1;
+    ResolutionController resolution(resolutionSettings);
+    SceneTarget sceneTarget(resolution.scaled(win.width), resolution.scaled(win.height));
+    Shader& upscaleShader = shaders.load("shaders/deferred_vertex.glsl", "shaders/upscale_fragment.glsl");
+    unsigned measuredGpuFrames = 0;
 
     // Objects
-    Grid grid(500.0f, 1.0f, Grid::XZ_PLANE);
+    Grid grid(500.0f, 1.0f, Grid::XZ_PLANE, options.gridLines ? Grid::LINES : Grid::PROCEDURAL);
 
     // Enable OpenGL settings
-    glEnable(GL_DEPTH_TEST);
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    GLState& gl = GLState::instance();
+    gl.enable(GL_DEPTH_TEST);
+    gl.blendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
     // Load Textures
     unsigned int cubeTexture = loadTexture("assets/oak_veneer_01_diff_4k.jpg");
@@ -50,10 +316,227 @@ int main() {
     Pyramid myPyramid(pyramidTexture, pyramidNormalMap);
     Sphere mySphere(0.8f, sphereTexture, sphereNormalMap);
 
-    // Main loop
+    // Instanced materials; texture array layers must share one size
+    unsigned int materialDiffuse = loadTextureArray({
+        "assets/stonebase.png", "assets/Metal_007_basecolor.png", "assets/texturemetal.jpg"});
+    unsigned int materialNormals = loadTextureArray({
+        "assets/stonenormal.png", "assets/Metal_007_normal.png", "assets/normalmetal.jpg"});
+    const int materialLayers = 3;
+    if (options.instances > 0 && (!materialDiffuse || !materialNormals)) {
+        std::cerr << "Material texture array loading failed!" << std::endl;
+        return -1;
+    }
+
+    // Stress cubes on a lattice around the origin, sharing one cube geometry buffer
+    PrimitiveGeometry cubeGeometry = PrimitiveGeometry::cube();
+    InstancedPrimitive instancedCubes(cubeGeometry, materialDiffuse, materialNormals);
+    std::vector<glm::vec3> stressPositions(options.instances);
+    int side = 1;
+    while ((size_t)side * side * side < options.instances) ++side;
+    for (size_t i = 0; i < options.instances; ++i) {
+        glm::vec3 cell((float)(i % side), (float)(i / side % side), (float)(i / ((size_t)side * side)));
+        stressPositions[i] = (cell - glm::vec3((side - 1) * 0.5f)) * 1.5f;
+    }
+
+    // Scene meshes packed into one buffer for the indirect path, in DrawId order
+    std::vector<float> sphereVertices;
+    std::vector<unsigned int> sphereIndices;
+    buildSphereGeometry(0.8f, sphereVertices, sphereIndices);
+    GeometryBuffer sceneGeometry;
+    sceneGeometry.add(cubeVertices(), cubeIndices());
+    sceneGeometry.add(pyramidVertices(), pyramidIndices());
+    sceneGeometry.add(sphereVertices, sphereIndices);
+    sceneGeometry.upload();
+    IndirectRenderer sceneIndirectDraws(sceneGeometry, 64);
+    IndirectRenderer stressIndirectDraws(sceneGeometry,
+        options.stressPath == STRESS_INDIRECT ? (uint32_t)std::max<size_t>(options.instances, 1) : 1);
+    const GLuint materialTextures[][2] = {
+        {0, 0}, {cubeTexture, cubeNormalMap}, {pyramidTexture, pyramidNormalMap}, {sphereTexture, sphereNormalMap}};
+
+    // --software: CPU copies of the same meshes and textures. Scene materials are
+    // indexed by MaterialId, stress materials by texture array layer.
+    SoftwareRasterizer software(win.width, win.height);
+    SoftwareRasterizer::Mesh softwareMeshes[3];
+    std::vector<SoftwareTexture> softwareTextures;
+    SoftwareRasterizer::Material softwareMaterials[MATERIAL_METAL + 1];
+    SoftwareRasterizer::Material stressMaterials[materialLayers];
+    if (options.software) {
+        softwareMeshes[DRAW_CUBE] = SoftwareRasterizer::Mesh::fromVertices(cubeVertices(), cubeIndices());
+        softwareMeshes[DRAW_PYRAMID] = SoftwareRasterizer::Mesh::fromVertices(pyramidVertices(), pyramidIndices());
+        softwareMeshes[DRAW_SPHERE] = SoftwareRasterizer::Mesh::fromVertices(sphereVertices, sphereIndices);
+
+        const char* paths[] = {
+            "assets/oak_veneer_01_diff_4k.jpg", "assets/oak_veneer_01_nor_gl_1k.jpg",
+            "assets/stonebase.png", "assets/stonenormal.png",
+            "assets/Metal_007_basecolor.png", "assets/Metal_007_normal.png",
+            "assets/texturemetal.jpg", "assets/normalmetal.jpg"};
+        for (const char* path : paths) {
+            int width, height;
+            std::vector<unsigned char> rgba;
+            if (!loadImage(path, width, height, rgba)) return -1;
+            softwareTextures.emplace_back(width, height, rgba.data());
+        }
+        // GL filters: loadTexture() samples level 0, the texture arrays are trilinear
+        for (unsigned material = MATERIAL_WOOD; material <= MATERIAL_METAL; ++material) {
+            softwareMaterials[material].diffuse = &softwareTextures[2 * (material - MATERIAL_WOOD)];
+            softwareMaterials[material].normalMap = &softwareTextures[2 * (material - MATERIAL_WOOD) + 1];
+        }
+        for (int layer = 0; layer < materialLayers; ++layer) {
+            stressMaterials[layer].diffuse = &softwareTextures[2 * (layer + 1)];
+            stressMaterials[layer].normalMap = &softwareTextures[2 * (layer + 1) + 1];
+            stressMaterials[layer].filter = SoftwareTexture::TRILINEAR;
+        }
+    }
+
+    // Blending is switched on by the render queue for translucent draws only;
+    // the lit slot is pointed at the forward or deferred scene program every frame
+    Shader* programs[] = {&myShader, &gridShader, &lightmapShader};
+    std::vector<Shader*> forwardLitPrograms = {forward.scene, forward.instanced};
+    if (indirect) {
+        forwardLitPrograms.push_back(forward.indirect);
+        forwardLitPrograms.push_back(forward.indirectArray);
+    }
+    RenderQueue renderQueue;
+    FrustumCuller culler;
+
+    // Scene BVH over world bounds, indexed by DrawId; refit as objects move
+    BVH sceneBVH;
+    sceneBVH.build({myCube.bounds, myPyramid.bounds, mySphere.bounds, grid.bounds});
+    std::vector<uint32_t> visibleObjects;
+
+    // CPU occlusion: the lit objects and the stress cubes nearest the camera are
+    // occluders; frustum-visible objects and all stress cubes are tested
+    OcclusionCuller occlusion;
+    const OcclusionCuller::Mesh cubeOccluder = OcclusionCuller::Mesh::fromVertices(cubeVertices(), 14, cubeIndices());
+    const OcclusionCuller::Mesh pyramidOccluder =
+        OcclusionCuller::Mesh::fromVertices(pyramidVertices(), 14, pyramidIndices());
+    const OcclusionCuller::Mesh sphereOccluder = OcclusionCuller::Mesh::fromVertices(sphereVertices, 14, sphereIndices);
+    const size_t MAX_STRESS_OCCLUDERS = 512;
+    bool occlusionCulling = options.occlusion;
+    std::vector<AABB> occludeeBounds;
+    std::vector<uint8_t> occludeeVisible;
+    std::vector<uint32_t> stressOrder;
+    std::vector<InstanceData> stressVisible;      // Stress cubes that passed, compacted
+    std::vector<uint32_t> stressVisibleIds;       // ...and their index in stressInstances
+
+    // --naive --command-lists: per-cube draws recorded in parallel, replayed below
+    struct StressDraw {
+        glm::mat4 model;
+        glm::mat3 normalMatrix;
+    };
+    ParallelRecorder stressCommands;
+    bool recordStress =
+        options.instances > 0 && options.stressPath == STRESS_NAIVE && options.commandLists && !options.software;
+    const float nearPlane = 0.1f;
+    const float farPlane = 100.0f;
+    grid.setViewDistance(farPlane);
+
+    // Two key lights with a range covering the scene, plus `--lights N` small orbiting ones
+    ClusteredLighting lighting;
+    const size_t KEY_LIGHTS = 2;
+    lighting.lights.push_back({glm::vec3(-6.2f, 3.0f, 2.0f), 60.0f, glm::vec3(1.0f, 1.0f, 1.0f), 1.0f});
+    lighting.lights.push_back({glm::vec3(6.0f, -2.0f, 0.0f), 60.0f, glm::vec3(0.0f, 0.0f, 1.0f), 1.0f});
+
+    struct LightOrbit {
+        float distance, height, phase, speed;
+    };
+    std::vector<LightOrbit> orbits(options.lights);
+    std::mt19937 lightRng(7);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    for (LightOrbit& orbit : orbits) {
+        orbit = {2.0f + unit(lightRng) * 40.0f, 0.2f + unit(lightRng) * 3.0f,
+                 unit(lightRng) * glm::two_pi<float>(), 0.2f + unit(lightRng) * 0.8f};
+        glm::vec3 color(unit(lightRng), unit(lightRng), unit(lightRng));
+        lighting.lights.push_back({glm::vec3(0.0f), 1.5f + unit(lightRng) * 3.0f, color, 2.0f});
+    }
+
+    // --bake-lightmap / --lightmap: the key lights baked over the cube, pyramid and
+    // sphere, frozen where they are at t = 0. The cooked file only holds texels, so
+    // the atlas is rebuilt from the same geometry either way and must match it.
+    // Lightmapped objects shade only the orbiting lights per fragment.
+    bool lightmapped = !options.lightmap.empty() && !options.software;
+    if (!options.lightmap.empty() && options.software)
+        std::cout << "--software shades every light itself, ignoring the lightmap" << std::endl;
+    Lightmap lightmap;
+    std::unique_ptr<LightmappedMesh> lightmappedMeshes[3];
+    if (lightmapped) {
+        glm::mat4 models[3];
+        objectModels(0.0f, models[DRAW_CUBE], models[DRAW_PYRAMID], models[DRAW_SPHERE]);
+        const std::vector<float> vertices[3] = {cubeVertices(), pyramidVertices(), sphereVertices};
+        const std::vector<unsigned int> indices[3] = {cubeIndices(), pyramidIndices(), sphereIndices};
+        const char* diffusePaths[3] = {
+            "assets/oak_veneer_01_diff_4k.jpg", "assets/stonebase.png", "assets/Metal_007_basecolor.png"};
+
+        LightmapBaker baker;
+        for (int object = DRAW_CUBE; object <= DRAW_SPHERE; ++object) {
+            // Indirect light bounces off the mean diffuse colour; only the bake reads it
+            glm::vec3 albedo(0.0f);
+            if (options.bakeLightmap) {
+                int width, height;
+                std::vector<unsigned char> rgba;
+                if (!loadImage(diffusePaths[object], width, height, rgba)) return -1;
+                double sum[3] = {0.0, 0.0, 0.0};
+                for (size_t i = 0; i < rgba.size(); i += 4)
+                    for (int c = 0; c < 3; ++c) sum[c] += rgba[i + c];
+                double texels = 255.0 * width * height;
+                albedo = glm::vec3((float)(sum[0] / texels), (float)(sum[1] / texels), (float)(sum[2] / texels));
+            }
+            baker.addObject(vertices[object], indices[object], models[object], albedo);
+        }
+        baker.buildAtlas();
+
+        LightmapImage image;
+        if (options.bakeLightmap) {
+            std::vector<PointLight> keyLights(lighting.lights.begin(), lighting.lights.begin() + KEY_LIGHTS);
+            baker.bake(keyLights);
+            const LightmapBaker::Stats& stats = baker.stats();
+            std::cout << "Baked a " << baker.width() << "x" << baker.height() << " lightmap (" << stats.charts
+                      << " charts) in " << stats.atlasMs + stats.bakeMs << " ms, "
+                      << stats.rays / std::max(stats.bakeMs, 1e-3f) / 1000.0f << " Mrays/s" << std::endl;
+            image = baker.cook();
+            if (!image.write(options.lightmap)) {
+                std::cerr << "Failed to write lightmap: " << options.lightmap << std::endl;
+                return -1;
+            }
+        } else if (!image.read(options.lightmap)) {
+            std::cerr << "Failed to read lightmap: " << options.lightmap << std::endl;
+            return -1;
+        }
+        if (image.width != baker.width() || image.height != baker.height() || image.charts != baker.stats().charts) {
+            std::cerr << "Lightmap " << options.lightmap
+                      << " was baked for other geometry; bake it again with --bake-lightmap" << std::endl;
+            return -1;
+        }
+        lightmap.upload(image);
+
+        const MaterialId materials[3] = {MATERIAL_WOOD, MATERIAL_STONE, MATERIAL_METAL};
+        for (int object = DRAW_CUBE; object <= DRAW_SPHERE; ++object)
+            lightmappedMeshes[object].reset(new LightmappedMesh(baker.unwrapped(object),
+                materialTextures[materials[object]][0], materialTextures[materials[object]][1]));
+        forwardLitPrograms.push_back(&lightmapShader);
+    }
+    const ProgramId objectProgram = lightmapped ? PROGRAM_LIGHTMAPPED : PROGRAM_LIT;
+
+    // Frames are pipelined over two threads. This one handles input and animation
+    // and fills a FrameSnapshot. The render thread culls and draws the previous
+    // one; it is the only thread holding the GL context while the loop runs.
+    // --single-thread runs the two stages in turn instead.
     bool running = true;
-    while (running) {
-        float currentFrame = SDL_GetTicks() / 1000.0f;
+    FramePipeline<FrameSnapshot> pipeline;
+    FramePipeline<FrameSnapshot>::Stats lastPipelineStats;
+    std::mutex titleMutex;
+    std::string pendingTitle;   // From the render stage; SDL window calls stay on this thread
+    unsigned simulatedFrames = 0;
+    FrameTimings timings;
+    timings.reserve(options.headlessFrames);
+    unsigned timedGpuFrames = 0;
+    std::vector<unsigned char> framePixels;
+
+    auto simulate = [&](FrameSnapshot& frame) {
+        Uint64 simulationStart = SDL_GetPerformanceCounter();
+        // Headless runs step a fixed 1/60 s so every run draws the same frames
+        frame.index = simulatedFrames++;
+        float currentFrame = headless ? frame.index / 60.0f : SDL_GetTicks() / 1000.0f;
         deltaTime = currentFrame - lastFrame;
         lastFrame = currentFrame;
 
@@ -75,68 +558,611 @@ int main() {
                 case SDL_MOUSEWHEEL:
                     camera.ProcessMouseScroll(event.wheel.y);  // Zoom in/out
                     break;
+                case SDL_KEYDOWN:
+                    if (event.key.repeat) break;
+                    if (event.key.keysym.sym == SDLK_TAB)
+                        useDeferred = !useDeferred;
+                    else if (event.key.keysym.sym == SDLK_p)
+                        depthPrepass = !depthPrepass;
+                    else if (event.key.keysym.sym == SDLK_o)
+                        occlusionCulling = !occlusionCulling;
+                    break;
             }
         }
 
-        processInput(win.window);
+        if (!headless) processInput(win.window);
+        else if (simulatedFrames >= options.headlessFrames) running = false;
+        if (!cameraPath.empty()) {
+            CameraPath::Key key = cameraPath.sample(currentFrame);
+            camera.SetOrbit(key.distance, key.yaw, key.pitch);
+        }
+
+        frame.time = currentFrame;
+        frame.deferred = useDeferred;
+        frame.depthPrepass = depthPrepass;
+        frame.occlusionCulling = occlusionCulling;
+
+        // Prepare camera
+        frame.view = camera.GetViewMatrix();  // Get the view matrix from the orbital camera
+        frame.projection = glm::perspective(glm::radians(45.0f), (float)win.width / win.height, nearPlane, farPlane);
+        frame.eye = camera.GetCameraPosition();
+
+        float t = currentFrame;
+
+        // Orbiting lights move every frame, so clusters are rebuilt every frame
+        frame.lightPositions.resize(orbits.size());
+        for (size_t i = 0; i < orbits.size(); ++i) {
+            const LightOrbit& orbit = orbits[i];
+            float angle = orbit.phase + t * orbit.speed;
+            frame.lightPositions[i] =
+                glm::vec3(std::cos(angle) * orbit.distance, orbit.height, std::sin(angle) * orbit.distance);
+        }
+
+        objectModels(lightmapped ? 0.0f : t, frame.cubeModel, frame.pyramidModel, frame.sphereModel);
+
+        // Normal matrices once per object, not per vertex
+        frame.cubeNormal = normalMatrix(frame.cubeModel);
+        frame.pyramidNormal = normalMatrix(frame.pyramidModel);
+        frame.sphereNormal = normalMatrix(frame.sphereModel);
+
+        // Stress cubes spin in place; transforms are rebuilt on the CPU every frame,
+        // normal matrices in one batch per job
+        if (options.instances > 0) {
+            JobPool::shared().parallelFor(options.instances, 4096, [&](size_t begin, size_t end, unsigned) {
+                for (size_t i = begin; i < end; ++i) {
+                    glm::mat4 model = glm::translate(glm::mat4(1.0f), stressPositions[i]);
+                    model = glm::rotate(model, t + i * 0.01f, glm::vec3(0.0f, 1.0f, 0.0f));
+                    frame.stressInstances[i].model = glm::scale(model, glm::vec3(0.5f));
+                    frame.stressInstances[i].materialLayer = (float)(i % materialLayers);
+                }
+                computeNormalMatrices(&frame.stressInstances[begin].model,
+                                      &frame.stressInstances[begin].normalMatrix[0], end - begin, sizeof(InstanceData));
+            });
+        }
+
+        frame.simulationMs =
+            (SDL_GetPerformanceCounter() - simulationStart) * 1000.0f / SDL_GetPerformanceFrequency();
+    };
+
+    float lastStatsTime = 0.0f;
+    float cpuFrameMs = 0.0f;
+    auto render = [&](const FrameSnapshot& frame) {
+        Uint64 frameStart = SDL_GetPerformanceCounter();
+        profiler.beginFrame();
+        shaders.update();
+
+        const glm::mat4& view = frame.view;
+        const glm::mat4& projection = frame.projection;
+        const glm::mat4& cubeModel = frame.cubeModel;
+        const glm::mat4& pyramidModel = frame.pyramidModel;
+        const glm::mat4& sphereModel = frame.sphereModel;
+        const glm::mat3& cubeNormal = frame.cubeNormal;
+        const glm::mat3& pyramidNormal = frame.pyramidNormal;
+        const glm::mat3& sphereNormal = frame.sphereNormal;
+        const std::vector<InstanceData>& stressInstances = frame.stressInstances;
+
+        // Scale from the newest GPU frame time, then draw into the scene target
+        int renderWidth = win.width, renderHeight = win.height;
+        GLuint sceneFramebuffer = win.framebuffer;
+        if (options.dynamicResolution) {
+            if (profiler.stats().collectedFrames != measuredGpuFrames) {
+                measuredGpuFrames = profiler.stats().collectedFrames;
+                resolution.update(profiler.stats().lastGpuFrameMs);
+            }
+            renderWidth = resolution.scaled(win.width);
+            renderHeight = resolution.scaled(win.height);
+            sceneTarget.resize(renderWidth, renderHeight);
+            sceneTarget.bind();
+            sceneFramebuffer = sceneTarget.framebuffer();
+        } else {
+            gl.bindFramebuffer(GL_FRAMEBUFFER, win.framebuffer);
+            gl.viewport(0, 0, win.width, win.height);
+        }
 
         // Clear buffers
         glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-        // Prepare camera
-        glm::mat4 view = camera.GetViewMatrix();  // Get the view matrix from the orbital camera
-        glm::mat4 projection = glm::perspective(glm::radians(45.0f), (float)win.width / win.height, 0.1f, 100.0f);
+        glsl::CameraBlock cameraBlock = {};
+        cameraBlock.view = view;
+        cameraBlock.projection = projection;
+        cameraBlock.viewPos = frame.eye;
+        cameraBuffer.update(cameraBlock);
 
         myShader.use();
-        myShader.setMat4("view", glm::value_ptr(view));
-        myShader.setMat4("projection", glm::value_ptr(projection));
-        myShader.setVec3("viewPos", camera.GetCameraPosition());
 
-        float t = SDL_GetTicks() / 1000.0f;
+        for (size_t i = 0; i < frame.lightPositions.size(); ++i)
+            lighting.lights[KEY_LIGHTS + i].position = frame.lightPositions[i];
+        profiler.begin("lights");
+        lighting.update(view, projection, nearPlane, farPlane);
+        profiler.end();
 
-        // Lights
-        const int NR_LIGHTS = 2;
-        glm::vec3 lightPositions[NR_LIGHTS] = {
-            glm::vec3(-6.2f, 3.0f, 2.0f),
-            glm::vec3(6.0f, -2.0f, 0.0f)
+        // Normalized view depth of an object's origin, for the sort key
+        auto viewDepth = [&](const glm::mat4& model) {
+            return -(view * model[3]).z / farPlane;
         };
-        glm::vec3 lightColors[NR_LIGHTS] = {
-            glm::vec3(1.0f, 1.0f, 1.0f),
-            glm::vec3(0.0f, 0.0f, 1.0f)
+
+        // Move the objects in the scene BVH, then cull hierarchically
+        profiler.begin("cull");
+        glm::mat4 gridModel = glm::mat4(1.0f);
+        sceneBVH.update(DRAW_CUBE, myCube.bounds.transformed(cubeModel));
+        sceneBVH.update(DRAW_PYRAMID, myPyramid.bounds.transformed(pyramidModel));
+        sceneBVH.update(DRAW_SPHERE, mySphere.bounds.transformed(sphereModel));
+        sceneBVH.refitOrRebuild();
+
+        culler.setFrustum(projection * view);
+        glm::vec4 frustumPlanes[6];
+        for (int i = 0; i < 6; ++i) frustumPlanes[i] = culler.plane(i);
+        visibleObjects.clear();
+        sceneBVH.queryFrustum(frustumPlanes, visibleObjects);
+
+        // Occlusion culling on the CPU before anything reaches the render queue
+        if (frame.occlusionCulling) {
+            occlusion.begin(projection * view);
+            for (uint32_t object : visibleObjects) {
+                if (object == DRAW_CUBE) occlusion.addOccluder(cubeOccluder, cubeModel);
+                if (object == DRAW_PYRAMID) occlusion.addOccluder(pyramidOccluder, pyramidModel);
+                if (object == DRAW_SPHERE) occlusion.addOccluder(sphereOccluder, sphereModel);
+            }
+            // The nearest stress cubes hide the most
+            if (options.instances > 0) {
+                glm::vec3 eye = frame.eye;
+                auto distanceSq = [&](uint32_t i) {
+                    glm::vec3 d = glm::vec3(stressInstances[i].model[3]) - eye;
+                    return glm::dot(d, d);
+                };
+                size_t count = std::min(options.instances, MAX_STRESS_OCCLUDERS);
+                stressOrder.resize(options.instances);
+                for (size_t i = 0; i < options.instances; ++i) stressOrder[i] = (uint32_t)i;
+                std::nth_element(stressOrder.begin(), stressOrder.begin() + (count - 1), stressOrder.end(),
+                                 [&](uint32_t a, uint32_t b) { return distanceSq(a) < distanceSq(b); });
+                for (size_t i = 0; i < count; ++i)
+                    occlusion.addOccluder(cubeOccluder, stressInstances[stressOrder[i]].model);
+            }
+            occlusion.rasterize();
+
+            occludeeBounds.clear();
+            for (uint32_t object : visibleObjects) occludeeBounds.push_back(sceneBVH.objectBounds(object));
+            occludeeVisible.resize(occludeeBounds.size());
+            occlusion.cull(occludeeBounds.data(), occludeeBounds.size(), occludeeVisible.data());
+            size_t kept = 0;
+            for (size_t i = 0; i < visibleObjects.size(); ++i)
+                if (occludeeVisible[i]) visibleObjects[kept++] = visibleObjects[i];
+            visibleObjects.resize(kept);
+
+            if (options.instances > 0) {
+                occludeeBounds.resize(options.instances);
+                occludeeVisible.resize(options.instances);
+                JobPool::shared().parallelFor(options.instances, 4096, [&](size_t begin, size_t end, unsigned) {
+                    for (size_t i = begin; i < end; ++i)
+                        occludeeBounds[i] = myCube.bounds.transformed(stressInstances[i].model);
+                });
+                occlusion.cull(occludeeBounds.data(), options.instances, occludeeVisible.data());
+                stressVisible.clear();
+                stressVisibleIds.clear();
+                for (size_t i = 0; i < options.instances; ++i) {
+                    if (!occludeeVisible[i]) continue;
+                    stressVisible.push_back(stressInstances[i]);
+                    stressVisibleIds.push_back((uint32_t)i);
+                }
+            }
+        }
+        profiler.end();
+
+        // Submit the visible objects, sort by state and depth, then draw
+        renderQueue.clear();
+        for (uint32_t object : visibleObjects) {
+            switch (object) {
+                case DRAW_CUBE:
+                    renderQueue.submit(RenderQueue::makeKey(0, false, viewDepth(cubeModel), objectProgram, MATERIAL_WOOD, DRAW_CUBE), DRAW_CUBE);
+                    break;
+                case DRAW_PYRAMID:
+                    renderQueue.submit(RenderQueue::makeKey(0, false, viewDepth(pyramidModel), objectProgram, MATERIAL_STONE, DRAW_PYRAMID), DRAW_PYRAMID);
+                    break;
+                case DRAW_SPHERE:
+                    renderQueue.submit(RenderQueue::makeKey(0, false, viewDepth(sphereModel), objectProgram, MATERIAL_METAL, DRAW_SPHERE), DRAW_SPHERE);
+                    break;
+                case DRAW_GRID:
+                    renderQueue.submit(RenderQueue::makeKey(0, true, viewDepth(gridModel), PROGRAM_GRID, MATERIAL_NONE, DRAW_GRID), DRAW_GRID);
+                    break;
+            }
+        }
+        renderQueue.sort();
+
+        // Deferred: opaque draws fill the G-buffer and are lit in one full-screen pass
+        // before the translucent ones; forward: every lit program shades as it draws
+        bool deferredFrame = frame.deferred && !options.software;
+        const LitPrograms& lit = deferredFrame ? deferred : forward;
+        if (!deferredFrame) {
+            for (Shader* program : forwardLitPrograms)
+                lighting.bind(*program, renderWidth, renderHeight);
+            if (lightmapped) {
+                lightmapShader.use();
+                lightmapShader.setInt(glsl::uniform::bakedLights, (int)KEY_LIGHTS);
+            }
+        }
+
+        // Indirect path: the lit draws become one multi-draw per material bucket,
+        // in queue order; the render queue below then only draws the rest
+        if (sceneIndirect) {
+            sceneIndirectDraws.clear();
+            for (const RenderQueue::Item& item : renderQueue.sorted()) {
+                if (RenderQueue::program(item.key) != PROGRAM_LIT) continue;
+                const glm::mat4& model = item.payload == DRAW_CUBE ? cubeModel
+                                       : item.payload == DRAW_PYRAMID ? pyramidModel : sphereModel;
+                sceneIndirectDraws.add(RenderQueue::material(item.key), item.payload, InstanceData::make(model, 0.0f));
+            }
+            sceneIndirectDraws.upload();
+        }
+
+        // Stress cubes that survived occlusion culling (all of them without it)
+        const InstanceData* stressDrawn = frame.occlusionCulling ? stressVisible.data() : stressInstances.data();
+        size_t stressDrawnCount = frame.occlusionCulling ? stressVisible.size() : stressInstances.size();
+        if (options.instances > 0 && !options.software) {
+            if (options.stressPath == STRESS_INDIRECT) {
+                // Mixed meshes, still a single call
+                stressIndirectDraws.clear();
+                for (size_t k = 0; k < stressDrawnCount; ++k) {
+                    size_t i = frame.occlusionCulling ? stressVisibleIds[k] : k;
+                    stressIndirectDraws.add(0, (uint32_t)(i % 3), stressInstances[i]);
+                }
+                stressIndirectDraws.upload();
+            } else if (options.stressPath == STRESS_INSTANCED) {
+                instancedCubes.setInstances(stressDrawn, stressDrawnCount);
+            }
+        }
+        if (recordStress) {
+            Profiler::Scope scope(profiler, "record");
+            stressCommands.record(stressDrawnCount, 1024, [&](CommandList& list, size_t begin, size_t end) {
+                list.bindProgram(PROGRAM_LIT);
+                for (size_t k = begin; k < end; ++k) {
+                    const InstanceData& instance = stressDrawn[k];
+                    StressDraw draw;
+                    draw.model = instance.model;
+                    draw.normalMatrix = glm::mat3(glm::vec3(instance.normalMatrix[0]),
+                                                  glm::vec3(instance.normalMatrix[1]),
+                                                  glm::vec3(instance.normalMatrix[2]));
+                    list.setDrawData(draw);
+                    list.draw(DRAW_CUBE);
+                }
+            });
+        }
+
+        // One half of the queue at a time; other passes run in between, so the first
+        // item drawn in each half sets its state again
+        auto executeQueue = [&](bool translucentHalf, bool depthOnly) {
+            bool first = true;
+            renderQueue.execute([&](const RenderQueue::Item& item, unsigned changes) {
+                if (RenderQueue::translucent(item.key) != translucentHalf) return;
+                if (sceneIndirect && RenderQueue::program(item.key) == PROGRAM_LIT) return;
+                if (first) changes |= RenderQueue::TRANSLUCENCY_CHANGED | RenderQueue::PROGRAM_CHANGED;
+                first = false;
+
+                if (changes & RenderQueue::TRANSLUCENCY_CHANGED)
+                    gl.setEnabled(GL_BLEND, RenderQueue::translucent(item.key));
+                if (changes & RenderQueue::PROGRAM_CHANGED)
+                    programs[RenderQueue::program(item.key)]->use();
+
+                // Lightmapped objects take the lit program in depth-only and deferred passes
+                Shader& scene = *programs[RenderQueue::program(item.key)];
+                bool baked = &scene == &lightmapShader;
+                Profiler::Scope scope(profiler, drawNames[item.payload]);
+                switch (item.payload) {
+                    case DRAW_CUBE:
+                        scene.setMat4(glsl::uniform::model, glm::value_ptr(cubeModel));
+                        if (depthOnly) {
+                            myCube.DrawDepth();
+                            break;
+                        }
+                        scene.setMat3(glsl::uniform::normalMatrix, glm::value_ptr(cubeNormal));
+                        if (baked) lightmappedMeshes[DRAW_CUBE]->Draw();
+                        else myCube.Draw();
+                        break;
+                    case DRAW_PYRAMID:
+                        scene.setMat4(glsl::uniform::model, glm::value_ptr(pyramidModel));
+                        if (depthOnly) {
+                            myPyramid.DrawDepth();
+                            break;
+                        }
+                        scene.setMat3(glsl::uniform::normalMatrix, glm::value_ptr(pyramidNormal));
+                        if (baked) lightmappedMeshes[DRAW_PYRAMID]->Draw();
+                        else myPyramid.Draw();
+                        break;
+                    case DRAW_SPHERE:
+                        scene.setMat4(glsl::uniform::model, glm::value_ptr(sphereModel));
+                        if (depthOnly) {
+                            mySphere.drawDepth();
+                            break;
+                        }
+                        scene.setMat3(glsl::uniform::normalMatrix, glm::value_ptr(sphereNormal));
+                        if (baked) lightmappedMeshes[DRAW_SPHERE]->Draw();
+                        else mySphere.draw(scene);
+                        break;
+                    case DRAW_GRID:
+                        grid.Draw(gridShader);
+                        break;
+                }
+            });
+        };
+
+        // Every opaque draw of the frame, shaded by `pass` or depth only
+        auto drawOpaque = [&](const LitPrograms& pass, bool depthOnly) {
+            programs[PROGRAM_LIT] = pass.scene;
+            // Deferred frames shade the lightmapped objects with every light instead
+            bool baked = lightmapped && !depthOnly && &pass == &forward;
+            programs[PROGRAM_LIGHTMAPPED] = baked ? &lightmapShader : pass.scene;
+            if (baked) lightmap.bind();
+            gl.setEnabled(GL_BLEND, false);
+            if (sceneIndirect) {
+                Profiler::Scope scope(profiler, "scene");
+                pass.indirect->use();
+                for (unsigned material = MATERIAL_WOOD; material <= MATERIAL_METAL; ++material) {
+                    if (depthOnly) {
+                        sceneIndirectDraws.drawDepth(material);
+                        continue;
+                    }
+                    gl.bindTexture(glsl::sampler::texture1, GL_TEXTURE_2D, materialTextures[material][0]);
+                    gl.bindTexture(glsl::sampler::normalMap, GL_TEXTURE_2D, materialTextures[material][1]);
+                    sceneIndirectDraws.draw(material);
+                }
+            }
+
+            executeQueue(false, depthOnly);
+
+            if (options.instances == 0) return;
+            Profiler::Scope scope(profiler, "stress");
+            gl.setEnabled(GL_BLEND, false);
+            if (options.stressPath == STRESS_INDIRECT) {
+                pass.indirectArray->use();
+                if (depthOnly) {
+                    stressIndirectDraws.drawDepth(0);
+                } else {
+                    gl.bindTexture(glsl::sampler::diffuseLayers, GL_TEXTURE_2D_ARRAY, materialDiffuse);
+                    gl.bindTexture(glsl::sampler::normalLayers, GL_TEXTURE_2D_ARRAY, materialNormals);
+                    stressIndirectDraws.draw(0);
+                }
+            } else if (recordStress) {
+                // Same draws as the loop below; only the GL calls are left on this thread
+                stressCommands.replay([&](const CommandList::Command& command) {
+                    switch (command.op) {
+                        case CommandList::BIND_PROGRAM:
+                            programs[command.id]->use();
+                            break;
+                        case CommandList::BIND_MATERIAL:
+                            break;
+                        case CommandList::SET_DRAW_DATA: {
+                            const StressDraw& draw = *static_cast<const StressDraw*>(command.data());
+                            pass.scene->setMat4(glsl::uniform::model, glm::value_ptr(draw.model));
+                            if (!depthOnly)
+                                pass.scene->setMat3(glsl::uniform::normalMatrix, glm::value_ptr(draw.normalMatrix));
+                            break;
+                        }
+                        case CommandList::DRAW:
+                            if (depthOnly) myCube.DrawDepth();
+                            else myCube.Draw();
+                            break;
+                    }
+                });
+            } else if (options.stressPath == STRESS_NAIVE) {
+                pass.scene->use();
+                for (size_t k = 0; k < stressDrawnCount; ++k) {
+                    const InstanceData& instance = stressDrawn[k];
+                    pass.scene->setMat4(glsl::uniform::model, glm::value_ptr(instance.model));
+                    if (depthOnly) {
+                        myCube.DrawDepth();
+                        continue;
+                    }
+                    glm::mat3 normal(glm::vec3(instance.normalMatrix[0]), glm::vec3(instance.normalMatrix[1]),
+                                     glm::vec3(instance.normalMatrix[2]));
+                    pass.scene->setMat3(glsl::uniform::normalMatrix, glm::value_ptr(normal));
+                    myCube.Draw();
+                }
+            } else if (depthOnly) {
+                instancedCubes.DrawDepth(*pass.instanced);
+            } else {
+                instancedCubes.Draw(*pass.instanced);
+            }
         };
-        for (int i = 0; i < NR_LIGHTS; ++i) {
-            myShader.setVec3("lights[" + std::to_string(i) + "].position", lightPositions[i]);
-            myShader.setVec3("lights[" + std::to_string(i) + "].color", lightColors[i]);
-        }
-
-        // Draw Cube
-        glm::mat4 cubeModel = glm::mat4(1.0f);
-        cubeModel = glm::rotate(cubeModel, t, glm::vec3(0.0f, 0.0f, 1.0f));
-        cubeModel = glm::scale(cubeModel, glm::vec3(0.5f, 0.5f, 0.5f));
-        cubeModel = glm::translate(cubeModel, glm::vec3(1.0f, 0.5f, 0.0f));
-        myShader.setMat4("model", glm::value_ptr(cubeModel));
-        myCube.Draw(myShader);
-
-        // Draw Pyramid
-        glm::mat4 pyramidModel = glm::mat4(1.0f);
-        pyramidModel = glm::rotate(pyramidModel, t, glm::vec3(0.0f, 1.0f, 0.0f));
-        pyramidModel = glm::translate(pyramidModel, glm::vec3(-1.0f, 0.5f, 0.0f));
-        myShader.setMat4("model", glm::value_ptr(pyramidModel));
-        myPyramid.Draw(myShader);
-
-        // Draw Sphere
-        glm::mat4 sphereModel = glm::mat4(1.0f);
-        sphereModel = glm::rotate(sphereModel, t, glm::vec3(1.0f, 1.0f, 1.0f));
-        sphereModel = glm::translate(sphereModel, glm::vec3(3.0f, 0.5f, 0.0f));
-        myShader.setMat4("model", glm::value_ptr(sphereModel));
-        mySphere.draw(myShader);
-
-        // Draw Grid
-        grid.Draw(gridShader, view, projection);
-
-        SDL_GL_SwapWindow(win.window);
+
+        if (options.software) {
+            // The lit objects and stress cubes on the CPU; the grid is translucent and stays out
+            Profiler::Scope scope(profiler, "software");
+            sceneTarget.resize(renderWidth, renderHeight);
+            software.resize(renderWidth, renderHeight);
+            software.begin(view, projection, frame.eye, lighting.lights);
+            for (const RenderQueue::Item& item : renderQueue.sorted()) {
+                if (RenderQueue::program(item.key) != PROGRAM_LIT) continue;
+                const glm::mat4& model = item.payload == DRAW_CUBE ? cubeModel
+                                       : item.payload == DRAW_PYRAMID ? pyramidModel : sphereModel;
+                software.draw(softwareMeshes[item.payload], model, softwareMaterials[RenderQueue::material(item.key)]);
+            }
+            for (size_t k = 0; k < stressDrawnCount; ++k)
+                software.draw(softwareMeshes[DRAW_CUBE], stressDrawn[k].model,
+                              stressMaterials[(int)stressDrawn[k].materialLayer]);
+            software.finish();
+            sceneTarget.upload(software.color().data());
+        } else {
+            // Depth pre-pass: opaque depth from the position-only streams first, so the
+            // shading pass runs its fragment shader once per visible pixel (GL_EQUAL, no writes)
+            auto opaquePass = [&](const FrameGraph::Context&) {
+                if (frame.depthPrepass) {
+                    Profiler::Scope scope(profiler, "prepass");
+                    gl.colorMask(false);
+                    drawOpaque(depthOnly, true);
+                    gl.colorMask(true);
+                    gl.depthFunc(GL_EQUAL);
+                    gl.depthMask(false);
+                }
+                profiler.begin("opaque");
+                drawOpaque(lit, false);
+                profiler.end();
+                if (frame.depthPrepass) {
+                    gl.depthFunc(GL_LESS);
+                    gl.depthMask(true);
+                }
+            };
+
+            // The scene framebuffer was cleared above; every pass loads it
+            frameGraph.reset();
+            FrameGraph::TextureDesc sceneDesc;
+            sceneDesc.width = renderWidth;
+            sceneDesc.height = renderHeight;
+            FrameGraph::Resource scene = frameGraph.import("scene", sceneDesc, sceneFramebuffer);
+            DeferredShading::GBuffer gbuffer;
+            if (deferredFrame) {
+                frameGraph.addPass("geometry", [&](FrameGraph::Builder& builder) {
+                    gbuffer = DeferredShading::createGBuffer(builder, renderWidth, renderHeight);
+                }, opaquePass);
+                frameGraph.addPass("lighting", [&](FrameGraph::Builder& builder) {
+                    DeferredShading::readGBuffer(builder, gbuffer);
+                    builder.write(scene);
+                }, [&](const FrameGraph::Context& context) {
+                    Profiler::Scope scope(profiler, "lighting");
+                    deferredShading.lightingPass(context, gbuffer, deferredLightingShader, lighting, sceneFramebuffer);
+                });
+            } else {
+                frameGraph.addPass("opaque", [&](FrameGraph::Builder& builder) { builder.write(scene); }, opaquePass);
+            }
+            frameGraph.addPass("translucent", [&](FrameGraph::Builder& builder) { builder.write(scene); },
+                               [&](const FrameGraph::Context&) {
+                profiler.begin("translucent");
+                executeQueue(true, false);
+                profiler.end();
+            });
+            if (frameGraph.compile()) frameGraph.execute(renderTargets);
+        }
+
+        // Sharpen more the further the scale is below native; software frames arrive through the target too
+        if (options.dynamicResolution || options.software) {
+            Profiler::Scope scope(profiler, "present");
+            float sharpness = options.dynamicResolution ? std::min(1.0f, (1.0f - resolution.scale()) * 2.0f) : 0.0f;
+            sceneTarget.present(upscaleShader, win.width, win.height, sharpness, win.framebuffer);
+        }
+
+        cpuFrameMs = (SDL_GetPerformanceCounter() - frameStart) * 1000.0f / SDL_GetPerformanceFrequency();
+        // The readback stalls on the GPU, so it comes after the CPU time is taken
+        if (headless && !options.dumpFramesDir.empty() && frame.index % options.dumpEvery == 0) {
+            char name[32];
+            std::snprintf(name, sizeof(name), "/frame_%05u.ppm", frame.index);
+            win.readPixels(framePixels);
+            if (!writePPM(options.dumpFramesDir + name, win.width, win.height, framePixels))
+                std::cerr << "Failed to write frame: " << options.dumpFramesDir + name << std::endl;
+        }
+        win.swap();
+
+        // Report the GL calls of this frame once per second
+        gl.endFrame();
+        profiler.endFrame();
+        // GPU times arrive FRAME_LATENCY frames late; they are logged against the frame that read them
+        float gpuMs = -1.0f;
+        if (profiler.stats().collectedFrames != timedGpuFrames) {
+            timedGpuFrames = profiler.stats().collectedFrames;
+            gpuMs = profiler.stats().lastGpuFrameMs;
+        }
+        if (headless || !options.timingJson.empty())
+            timings.add({frame.index, frame.simulationMs, cpuFrameMs, gpuMs});
+        if (frame.time - lastStatsTime >= 1.0f) {
+            lastStatsTime = frame.time;
+            FramePipeline<FrameSnapshot>::Stats pipelineStats = pipeline.stats();
+            std::string title = std::string(win.title) +
+                " | GL calls issued: " + std::to_string(gl.lastFrame().issued) +
+                " filtered: " + std::to_string(gl.lastFrame().filtered) +
+                " | culled: " + std::to_string(sceneBVH.objectCount() - visibleObjects.size()) +
+                "/" + std::to_string(sceneBVH.objectCount()) +
+                (frame.occlusionCulling ? " | occluded: " + std::to_string(occlusion.stats().rejected) +
+                                          "/" + std::to_string(occlusion.stats().tested) +
+                                          " raster: " + std::to_string(occlusion.stats().rasterMs) + " ms" +
+                                          " test: " + std::to_string(occlusion.stats().testMs) + " ms"
+                                        : std::string()) +
+                (sceneIndirect ? " | indirect" : " | per-object") +
+                (indirect ? " | stream stalls: " + std::to_string(sceneIndirectDraws.streamStats().stalls +
+                                                                  stressIndirectDraws.streamStats().stalls)
+                          : std::string()) +
+                (deferredFrame ? " | deferred" : " | forward") +
+                (frame.depthPrepass ? " + depth pre-pass" : "") +
+                (frameGraph.stats().transients
+                     ? " | transient targets: " + std::to_string(frameGraph.stats().allocatedBytes >> 10) + " KB in " +
+                           std::to_string(frameGraph.stats().textures) + " textures (" +
+                           std::to_string(frameGraph.stats().requestedBytes >> 10) + " KB unaliased)"
+                     : std::string()) +
+                (lightmapped ? " | lightmapped" : "") +
+                (options.dynamicResolution ? " | scale: " + std::to_string(resolution.scale()) +
+                                             " (" + std::to_string(renderWidth) + "x" + std::to_string(renderHeight) +
+                                             ", GPU " + std::to_string(profiler.stats().lastGpuFrameMs) + " ms)"
+                                           : std::string()) +
+                " | draws: " + std::to_string(gl.lastFrame().draws) +
+                " instances: " + std::to_string(gl.lastFrame().instances) +
+                " | CPU sim: " + std::to_string(frame.simulationMs) + " ms" +
+                " render: " + std::to_string(cpuFrameMs) + " ms" +
+                (options.singleThread
+                     ? std::string()
+                     : " | waited sim: " +
+                           std::to_string(pipelineStats.producerWaitMs - lastPipelineStats.producerWaitMs) +
+                           " render: " +
+                           std::to_string(pipelineStats.consumerWaitMs - lastPipelineStats.consumerWaitMs) +
+                           " ms/s") +
+                " | lights: " + std::to_string(lighting.stats().lights) +
+                " assign: " + std::to_string(lighting.stats().assignMs) + " ms" +
+                " avg/cluster: " + std::to_string(lighting.stats().averageLightsPerCluster) +
+                " | " + profiler.summary();
+            lastPipelineStats = pipelineStats;
+            std::lock_guard<std::mutex> lock(titleMutex);
+            pendingTitle = title;
+        }
+    };
+
+    auto applyTitle = [&] {
+        std::lock_guard<std::mutex> lock(titleMutex);
+        if (pendingTitle.empty()) return;
+        win.setTitle(pendingTitle.c_str());
+        pendingTitle.clear();
+    };
+
+    if (options.singleThread) {
+        FrameSnapshot frame;
+        frame.stressInstances.resize(options.instances);
+        while (running) {
+            simulate(frame);
+            render(frame);
+            applyTitle();
+        }
+    } else {
+        for (unsigned i = 0; i < FramePipeline<FrameSnapshot>::SLOT_COUNT; ++i)
+            pipeline.slot(i).stressInstances.resize(options.instances);
+
+        // Hand the context over; it comes back for the GL cleanup at the end of main()
+        win.makeCurrent(false);
+        std::thread renderThread([&] {
+            win.makeCurrent(true);
+            while (const FrameSnapshot* frame = pipeline.next()) {
+                render(*frame);
+                pipeline.release();
+            }
+            win.makeCurrent(false);
+        });
+
+        while (running) {
+            FrameSnapshot* frame = pipeline.acquire();
+            simulate(*frame);
+            pipeline.publish();
+            applyTitle();
+        }
+        pipeline.close();
+        renderThread.join();
+        win.makeCurrent(true);
+    }
+
+    if (headless) {
+        FrameTimings::Summary cpu = timings.summary(&FrameTimings::Frame::renderMs);
+        FrameTimings::Summary gpu = timings.summary(&FrameTimings::Frame::gpuMs);
+        std::cout << "Rendered " << timings.all().size() << " frames headless | render CPU mean " << cpu.mean
+                  << " ms p95 " << cpu.p95 << " ms | GPU mean " << gpu.mean << " ms p95 " << gpu.p95 << " ms"
+                  << std::endl;
     }
+    if (!options.timingJson.empty() && !timings.writeJson(options.timingJson, profiler))
+        std::cerr << "Failed to write timings: " << options.timingJson << std::endl;
 
+    if (!options.profileCsv.empty() && !profiler.exportCsv(options.profileCsv))
+        std::cerr << "Failed to write profile: " << options.profileCsv << std::endl;
     return 0;
 }
@@ -0,0 +1,409 @@
+// Golden-image and performance regression harness. Runs the Engine headless over a
+// set of canonical scenes and fails when a frame or the frame times regress.
+//
+//   RegressionHarness [--engine PATH] [--data DIR] [--scene NAME] [--update]
+//                     [--images-only | --perf-only] [--tolerance N] [--max-pixels F]
+//                     [--min-ssim S] [--perf-slack F] [--perf-floor MS]
+//
+// Run it from the repository root, where the Engine finds shaders/ and assets/. The
+// Engine defaults to the one next to this executable. Every scene is run twice:
+//   images  IMAGE_FRAMES frames at the headless 60 Hz step, dumping every
+//           IMAGE_STEP-th (t = 0, 0.5, ... 3 s); each is compared with its golden
+//           image (ImageCompare.h): it fails when more than --max-pixels (fraction,
+//           default 0.001) of the pixels differ by more than --tolerance (default 8
+//           of 255) in any channel, or when the SSIM drops below --min-ssim (0.99)
+//   perf    PERF_FRAMES frames without readbacks; fails when the p50 or p95 of the
+//           CPU render time or GPU frame time exceeds the baseline by more than
+//           --perf-slack (fraction, 0.15) plus --perf-floor (0.05 ms, for tiny times)
+// --update records the current frames and times as the new goldens and baseline
+// instead; do it on the machine the baseline is meant for.
+//
+// DIR (default "regression") holds:
+//   camera.path                      orbit every scene follows (CameraPath.h)
+//   golden/<scene>/frame_NNNNN.ppm   golden images
+//   baseline.json                    { "<scene>": { "render_ms_p50": ..., ... }, ... }
+//   out/<scene>/                     frames, heatmaps and timings of the last run
+//
+// Exit code 0 when every scene passes.
+
+#include <map>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <filesystem>
+#include "FrameCapture.h"
+#include "ImageCompare.h"
+
+namespace fs = std::filesystem;
+
+namespace {
+
+const unsigned IMAGE_FRAMES = 181;
+const unsigned IMAGE_STEP = 30;
+const unsigned PERF_FRAMES = 600;
+
+// The main.cpp scene as it starts, then the heavier paths
+struct Scene {
+    const char* name;
+    const char* args;
+};
+
+const Scene SCENES[] = {
+    {"default", ""},
+    {"prepass-occlusion", "--prepass --occlusion"},
+    {"deferred-lights", "--deferred --lights 256"},
+    {"stress-instanced", "--instances 50000"},
+    {"stress-indirect", "--instances 50000 --indirect"},
+    {"stress-command-lists", "--instances 20000 --naive --command-lists"},
+    {"software", "--software --instances 2000"},
+};
+
+// Baseline metrics: timing JSON group and statistic
+struct Metric {
+    const char* name;
+    const char* group;
+    const char* stat;
+};
+
+const Metric METRICS[] = {
+    {"render_ms_p50", "render_ms", "p50"},
+    {"render_ms_p95", "render_ms", "p95"},
+    {"gpu_ms_p50", "gpu_ms", "p50"},
+    {"gpu_ms_p95", "gpu_ms", "p95"},
+};
+
+struct Settings {
+    std::string engine;
+    std::string data = "regression";
+    std::string scene;          // Empty: all
+    bool update = false;
+    bool images = true, perf = true;
+    int tolerance = 8;
+    double maxPixels = 0.001;
+    double minSsim = 0.99;
+    double perfSlack = 0.15;
+    double perfFloorMs = 0.05;
+};
+
+// Just enough JSON for the timing files and the baseline: objects, arrays, numbers,
+// strings (escapes kept verbatim), true, false and null
+struct Json {
+    enum Type { NUL, BOOL, NUMBER, STRING, ARRAY, OBJECT };
+    Type type = NUL;
+    double number = 0.0;
+    std::string string;
+    std::vector<Json> array;
+    std::vector<std::pair<std::string, Json>> object;
+
+    const Json* find(const std::string& key) const {
+        for (const auto& member : object)
+            if (member.first == key) return &member.second;
+        return nullptr;
+    }
+};
+
+class JsonParser {
+public:
+    explicit JsonParser(const std::string& text) : p(text.c_str()), end(text.c_str() + text.size()) {}
+
+    bool parse(Json& value) {
+        if (!parseValue(value)) return false;
+        skipSpace();
+        return p == end;
+    }
+
+private:
+    const char* p;
+    const char* end;
+
+    void skipSpace() {
+        while (p < end && (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r')) ++p;
+    }
+
+    bool literal(const char* word) {
+        size_t length = std::strlen(word);
+        if ((size_t)(end - p) < length || std::strncmp(p, word, length) != 0) return false;
+        p += length;
+        return true;
+    }
+
+    bool parseString(std::string& out) {
+        if (p >= end || *p != '"') return false;
+        const char* start = ++p;
+        while (p < end && *p != '"') p += (*p == '\\' && p + 1 < end) ? 2 : 1;
+        if (p >= end) return false;
+        out.assign(start, p++);
+        return true;
+    }
+
+    bool parseValue(Json& value) {
+        skipSpace();
+        if (p >= end) return false;
+        if (*p == '{') {
+            value.type = Json::OBJECT;
+            ++p;
+            skipSpace();
+            if (p < end && *p == '}') return ++p, true;
+            for (;;) {
+                std::pair<std::string, Json> member;
+                skipSpace();
+                if (!parseString(member.first)) return false;
+                skipSpace();
+                if (p >= end || *p++ != ':' || !parseValue(member.second)) return false;
+                value.object.push_back(std::move(member));
+                skipSpace();
+                if (p < end && *p == ',') { ++p; continue; }
+                return p < end && *p++ == '}';
+            }
+        }
+        if (*p == '[') {
+            value.type = Json::ARRAY;
+            ++p;
+            skipSpace();
+            if (p < end && *p == ']') return ++p, true;
+            for (;;) {
+                value.array.emplace_back();
+                if (!parseValue(value.array.back())) return false;
+                skipSpace();
+                if (p < end && *p == ',') { ++p; continue; }
+                return p < end && *p++ == ']';
+            }
+        }
+        if (*p == '"') {
+            value.type = Json::STRING;
+            return parseString(value.string);
+        }
+        if (literal("null")) return value.type = Json::NUL, true;
+        if (literal("true")) return value.type = Json::BOOL, value.number = 1.0, true;
+        if (literal("false")) return value.type = Json::BOOL, value.number = 0.0, true;
+        char* numberEnd = nullptr;
+        value.type = Json::NUMBER;
+        value.number = std::strtod(p, &numberEnd);
+        if (numberEnd == p) return false;
+        p = numberEnd;
+        return true;
+    }
+};
+
+bool readJson(const std::string& path, Json& value) {
+    std::ifstream file(path);
+    if (!file.is_open()) return false;
+    std::stringstream text;
+    text << file.rdbuf();
+    if (!JsonParser(text.str()).parse(value)) {
+        std::cerr << "Malformed JSON: " << path << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// scene -> metric -> milliseconds
+typedef std::map<std::string, std::map<std::string, double>> Baseline;
+
+bool readBaseline(const std::string& path, Baseline& baseline) {
+    Json root;
+    if (!readJson(path, root) || root.type != Json::OBJECT) return false;
+    for (const auto& scene : root.object)
+        for (const auto& metric : scene.second.object)
+            if (metric.second.type == Json::NUMBER) baseline[scene.first][metric.first] = metric.second.number;
+    return true;
+}
+
+bool writeBaseline(const std::string& path, const Baseline& baseline) {
+    std::ofstream file(path);
+    if (!file.is_open()) return false;
+    char number[64];
+    file << "{";
+    bool firstScene = true;
+    for (const auto& scene : baseline) {
+        file << (firstScene ? "\n" : ",\n") << "  \"" << scene.first << "\": {";
+        bool firstMetric = true;
+        for (const auto& metric : scene.second) {
+            std::snprintf(number, sizeof(number), "%.4f", metric.second);
+            file << (firstMetric ? "" : ", ") << "\"" << metric.first << "\": " << number;
+            firstMetric = false;
+        }
+        file << "}";
+        firstScene = false;
+    }
+    file << "\n}\n";
+    return file.good();
+}
+
+std::string quoted(const std::string& s) {
+    return "\"" + s + "\"";
+}
+
+bool runEngine(const Settings& settings, const Scene& scene, const std::string& extra) {
+    std::string command = quoted(settings.engine) + " " + scene.args + " --camera-path " +
+                          quoted((fs::path(settings.data) / "camera.path").string()) + " " + extra;
+    std::cout << "  $ " << command << std::endl;
+    if (std::system(command.c_str()) != 0) {
+        std::cerr << "  FAIL " << scene.name << ": the engine did not exit cleanly" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+std::string frameName(unsigned index) {
+    char name[32];
+    std::snprintf(name, sizeof(name), "frame_%05u.ppm", index);
+    return name;
+}
+
+bool checkImages(const Settings& settings, const Scene& scene, const fs::path& out) {
+    std::string args = "--headless " + std::to_string(IMAGE_FRAMES) + " --dump-every " +
+                       std::to_string(IMAGE_STEP) + " --dump-frames " + quoted(out.string());
+    if (!runEngine(settings, scene, args)) return false;
+
+    fs::path golden = fs::path(settings.data) / "golden" / scene.name;
+    if (settings.update) fs::create_directories(golden);
+    bool ok = true;
+    for (unsigned index = 0; index < IMAGE_FRAMES; index += IMAGE_STEP) {
+        std::string name = frameName(index);
+        int width, height, goldenWidth, goldenHeight;
+        std::vector<unsigned char> frame, expected;
+        if (!readPPM((out / name).string(), width, height, frame)) {
+            std::cerr << "  FAIL " << scene.name << " " << name << ": the engine wrote no frame" << std::endl;
+            ok = false;
+            continue;
+        }
+        if (settings.update) {
+            fs::copy_file(out / name, golden / name, fs::copy_options::overwrite_existing);
+            continue;
+        }
+        if (!readPPM((golden / name).string(), goldenWidth, goldenHeight, expected)) {
+            std::cerr << "  FAIL " << scene.name << " " << name << ": no golden image (record it with --update)"
+                      << std::endl;
+            ok = false;
+            continue;
+        }
+        if (width != goldenWidth || height != goldenHeight) {
+            std::cerr << "  FAIL " << scene.name << " " << name << ": " << width << "x" << height
+                      << ", golden is " << goldenWidth << "x" << goldenHeight << std::endl;
+            ok = false;
+            continue;
+        }
+
+        std::vector<unsigned char> heatmap;
+        ImageDiff diff = compareImages(frame.data(), expected.data(), width, height, settings.tolerance, &heatmap);
+        bool passed = diff.fractionOver <= settings.maxPixels && diff.ssim >= settings.minSsim;
+        std::printf("  %s %s %s: %zu pixels over (%.4f%%), max difference %d, SSIM %.5f\n",
+                    passed ? "ok  " : "FAIL", scene.name, name.c_str(), diff.pixelsOver, diff.fractionOver * 100.0,
+                    diff.maxDifference, diff.ssim);
+        if (!passed) {
+            writePPM((out / ("diff_" + name)).string(), width, height, heatmap);
+            ok = false;
+        }
+    }
+    return ok;
+}
+
+bool checkPerf(const Settings& settings, const Scene& scene, const fs::path& out, Baseline& baseline) {
+    fs::path timingsPath = out / "timings.json";
+    std::string args = "--headless " + std::to_string(PERF_FRAMES) + " --timing-json " + quoted(timingsPath.string());
+    if (!runEngine(settings, scene, args)) return false;
+
+    Json timings;
+    if (!readJson(timingsPath.string(), timings)) {
+        std::cerr << "  FAIL " << scene.name << ": no timings in " << timingsPath.string() << std::endl;
+        return false;
+    }
+
+    bool ok = true;
+    std::map<std::string, double>& expected = baseline[scene.name];
+    for (const Metric& metric : METRICS) {
+        const Json* group = timings.find(metric.group);
+        const Json* count = group ? group->find("count") : nullptr;
+        const Json* stat = group ? group->find(metric.stat) : nullptr;
+        // No GPU timer results (e.g. no timer queries); nothing to compare
+        if (!stat || !count || count->number == 0.0) continue;
+        double current = stat->number;
+        if (settings.update) {
+            expected[metric.name] = current;
+            continue;
+        }
+        auto base = expected.find(metric.name);
+        if (base == expected.end()) {
+            std::cerr << "  FAIL " << scene.name << " " << metric.name << ": not in the baseline (record it with --update)"
+                      << std::endl;
+            ok = false;
+            continue;
+        }
+        double limit = base->second * (1.0 + settings.perfSlack) + settings.perfFloorMs;
+        bool passed = current <= limit;
+        std::printf("  %s %s %s: %.3f ms, baseline %.3f ms, limit %.3f ms\n", passed ? "ok  " : "FAIL", scene.name,
+                    metric.name, current, base->second, limit);
+        ok = ok && passed;
+    }
+    return ok;
+}
+
+bool parseSettings(int argc, char** argv, Settings& settings) {
+    settings.engine = (fs::path(argv[0]).parent_path() / "Engine").string();
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--engine" && hasValue) settings.engine = argv[++i];
+        else if (arg == "--data" && hasValue) settings.data = argv[++i];
+        else if (arg == "--scene" && hasValue) settings.scene = argv[++i];
+        else if (arg == "--update") settings.update = true;
+        else if (arg == "--images-only") settings.perf = false;
+        else if (arg == "--perf-only") settings.images = false;
+        else if (arg == "--tolerance" && hasValue) settings.tolerance = std::atoi(argv[++i]);
+        else if (arg == "--max-pixels" && hasValue) settings.maxPixels = std::atof(argv[++i]);
+        else if (arg == "--min-ssim" && hasValue) settings.minSsim = std::atof(argv[++i]);
+        else if (arg == "--perf-slack" && hasValue) settings.perfSlack = std::atof(argv[++i]);
+        else if (arg == "--perf-floor" && hasValue) settings.perfFloorMs = std::atof(argv[++i]);
+        else {
+            std::cerr << "Unknown argument: " << arg << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Settings settings;
+    if (!parseSettings(argc, argv, settings)) return 2;
+
+    fs::path baselinePath = fs::path(settings.data) / "baseline.json";
+    Baseline baseline;
+    if (settings.perf && !readBaseline(baselinePath.string(), baseline) && !settings.update) {
+        std::cerr << "No baseline at " << baselinePath.string() << " (record it with --update)" << std::endl;
+        return 1;
+    }
+
+    unsigned failed = 0, run = 0;
+    for (const Scene& scene : SCENES) {
+        if (!settings.scene.empty() && settings.scene != scene.name) continue;
+        ++run;
+        std::cout << scene.name << std::endl;
+        fs::path out = fs::path(settings.data) / "out" / scene.name;
+        fs::remove_all(out);   // No heatmaps left over from an earlier failure
+        fs::create_directories(out);
+        bool ok = true;
+        if (settings.images) ok = checkImages(settings, scene, out) && ok;
+        if (settings.perf) ok = checkPerf(settings, scene, out, baseline) && ok;
+        if (!ok) ++failed;
+    }
+    if (run == 0) {
+        std::cerr << "No scene named " << settings.scene << std::endl;
+        return 2;
+    }
+
+    if (settings.update && settings.perf && !writeBaseline(baselinePath.string(), baseline)) {
+        std::cerr << "Failed to write " << baselinePath.string() << std::endl;
+        return 1;
+    }
+    if (settings.update) std::cout << "Recorded " << run << " scene(s) in " << settings.data << std::endl;
+    else std::cout << (failed ? "FAILED: " : "passed: ") << run - failed << "/" << run << " scene(s)" << std::endl;
+    return failed ? 1 : 0;
+}
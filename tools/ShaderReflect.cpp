@@ -0,0 +1,480 @@
+// Build-time GLSL reflection: parses the uniform, uniform block and shader storage
+// block declarations of the engine shaders and writes a C++ header with constexpr
+// uniform IDs, sampler texture units, block binding indices and std140-compatible structs.
+//
+// Usage: ShaderReflect <output header> <shader.glsl>...
+
+#include <map>
+#include <algorithm>
+#include <set>
+#include <string>
+#include <vector>
+#include <cctype>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include "ShaderPreprocessor.h"
+
+struct Declaration {
+    std::string type;
+    std::string name;
+    int arraySize = 0; // 0 = not an array
+};
+
+struct Block {
+    std::string name;
+    std::vector<Declaration> members;
+};
+
+struct Reflection {
+    std::map<std::string, std::vector<Declaration>> structs;
+    std::vector<Declaration> uniforms; // In order of first appearance
+    std::vector<Block> blocks;
+    std::vector<std::string> storageBlocks; // Shader storage blocks; layout is left to the C++ side
+};
+
+static bool fail(const std::string& file, const std::string& message) {
+    std::cerr << file << ": error: " << message << std::endl;
+    return false;
+}
+
+// Removes comments and preprocessor lines, remembering integer #defines for array sizes
+static std::string stripSource(const std::string& code, std::map<std::string, int>& macros) {
+    std::string noComments;
+    for (size_t i = 0; i < code.size(); ++i) {
+        if (code.compare(i, 2, "//") == 0) {
+            while (i < code.size() && code[i] != '\n') ++i;
+            noComments += '\n';
+        } else if (code.compare(i, 2, "/*") == 0) {
+            size_t end = code.find("*/", i + 2);
+            i = end == std::string::npos ? code.size() : end + 1;
+            noComments += ' ';
+        } else {
+            noComments += code[i];
+        }
+    }
+
+    std::stringstream in(noComments);
+    std::string line, out;
+    while (std::getline(in, line)) {
+        size_t start = line.find_first_not_of(" \t");
+        if (start != std::string::npos && line[start] == '#') {
+            std::stringstream directive(line.substr(start + 1));
+            std::string keyword, name, value;
+            directive >> keyword >> name >> value;
+            if (keyword == "define" && !value.empty() && std::isdigit((unsigned char)value[0]))
+                macros[name] = std::stoi(value);
+            continue;
+        }
+        out += line + "\n";
+    }
+    return out;
+}
+
+static std::vector<std::string> tokenize(const std::string& code) {
+    std::vector<std::string> tokens;
+    for (size_t i = 0; i < code.size();) {
+        char c = code[i];
+        if (std::isspace((unsigned char)c)) {
+            ++i;
+        } else if (std::isalnum((unsigned char)c) || c == '_' || c == '.') {
+            size_t start = i;
+            while (i < code.size() && (std::isalnum((unsigned char)code[i]) || code[i] == '_' || code[i] == '.')) ++i;
+            tokens.push_back(code.substr(start, i - start));
+        } else {
+            tokens.push_back(std::string(1, c));
+            ++i;
+        }
+    }
+    return tokens;
+}
+
+class Parser {
+public:
+    Parser(const std::string& file, const std::vector<std::string>& tokens,
+           const std::map<std::string, int>& macros, Reflection& out)
+        : file(file), tokens(tokens), macros(macros), out(out) {}
+
+    bool run() {
+        while (pos < tokens.size()) {
+            const std::string& token = tokens[pos];
+            if (token == "struct") {
+                if (!parseStruct()) return false;
+            } else if (token == "layout") {
+                skipParens();
+            } else if (token == "uniform") {
+                ++pos;
+                if (!parseUniform()) return false;
+            } else if (token == "readonly" || token == "writeonly" || token == "coherent" ||
+                       token == "restrict" || token == "volatile") {
+                ++pos;
+            } else if (token == "buffer") {
+                ++pos;
+                if (!parseStorageBlock()) return false;
+            } else {
+                skipStatement();
+            }
+        }
+        return true;
+    }
+
+private:
+    const std::string& file;
+    const std::vector<std::string>& tokens;
+    const std::map<std::string, int>& macros;
+    Reflection& out;
+    size_t pos = 0;
+
+    const std::string& peek() const {
+        static const std::string end;
+        return pos < tokens.size() ? tokens[pos] : end;
+    }
+
+    bool expect(const std::string& token) {
+        if (peek() != token) return fail(file, "expected '" + token + "' near '" + peek() + "'");
+        ++pos;
+        return true;
+    }
+
+    void skipParens() {
+        ++pos;
+        if (peek() != "(") return;
+        int depth = 0;
+        do {
+            if (peek() == "(") ++depth;
+            else if (peek() == ")") --depth;
+            ++pos;
+        } while (pos < tokens.size() && depth > 0);
+    }
+
+    // Skips a declaration up to ';' or a whole function body
+    void skipStatement() {
+        int depth = 0;
+        while (pos < tokens.size()) {
+            const std::string& token = tokens[pos++];
+            if (token == "{") ++depth;
+            else if (token == "}" && --depth <= 0) return;
+            else if (token == ";" && depth == 0) return;
+        }
+    }
+
+    bool parseArraySize(int& size) {
+        size = 0;
+        if (peek() != "[") return true;
+        ++pos;
+        const std::string& value = peek();
+        if (!value.empty() && std::isdigit((unsigned char)value[0])) size = std::stoi(value);
+        else if (macros.count(value)) size = macros.at(value);
+        else return fail(file, "cannot resolve array size '" + value + "'");
+        ++pos;
+        return expect("]");
+    }
+
+    // type name[N], name2; ... up to the closing '}'
+    bool parseMembers(std::vector<Declaration>& members) {
+        if (!expect("{")) return false;
+        while (peek() != "}") {
+            if (pos >= tokens.size()) return fail(file, "unterminated member list");
+            Declaration decl;
+            decl.type = tokens[pos++];
+            while (true) {
+                decl.name = tokens[pos++];
+                if (!parseArraySize(decl.arraySize)) return false;
+                members.push_back(decl);
+                if (peek() != ",") break;
+                ++pos;
+            }
+            if (!expect(";")) return false;
+        }
+        ++pos;
+        return true;
+    }
+
+    bool parseStruct() {
+        ++pos;
+        std::string name = tokens[pos++];
+        std::vector<Declaration> members;
+        if (!parseMembers(members)) return false;
+        if (!expect(";")) return false;
+        if (!out.structs.count(name)) out.structs[name] = members;
+        return true;
+    }
+
+    bool parseUniform() {
+        std::string type = tokens[pos++];
+        if (peek() == "{") {
+            Block block;
+            block.name = type;
+            if (!parseMembers(block.members)) return false;
+            if (peek() != ";") ++pos; // Instance name
+            if (!expect(";")) return false;
+            for (const Block& existing : out.blocks)
+                if (existing.name == block.name) return true;
+            out.blocks.push_back(block);
+            return true;
+        }
+
+        while (true) {
+            Declaration decl;
+            decl.type = type;
+            decl.name = tokens[pos++];
+            if (!parseArraySize(decl.arraySize)) return false;
+            if (peek() == "=") {
+                // Default initializer
+                int depth = 0;
+                while (pos < tokens.size() && !(depth == 0 && (peek() == "," || peek() == ";"))) {
+                    if (peek() == "(") ++depth;
+                    else if (peek() == ")") --depth;
+                    ++pos;
+                }
+            }
+            if (!addUniform(decl)) return false;
+            if (peek() != ",") break;
+            ++pos;
+        }
+        return expect(";");
+    }
+
+    // buffer Name { ... } instance; -- only the name is needed for the binding
+    bool parseStorageBlock() {
+        std::string name = tokens[pos++];
+        if (peek() != "{") return fail(file, "expected '{' after buffer " + name);
+        skipStatement();
+        if (peek() != ";") ++pos; // Instance name
+        if (!expect(";")) return false;
+        if (std::find(out.storageBlocks.begin(), out.storageBlocks.end(), name) == out.storageBlocks.end())
+            out.storageBlocks.push_back(name);
+        return true;
+    }
+
+    bool addUniform(const Declaration& decl) {
+        for (const Declaration& existing : out.uniforms) {
+            if (existing.name != decl.name) continue;
+            if (existing.type != decl.type || existing.arraySize != decl.arraySize)
+                return fail(file, "uniform '" + decl.name + "' redeclared with a different type");
+            return true;
+        }
+        out.uniforms.push_back(decl);
+        return true;
+    }
+};
+
+// One GL-visible uniform: its GLSL name and the C++ identifier (plus element index for arrays)
+struct FlatUniform {
+    std::string glslName;
+    std::string identifier;
+    int element = -1;
+    bool sampler = false;
+};
+
+static bool flatten(const Reflection& reflection, std::vector<FlatUniform>& flat) {
+    for (const Declaration& decl : reflection.uniforms) {
+        int count = decl.arraySize ? decl.arraySize : 1;
+        auto structIt = reflection.structs.find(decl.type);
+        for (int i = 0; i < count; ++i) {
+            std::string base = decl.name + (decl.arraySize ? "[" + std::to_string(i) + "]" : "");
+            int element = decl.arraySize ? i : -1;
+            if (structIt == reflection.structs.end()) {
+                flat.push_back({base, decl.name, element, decl.type.find("sampler") != std::string::npos});
+                continue;
+            }
+            for (const Declaration& member : structIt->second) {
+                if (member.arraySize || reflection.structs.count(member.type))
+                    return fail(decl.name, "nested arrays/structs in uniform structs are not supported");
+                flat.push_back({base + "." + member.name, decl.name + "_" + member.name, element, false});
+            }
+        }
+    }
+    return true;
+}
+
+struct Std140Type {
+    const char* cppType;
+    int alignment;
+    int size;
+};
+
+static bool std140Type(const std::string& glslType, Std140Type& type) {
+    static const std::map<std::string, Std140Type> types = {
+        {"float", {"float", 4, 4}},         {"int", {"int32_t", 4, 4}},
+        {"uint", {"uint32_t", 4, 4}},       {"bool", {"uint32_t", 4, 4}},
+        {"vec2", {"glm::vec2", 8, 8}},      {"vec3", {"glm::vec3", 16, 12}},
+        {"vec4", {"glm::vec4", 16, 16}},    {"mat3", {"glm::vec4", 16, 48}},
+        {"mat4", {"glm::mat4", 16, 64}},
+    };
+    auto it = types.find(glslType);
+    if (it == types.end()) return false;
+    type = it->second;
+    return true;
+}
+
+static int alignUp(int value, int alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+static bool writeBlock(std::ostream& out, const Block& block) {
+    out << "// std140 layout of uniform block " << block.name << "\n";
+    out << "struct " << block.name << "Block {\n";
+
+    std::vector<std::pair<std::string, int>> offsets;
+    int offset = 0, padCount = 0;
+    auto pad = [&](int to) {
+        if (to > offset) out << "    float _pad" << padCount++ << "[" << (to - offset) / 4 << "];\n";
+        offset = to;
+    };
+
+    for (const Declaration& member : block.members) {
+        Std140Type type;
+        if (!std140Type(member.type, type))
+            return fail(block.name, "unsupported std140 member type '" + member.type + "'");
+
+        std::string cppType = type.cppType;
+        std::string note;
+        int alignment = type.alignment, size = type.size, columns = 1;
+        if (member.type == "mat3") {
+            columns = 3;
+            note = "  // mat3 columns padded to vec4";
+        }
+        if (member.arraySize) {
+            // Array elements are padded to a multiple of 16 bytes
+            int stride = alignUp(size, 16);
+            alignment = 16;
+            size = stride * member.arraySize;
+            if (stride != type.size) {
+                cppType = "glm::vec4";
+                columns = stride / 16;
+                note = "  // std140 pads " + member.type + " elements to vec4";
+            }
+        }
+
+        pad(alignUp(offset, alignment));
+        offsets.push_back({member.name, offset});
+        int count = (member.arraySize ? member.arraySize : 1) * columns;
+        out << "    " << cppType << " " << member.name;
+        if (member.arraySize || columns > 1) out << "[" << count << "]";
+        out << ";" << note << "\n";
+        offset += size;
+    }
+    pad(alignUp(offset, 16));
+    out << "};\n";
+
+    out << "static_assert(sizeof(" << block.name << "Block) == " << offset << ", \"std140 size mismatch\");\n";
+    for (const auto& [name, memberOffset] : offsets)
+        out << "static_assert(offsetof(" << block.name << "Block, " << name << ") == " << memberOffset
+            << ", \"std140 offset mismatch\");\n";
+    out << "\n";
+    return true;
+}
+
+static bool writeHeader(const std::string& path, const Reflection& reflection, const std::vector<FlatUniform>& flat) {
+    std::ostringstream out;
+    out << "// Generated by tools/ShaderReflect.cpp from the GLSL sources. Do not edit.\n"
+        << "#ifndef SHADER_REFLECTION_H\n#define SHADER_REFLECTION_H\n\n"
+        << "#include <cstddef>\n#include <cstdint>\n#include <glm/glm.hpp>\n\n"
+        << "namespace glsl {\n\n"
+        << "using UniformId = uint16_t;\n\n";
+
+    // IDs; array elements are grouped under one identifier
+    out << "namespace uniform {\n";
+    std::vector<std::string> emitted;
+    for (size_t i = 0; i < flat.size(); ++i) {
+        const FlatUniform& u = flat[i];
+        if (std::find(emitted.begin(), emitted.end(), u.identifier) != emitted.end()) continue;
+        emitted.push_back(u.identifier);
+        if (u.element < 0) {
+            out << "constexpr UniformId " << u.identifier << " = " << i << ";\n";
+            continue;
+        }
+        std::vector<size_t> ids;
+        for (size_t j = i; j < flat.size(); ++j)
+            if (flat[j].identifier == u.identifier) ids.push_back(j);
+        out << "constexpr UniformId " << u.identifier << "[" << ids.size() << "] = {";
+        for (size_t j = 0; j < ids.size(); ++j) out << (j ? ", " : "") << ids[j];
+        out << "};\n";
+    }
+    out << "constexpr UniformId COUNT = " << flat.size() << ";\n";
+    out << "}\n\n";
+
+    out << "// GLSL names, indexed by UniformId\n";
+    out << "constexpr const char* uniformNames[uniform::COUNT] = {\n";
+    for (const FlatUniform& u : flat) out << "    \"" << u.glslName << "\",\n";
+    out << "};\n\n";
+
+    // Samplers get fixed texture units, assigned once at link time
+    out << "namespace sampler {\n";
+    int unit = 0;
+    for (const FlatUniform& u : flat)
+        if (u.sampler && u.element < 0) out << "constexpr int " << u.identifier << " = " << unit++ << ";\n";
+    out << "}\n\n";
+
+    out << "struct SamplerUnit {\n    UniformId id;\n    int unit;\n};\n\n";
+    out << "constexpr SamplerUnit samplerUnits[] = {\n";
+    unit = 0;
+    for (size_t i = 0; i < flat.size(); ++i)
+        if (flat[i].sampler && flat[i].element < 0) out << "    {" << i << ", " << unit++ << "},\n";
+    if (unit == 0) out << "    {uniform::COUNT, 0},\n";
+    out << "};\n\n";
+
+    out << "namespace binding {\n";
+    for (size_t i = 0; i < reflection.blocks.size(); ++i)
+        out << "constexpr unsigned int " << reflection.blocks[i].name << " = " << i << ";\n";
+    out << "}\n\n";
+
+    out << "struct UniformBlockBinding {\n    const char* name;\n    unsigned int binding;\n};\n\n";
+    out << "constexpr UniformBlockBinding uniformBlocks[] = {\n";
+    for (size_t i = 0; i < reflection.blocks.size(); ++i)
+        out << "    {\"" << reflection.blocks[i].name << "\", " << i << "},\n";
+    if (reflection.blocks.empty()) out << "    {nullptr, 0},\n";
+    out << "};\n\n";
+
+    // Shader storage blocks have their own binding points (GL 4.3+)
+    out << "namespace storage {\n";
+    for (size_t i = 0; i < reflection.storageBlocks.size(); ++i)
+        out << "constexpr unsigned int " << reflection.storageBlocks[i] << " = " << i << ";\n";
+    out << "}\n\n";
+
+    out << "constexpr UniformBlockBinding storageBlocks[] = {\n";
+    for (size_t i = 0; i < reflection.storageBlocks.size(); ++i)
+        out << "    {\"" << reflection.storageBlocks[i] << "\", " << i << "},\n";
+    if (reflection.storageBlocks.empty()) out << "    {nullptr, 0},\n";
+    out << "};\n\n";
+
+    for (const Block& block : reflection.blocks)
+        if (!writeBlock(out, block)) return false;
+
+    out << "} // namespace glsl\n\n#endif // SHADER_REFLECTION_H\n";
+
+    // Leave the file untouched when nothing changed so dependents don't rebuild
+    std::ifstream existing(path);
+    std::stringstream current;
+    current << existing.rdbuf();
+    if (existing.is_open() && current.str() == out.str()) return true;
+
+    std::ofstream file(path);
+    if (!file.is_open()) return fail(path, "cannot write output");
+    file << out.str();
+    return true;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        std::cerr << "Usage: " << argv[0] << " <output header> <shader.glsl>..." << std::endl;
+        return 1;
+    }
+
+    Reflection reflection;
+    ShaderPreprocessor preprocessor;
+    for (int i = 2; i < argc; ++i) {
+        PreprocessedSource source = preprocessor.process(argv[i]);
+        if (!source.ok) return 1;
+
+        std::map<std::string, int> macros;
+        std::vector<std::string> tokens = tokenize(stripSource(source.code, macros));
+        Parser parser(argv[i], tokens, macros, reflection);
+        if (!parser.run()) return 1;
+    }
+
+    std::vector<FlatUniform> flat;
+    if (!flatten(reflection, flat)) return 1;
+    return writeHeader(argv[1], reflection, flat) ? 0 : 1;
+}